@@ -1,9 +1,13 @@
 set(PROJECT_SOURCES
+  src/ann_index.cc
   src/check.cc
   src/color.cc
   src/color_map.cc
+  src/cpu_features.cc
+  src/descriptor_matcher.cc
   src/fileio.cc
   src/filter.cc
+  src/gemm.cc
   src/geometry.cc
   src/histogram.cc
   src/image.cc
@@ -14,12 +18,14 @@ set(PROJECT_SOURCES
   src/image_io_pnm.cc
   src/image_paint.cc
   src/image_processing.cc
+  src/image_pyramid.cc
   src/indexed_array.cc
   src/kmatrix.cc
   src/linear_algebra.cc
   src/log_manager.cc
   src/math.cc
   src/matrix.cc
+  src/matrix_batch.cc
   src/mem_manager.cc
   src/mem_unit.cc
   src/message.cc
@@ -30,11 +36,14 @@ set(PROJECT_SOURCES
   src/progress_bar.cc
   src/random.cc
   src/random_generator.cc
+  src/ransac.cc
   src/rect2.cc
+  src/resample.cc
   src/rotation.cc
   src/sorted_pair_map.cc
   src/sorting.cc
   src/sparse_array_t.cc
+  src/sparse_matrix.cc
   src/sse_extensions.cc
   src/string.cc
   src/svd.cc
@@ -43,14 +52,21 @@ set(PROJECT_SOURCES
 )
 
 set(PROJECT_HEADERS
+  kortex/include/ann_index.h
   kortex/include/bit_operations.h
   kortex/include/check.h
+  kortex/include/cpu_features.h
   kortex/include/color.h
   kortex/include/color_map.h
   kortex/include/defs.h
+  kortex/include/dary_heap.h
+  kortex/include/dary_heap.tcc
+  kortex/include/descriptor_matcher.h
   kortex/include/eigen_conversion.h
   kortex/include/fileio.h
   kortex/include/filter.h
+  kortex/include/flat_hash_map.h
+  kortex/include/gemm.h
   kortex/include/geometry.h
   kortex/include/heap.h
   kortex/include/heap.tcc
@@ -63,8 +79,10 @@ set(PROJECT_HEADERS
   kortex/include/image_io_pnm.h
   kortex/include/image_paint.h
   kortex/include/image_processing.h
+  kortex/include/image_pyramid.h
   kortex/include/indexed_array.h
   kortex/include/keyed_value.h
+  kortex/include/kfixed_matrix.h
   kortex/include/kmatrix.h
   kortex/include/kvector.h
   kortex/include/lapack_externs.h
@@ -73,6 +91,7 @@ set(PROJECT_HEADERS
   kortex/include/log_manager.h
   kortex/include/math.h
   kortex/include/matrix.h
+  kortex/include/matrix_batch.h
   kortex/include/mem_manager.h
   kortex/include/mem_unit.h
   kortex/include/message.h
@@ -83,11 +102,15 @@ set(PROJECT_HEADERS
   kortex/include/progress_bar.h
   kortex/include/random.h
   kortex/include/random_generator.h
+  kortex/include/ransac.h
+  kortex/include/ransac.tcc
+  kortex/include/resample.h
   kortex/include/rect2.h
   kortex/include/rotation.h
   kortex/include/sorted_pair_map.h
   kortex/include/sorting.h
   kortex/include/sparse_array_t.h
+  kortex/include/sparse_matrix.h
   kortex/include/sse_extensions.h
   kortex/include/string.h
   kortex/include/svd.h
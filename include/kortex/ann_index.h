@@ -0,0 +1,186 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+//
+// Approximate nearest neighbor indices over n points of dimension dim stored
+// consecutively as floats ( 3d points, sift descriptors... ). distances are
+// euclidean.
+//
+// KdForest - randomized k-d trees ( silpa-anan & hartley, 2008 ) for low and
+// medium dimensions. every tree splits on a dimension drawn among the ones
+// of largest variance. a query descends all trees and then explores the
+// closest unexplored branches of the forest from a shared priority queue
+// until checks distances are computed. the search is exact if checks <= 0.
+//
+// HnswIndex - hierarchical navigable small world graph ( malkov & yashunin,
+// 2018 ) for high dimensional descriptors. a query descends the sparse upper
+// layers greedily and runs a beam search of width ef on the bottom layer.
+//
+// checks and ef trade recall for speed. the indices reference the data - it
+// has to outlive the index unchanged. save/load store the index structure
+// only and load is given the data the index was built on. builds and batch
+// queries run in parallel.
+//
+#ifndef KORTEX_ANN_INDEX_H
+#define KORTEX_ANN_INDEX_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace kortex {
+
+    using std::vector;
+    using std::string;
+
+    struct KdForestParams {
+        int      n_trees;
+        /// nodes with at most leaf_size points are not split further
+        int      leaf_size;
+        /// the split dimension of a node is drawn among the n_split_dims
+        /// dimensions of largest variance
+        int      n_split_dims;
+        uint64_t seed;
+        /// trees are built in parallel
+        bool     run_parallel;
+
+        KdForestParams();
+    };
+
+    class KdForest {
+    public:
+        KdForest();
+
+        /// indexes the n points of dimension dim in data
+        void build( const float* data, int n, int dim, const KdForestParams& params );
+        void release();
+
+        /// k nearest neighbors of the n_query queries. checks bounds the
+        /// number of distance computations per query - the first tree is
+        /// searched exactly if checks <= 0. indices and distances are
+        /// n_query x k arrays sorted by increasing distance. missing
+        /// neighbors are set to -1.
+        void knn( const float* query, int n_query, int k, int checks, bool run_parallel,
+                  int* indices, float* distances ) const;
+
+        /// all points closer than radius to q sorted by increasing distance -
+        /// exact.
+        void radius_search( const float* q, float radius, vector<int>& indices,
+                            vector<float>* distances=NULL ) const;
+
+        void save( const string& file ) const;
+        /// data has to be the n x dim array the index was built on
+        void load( const string& file, const float* data, int n, int dim );
+
+        int size   () const { return m_n;   }
+        int dim    () const { return m_dim; }
+        int n_trees() const { return (int)m_nodes.size(); }
+
+    private:
+        /// inner nodes split at split_dim - left holds the points below split.
+        /// leaves have split_dim -1 and hold the points index[left..right).
+        struct Node {
+            int   split_dim;
+            float split;
+            int   left;
+            int   right;
+        };
+        struct Builder;
+        struct Search;
+
+        const float*           m_data;
+        int                    m_n;
+        int                    m_dim;
+        KdForestParams         m_params;
+        vector< vector<Node> > m_nodes;
+        vector< vector<int>  > m_index;
+
+        void build_tree  ( const int& t );
+        int  divide      ( Builder& b, const int& t, const int& begin, const int& end );
+        void scan_leaf   ( Search& s, const int& t, const Node& leaf ) const;
+        void descend     ( Search& s, int t, int node, float rd ) const;
+        void search_exact( Search& s, int node, float rd ) const;
+    };
+
+    struct HnswParams {
+        /// number of links of a node on the upper layers - the bottom layer
+        /// keeps 2*M
+        int      M;
+        /// beam width of the insertions. larger values build better graphs
+        /// more slowly.
+        int      ef_construction;
+        uint64_t seed;
+        /// points are inserted in parallel
+        bool     run_parallel;
+
+        HnswParams();
+    };
+
+    class HnswIndex {
+    public:
+        HnswIndex();
+
+        /// indexes the n points of dimension dim in data
+        void build( const float* data, int n, int dim, const HnswParams& params );
+        void release();
+
+        /// k nearest neighbors of the n_query queries found by a beam search
+        /// of width max(ef,k). indices and distances are n_query x k arrays
+        /// sorted by increasing distance. missing neighbors are set to -1.
+        void knn( const float* query, int n_query, int k, int ef, bool run_parallel,
+                  int* indices, float* distances ) const;
+
+        void save( const string& file ) const;
+        /// data has to be the n x dim array the index was built on
+        void load( const string& file, const float* data, int n, int dim );
+
+        int size     () const { return m_n;         }
+        int dim      () const { return m_dim;       }
+        int max_level() const { return m_max_level; }
+
+    private:
+        struct Scratch;
+        struct Locks;
+
+        const float*   m_data;
+        int            m_n;
+        int            m_dim;
+        HnswParams     m_params;
+        int            m_entry;
+        int            m_max_level;
+        vector<int>    m_levels;
+        /// bottom layer links - n lists of a count and 2*M indices
+        vector<int>    m_links0;
+        /// links of the upper layers of the nodes with level > 0 - level
+        /// lists of a count and M indices starting at m_upper_offset[i]
+        vector<int>    m_upper;
+        vector<size_t> m_upper_offset;
+
+        int  capacity( const int& level ) const { return level == 0 ? 2*m_params.M : m_params.M; }
+        int* links   ( const int& i, const int& level );
+        const int* links( const int& i, const int& level ) const;
+        /// returns the size of m_upper
+        size_t set_upper_offsets();
+
+        void insert      ( const int& i, Scratch& s, Locks& locks );
+        int  greedy      ( const float* q, int cur, const int& level, Scratch& s, Locks* locks ) const;
+        void search_layer( const float* q, const int& ep, const int& ef, const int& level,
+                           Scratch& s, Locks* locks ) const;
+        void select      ( const int& M, Scratch& s ) const;
+        void add_link    ( const int& from, const int& to, const int& level, Scratch& s, Locks& locks );
+    };
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+#ifndef KORTEX_CPU_FEATURES_H
+#define KORTEX_CPU_FEATURES_H
+
+#include <string>
+using std::string;
+
+// simd kernels are compiled for all instruction sets and selected at runtime
+// by simd_level() - so one binary runs on every x86 cpu. the kernels are only
+// built on x86 targets when WITH_SSE is defined.
+#if defined(WITH_SSE) && ( defined(__x86_64__) || defined(__i386__) || defined(_M_X64) )
+#define KORTEX_WITH_SIMD_DISPATCH
+#endif
+
+#if defined(__GNUC__)
+#define KORTEX_TARGET_AVX2   __attribute__ ((__target__ ("avx2,fma")))
+#define KORTEX_TARGET_AVX512 __attribute__ ((__target__ ("avx512f,avx512bw,avx512vl,fma")))
+#define KORTEX_TARGET_AVX512_VPOPCNT __attribute__ ((__target__ ("avx512f,avx512bw,avx512vl,fma,avx512vpopcntdq")))
+#else
+#define KORTEX_TARGET_AVX2
+#define KORTEX_TARGET_AVX512
+#define KORTEX_TARGET_AVX512_VPOPCNT
+#endif
+
+namespace kortex {
+
+    enum SimdLevel { SIMD_NONE=0, SIMD_SSE2=1, SIMD_AVX2=2, SIMD_AVX512=3 };
+
+    /// widest instruction set supported by the running cpu, capped by the
+    /// limit set through set_simd_level_limit. detection is done once.
+    SimdLevel simd_level();
+
+    /// caps the instruction set used by the dispatched kernels. use for
+    /// testing/benchmarking the narrower code paths.
+    void set_simd_level_limit( const SimdLevel& level );
+
+    /// instruction set supported by the cpu regardless of the limit
+    SimdLevel cpu_simd_level();
+
+    /// avx512 vector popcount ( vpopcntdq ) support of the cpu - only used
+    /// by the kernels when simd_level() is SIMD_AVX512
+    bool cpu_has_vpopcntdq();
+
+    string simd_level_name( const SimdLevel& level );
+
+}
+
+#endif
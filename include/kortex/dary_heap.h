@@ -0,0 +1,131 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2016 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+// web   : http://www.aurvis.com
+//
+// ---------------------------------------------------------------------------
+//
+// d-ary heaps over contiguous arrays. unlike Heap, the comparator is a
+// template argument and gets inlined, the keys are stored by value and no
+// per-node pointers or indices are kept. the D children of a node are
+// adjacent in memory - a 4-ary heap is half as deep as a binary one and
+// compares the children of a node within a cache line.
+//
+// cmp(a,b) is true if a has to be popped before b - std::less<Key> pops in
+// ascending order ( Heap::HT_ASCENDING ), std::greater<Key> in descending
+// order.
+//
+// IndexedDaryHeap keeps items identified by ids in [0,n_ids) - the graph
+// nodes or pixels of shortest path and flooding algorithms - and supports
+// changing the key of an item already in the heap.
+//
+// the definitions are in dary_heap.tcc.
+//
+#ifndef KORTEX_DARY_HEAP_H
+#define KORTEX_DARY_HEAP_H
+
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+namespace kortex {
+
+    using std::vector;
+
+    template< typename Key, typename Compare=std::less<Key>, int D=4 >
+    class DaryHeap {
+    public:
+        DaryHeap( const Compare& cmp=Compare() );
+
+        void reserve( const size_t& n ) { m_keys.reserve( n ); }
+        void clear  ()                  { m_keys.clear();      }
+        void release();
+
+        /// replaces the contents with the n keys - O(n)
+        void assign( const Key* keys, const size_t& n );
+
+        void push( const Key& key );
+        /// the key to be popped next - the heap must not be empty
+        const Key& top() const { return m_keys[0]; }
+        /// removes and returns top()
+        Key  pop();
+
+        size_t size    () const { return m_keys.size();  }
+        bool   is_empty() const { return m_keys.empty(); }
+
+        bool is_heap_healthy() const;
+
+    private:
+        vector<Key> m_keys;
+        Compare     m_cmp;
+
+        void upheap  ( size_t k );
+        void downheap( size_t k );
+    };
+
+    template< typename Key, typename Compare=std::less<Key>, int D=4 >
+    class IndexedDaryHeap {
+    public:
+        IndexedDaryHeap( const Compare& cmp=Compare() );
+
+        /// empties the heap and accepts ids in [0,n_ids)
+        void init( const size_t& n_ids );
+        /// empties the heap - O(size())
+        void clear();
+        void release();
+
+        /// id must not be in the heap
+        void push  ( const int& id, const Key& key );
+        /// changes the key of id - in either direction
+        void update( const int& id, const Key& key );
+        /// pushes id or updates its key
+        void push_or_update( const int& id, const Key& key );
+        /// pushes id or updates its key if key is to be popped before the
+        /// current one - the relaxation step of dijkstra. returns false if
+        /// the heap is unchanged.
+        bool decrease( const int& id, const Key& key );
+        /// removes id if it is in the heap
+        void remove( const int& id );
+
+        /// id and key to be popped next - the heap must not be empty
+        int        top    () const { return m_heap[0].id;  }
+        const Key& top_key() const { return m_heap[0].key; }
+        /// removes top() and returns its id
+        int        pop();
+
+        bool       contains( const int& id ) const { return m_pos[id] >= 0; }
+        /// key of an id in the heap
+        const Key& key     ( const int& id ) const { return m_heap[ m_pos[id] ].key; }
+
+        size_t size    () const { return m_heap.size();  }
+        bool   is_empty() const { return m_heap.empty(); }
+        size_t n_ids   () const { return m_pos.size();   }
+
+        bool is_heap_healthy() const;
+
+    private:
+        struct Entry {
+            Key key;
+            int id;
+        };
+        vector<Entry> m_heap;
+        /// heap position of each id - -1 if not in the heap
+        vector<int>   m_pos;
+        Compare       m_cmp;
+
+        void upheap  ( size_t k );
+        void downheap( size_t k );
+        void sift    ( const size_t& k );
+    };
+
+}
+
+#endif
@@ -0,0 +1,278 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2016 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+// web   : http://www.aurvis.com
+//
+// ---------------------------------------------------------------------------
+
+#ifndef KORTEX_DARY_HEAP_TCC
+#define KORTEX_DARY_HEAP_TCC
+
+#include <algorithm>
+#include <kortex/check.h>
+#include <kortex/log_manager.h>
+#include "dary_heap.h"
+
+namespace kortex {
+
+    //
+    // DaryHeap
+    //
+    // the children of node k are D*k+1 .. D*k+D. the sifts move a hole
+    // instead of swapping and write the sifted key once.
+    //
+
+    template< typename Key, typename Compare, int D >
+    DaryHeap<Key,Compare,D>::DaryHeap( const Compare& cmp ) : m_cmp( cmp ) {
+        static_assert( D >= 2, "heap arity has to be at least 2" );
+    }
+
+    template< typename Key, typename Compare, int D >
+    void DaryHeap<Key,Compare,D>::release() {
+        vector<Key>().swap( m_keys );
+    }
+
+    template< typename Key, typename Compare, int D >
+    void DaryHeap<Key,Compare,D>::assign( const Key* keys, const size_t& n ) {
+        passert_pointer( n == 0 || keys );
+        m_keys.assign( keys, keys+n );
+        if( n < 2 ) return;
+        for( size_t k=(n-2)/D+1; k>0; k-- )
+            downheap( k-1 );
+    }
+
+    template< typename Key, typename Compare, int D >
+    void DaryHeap<Key,Compare,D>::push( const Key& key ) {
+        m_keys.push_back( key );
+        upheap( m_keys.size()-1 );
+    }
+
+    template< typename Key, typename Compare, int D >
+    Key DaryHeap<Key,Compare,D>::pop() {
+        assert_statement( !m_keys.empty(), "pop from an empty heap" );
+        Key t = m_keys[0];
+        m_keys[0] = m_keys.back();
+        m_keys.pop_back();
+        if( !m_keys.empty() )
+            downheap( 0 );
+        return t;
+    }
+
+    template< typename Key, typename Compare, int D >
+    void DaryHeap<Key,Compare,D>::upheap( size_t k ) {
+        Key v = m_keys[k];
+        while( k > 0 ) {
+            size_t p = (k-1)/D;
+            if( !m_cmp( v, m_keys[p] ) )
+                break;
+            m_keys[k] = m_keys[p];
+            k = p;
+        }
+        m_keys[k] = v;
+    }
+
+    template< typename Key, typename Compare, int D >
+    void DaryHeap<Key,Compare,D>::downheap( size_t k ) {
+        const size_t n = m_keys.size();
+        Key v = m_keys[k];
+        while( true ) {
+            size_t c = D*k+1;
+            if( c >= n ) break;
+            size_t ce = std::min( c+D, n );
+            size_t b  = c;
+            for( c++; c<ce; c++ )
+                if( m_cmp( m_keys[c], m_keys[b] ) )
+                    b = c;
+            if( !m_cmp( m_keys[b], v ) )
+                break;
+            m_keys[k] = m_keys[b];
+            k = b;
+        }
+        m_keys[k] = v;
+    }
+
+    template< typename Key, typename Compare, int D >
+    bool DaryHeap<Key,Compare,D>::is_heap_healthy() const {
+        for( size_t k=1; k<m_keys.size(); k++ ) {
+            if( m_cmp( m_keys[k], m_keys[(k-1)/D] ) ) {
+                logman_error_g( "heap error: node [%d]", (int)k );
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //
+    // IndexedDaryHeap
+    //
+
+    template< typename Key, typename Compare, int D >
+    IndexedDaryHeap<Key,Compare,D>::IndexedDaryHeap( const Compare& cmp ) : m_cmp( cmp ) {
+        static_assert( D >= 2, "heap arity has to be at least 2" );
+    }
+
+    template< typename Key, typename Compare, int D >
+    void IndexedDaryHeap<Key,Compare,D>::init( const size_t& n_ids ) {
+        m_heap.clear();
+        m_pos.assign( n_ids, -1 );
+    }
+
+    template< typename Key, typename Compare, int D >
+    void IndexedDaryHeap<Key,Compare,D>::clear() {
+        for( size_t k=0; k<m_heap.size(); k++ )
+            m_pos[ m_heap[k].id ] = -1;
+        m_heap.clear();
+    }
+
+    template< typename Key, typename Compare, int D >
+    void IndexedDaryHeap<Key,Compare,D>::release() {
+        vector<Entry>().swap( m_heap );
+        vector<int>  ().swap( m_pos  );
+    }
+
+    template< typename Key, typename Compare, int D >
+    void IndexedDaryHeap<Key,Compare,D>::push( const int& id, const Key& key ) {
+        assert_statement_g( id >= 0 && size_t(id) < m_pos.size(), "invalid id [%d]", id );
+        assert_statement_g( m_pos[id] < 0, "id [%d] is already in the heap", id );
+        Entry e;
+        e.key = key;
+        e.id  = id;
+        m_heap.push_back( e );
+        m_pos[id] = int( m_heap.size()-1 );
+        upheap( m_heap.size()-1 );
+    }
+
+    template< typename Key, typename Compare, int D >
+    void IndexedDaryHeap<Key,Compare,D>::update( const int& id, const Key& key ) {
+        assert_statement_g( contains( id ), "id [%d] is not in the heap", id );
+        const size_t k = m_pos[id];
+        m_heap[k].key = key;
+        sift( k );
+    }
+
+    template< typename Key, typename Compare, int D >
+    void IndexedDaryHeap<Key,Compare,D>::push_or_update( const int& id, const Key& key ) {
+        if( contains( id ) ) update( id, key );
+        else                 push  ( id, key );
+    }
+
+    template< typename Key, typename Compare, int D >
+    bool IndexedDaryHeap<Key,Compare,D>::decrease( const int& id, const Key& key ) {
+        if( !contains( id ) ) {
+            push( id, key );
+            return true;
+        }
+        const size_t k = m_pos[id];
+        if( !m_cmp( key, m_heap[k].key ) )
+            return false;
+        m_heap[k].key = key;
+        upheap( k );
+        return true;
+    }
+
+    template< typename Key, typename Compare, int D >
+    void IndexedDaryHeap<Key,Compare,D>::remove( const int& id ) {
+        if( !contains( id ) ) return;
+        const size_t k = m_pos[id];
+        m_pos[id] = -1;
+        if( k+1 < m_heap.size() ) {
+            m_heap[k] = m_heap.back();
+            m_pos[ m_heap[k].id ] = int(k);
+            m_heap.pop_back();
+            sift( k );
+        } else {
+            m_heap.pop_back();
+        }
+    }
+
+    template< typename Key, typename Compare, int D >
+    int IndexedDaryHeap<Key,Compare,D>::pop() {
+        assert_statement( !m_heap.empty(), "pop from an empty heap" );
+        const int id = m_heap[0].id;
+        m_pos[id] = -1;
+        if( m_heap.size() > 1 ) {
+            m_heap[0] = m_heap.back();
+            m_pos[ m_heap[0].id ] = 0;
+            m_heap.pop_back();
+            downheap( 0 );
+        } else {
+            m_heap.pop_back();
+        }
+        return id;
+    }
+
+    template< typename Key, typename Compare, int D >
+    void IndexedDaryHeap<Key,Compare,D>::sift( const size_t& k ) {
+        if( k > 0 && m_cmp( m_heap[k].key, m_heap[(k-1)/D].key ) )
+            upheap( k );
+        else
+            downheap( k );
+    }
+
+    template< typename Key, typename Compare, int D >
+    void IndexedDaryHeap<Key,Compare,D>::upheap( size_t k ) {
+        Entry v = m_heap[k];
+        while( k > 0 ) {
+            size_t p = (k-1)/D;
+            if( !m_cmp( v.key, m_heap[p].key ) )
+                break;
+            m_heap[k] = m_heap[p];
+            m_pos[ m_heap[k].id ] = int(k);
+            k = p;
+        }
+        m_heap[k] = v;
+        m_pos[v.id] = int(k);
+    }
+
+    template< typename Key, typename Compare, int D >
+    void IndexedDaryHeap<Key,Compare,D>::downheap( size_t k ) {
+        const size_t n = m_heap.size();
+        Entry v = m_heap[k];
+        while( true ) {
+            size_t c = D*k+1;
+            if( c >= n ) break;
+            size_t ce = std::min( c+D, n );
+            size_t b  = c;
+            for( c++; c<ce; c++ )
+                if( m_cmp( m_heap[c].key, m_heap[b].key ) )
+                    b = c;
+            if( !m_cmp( m_heap[b].key, v.key ) )
+                break;
+            m_heap[k] = m_heap[b];
+            m_pos[ m_heap[k].id ] = int(k);
+            k = b;
+        }
+        m_heap[k] = v;
+        m_pos[v.id] = int(k);
+    }
+
+    template< typename Key, typename Compare, int D >
+    bool IndexedDaryHeap<Key,Compare,D>::is_heap_healthy() const {
+        for( size_t k=0; k<m_heap.size(); k++ ) {
+            if( m_pos[ m_heap[k].id ] != int(k) ||
+                ( k > 0 && m_cmp( m_heap[k].key, m_heap[(k-1)/D].key ) ) ) {
+                logman_error_g( "heap error: node [%d]", (int)k );
+                return false;
+            }
+        }
+        size_t n_in = 0;
+        for( size_t i=0; i<m_pos.size(); i++ )
+            if( m_pos[i] >= 0 ) n_in++;
+        if( n_in != m_heap.size() ) {
+            logman_error_g( "heap error: [%d] ids for [%d] nodes", (int)n_in, (int)m_heap.size() );
+            return false;
+        }
+        return true;
+    }
+
+}
+
+#endif
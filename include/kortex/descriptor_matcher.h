@@ -0,0 +1,104 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+//
+// Brute-force matching of descriptor sets. query and train descriptors are
+// stored consecutively - binary descriptors are 256 bits packed into 32 bytes
+// ( see pack256 ), real valued ones are dim floats or uchar-quantized values
+// ( e.g. sift ).
+//
+// the query x train distance matrix is computed in tiles that keep a block of
+// train descriptors in cache while a block of queries is scanned over it.
+// query blocks are processed in parallel.
+//
+// real valued descriptors are compared with the gemm formulation
+// |a-b|^2 = |a|^2 + |b|^2 - 2 a.b : the train descriptors are packed into
+// panels and the dot products of a few queries with a panel are accumulated
+// in registers as in mat_gemm. the distances never leave the registers - only
+// the lanes closer than the current second best neighbor are merged into the
+// top-2 lists. uchar descriptors use exact 16 bit integer multiply-adds.
+//
+#ifndef KORTEX_DESCRIPTOR_MATCHER_H
+#define KORTEX_DESCRIPTOR_MATCHER_H
+
+#include <kortex/types.h>
+#include <vector>
+
+namespace kortex {
+
+    using std::vector;
+
+    struct DescriptorMatch {
+        int   query;
+        int   train;
+        float distance;
+    };
+
+    enum DescriptorMetric {
+        /// euclidean distance
+        DESCRIPTOR_L2,
+        /// 1 - cos(a,b)
+        DESCRIPTOR_COSINE
+    };
+
+    struct MatcherParams {
+        /// matches farther than max_distance are dropped. disabled if < 0.
+        float max_distance;
+        /// lowe's ratio test - the nearest neighbor is kept only if its
+        /// distance is below ratio times the distance of the second nearest
+        /// one. disabled if >= 1.
+        float ratio;
+        /// keeps a match only if the query is also the nearest neighbor of
+        /// its train descriptor among the queries
+        bool  cross_check;
+        bool  run_parallel;
+
+        MatcherParams();
+    };
+
+    /// k nearest train descriptors of each query. indices and distances are
+    /// n_query x k arrays sorted by increasing distance - ties are broken by
+    /// the lower train index. entries beyond n_train are set to -1.
+    void hamming_256_knn( const uchar* query, int n_query, const uchar* train, int n_train,
+                          int k, bool run_parallel, int* indices, int* distances );
+
+    /// nearest neighbor matches of the queries filtered by params. matches
+    /// are ordered by query index.
+    void hamming_256_match( const uchar* query, int n_query, const uchar* train, int n_train,
+                            const MatcherParams& params, vector<DescriptorMatch>& matches );
+
+    /// two nearest train descriptors of each query under metric. indices and
+    /// distances are n_query x 2 arrays sorted by increasing distance - ties
+    /// are broken by the lower train index. missing neighbors are set to -1.
+    void descriptor_knn2( const float* query, int n_query, const float* train, int n_train,
+                          int dim, const DescriptorMetric& metric, bool run_parallel,
+                          int* indices, float* distances );
+
+    /// uchar-quantized descriptors - l2 distances are computed exactly in
+    /// integer arithmetic. cosine distances are computed on float copies.
+    void descriptor_knn2( const uchar* query, int n_query, const uchar* train, int n_train,
+                          int dim, const DescriptorMetric& metric, bool run_parallel,
+                          int* indices, float* distances );
+
+    /// nearest neighbor matches of the queries filtered by params. matches
+    /// are ordered by query index.
+    void descriptor_match( const float* query, int n_query, const float* train, int n_train,
+                           int dim, const DescriptorMetric& metric, const MatcherParams& params,
+                           vector<DescriptorMatch>& matches );
+    void descriptor_match( const uchar* query, int n_query, const uchar* train, int n_train,
+                           int dim, const DescriptorMetric& metric, const MatcherParams& params,
+                           vector<DescriptorMatch>& matches );
+
+}
+
+#endif
@@ -14,15 +14,82 @@
 #ifndef KORTEX_FILTER_H
 #define KORTEX_FILTER_H
 
+#include <cstddef>
+
 namespace kortex {
 
-    void filter_hor(const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out);
-    void filter_ver(const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out);
-    void filter_hv (const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out);
+    /// the strided versions read the rows of im in_stride floats apart and
+    /// write the rows of out out_stride floats apart - padded images and
+    /// region views. out can be im if the strides are equal.
+    void filter_hor(const float* im, const int& w, const int& h, const size_t& in_stride,
+                    const float* kernel, const int& ksize, float* out, const size_t& out_stride);
+    void filter_ver(const float* im, const int& w, const int& h, const size_t& in_stride,
+                    const float* kernel, const int& ksize, float* out, const size_t& out_stride);
+    void filter_hv (const float* im, const int& w, const int& h, const size_t& in_stride,
+                    const float* kernel, const int& ksize, float* out, const size_t& out_stride);
+
+    void filter_hor_par(const float* im, const int& w, const int& h, const size_t& in_stride,
+                        const float* kernel, const int& ksize, float* out, const size_t& out_stride);
+    void filter_ver_par(const float* im, const int& w, const int& h, const size_t& in_stride,
+                        const float* kernel, const int& ksize, float* out, const size_t& out_stride);
+    void filter_hv_par (const float* im, const int& w, const int& h, const size_t& in_stride,
+                        const float* kernel, const int& ksize, float* out, const size_t& out_stride);
+
+    /// single pass separable convolution: rows are filtered with kernel_h and
+    /// then columns with kernel_v without writing out the intermediate image.
+    /// filter_hv is filter_separable with kernel_h = kernel_v.
+    void filter_separable    (const float* im, const int& w, const int& h, const size_t& in_stride,
+                              const float* kernel_h, const int& ksize_h,
+                              const float* kernel_v, const int& ksize_v, float* out, const size_t& out_stride);
+    void filter_separable_par(const float* im, const int& w, const int& h, const size_t& in_stride,
+                              const float* kernel_h, const int& ksize_h,
+                              const float* kernel_v, const int& ksize_v, float* out, const size_t& out_stride);
+
+    /// recursive ( iir ) gaussian smoothing with zero padded borders. the cost
+    /// per pixel does not depend on sigma. sigma should be >= 0.5.
+    void filter_gaussian_iir    (const float* im, const int& w, const int& h, const size_t& in_stride,
+                                 const float& sigma, float* out, const size_t& out_stride);
+    void filter_gaussian_iir_par(const float* im, const int& w, const int& h, const size_t& in_stride,
+                                 const float& sigma, float* out, const size_t& out_stride);
 
-    void filter_hor_par(const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out);
-    void filter_ver_par(const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out);
-    void filter_hv_par (const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out);
+    //
+    // packed w x h buffers. out can be im.
+    //
+
+    inline void filter_hor(const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out) {
+        filter_hor( im, w, h, size_t(w), kernel, ksize, out, size_t(w) );
+    }
+    inline void filter_ver(const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out) {
+        filter_ver( im, w, h, size_t(w), kernel, ksize, out, size_t(w) );
+    }
+    inline void filter_hv (const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out) {
+        filter_hv( im, w, h, size_t(w), kernel, ksize, out, size_t(w) );
+    }
+    inline void filter_hor_par(const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out) {
+        filter_hor_par( im, w, h, size_t(w), kernel, ksize, out, size_t(w) );
+    }
+    inline void filter_ver_par(const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out) {
+        filter_ver_par( im, w, h, size_t(w), kernel, ksize, out, size_t(w) );
+    }
+    inline void filter_hv_par (const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out) {
+        filter_hv_par( im, w, h, size_t(w), kernel, ksize, out, size_t(w) );
+    }
+    inline void filter_separable(const float* im, const int& w, const int& h,
+                                 const float* kernel_h, const int& ksize_h,
+                                 const float* kernel_v, const int& ksize_v, float* out) {
+        filter_separable( im, w, h, size_t(w), kernel_h, ksize_h, kernel_v, ksize_v, out, size_t(w) );
+    }
+    inline void filter_separable_par(const float* im, const int& w, const int& h,
+                                     const float* kernel_h, const int& ksize_h,
+                                     const float* kernel_v, const int& ksize_v, float* out) {
+        filter_separable_par( im, w, h, size_t(w), kernel_h, ksize_h, kernel_v, ksize_v, out, size_t(w) );
+    }
+    inline void filter_gaussian_iir(const float* im, const int& w, const int& h, const float& sigma, float* out) {
+        filter_gaussian_iir( im, w, h, size_t(w), sigma, out, size_t(w) );
+    }
+    inline void filter_gaussian_iir_par(const float* im, const int& w, const int& h, const float& sigma, float* out) {
+        filter_gaussian_iir_par( im, w, h, size_t(w), sigma, out, size_t(w) );
+    }
 
     inline void filter_hor( float*  im, const int& w, const int& h, const float* kernel, const int& ksize ) {
         filter_hor( im, w, h, kernel, ksize, im );
@@ -43,6 +110,11 @@ namespace kortex {
         filter_hv_par(im, w, h, kernel, ksize, im);
     }
 
+    /// weighted sum of ksize rows: out[x] = sum_j kernel[j]*rows[j][x] for
+    /// x in [0,n). building block of the vertical passes - rows may point
+    /// anywhere but out should not alias any of them.
+    void filter_rows(const float* const* rows, const float* kernel, const int& ksize, const int& n, float* out);
+
 }
 
 #endif
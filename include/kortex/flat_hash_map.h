@@ -0,0 +1,321 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2016 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+// web   : http://www.aurvis.com
+//
+// ---------------------------------------------------------------------------
+//
+// Open addressing hash map with robin hood linear probing. the entries are
+// stored in one array of slots and the probe distances in a parallel byte
+// array - no allocation per entry and a lookup touches a few adjacent slots
+// instead of chasing bucket list pointers.
+//
+// an entry is kept no farther from its home slot than the entries it passed
+// ( robin hood ), so a lookup stops as soon as it meets a slot closer to its
+// home than the probe. erase shifts the following entries back instead of
+// leaving tombstones. the table holds at most 7/8 of its slots.
+//
+// the interface follows std::unordered_map for the operations the library
+// uses. insertions and erasures invalidate iterators and references. the
+// iteration order is unspecified. the key of an entry must not be modified
+// through an iterator.
+//
+// pairs of integers of up to 32 bits are hashed as one packed 64 bit key.
+//
+#ifndef KORTEX_FLAT_HASH_MAP_H
+#define KORTEX_FLAT_HASH_MAP_H
+
+#include <vector>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#include <kortex/check.h>
+
+namespace kortex {
+
+    using std::vector;
+
+    /// murmur3 finalizer - spreads the entropy of the key over the low bits
+    /// the table is indexed with
+    inline uint64_t hash_mix64( uint64_t h ) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    template< typename Key >
+    struct FlatHash {
+        size_t operator()( const Key& key ) const {
+            return size_t( hash_mix64( uint64_t( std::hash<Key>()( key ) ) ) );
+        }
+    };
+
+    template< typename A, typename B >
+    struct FlatHash< std::pair<A,B> > {
+        size_t operator()( const std::pair<A,B>& key ) const {
+            return hash( key, std::integral_constant< bool, std::is_integral<A>::value && sizeof(A) <= 4 &&
+                                                            std::is_integral<B>::value && sizeof(B) <= 4 >() );
+        }
+    private:
+        size_t hash( const std::pair<A,B>& key, std::true_type ) const {
+            return size_t( hash_mix64( ( uint64_t( uint32_t( key.first ) ) << 32 ) | uint32_t( key.second ) ) );
+        }
+        size_t hash( const std::pair<A,B>& key, std::false_type ) const {
+            uint64_t h0 = FlatHash<A>()( key.first  );
+            uint64_t h1 = FlatHash<B>()( key.second );
+            return size_t( hash_mix64( h0 * 0x9e3779b97f4a7c15ULL + h1 ) );
+        }
+    };
+
+    template< typename Key, typename T, typename Hash=FlatHash<Key>, typename KeyEqual=std::equal_to<Key> >
+    class FlatHashMap {
+    public:
+        typedef Key                key_type;
+        typedef T                  mapped_type;
+        typedef std::pair<Key,T>   value_type;
+
+        template< bool Const >
+        class Iter {
+        public:
+            typedef typename std::conditional< Const, const FlatHashMap*, FlatHashMap* >::type map_pointer;
+            typedef typename std::conditional< Const, const value_type&, value_type& >::type reference;
+            typedef typename std::conditional< Const, const value_type*, value_type* >::type pointer;
+
+            Iter() : m_map(NULL), m_i(0) {}
+            Iter( map_pointer map, const size_t& i ) : m_map(map), m_i(i) { skip(); }
+            /// iterator to const_iterator
+            Iter( const Iter<false>& it ) : m_map(it.m_map), m_i(it.m_i) {}
+
+            reference operator* () const { return  m_map->m_slots[m_i]; }
+            pointer   operator->() const { return &m_map->m_slots[m_i]; }
+
+            Iter& operator++() {
+                m_i++;
+                skip();
+                return *this;
+            }
+            Iter operator++( int ) {
+                Iter it( *this );
+                ++(*this);
+                return it;
+            }
+            bool operator==( const Iter& rhs ) const { return m_i == rhs.m_i; }
+            bool operator!=( const Iter& rhs ) const { return m_i != rhs.m_i; }
+
+        private:
+            map_pointer m_map;
+            size_t      m_i;
+            void skip() {
+                while( m_i < m_map->m_dist.size() && m_map->m_dist[m_i] == 0 )
+                    m_i++;
+            }
+            friend class FlatHashMap;
+            friend class Iter<true>;
+        };
+        typedef Iter<false> iterator;
+        typedef Iter<true>  const_iterator;
+
+        FlatHashMap() : m_size(0), m_mask(0) {}
+
+        size_t size    () const { return m_size;        }
+        bool   empty   () const { return m_size == 0;   }
+        /// number of slots
+        size_t capacity() const { return m_dist.size(); }
+
+        /// removes the entries and keeps the slots
+        void clear() {
+            for( size_t i=0; i<m_dist.size(); i++ ) {
+                if( m_dist[i] == 0 ) continue;
+                m_slots[i] = value_type();
+                m_dist [i] = 0;
+            }
+            m_size = 0;
+        }
+
+        void release() {
+            vector<value_type>().swap( m_slots );
+            vector<uint8_t>   ().swap( m_dist  );
+            m_size = 0;
+            m_mask = 0;
+        }
+
+        /// makes room for n entries without rehashing
+        void reserve( const size_t& n ) {
+            size_t n_slots = size_t( MIN_SLOTS );
+            while( n_slots/8*7 < n )
+                n_slots *= 2;
+            if( n_slots > capacity() )
+                rehash( n_slots );
+        }
+
+        iterator       begin()       { return iterator      ( this, 0 ); }
+        iterator       end  ()       { return iterator      ( this, capacity() ); }
+        const_iterator begin() const { return const_iterator( this, 0 ); }
+        const_iterator end  () const { return const_iterator( this, capacity() ); }
+
+        iterator       find( const Key& key )       { return iterator      ( this, find_slot( key ) ); }
+        const_iterator find( const Key& key ) const { return const_iterator( this, find_slot( key ) ); }
+
+        size_t count( const Key& key ) const { return find_slot( key ) == capacity() ? 0 : 1; }
+
+        /// inserts a value initialized entry if key does not exist
+        T& operator[]( const Key& key ) {
+            size_t i = find_slot( key );
+            if( i == capacity() )
+                i = insert_new( value_type( key, T() ) );
+            return m_slots[i].second;
+        }
+
+        T& at( const Key& key ) {
+            size_t i = find_slot( key );
+            passert_statement( i != capacity(), "key does not exist" );
+            return m_slots[i].second;
+        }
+        const T& at( const Key& key ) const {
+            size_t i = find_slot( key );
+            passert_statement( i != capacity(), "key does not exist" );
+            return m_slots[i].second;
+        }
+
+        /// inserts v if its key does not exist. returns the entry of the key
+        /// and whether v was inserted.
+        std::pair<iterator,bool> insert( const value_type& v ) {
+            size_t i = find_slot( v.first );
+            if( i != capacity() )
+                return std::pair<iterator,bool>( iterator( this, i ), false );
+            i = insert_new( v );
+            return std::pair<iterator,bool>( iterator( this, i ), true );
+        }
+
+        /// returns the number of erased entries
+        size_t erase( const Key& key ) {
+            size_t i = find_slot( key );
+            if( i == capacity() )
+                return 0;
+            // backward shift - the following displaced entries move one slot
+            // closer to their homes
+            size_t j = ( i+1 ) & m_mask;
+            while( m_dist[j] > 1 ) {
+                m_slots[i] = std::move( m_slots[j] );
+                m_dist [i] = uint8_t( m_dist[j] - 1 );
+                i = j;
+                j = ( j+1 ) & m_mask;
+            }
+            m_slots[i] = value_type();
+            m_dist [i] = 0;
+            m_size--;
+            return 1;
+        }
+
+        /// erases the entries for which pred( entry ) is true. returns the
+        /// number of erased entries.
+        template< typename Predicate >
+        size_t erase_if( Predicate pred ) {
+            vector<value_type> slots( capacity() );
+            vector<uint8_t>    dist ( capacity(), 0 );
+            slots.swap( m_slots );
+            dist .swap( m_dist  );
+            const size_t n_old = m_size;
+            m_size = 0;
+            for( size_t i=0; i<dist.size(); i++ )
+                if( dist[i] && !pred( slots[i] ) )
+                    place( std::move( slots[i] ) );
+            return n_old - m_size;
+        }
+
+    private:
+        enum { MIN_SLOTS = 16, MAX_DIST = 255 };
+
+        vector<value_type> m_slots;
+        /// 0 for empty slots, 1 + the distance to the home slot otherwise
+        vector<uint8_t>    m_dist;
+        size_t             m_size;
+        size_t             m_mask;
+        Hash               m_hash;
+        KeyEqual           m_equal;
+
+        size_t home( const Key& key ) const { return m_hash( key ) & m_mask; }
+
+        // the slot of key or capacity() if it does not exist
+        size_t find_slot( const Key& key ) const {
+            if( m_size == 0 ) return capacity();
+            size_t i = home( key );
+            for( int d=1; d<=MAX_DIST; d++ ) {
+                if( m_dist[i] < d )
+                    break;
+                if( m_dist[i] == d && m_equal( m_slots[i].first, key ) )
+                    return i;
+                i = ( i+1 ) & m_mask;
+            }
+            return capacity();
+        }
+
+        size_t insert_new( const value_type& v ) {
+            if( ( m_size+1 )*8 > capacity()*7 )
+                rehash( capacity() ? 2*capacity() : size_t( MIN_SLOTS ) );
+            return place( value_type( v ) );
+        }
+
+        // inserts v - there has to be an empty slot. v takes the slot of any
+        // entry closer to its home and the displaced entry continues the
+        // probe. returns the slot of v.
+        size_t place( value_type&& v ) {
+            size_t i      = home( v.first );
+            size_t placed = capacity();
+            int    d      = 1;
+            while( true ) {
+                if( m_dist[i] == 0 ) {
+                    m_slots[i] = std::move( v );
+                    m_dist [i] = uint8_t( d );
+                    m_size++;
+                    return placed == capacity() ? i : placed;
+                }
+                if( m_dist[i] < d ) {
+                    std::swap( v, m_slots[i] );
+                    int di = m_dist[i];
+                    m_dist[i] = uint8_t( d );
+                    d = di;
+                    if( placed == capacity() ) placed = i;
+                }
+                i = ( i+1 ) & m_mask;
+                if( ++d > MAX_DIST ) {
+                    // probe too long for the distance bytes - grow and
+                    // insert the entry in hand again
+                    Key key = placed == capacity() ? v.first : m_slots[placed].first;
+                    rehash( 2*capacity() );
+                    place( std::move( v ) );
+                    return find_slot( key );
+                }
+            }
+        }
+
+        void rehash( const size_t& n_slots ) {
+            vector<value_type> slots( n_slots );
+            vector<uint8_t>    dist ( n_slots, 0 );
+            slots.swap( m_slots );
+            dist .swap( m_dist  );
+            m_mask = n_slots-1;
+            m_size = 0;
+            for( size_t i=0; i<dist.size(); i++ )
+                if( dist[i] )
+                    place( std::move( slots[i] ) );
+        }
+    };
+
+}
+
+#endif
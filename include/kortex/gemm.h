@@ -0,0 +1,51 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+//
+// general matrix multiplication C = op(A) * op(B) for row-major matrices
+// where op(X) is X or X'. op(A) is m x k, op(B) is k x n and C is m x n. lda,
+// ldb, ldc are the row strides of the stored ( not transposed ) matrices.
+//
+#ifndef KORTEX_GEMM_H
+#define KORTEX_GEMM_H
+
+namespace kortex {
+
+    /// products smaller than this many multiply-adds are computed with plain
+    /// loops by mat_gemm
+    const double GEMM_SMALL_PRODUCT = 32.0*32.0*32.0;
+
+    /// cache-blocked gemm - op(A) and op(B) are packed into panels and
+    /// multiplied with register-blocked avx2/avx512 fma micro-kernels. the
+    /// blocks of C are distributed over the openmp threads.
+    void mat_gemm_packed( const bool& trans_a, const bool& trans_b, const int& m, const int& n, const int& k,
+                          const double* A, const int& lda, const double* B, const int& ldb,
+                          double* C, const int& ldc );
+
+#ifdef WITH_BLAS
+    /// dgemm of the linked blas library
+    void mat_gemm_blas( const bool& trans_a, const bool& trans_b, const int& m, const int& n, const int& k,
+                        const double* A, const int& lda, const double* B, const int& ldb,
+                        double* C, const int& ldc );
+#endif
+
+    /// computes small products with plain loops and larger ones with blas
+    /// when WITH_BLAS is defined, with mat_gemm_packed otherwise. used by
+    /// mat_mat, mat_mat_trans and mat_trans_mat.
+    void mat_gemm( const bool& trans_a, const bool& trans_b, const int& m, const int& n, const int& k,
+                   const double* A, const int& lda, const double* B, const int& ldb,
+                   double* C, const int& ldc );
+
+}
+
+#endif
@@ -32,6 +32,20 @@ namespace kortex {
     double compute_plane( const vector<const double*> pnts, double plane[4] );
     float compute_plane ( const vector< Vec3f >& pnts, float plane[4] );
 
+    /// fits planes to n_nbh neighborhoods of the points pnts[3*n_pnts]. the
+    /// i'th neighborhood is the points indexed by nbh[ nbh_offsets[i] ...
+    /// nbh_offsets[i+1] ). its plane is written to planes[4*i] and its
+    /// curvature estimate to curvatures[i] ( if not NULL ). neighborhoods with
+    /// less than 4 points get a zero plane and a curvature of -1. the
+    /// neighborhoods are processed in parallel.
+    void compute_planes( const float* pnts, const int& n_pnts, const int* nbh, const int* nbh_offsets,
+                         const int& n_nbh, float* planes, float* curvatures );
+
+    /// compute_planes for neighborhoods of k points each - e.g. the k nearest
+    /// neighbors of every point. nbh is n_nbh x k.
+    void compute_knn_planes( const float* pnts, const int& n_pnts, const int* nbh, const int& k,
+                             const int& n_nbh, float* planes, float* curvatures );
+
     double point_to_plane_distance( const double X[3], const double plane[4] );
     float  point_to_plane_distance( const float  X[3], const float  plane[4] );
 
@@ -19,6 +19,7 @@
 #include <kortex/types.h>
 #include <kortex/check.h>
 #include <kortex/mem_unit.h>
+#include <kortex/rect2.h>
 
 using std::ofstream;
 using std::ifstream;
@@ -55,10 +56,14 @@ namespace kortex {
 	class Image {
 	private:
 		void init_();
+		void create_( int w, int h, ImageType type, size_t stride );
+		void take_( Image& img );
 
 		int         m_w;
 		int         m_h;
 		int         m_ch;
+		size_t      m_stride;
+		size_t      m_plane;
 		ImageType   m_type;
 		ChannelType m_channel_type;
 		uchar*      m_data_u;
@@ -75,8 +80,28 @@ namespace kortex {
 
 		Image& operator=( const Image& p );
 
+		/// takes over the buffer of img when both images own their memory -
+		/// img is left empty. wrappers are copied as in the copy versions.
+		Image( Image&& img ) noexcept;
+		Image& operator=( Image&& p );
+
 		void create( int w, int h, ImageType type );
 
+		/// creates an image whose rows start at MEMORY_ALIGNMENT ( 64 byte )
+		/// boundaries - rows are padded so that kernels can use aligned loads
+		/// on every row.
+		void create_padded( int w, int h, ImageType type );
+
+		/// makes the image a wrapper around an externally managed buffer of
+		/// size req_mem(w,h,type)-sizeof(Image) - the content is neither copied
+		/// nor released by the image.
+		void create_wrapper( int w, int h, ImageType type, void* buffer );
+
+		/// makes the image a zero-copy view of the roi [lx,ux)x[ly,uy) of
+		/// img. the view shares the rows of img - writing to the view changes
+		/// img and the view is invalidated when img is released.
+		void create_wrapper( const Image& img, const Rect2i& roi );
+
 		~Image();
 		void release();
 
@@ -95,6 +120,17 @@ namespace kortex {
 		int         pixel_count()   const { return m_w*m_h;                 }
 		size_t      element_count() const { return size_t(m_w)*size_t(m_h)*size_t(m_ch); }
 
+		/// number of elements between the starts of consecutive rows ( of a
+		/// channel plane for image-ordered types ). rows are packed unless the
+		/// image is padded or a region view.
+		size_t      stride()        const { return m_stride;                }
+		/// number of elements between the starts of channel planes of
+		/// image-ordered types
+		size_t      plane_stride()  const { return m_plane;                 }
+		/// rows ( and planes ) are packed - the image can be processed as a
+		/// single buffer of element_count() elements
+		bool        is_contiguous() const;
+
 		bool is_inside( int x, int y ) const {
 			return kortex::is_inside(x,0,m_w)
 				&& kortex::is_inside(y,0,m_h);
@@ -206,6 +242,13 @@ namespace kortex {
 		void  get_bicubic_fp (const float& x0, const float& y0, float& r, float& g, float& b) const;
 		void  get_bicubic_fi (const float& x0, const float& y0, float& r, float& g, float& b) const;
 
+		/// batched get_bilinear / get_bicubic - samples the n points
+		/// (xs[i],ys[i]) with a single type dispatch. single channel images
+		/// write out[i], 3-channel images write all channels in one pass as
+		/// out[3*i+c]. coordinates are clamped to the image.
+		void  get_bilinear( const float* xs, const float* ys, const int& n, float* out ) const;
+		void  get_bicubic ( const float* xs, const float* ys, const int& n, float* out ) const;
+
 		/// returns a simple 2-point gradient. for full image gradient check the
 		/// image_processing.h for a more efficient version
 		float get_grad_x( const int& x0, const int &y0 ) const;
@@ -317,6 +360,12 @@ namespace kortex {
 		float get_min_neighbour_f( const int& x0, const int& y0, int rsz ) const;
 		float get_max_neighbour_f( const int& x0, const int& y0, int rsz ) const;
 
+		/// asserts packed rows - persistent in DEBUG/RELEASE mode. required by
+		/// the functions that process the image as a single buffer.
+		void passert_contiguous() const {
+			passert_statement( is_contiguous(), "image should have packed rows - copy padded images and region views first" );
+		}
+
 		/// asserts the image type - disables in RELEASE mode
 		void assert_type( int type ) const {
 			assert_statement( m_type & type, "invalid image type" );
@@ -464,6 +513,11 @@ namespace kortex {
 
 //
 	void extract_region_patch  ( const Image& img, int x0, int y0, int x1, int y1, Image& patch );
+
+	/// zero-copy version of extract_region_patch for regions inside the
+	/// image - patch becomes a view of img ( see Image::create_wrapper ).
+	/// regions crossing the border are copied and zero padded.
+	void extract_region_view   ( const Image& img, int x0, int y0, int x1, int y1, Image& patch );
 	void extract_centered_patch( const Image& img, int x0, int y0, int pw, int ph, Image& patch );
 
 
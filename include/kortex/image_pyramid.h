@@ -0,0 +1,92 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+#ifndef KORTEX_IMAGE_PYRAMID_H
+#define KORTEX_IMAGE_PYRAMID_H
+
+#include <kortex/image.h>
+#include <kortex/mem_unit.h>
+
+#include <vector>
+using std::vector;
+
+namespace kortex {
+
+    /// gaussian scale-space of an IT_F_GRAY image. every octave has n_levels
+    /// levels and the blur of level l is sigma0 * 2^(l/n_scales) in the pixel
+    /// units of its octave - so level n_scales has twice the blur of level 0
+    /// and n_levels > n_scales+1 gives extra levels ( ie n_scales+3 for
+    /// difference of gaussians ). octave o is half the size of octave o-1;
+    /// its level 0 is level n_scales of octave o-1 decimated by 2.
+    ///
+    /// all levels live in a single memory block that is reused as long as the
+    /// pyramid is rebuilt with the same geometry.
+    class ImagePyramid {
+    public:
+        ImagePyramid();
+
+        /// n_octaves <= 0 creates octaves as long as the smaller image side is
+        /// at least 16 pixels. input_sigma is the blur assumed to be present
+        /// in the images passed to build.
+        void create( const int& w, const int& h, const int& n_octaves, const int& n_scales,
+                     const int& n_levels, const float& sigma0, const float& input_sigma );
+
+        /// computes all levels. every level is blurred incrementally from the
+        /// previous one. build_par runs the filters of each level in
+        /// parallel and gives the same result as build.
+        void build    ( const Image& img );
+        void build_par( const Image& img );
+
+        void release();
+
+        int   n_octaves() const { return m_n_octaves; }
+        int   n_scales () const { return m_n_scales;  }
+        int   n_levels () const { return m_n_levels;  }
+        float sigma0   () const { return m_sigma0;    }
+
+        int   octave_w( const int& octave ) const;
+        int   octave_h( const int& octave ) const;
+
+        const Image* get_level( const int& octave, const int& level ) const;
+        Image*       get_level( const int& octave, const int& level );
+
+        /// blur of the level in the pixel units of its octave
+        float level_sigma( const int& level ) const;
+
+        /// blur of the level in the pixel units of the input image
+        float scale( const int& octave, const int& level ) const;
+
+        size_t mem_usage() const;
+
+    private:
+        ImagePyramid( const ImagePyramid& p );
+        ImagePyramid& operator=( const ImagePyramid& p );
+
+        void build_base  ( const Image& img, const bool& run_parallel );
+        void build_levels( const Image& img, const bool& run_parallel );
+
+        int   m_w;
+        int   m_h;
+        int   m_n_octaves;
+        int   m_n_scales;
+        int   m_n_levels;
+        float m_sigma0;
+        float m_input_sigma;
+
+        MemUnit       m_memory;
+        vector<Image> m_levels;  // octave major
+    };
+
+}
+
+#endif
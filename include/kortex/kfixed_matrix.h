@@ -0,0 +1,500 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+//
+// fixed-size matrices - dimensions are template parameters and the data lives
+// on the stack. storage is row-major like KMatrix so operator()() can be
+// passed to the raw mat_* functions of matrix.h directly. meant for the small
+// 3x3/3x4/4x4 geometry math where KMatrix spends more time in allocation than
+// in arithmetic.
+//
+#ifndef KORTEX_KFIXED_MATRIX_H
+#define KORTEX_KFIXED_MATRIX_H
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <type_traits>
+
+#include <kortex/check.h>
+#include <kortex/kvector.h>
+#include <kortex/kmatrix.h>
+
+#if defined(__GNUC__)
+#define KORTEX_UNROLL _Pragma("GCC unroll 16")
+#else
+#define KORTEX_UNROLL
+#endif
+
+namespace kortex {
+
+    template <typename T, int R, int C> class KFixedMatrix;
+
+    typedef KFixedMatrix<double,2,2> Mat2d;
+    typedef KFixedMatrix<double,3,3> Mat3d;
+    typedef KFixedMatrix<double,3,4> Mat34d;
+    typedef KFixedMatrix<double,4,4> Mat4d;
+
+    typedef KFixedMatrix<float,2,2>  Mat2f;
+    typedef KFixedMatrix<float,3,3>  Mat3f;
+    typedef KFixedMatrix<float,3,4>  Mat34f;
+    typedef KFixedMatrix<float,4,4>  Mat4f;
+
+    template<typename T, int R, int C>
+    class KFixedMatrix {
+        static_assert( R > 0 && C > 0, "invalid matrix dimensions" );
+    public:
+        /// contents are uninitialized
+        KFixedMatrix() {}
+        explicit KFixedMatrix( const T* vals ) { set( vals ); }
+        /// copies a KMatrix of the same dimensions
+        explicit KFixedMatrix( const KMatrix& A ) { set( A ); }
+
+        static constexpr int h   () { return R;   }
+        static constexpr int w   () { return C;   }
+        static constexpr int size() { return R*C; }
+        static constexpr bool is_square() { return R == C; }
+
+        void set( const T* vals ) {
+            assert_pointer( vals );
+            std::copy( vals, vals+R*C, m_v );
+        }
+        void set( const KMatrix& A ) {
+            assert_statement_g( A.h() == R && A.w() == C, "dimension mismatch [%d %d] [%d %d]", A.h(), A.w(), R, C );
+            const double* a = A();
+            KORTEX_UNROLL
+            for( int i=0; i<R*C; i++ )
+                m_v[i] = static_cast<T>( a[i] );
+        }
+        void set_row( int r, const T* rdata ) { std::copy( rdata, rdata+C, m_v+r*C ); }
+        void set_col( int c, const T* cdata ) {
+            KORTEX_UNROLL
+            for( int r=0; r<R; r++ )
+                m_v[r*C+c] = cdata[r];
+        }
+
+        /// wraps the data as a KMatrix - changes through the wrapper are
+        /// reflected here. see initialize() for a copy.
+        KMatrix wrapper() {
+            static_assert( std::is_same<T,double>::value, "only double matrices can be wrapped" );
+            return KMatrix( m_v, R, C );
+        }
+
+        T*       operator()()       { return m_v; }
+        const T* operator()() const { return m_v; }
+
+        T&       operator()( int r, int c )       { assert_boundary(r,0,R); assert_boundary(c,0,C); return m_v[r*C+c]; }
+        const T& operator()( int r, int c ) const { assert_boundary(r,0,R); assert_boundary(c,0,C); return m_v[r*C+c]; }
+
+        T&       operator[]( int k )       { assert_boundary(k,0,R*C); return m_v[k]; }
+        const T& operator[]( int k ) const { assert_boundary(k,0,R*C); return m_v[k]; }
+
+        T*       get_row( int r )       { assert_boundary(r,0,R); return m_v+r*C; }
+        const T* get_row( int r ) const { assert_boundary(r,0,R); return m_v+r*C; }
+
+        void zero() { std::fill( m_v, m_v+R*C, T(0) ); }
+        void identity() {
+            zero();
+            KORTEX_UNROLL
+            for( int i=0; i<( R < C ? R : C ); i++ )
+                m_v[i*C+i] = T(1);
+        }
+
+        void negate() {
+            KORTEX_UNROLL
+            for( int i=0; i<R*C; i++ )
+                m_v[i] = -m_v[i];
+        }
+        void scale( const T& s ) {
+            KORTEX_UNROLL
+            for( int i=0; i<R*C; i++ )
+                m_v[i] *= s;
+        }
+
+        /// in-place transpose - square matrices only. see mat_transpose().
+        void transpose() {
+            static_assert( R == C, "in-place transpose needs a square matrix" );
+            KORTEX_UNROLL
+            for( int r=0; r<R; r++ ) {
+                for( int c=r+1; c<C; c++ )
+                    std::swap( m_v[r*C+c], m_v[c*C+r] );
+            }
+        }
+
+        T trace() const {
+            T t = T(0);
+            KORTEX_UNROLL
+            for( int i=0; i<( R < C ? R : C ); i++ )
+                t += m_v[i*C+i];
+            return t;
+        }
+        T det() const;
+
+        T norm_sq() const {
+            T s = T(0);
+            KORTEX_UNROLL
+            for( int i=0; i<R*C; i++ )
+                s += m_v[i]*m_v[i];
+            return s;
+        }
+        T norm() const { return std::sqrt( norm_sq() ); }
+
+        KFixedMatrix<T,C,R> transposed() const {
+            KFixedMatrix<T,C,R> At;
+            KORTEX_UNROLL
+            for( int r=0; r<R; r++ ) {
+                KORTEX_UNROLL
+                for( int c=0; c<C; c++ )
+                    At(c,r) = m_v[r*C+c];
+            }
+            return At;
+        }
+
+        /// returns the inverse - fatals out for singular matrices. use
+        /// mat_inv() to handle them.
+        KFixedMatrix<T,R,C> inv() const;
+
+        KFixedMatrix<T,R,C> operator+( const KFixedMatrix<T,R,C>& rhs ) const {
+            KFixedMatrix<T,R,C> res;
+            KORTEX_UNROLL
+            for( int i=0; i<R*C; i++ )
+                res.m_v[i] = m_v[i] + rhs.m_v[i];
+            return res;
+        }
+        KFixedMatrix<T,R,C> operator-( const KFixedMatrix<T,R,C>& rhs ) const {
+            KFixedMatrix<T,R,C> res;
+            KORTEX_UNROLL
+            for( int i=0; i<R*C; i++ )
+                res.m_v[i] = m_v[i] - rhs.m_v[i];
+            return res;
+        }
+        KFixedMatrix<T,R,C> operator*( const T& s ) const {
+            KFixedMatrix<T,R,C> res;
+            KORTEX_UNROLL
+            for( int i=0; i<R*C; i++ )
+                res.m_v[i] = m_v[i] * s;
+            return res;
+        }
+        void operator+=( const KFixedMatrix<T,R,C>& rhs ) {
+            KORTEX_UNROLL
+            for( int i=0; i<R*C; i++ )
+                m_v[i] += rhs.m_v[i];
+        }
+        void operator-=( const KFixedMatrix<T,R,C>& rhs ) {
+            KORTEX_UNROLL
+            for( int i=0; i<R*C; i++ )
+                m_v[i] -= rhs.m_v[i];
+        }
+
+        template<int K>
+        KFixedMatrix<T,R,K> operator*( const KFixedMatrix<T,C,K>& rhs ) const;
+
+        KVector<T,R> operator*( const KVector<T,C>& x ) const;
+
+        void print( const char* str ) const {
+            if( str ) printf( "%s\n", str );
+            for( int r=0; r<R; r++ ) {
+                for( int c=0; c<C; c++ )
+                    printf( "%f ", double( m_v[r*C+c] ) );
+                printf( "\n" );
+            }
+        }
+
+    private:
+        T m_v[R*C];
+    };
+
+///
+/// mat-ops
+///
+
+    /// C = A * B
+    template<typename T, int M, int K, int N>
+    inline void mat_mat( const KFixedMatrix<T,M,K>& A, const KFixedMatrix<T,K,N>& B, KFixedMatrix<T,M,N>& C ) {
+        assert_noalias_p( A(), C() );
+        assert_noalias_p( B(), C() );
+        const T* a = A();
+        const T* b = B();
+        T*       c = C();
+        KORTEX_UNROLL
+        for( int r=0; r<M; r++ ) {
+            KORTEX_UNROLL
+            for( int j=0; j<N; j++ ) {
+                T s = T(0);
+                KORTEX_UNROLL
+                for( int k=0; k<K; k++ )
+                    s += a[r*K+k] * b[k*N+j];
+                c[r*N+j] = s;
+            }
+        }
+    }
+
+    /// C = A' * B
+    template<typename T, int K, int M, int N>
+    inline void mat_trans_mat( const KFixedMatrix<T,K,M>& A, const KFixedMatrix<T,K,N>& B, KFixedMatrix<T,M,N>& C ) {
+        assert_noalias_p( A(), C() );
+        assert_noalias_p( B(), C() );
+        const T* a = A();
+        const T* b = B();
+        T*       c = C();
+        KORTEX_UNROLL
+        for( int r=0; r<M; r++ ) {
+            KORTEX_UNROLL
+            for( int j=0; j<N; j++ ) {
+                T s = T(0);
+                KORTEX_UNROLL
+                for( int k=0; k<K; k++ )
+                    s += a[k*M+r] * b[k*N+j];
+                c[r*N+j] = s;
+            }
+        }
+    }
+
+    /// C = A * B'
+    template<typename T, int M, int K, int N>
+    inline void mat_mat_trans( const KFixedMatrix<T,M,K>& A, const KFixedMatrix<T,N,K>& B, KFixedMatrix<T,M,N>& C ) {
+        assert_noalias_p( A(), C() );
+        assert_noalias_p( B(), C() );
+        const T* a = A();
+        const T* b = B();
+        T*       c = C();
+        KORTEX_UNROLL
+        for( int r=0; r<M; r++ ) {
+            KORTEX_UNROLL
+            for( int j=0; j<N; j++ ) {
+                T s = T(0);
+                KORTEX_UNROLL
+                for( int k=0; k<K; k++ )
+                    s += a[r*K+k] * b[j*K+k];
+                c[r*N+j] = s;
+            }
+        }
+    }
+
+    /// y = A * x
+    template<typename T, int R, int C>
+    inline void mat_vec( const KFixedMatrix<T,R,C>& A, const T* x, T* y ) {
+        assert_noalias_p( x, y );
+        const T* a = A();
+        KORTEX_UNROLL
+        for( int r=0; r<R; r++ ) {
+            T s = T(0);
+            KORTEX_UNROLL
+            for( int k=0; k<C; k++ )
+                s += a[r*C+k] * x[k];
+            y[r] = s;
+        }
+    }
+
+    /// y = A' * x
+    template<typename T, int R, int C>
+    inline void mat_trans_vec( const KFixedMatrix<T,R,C>& A, const T* x, T* y ) {
+        assert_noalias_p( x, y );
+        const T* a = A();
+        KORTEX_UNROLL
+        for( int c=0; c<C; c++ ) {
+            T s = T(0);
+            KORTEX_UNROLL
+            for( int k=0; k<R; k++ )
+                s += a[k*C+c] * x[k];
+            y[c] = s;
+        }
+    }
+
+    template<typename T, int R, int C>
+    inline void mat_transpose( const KFixedMatrix<T,R,C>& A, KFixedMatrix<T,C,R>& At ) {
+        At = A.transposed();
+    }
+
+    template<typename T>
+    inline T mat_det( const KFixedMatrix<T,1,1>& A ) { return A[0]; }
+
+    template<typename T>
+    inline T mat_det( const KFixedMatrix<T,2,2>& A ) {
+        const T* a = A();
+        return a[0]*a[3] - a[1]*a[2];
+    }
+
+    template<typename T>
+    inline T mat_det( const KFixedMatrix<T,3,3>& A ) {
+        const T* a = A();
+        return a[0] * ( a[4]*a[8] - a[5]*a[7] )
+            -  a[1] * ( a[3]*a[8] - a[5]*a[6] )
+            +  a[2] * ( a[3]*a[7] - a[4]*a[6] );
+    }
+
+    template<typename T>
+    inline T mat_det( const KFixedMatrix<T,4,4>& A ) {
+        const T* a = A();
+        // 2x2 minors of the top and bottom row pairs
+        T s0 = a[0]*a[5]  - a[4]*a[1];
+        T s1 = a[0]*a[6]  - a[4]*a[2];
+        T s2 = a[0]*a[7]  - a[4]*a[3];
+        T s3 = a[1]*a[6]  - a[5]*a[2];
+        T s4 = a[1]*a[7]  - a[5]*a[3];
+        T s5 = a[2]*a[7]  - a[6]*a[3];
+        T c5 = a[10]*a[15] - a[14]*a[11];
+        T c4 = a[9] *a[15] - a[13]*a[11];
+        T c3 = a[9] *a[14] - a[13]*a[10];
+        T c2 = a[8] *a[15] - a[12]*a[11];
+        T c1 = a[8] *a[14] - a[12]*a[10];
+        T c0 = a[8] *a[13] - a[12]*a[9];
+        return s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+    }
+
+    /// iA = inv(A) for 2x2, 3x3 and 4x4 matrices. returns false and zeros iA
+    /// if |det(A)| <= inversion_threshold.
+    template<typename T>
+    inline bool mat_inv( const KFixedMatrix<T,2,2>& A, KFixedMatrix<T,2,2>& iA, const T& inversion_threshold=T(0) ) {
+        assert_noalias_p( A(), iA() );
+        T d = mat_det( A );
+        if( !( std::fabs(d) > inversion_threshold ) ) {
+            iA.zero();
+            return false;
+        }
+        T id = T(1) / d;
+        const T* a = A();
+        T*       b = iA();
+        b[0] =  a[3]*id;
+        b[1] = -a[1]*id;
+        b[2] = -a[2]*id;
+        b[3] =  a[0]*id;
+        return true;
+    }
+
+    template<typename T>
+    inline bool mat_inv( const KFixedMatrix<T,3,3>& A, KFixedMatrix<T,3,3>& iA, const T& inversion_threshold=T(0) ) {
+        assert_noalias_p( A(), iA() );
+        const T* a = A();
+        T*       b = iA();
+        T c0 = a[4]*a[8] - a[5]*a[7];
+        T c1 = a[5]*a[6] - a[3]*a[8];
+        T c2 = a[3]*a[7] - a[4]*a[6];
+        T d  = a[0]*c0 + a[1]*c1 + a[2]*c2;
+        if( !( std::fabs(d) > inversion_threshold ) ) {
+            iA.zero();
+            return false;
+        }
+        T id = T(1) / d;
+        b[0] = c0 * id;
+        b[1] = ( a[2]*a[7] - a[1]*a[8] ) * id;
+        b[2] = ( a[1]*a[5] - a[2]*a[4] ) * id;
+        b[3] = c1 * id;
+        b[4] = ( a[0]*a[8] - a[2]*a[6] ) * id;
+        b[5] = ( a[2]*a[3] - a[0]*a[5] ) * id;
+        b[6] = c2 * id;
+        b[7] = ( a[1]*a[6] - a[0]*a[7] ) * id;
+        b[8] = ( a[0]*a[4] - a[1]*a[3] ) * id;
+        return true;
+    }
+
+    template<typename T>
+    inline bool mat_inv( const KFixedMatrix<T,4,4>& A, KFixedMatrix<T,4,4>& iA, const T& inversion_threshold=T(0) ) {
+        assert_noalias_p( A(), iA() );
+        const T* a = A();
+        T*       b = iA();
+        T s0 = a[0]*a[5]  - a[4]*a[1];
+        T s1 = a[0]*a[6]  - a[4]*a[2];
+        T s2 = a[0]*a[7]  - a[4]*a[3];
+        T s3 = a[1]*a[6]  - a[5]*a[2];
+        T s4 = a[1]*a[7]  - a[5]*a[3];
+        T s5 = a[2]*a[7]  - a[6]*a[3];
+        T c5 = a[10]*a[15] - a[14]*a[11];
+        T c4 = a[9] *a[15] - a[13]*a[11];
+        T c3 = a[9] *a[14] - a[13]*a[10];
+        T c2 = a[8] *a[15] - a[12]*a[11];
+        T c1 = a[8] *a[14] - a[12]*a[10];
+        T c0 = a[8] *a[13] - a[12]*a[9];
+        T d  = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+        if( !( std::fabs(d) > inversion_threshold ) ) {
+            iA.zero();
+            return false;
+        }
+        T id = T(1) / d;
+        b[0]  = (  a[5] *c5 - a[6] *c4 + a[7] *c3 ) * id;
+        b[1]  = ( -a[1] *c5 + a[2] *c4 - a[3] *c3 ) * id;
+        b[2]  = (  a[13]*s5 - a[14]*s4 + a[15]*s3 ) * id;
+        b[3]  = ( -a[9] *s5 + a[10]*s4 - a[11]*s3 ) * id;
+        b[4]  = ( -a[4] *c5 + a[6] *c2 - a[7] *c1 ) * id;
+        b[5]  = (  a[0] *c5 - a[2] *c2 + a[3] *c1 ) * id;
+        b[6]  = ( -a[12]*s5 + a[14]*s2 - a[15]*s1 ) * id;
+        b[7]  = (  a[8] *s5 - a[10]*s2 + a[11]*s1 ) * id;
+        b[8]  = (  a[4] *c4 - a[5] *c2 + a[7] *c0 ) * id;
+        b[9]  = ( -a[0] *c4 + a[1] *c2 - a[3] *c0 ) * id;
+        b[10] = (  a[12]*s4 - a[13]*s2 + a[15]*s0 ) * id;
+        b[11] = ( -a[8] *s4 + a[9] *s2 - a[11]*s0 ) * id;
+        b[12] = ( -a[4] *c3 + a[5] *c1 - a[6] *c0 ) * id;
+        b[13] = (  a[0] *c3 - a[1] *c1 + a[2] *c0 ) * id;
+        b[14] = ( -a[12]*s3 + a[13]*s1 - a[14]*s0 ) * id;
+        b[15] = (  a[8] *s3 - a[9] *s1 + a[10]*s0 ) * id;
+        return true;
+    }
+
+    /// copies A into a KMatrix
+    template<typename T, int R, int C>
+    inline void initialize( const KFixedMatrix<T,R,C>& A, KMatrix& mA ) {
+        mA.resize( R, C );
+        double* m = mA.get_pointer();
+        for( int i=0; i<R*C; i++ )
+            m[i] = static_cast<double>( A[i] );
+    }
+
+    template<typename T, int R, int C>
+    inline void initialize( const KMatrix& mA, KFixedMatrix<T,R,C>& A ) {
+        A.set( mA );
+    }
+
+    template<typename T, int R, int C>
+    inline bool is_equal( const KFixedMatrix<T,R,C>& A, const KFixedMatrix<T,R,C>& B, const T& eps ) {
+        for( int i=0; i<R*C; i++ )
+            if( std::fabs( A[i]-B[i] ) > eps )
+                return false;
+        return true;
+    }
+
+//
+//
+//
+    template<typename T, int R, int C>
+    inline T KFixedMatrix<T,R,C>::det() const {
+        static_assert( R == C && R <= 4, "det is defined for square matrices up to 4x4 - use KMatrix" );
+        return mat_det( *this );
+    }
+
+    template<typename T, int R, int C>
+    inline KFixedMatrix<T,R,C> KFixedMatrix<T,R,C>::inv() const {
+        static_assert( R == C && R >= 2 && R <= 4, "inv is defined for 2x2 to 4x4 matrices - use KMatrix" );
+        KFixedMatrix<T,R,C> iA;
+        if( !mat_inv( *this, iA ) )
+            logman_fatal( "singular matrix" );
+        return iA;
+    }
+
+    template<typename T, int R, int C>
+    template<int K>
+    inline KFixedMatrix<T,R,K> KFixedMatrix<T,R,C>::operator*( const KFixedMatrix<T,C,K>& rhs ) const {
+        KFixedMatrix<T,R,K> res;
+        mat_mat( *this, rhs, res );
+        return res;
+    }
+
+    template<typename T, int R, int C>
+    inline KVector<T,R> KFixedMatrix<T,R,C>::operator*( const KVector<T,C>& x ) const {
+        KVector<T,R> y;
+        mat_vec( *this, x(), y() );
+        return y;
+    }
+
+}
+
+#endif
@@ -22,6 +22,8 @@
 #include <kortex/check.h>
 
 #include <fstream>
+#include <utility>
+#include <type_traits>
 
 using std::ifstream;
 using std::ofstream;
@@ -30,17 +32,35 @@ using std::ofstream;
 namespace kortex {
 
     class KMatrix;
-    inline void mat_minus_mat( const KMatrix& A, const KMatrix& B, KMatrix& C );
-    inline void mat_plus_mat( const KMatrix& A, const KMatrix& B, KMatrix& C );
-    inline void mat_mat( const KMatrix& A, const KMatrix& B, KMatrix& C );
-    inline bool mat_inv( const KMatrix& A, KMatrix& iA );
+    class KMatrixInverse;
+
+    /// base of the lazy matrix expressions - A*B, A+B, A-B, s*A and A.inv()
+    /// build expression nodes which are evaluated into the destination matrix
+    /// when assigned. an expression provides h(), w(), eval( dst ) and
+    /// aliases( M ). nodes reference their matrix operands - do not keep an
+    /// expression beyond the statement it is built in ( e.g. with auto ).
+    template<typename E>
+    struct KMatrixExpr {
+        const E& self() const { return static_cast<const E&>( *this ); }
+    };
 
-    class KMatrix {
+    class KMatrix : public KMatrixExpr<KMatrix> {
     public:
         KMatrix();
         KMatrix( int h, int w );
         KMatrix( const KMatrix& rhs );
 
+        /// takes over the memory of rhs if it owns it - rhs is left
+        /// empty. wrapped matrices are copied as in the copy constructor.
+        KMatrix( KMatrix&& rhs ) noexcept;
+
+        /// evaluates the expression into the new matrix
+        template<typename E>
+        KMatrix( const KMatrixExpr<E>& expr ) {
+            init_();
+            expr.self().eval( *this );
+        }
+
         /// wraps around data - no change possible
         KMatrix( const double* data, int h, int w );
         /// wraps around data - possible to change
@@ -115,6 +135,24 @@ namespace kortex {
             return *this;
         }
 
+        /// moves the memory of rhs if both matrices own their memory - copies
+        /// otherwise so that wrapped data is written in place.
+        KMatrix& operator= ( KMatrix&& rhs );
+
+        /// evaluates the expression directly into this matrix. goes through a
+        /// temporary only if the expression reads this matrix.
+        template<typename E>
+        KMatrix& operator= ( const KMatrixExpr<E>& expr ) {
+            if( expr.self().aliases( *this ) ) {
+                KMatrix tmp;
+                expr.self().eval( tmp );
+                *this = std::move( tmp );
+            } else {
+                expr.self().eval( *this );
+            }
+            return *this;
+        }
+
         // convenient access
         const double* operator() () const {
             return get_const_pointer();
@@ -140,31 +178,15 @@ namespace kortex {
         }
 
 
-        KMatrix operator-( const KMatrix& rhs ) const {
-            KMatrix res;
-            mat_minus_mat( *this, rhs, res );
-            return res;
-        }
+        /// lazy inverse - A.inv()*B is evaluated as a solve without forming
+        /// a result temporary. singular matrices evaluate to identity with a
+        /// warning.
+        KMatrixInverse inv() const;
 
-        KMatrix operator+( const KMatrix& rhs ) const {
-            KMatrix res;
-            mat_plus_mat( *this, rhs, res );
-            return res;
-        }
-
-        KMatrix operator*( const KMatrix& rhs ) const {
-            KMatrix res;
-            mat_mat( *this, rhs, res );
-            return res;
-        }
-
-        KMatrix inv() const {
-            KMatrix res;
-            if( !mat_inv( *this, res ) ) {
-                logman_warning("could not invert matrix - setting to identity");
-                res.identity();
-            }
-            return res;
+        // expression interface
+        void eval( KMatrix& dst ) const { dst.copy( *this ); }
+        bool aliases( const KMatrix& M ) const {
+            return this == &M || ( size() && M.size() && get_const_pointer() == M.get_const_pointer() );
         }
 
         void set( int y0, int x0, double v ) {
@@ -227,6 +249,7 @@ namespace kortex {
         int     nc;
 
         void init_();
+        void take_( KMatrix& rhs );
 
         size_t req_mem(int h, int w) const { return sizeof(*m_data)*h*w; }
     };
@@ -432,6 +455,155 @@ namespace kortex {
         return true;
     }
 
+///
+/// lazy expressions
+///
+
+    /// leaves are held by reference, sub-expressions by value
+    template<typename E> struct KMatrixOperand          { typedef E              type; };
+    template<>           struct KMatrixOperand<KMatrix> { typedef const KMatrix& type; };
+
+    /// returns A itself for a matrix - evaluates into tmp otherwise
+    inline const KMatrix& kmatrix_operand( const KMatrix& A, KMatrix& ) { return A; }
+    template<typename E>
+    inline const KMatrix& kmatrix_operand( const KMatrixExpr<E>& expr, KMatrix& tmp ) {
+        expr.self().eval( tmp );
+        return tmp;
+    }
+
+    class KMatrixInverse : public KMatrixExpr<KMatrixInverse> {
+    public:
+        explicit KMatrixInverse( const KMatrix& A ) : m_A(A) {}
+        int  h() const { return m_A.w(); }
+        int  w() const { return m_A.h(); }
+        bool aliases( const KMatrix& M ) const { return m_A.aliases( M ); }
+        void eval( KMatrix& dst ) const {
+            if( !mat_inv( m_A, dst ) ) {
+                logman_warning("could not invert matrix - setting to identity");
+                dst.identity();
+            }
+        }
+        /// dst = inv(A) * B
+        void eval_product( const KMatrix& B, KMatrix& dst ) const {
+            if( !mat_inv_mat( m_A, B, dst ) ) {
+                logman_warning("could not invert matrix - setting to identity");
+                dst.copy( B );
+            }
+        }
+    private:
+        const KMatrix& m_A;
+    };
+
+    inline KMatrixInverse KMatrix::inv() const {
+        return KMatrixInverse( *this );
+    }
+
+    template<typename L>
+    inline void kmatrix_product( const L& a, const KMatrix& B, KMatrix& dst ) {
+        KMatrix ta;
+        mat_mat( kmatrix_operand( a, ta ), B, dst );
+    }
+    inline void kmatrix_product( const KMatrixInverse& a, const KMatrix& B, KMatrix& dst ) {
+        a.eval_product( B, dst );
+    }
+
+    template<typename L, typename R>
+    class KMatrixProduct : public KMatrixExpr< KMatrixProduct<L,R> > {
+    public:
+        KMatrixProduct( const L& a, const R& b ) : m_a(a), m_b(b) {
+            assert_statement_g( a.w() == b.h(), "incompatible matrices [%d %d] [%d %d]", a.h(), a.w(), b.h(), b.w() );
+        }
+        int  h() const { return m_a.h(); }
+        int  w() const { return m_b.w(); }
+        bool aliases( const KMatrix& M ) const { return m_a.aliases( M ) || m_b.aliases( M ); }
+        void eval( KMatrix& dst ) const {
+            KMatrix tb;
+            kmatrix_product( m_a, kmatrix_operand( m_b, tb ), dst );
+        }
+    private:
+        typename KMatrixOperand<L>::type m_a;
+        typename KMatrixOperand<R>::type m_b;
+    };
+
+    /// a + sign * b
+    template<typename L, typename R>
+    class KMatrixSum : public KMatrixExpr< KMatrixSum<L,R> > {
+    public:
+        KMatrixSum( const L& a, const R& b, const double& sign ) : m_a(a), m_b(b), m_sign(sign) {
+            assert_statement_g( a.h() == b.h() && a.w() == b.w(), "incompatible matrices [%d %d] [%d %d]", a.h(), a.w(), b.h(), b.w() );
+        }
+        int  h() const { return m_a.h(); }
+        int  w() const { return m_a.w(); }
+        bool aliases( const KMatrix& M ) const { return m_a.aliases( M ) || m_b.aliases( M ); }
+        void eval( KMatrix& dst ) const {
+            // the non-leaf side is evaluated into dst and the leaf side is
+            // accumulated in place
+            if( !std::is_same<L,KMatrix>::value && std::is_same<R,KMatrix>::value ) {
+                KMatrix tb;
+                m_a.eval( dst );
+                accumulate( kmatrix_operand( m_b, tb ), 1.0, m_sign, dst );
+            } else {
+                KMatrix ta;
+                m_b.eval( dst );
+                accumulate( kmatrix_operand( m_a, ta ), m_sign, 1.0, dst );
+            }
+        }
+    private:
+        typename KMatrixOperand<L>::type m_a;
+        typename KMatrixOperand<R>::type m_b;
+        double m_sign;
+
+        /// dst = alpha * dst + beta * B
+        static void accumulate( const KMatrix& B, const double& alpha, const double& beta, KMatrix& dst ) {
+            const double* b = B();
+            double*       d = dst.get_pointer();
+            int           n = dst.size();
+            for( int i=0; i<n; i++ )
+                d[i] = alpha * d[i] + beta * b[i];
+        }
+    };
+
+    template<typename E>
+    class KMatrixScaled : public KMatrixExpr< KMatrixScaled<E> > {
+    public:
+        KMatrixScaled( const E& a, const double& s ) : m_a(a), m_s(s) {}
+        int  h() const { return m_a.h(); }
+        int  w() const { return m_a.w(); }
+        bool aliases( const KMatrix& M ) const { return m_a.aliases( M ); }
+        void eval( KMatrix& dst ) const {
+            m_a.eval( dst );
+            dst.scale( m_s );
+        }
+    private:
+        typename KMatrixOperand<E>::type m_a;
+        double m_s;
+    };
+
+    template<typename L, typename R>
+    inline KMatrixProduct<L,R> operator*( const KMatrixExpr<L>& a, const KMatrixExpr<R>& b ) {
+        return KMatrixProduct<L,R>( a.self(), b.self() );
+    }
+
+    template<typename L, typename R>
+    inline KMatrixSum<L,R> operator+( const KMatrixExpr<L>& a, const KMatrixExpr<R>& b ) {
+        return KMatrixSum<L,R>( a.self(), b.self(), 1.0 );
+    }
+
+    template<typename L, typename R>
+    inline KMatrixSum<L,R> operator-( const KMatrixExpr<L>& a, const KMatrixExpr<R>& b ) {
+        return KMatrixSum<L,R>( a.self(), b.self(), -1.0 );
+    }
+
+    template<typename E>
+    inline KMatrixScaled<E> operator*( const double& s, const KMatrixExpr<E>& a ) {
+        return KMatrixScaled<E>( a.self(), s );
+    }
+
+    template<typename E>
+    inline KMatrixScaled<E> operator*( const KMatrixExpr<E>& a, const double& s ) {
+        return KMatrixScaled<E>( a.self(), s );
+    }
+
 
 }
 
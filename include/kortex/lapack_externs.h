@@ -198,4 +198,16 @@ extern "C" {
 
 #endif
 
+#ifdef WITH_BLAS
+
+extern "C" {
+    // C = alpha * op(A) * op(B) + beta * C for column-major matrices where
+    // op(A) is m x k, op(B) is k x n and transa/transb are 'N' or 'T'
+    void dgemm_( char* transa, char* transb, int* m, int* n, int* k,
+                 double* alpha, double* A, int* lda, double* B, int* ldb,
+                 double* beta, double* C, int* ldc );
+}
+
+#endif
+
 #endif
@@ -101,6 +101,12 @@ namespace kortex {
         return mat_inv_3( A, 3, iA, 3, 0.0 );
     }
 
+    /// eigen decomposition of the symmetric 3x3 matrix A with cyclic jacobi
+    /// rotations - only the upper triangle of A is used. eigenvalues are
+    /// sorted in decreasing order and the rows of evecs are the corresponding
+    /// unit eigenvectors ( as the rows of svd's Vt ).
+    void    mat_eigen_sym_3( const double* A, double evals[3], double evecs[9] );
+
     double  mat_pseudo_inv( const double* A, int nra, int nca, double* iA, int nria, int ncia );
 
 //
@@ -0,0 +1,64 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+//
+// operations on batches of small matrices and vectors stored in
+// structure-of-arrays layout: element e of the i'th matrix of a batch of n is
+// at A[e*n+i] ( row-major element order ). the e'th elements of consecutive
+// matrices are contiguous and 4 ( avx2 ) or 8 ( avx512 ) matrices are
+// processed at once by the simd kernels.
+//
+// quaternions are stored as [qx qy qz qw] and axis-angles as [ax ay az angle]
+// as in rotation.h.
+//
+#ifndef KORTEX_MATRIX_BATCH_H
+#define KORTEX_MATRIX_BATCH_H
+
+#include <kortex/types.h>
+#include <cstddef>
+
+namespace kortex {
+
+    /// converts n matrices of esz elements each from array-of-structures
+    /// layout ( A[i*esz+e] ) to structure-of-arrays layout ( S[e*n+i] )
+    void batch_aos_to_soa( const double* A, const int& n, const int& esz, double* S );
+
+    /// inverse of batch_aos_to_soa
+    void batch_soa_to_aos( const double* S, const int& n, const int& esz, double* A );
+
+    void batch_det_3( const double* A, const int& n, double* d );
+    void batch_det_4( const double* A, const int& n, double* d );
+
+    /// inverts n 3x3 ( 4x4 ) matrices. matrices with |det| <= inversion_threshold
+    /// are set to zero and marked in valid ( if not NULL ) with 0. returns the
+    /// number of inverted matrices.
+    int  batch_inv_3( const double* A, const int& n, const double& inversion_threshold,
+                      double* iA, uchar* valid=NULL );
+    int  batch_inv_4( const double* A, const int& n, const double& inversion_threshold,
+                      double* iA, uchar* valid=NULL );
+
+    /// y_i = A_i * x_i - x and y are 3 ( 4 ) x n arrays.
+    void batch_mat_vec_3( const double* A, const double* x, const int& n, double* y );
+    void batch_mat_vec_4( const double* A, const double* x, const int& n, double* y );
+
+    /// y_i = A_i' * x_i - e.g. rotates world vectors into the local frames.
+    void batch_mat_trans_vec_3( const double* A, const double* x, const int& n, double* y );
+
+    void batch_quaternion_to_rotation ( const double* q,  const int& n, double* R );
+    void batch_rotation_to_quaternion ( const double* R,  const int& n, double* q );
+    void batch_axisangle_to_quaternion( const double* aa, const int& n, double* q );
+    void batch_axisangle_to_rotation  ( const double* aa, const int& n, double* R );
+
+}
+
+#endif
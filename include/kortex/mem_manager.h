@@ -18,9 +18,14 @@
 
 #include <kortex/types.h>
 #include <kortex/check.h>
+#include <kortex/defs.h>
 
 namespace kortex {
 
+    /// alignment of every buffer returned by allocate - a cache line and an
+    /// avx-512 register
+    const size_t MEMORY_ALIGNMENT = 64;
+
     void allocate(      int*& ptr, const size_t& n_elem );
     void allocate(    float*& ptr, const size_t& n_elem );
     void allocate(   double*& ptr, const size_t& n_elem );
@@ -33,6 +38,22 @@ namespace kortex {
     void deallocate(   double*& ptr );
     void deallocate(    uchar*& ptr );
 
+    /// size-class memory pool for allocate/deallocate. when enabled,
+    /// deallocated blocks are kept ( up to max_cached_bytes ) and handed out
+    /// again for requests of the same size class, so repeated create/release
+    /// of same sized buffers ( e.g., video frames ) does not hit the system
+    /// allocator. blocks are rounded up to 4 classes per power of two. only
+    /// blocks allocated while the pool is enabled are pooled.
+    void   enable_memory_pool ( const size_t& max_cached_bytes = size_t(512*MB) );
+
+    /// disables the pool and frees the cached blocks
+    void   disable_memory_pool();
+
+    /// frees the cached blocks - the pool stays enabled
+    void   release_memory_pool();
+
+    size_t memory_pool_cached_bytes();
+
     enum MemoryMode { MM_16_UNALIGNED=0, MM_16_ALIGNED=1 };
 
     template <typename T> inline
@@ -21,6 +21,9 @@ using std::ifstream;
 
 namespace kortex {
 
+    /// owned buffers are allocated through kortex::allocate - they are
+    /// MEMORY_ALIGNMENT ( 64 byte ) aligned and come from the memory pool
+    /// when it is enabled.
     class MemUnit {
     public:
         MemUnit();
@@ -30,6 +33,10 @@ namespace kortex {
         MemUnit( const MemUnit& m );
         MemUnit& operator=( const MemUnit& mem );
 
+        /// takes over the buffer of m - m is left empty
+        MemUnit( MemUnit&& m ) noexcept;
+        MemUnit& operator=( MemUnit&& mem );
+
         void copy( const MemUnit& m );
 
         /// content can be destroyed - if you want to keep the content unchanged
@@ -30,6 +30,8 @@ using std::vector;
 #include <utility>
 using std::pair;
 
+#include <kortex/flat_hash_map.h>
+
 namespace kortex {
 
     // // std::hash does not have an implementation to hash pair<T1,T2> - below is
@@ -66,6 +68,12 @@ namespace kortex {
                                   const PairValue<IndexType,T>& r ) {
         return l.val < r.val;
     }
+    /// orders by ( id0, id1 )
+    template< typename IndexType, typename T >
+    inline bool pair_value_cmp_ids( const PairValue<IndexType,T>& l,
+                                    const PairValue<IndexType,T>& r ) {
+        return l.id0 < r.id0 || ( l.id0 == r.id0 && l.id1 < r.id1 );
+    }
     template< typename IndexType, typename T >
     void sort_ascending( vector< PairValue<IndexType, T> >& arr ) {
         sort( arr.begin(), arr.end(), pair_value_cmp_s<IndexType,T> );
@@ -76,11 +84,14 @@ namespace kortex {
     }
 
 
+    /// values indexed by ( x, y ) pairs kept in a FlatHashMap - int pairs are
+    /// hashed as packed 64 bit keys. iteration order is unspecified.
     template< typename IndexType, typename T >
     class PairIndexedArray {
     public:
 
         typedef std::pair<IndexType,IndexType> itpair;
+        typedef FlatHashMap<itpair,T>          map_type;
 
         bool is_present( const IndexType& x, const IndexType& y ) const;
 
@@ -94,26 +105,28 @@ namespace kortex {
 
         // void report( int mode = 0 ) const;
 
+        /// pairs sorted by ( x, y )
         void export_pairs( vector< PairValue<IndexType,T> >& pairs ) const;
 
-        // void reserve( const int& n_samples );
+        /// makes room for n pairs without rehashing
+        void reserve( const int& n_samples );
 
         int  size() const { return (int)m_array.size(); }
 
+        /// removes the pairs with values below th. returns the number of
+        /// removed pairs.
         int filter_array( const T& th );
 
-        typename std::map<itpair,T>::iterator begin() { return m_array.begin(); }
-        typename std::map<itpair,T>::iterator end  () { return m_array.end();   }
-        typename std::map<itpair,T>::const_iterator begin() const { return m_array.begin(); }
-        typename std::map<itpair,T>::const_iterator end  () const { return m_array.end();   }
+        typename map_type::iterator       begin()       { return m_array.begin(); }
+        typename map_type::iterator       end  ()       { return m_array.end();   }
+        typename map_type::const_iterator begin() const { return m_array.begin(); }
+        typename map_type::const_iterator end  () const { return m_array.end();   }
 
         void load( const string& file );
         void save( const string& file ) const;
 
     private:
-        // unordered_map< ipair, T, ipair_hash > m_array;
-
-        std::map< itpair, T > m_array;
+        map_type m_array;
     };
 
 }
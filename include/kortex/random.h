@@ -25,17 +25,70 @@ namespace kortex {
     // /// generates a seed to feed to srand. better than time(NULL)
     // unsigned int time_seed();
 
+    // the samples are drawn from the generator of the calling thread ( see
+    // thread_random_generator() ) - safe to call in parallel regions and
+    // reproducible after set_random_seed().
+
+    /// uniform sample in [0,1)
     double  uniform_sample();
     double  normal_sample();
 
     uint32_t random_sample();
     uint32_t max_random_sample();
 
+    /// fills out with n samples. the double versions give the same values as
+    /// n single sample calls, float uniforms have 24 random bits.
+    void uniform_samples( float * out, const size_t& n );
+    void uniform_samples( double* out, const size_t& n );
+    void normal_samples ( float * out, const size_t& n );
+    void normal_samples ( double* out, const size_t& n );
+
+    /// draws distinct samples with floyd's algorithm in O(no_samples) time
+    /// and space - independent of the size of the range. keeps its scratch
+    /// table between draws so that repeated draws ( e.g. ransac minimal
+    /// samples ) do not allocate. not to be shared between threads.
+    class RandomSampler {
+    private:
+        std::vector<int>      m_keys;
+        std::vector<uint32_t> m_stamps;
+        uint32_t              m_stamp;
+
+        bool insert( const int& v );
+
+    public:
+        RandomSampler();
+
+        /// selects no_samples distinct values in [minval maxval) in no
+        /// particular order. returns false if the range is too small.
+        bool select( const int& minval, const int& maxval, const int& no_samples, int* selected_samples );
+        /// same as above but draws from gen instead of the thread generator
+        bool select( const int& minval, const int& maxval, const int& no_samples, PhiloxGenerator& gen,
+                     int* selected_samples );
+    };
+
     /// selects no_samples random in [minval maxval). returns false if samples cannot be selected
     bool select_random_samples(const int& minval, const int& maxval, const int& no_samples, int *selected_samples);
 
+    /// number of top ranked samples select_prosac_like_random_samples draws
+    /// from at iteration prosac_iter
+    int  prosac_sample_range( const int& prosac_iter, const int& selection_limit );
+
     void select_prosac_like_random_samples(const int& prosac_iter, const int& selection_limit, const int& no_samples_to_select,
                                            int* selected_samples);
+    void select_prosac_like_random_samples(const int& prosac_iter, const int& selection_limit, const int& no_samples_to_select,
+                                           RandomSampler& sampler, int* selected_samples);
+
+    /// in-place fisher-yates shuffle
+    template<typename T>
+    void random_shuffle( T* data, const int& n ) {
+        PhiloxGenerator* gen = thread_random_generator();
+        for( int i=n-1; i>0; i-- ) {
+            int j = int( gen->uniform_index( uint32_t(i+1) ) );
+            T tmp   = data[i];
+            data[i] = data[j];
+            data[j] = tmp;
+        }
+    }
 
     void random_permutation( int n, std::vector<int>& perm );
 
@@ -16,6 +16,8 @@
 #define KORTEX_RANDOM_GENERATOR_H
 
 #include <random>
+#include <cstdint>
+#include <cstddef>
 
 namespace kortex {
 
@@ -69,8 +71,76 @@ namespace kortex {
 
     extern RandomGenerator g_random;
 
+    /// shared mt19937 generator - not thread-safe. kept for existing callers;
+    /// the sampling functions in random.h use thread_random_generator().
     RandomGenerator* random_generator();
 
+    /// counter-based philox4x32-10 generator. every output block is a pure
+    /// function of (seed, stream, block index) - generators with the same
+    /// seed but different streams are independent, and a stream can be
+    /// reproduced or skipped ahead without generating the preceding numbers.
+    /// bulk fills produce exactly the numbers the single sample calls would.
+    class PhiloxGenerator {
+    private:
+        uint64_t m_seed;
+        uint64_t m_stream;
+        uint64_t m_block;
+        uint32_t m_buffer[4];
+        int      m_buffered;
+        double   m_spare;
+        bool     m_has_spare;
+
+        void refill();
+
+    public:
+        PhiloxGenerator( const uint64_t& seed=0, const uint64_t& stream=0 );
+
+        /// restarts the generator at the first block of stream
+        void set_seed( const uint64_t& seed, const uint64_t& stream=0 );
+        uint64_t get_seed()   const { return m_seed;   }
+        uint64_t get_stream() const { return m_stream; }
+
+        /// skips n_blocks output blocks of 4 numbers
+        void skip( const uint64_t& n_blocks );
+
+        uint32_t rv();
+        uint32_t max() const { return UINT32_MAX; }
+
+        /// unbiased integer in [0,n) - n > 0
+        uint32_t uniform_index( const uint32_t& n );
+
+        /// [0,1) with 53 random bits - consumes two rv()
+        double uniform_sample();
+        /// [0,1) with 24 random bits - consumes one rv()
+        float  uniform_sample_f();
+        /// box-muller - generates the samples in pairs. log and sincos are
+        /// polynomial approximations that the bulk fills evaluate in simd.
+        double normal_sample();
+
+        void fill_rv     ( uint32_t* out, const size_t& n );
+        void fill_uniform( float   * out, const size_t& n );
+        void fill_uniform( double  * out, const size_t& n );
+        void fill_normal ( float   * out, const size_t& n );
+        void fill_normal ( double  * out, const size_t& n );
+    };
+
+    /// philox4x32-10 block for counter ctr and key - exposed for testing
+    void philox4x32( const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4] );
+
+    /// seeds the generators of all threads. after the call the generator of
+    /// openmp thread t draws stream t of seed - loops with a fixed thread
+    /// assignment ( e.g. schedule(static) ) reproduce their results. a thread
+    /// takes its stream on first use; threads for which stream t is already
+    /// taken ( other std::threads, nested teams ) draw a stream of their own.
+    /// for results independent of the thread count, seed a PhiloxGenerator
+    /// per work item instead ( seed, item index ).
+    void     set_random_seed( const uint64_t& seed );
+    /// current seed - drawn from std::random_device unless set
+    uint64_t random_seed();
+
+    /// generator of the calling thread - never shared between threads
+    PhiloxGenerator* thread_random_generator();
+
 
 }
 
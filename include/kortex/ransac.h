@@ -0,0 +1,138 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+//
+// Generic robust estimation - ransac with optional prosac sampling,
+// lo-ransac refits and sprt early rejection of bad hypotheses. hypotheses are
+// generated and scored in parallel batches. a model type provides the
+// minimal solver, the least squares refit and the residuals:
+//
+//     class Model {
+//         typedef ... Params;                  // model parameters
+//         enum { MIN_SAMPLES = m };            // minimal sample size
+//         int  n_data() const;
+//         bool fit_minimal( const int* samples, Params& p ) const;
+//         bool fit( const int* indices, const int& n, Params& p ) const;
+//         void residuals( const Params& p, const int& begin, const int& end, float* res ) const;
+//     };
+//
+// fit_minimal/fit return false for degenerate samples. residuals writes the
+// absolute errors of the data points [begin,end) to res. include ransac.tcc
+// to instantiate ransac() for a model.
+//
+#ifndef KORTEX_RANSAC_H
+#define KORTEX_RANSAC_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace kortex {
+
+    using std::vector;
+
+    struct RansacParams {
+        /// points with residuals below threshold are inliers
+        float    threshold;
+        /// probability of drawing at least one all-inlier sample - sets the
+        /// adaptive iteration count
+        double   confidence;
+        int      min_iterations;
+        int      max_iterations;
+        /// number of hypotheses generated and scored together
+        int      batch_size;
+        /// data is sorted by decreasing quality - samples are drawn from the
+        /// top ranked points first ( see prosac_sample_range )
+        bool     prosac;
+        /// refits every new best model to its inliers ( lo-ransac )
+        bool     local_optimization;
+        int      lo_iterations;
+        /// wald's sequential probability ratio test - stops scoring a
+        /// hypothesis once it is unlikely to be as good as the best one. the
+        /// inlier ratio of the best model is used as the good model ratio.
+        bool     sprt;
+        /// probability of a point being consistent with a bad model
+        double   sprt_delta;
+        /// cost of a hypothesis fit in units of residual evaluations
+        double   sprt_model_cost;
+        /// refits the final model to all its inliers
+        bool     refine;
+        bool     run_parallel;
+        /// hypothesis i is drawn from stream i of seed - results do not
+        /// depend on the number of threads. defaults to random_seed().
+        uint64_t seed;
+
+        RansacParams();
+    };
+
+    struct RansacStats {
+        int    n_iterations; // number of hypotheses drawn
+        int    n_rejected;   // hypotheses stopped early by sprt
+        int    n_inliers;
+        /// msac score - sum of min( r^2, threshold^2 )
+        double score;
+    };
+
+    /// robust estimation of the model parameters. returns false if no
+    /// non-degenerate model could be fit. inliers are the indices of the data
+    /// points with residuals below the threshold.
+    template<typename Model>
+    bool ransac( const Model& model, const RansacParams& params, typename Model::Params& best,
+                 vector<int>& inliers, RansacStats* stats=NULL );
+
+    /// number of iterations needed to draw an all-inlier sample of size m
+    /// with the given confidence when the inlier ratio is eps
+    int    ransac_iteration_count( const double& eps, const int& m, const double& confidence,
+                                   const int& max_iterations );
+
+    /// decision threshold of sprt ( matas & chum, "randomized ransac with
+    /// sequential probability ratio test", iccv 2005 )
+    double sprt_threshold( const double& epsilon, const double& delta, const double& model_cost );
+
+    /// number of residuals below threshold. adds the msac loss of the
+    /// residuals to loss.
+    int    ransac_score( const float* res, const int& n, const float& threshold, double& loss );
+
+    /// plane model for ransac. params are ( a, b, c, d ) with a unit normal.
+    /// the minimal solver uses 3 points, refits use compute_plane.
+    class PlaneModel {
+    public:
+        struct Params {
+            float plane[4];
+        };
+        enum { MIN_SAMPLES = 3 };
+
+        /// pnts are n_pnts interleaved xyz points. they are referenced by the
+        /// refits and copied to planar arrays for the residual kernels.
+        PlaneModel( const float* pnts, const int& n_pnts );
+
+        int  n_data() const { return m_n; }
+        bool fit_minimal( const int* samples, Params& p ) const;
+        bool fit( const int* indices, const int& n, Params& p ) const;
+        void residuals( const Params& p, const int& begin, const int& end, float* res ) const;
+
+    private:
+        const float*  m_pnts;
+        int           m_n;
+        vector<float> m_x;
+        vector<float> m_y;
+        vector<float> m_z;
+    };
+
+    /// fits a plane to the n_pnts interleaved xyz points with ransac
+    bool ransac_plane( const float* pnts, const int& n_pnts, const RansacParams& params, float plane[4],
+                       vector<int>& inliers, RansacStats* stats=NULL );
+
+}
+
+#endif
@@ -0,0 +1,224 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#ifndef KORTEX_RANSAC_TCC
+#define KORTEX_RANSAC_TCC
+
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <kortex/check.h>
+#include <kortex/random.h>
+#include <kortex/random_generator.h>
+#include "ransac.h"
+
+namespace kortex {
+
+    /// residuals are computed and scored in chunks of this many points - sprt
+    /// decides after every chunk
+    const int RANSAC_CHUNK = 512;
+
+    /// scores p on all the data points and optionally collects the inliers.
+    /// returns the number of inliers.
+    template<typename Model>
+    int ransac_evaluate( const Model& model, const typename Model::Params& p, const float& threshold,
+                         float* res, double& loss, vector<int>* inliers ) {
+        int n    = model.n_data();
+        int n_in = 0;
+        loss = 0.0;
+        if( inliers ) inliers->clear();
+        for( int beg=0; beg<n; beg+=RANSAC_CHUNK ) {
+            int end = std::min( n, beg+RANSAC_CHUNK );
+            model.residuals( p, beg, end, res );
+            n_in += ransac_score( res, end-beg, threshold, loss );
+            if( !inliers ) continue;
+            for( int i=0; i<end-beg; i++ )
+                if( res[i] < threshold ) inliers->push_back( beg+i );
+        }
+        return n_in;
+    }
+
+    /// lo-ransac inner loop - refits to the inliers of the best model as long
+    /// as the score improves
+    template<typename Model>
+    void ransac_local_optimization( const Model& model, const RansacParams& params, float* res,
+                                    vector<int>& idx, typename Model::Params& best, double& best_loss,
+                                    int& best_inliers ) {
+        typename Model::Params p;
+        for( int it=0; it<params.lo_iterations; it++ ) {
+            double loss;
+            ransac_evaluate( model, best, params.threshold, res, loss, &idx );
+            if( (int)idx.size() < (int)Model::MIN_SAMPLES ) return;
+            if( !model.fit( &idx[0], (int)idx.size(), p ) ) return;
+            int n_in = ransac_evaluate( model, p, params.threshold, res, loss, (vector<int>*)NULL );
+            if( loss >= best_loss ) return;
+            best         = p;
+            best_loss    = loss;
+            best_inliers = n_in;
+        }
+    }
+
+    template<typename Model>
+    bool ransac( const Model& model, const RansacParams& params, typename Model::Params& best,
+                 vector<int>& inliers, RansacStats* stats ) {
+        typedef typename Model::Params MParams;
+        const int m = Model::MIN_SAMPLES;
+        const int n = model.n_data();
+        passert_statement_g( n >= m, "not enough data [%d] for a minimal sample of [%d]", n, m );
+        passert_statement( params.threshold > 0.0f, "threshold should be positive" );
+        passert_statement( params.batch_size > 0, "batch size should be positive" );
+        passert_statement( params.min_iterations <= params.max_iterations, "invalid iteration limits" );
+
+        const int n_chunks  = ( n + RANSAC_CHUNK - 1 ) / RANSAC_CHUNK;
+#ifdef _OPENMP
+        const int n_threads = params.run_parallel ? omp_get_max_threads() : 1;
+#else
+        const int n_threads = 1;
+#endif
+        const int B         = params.batch_size;
+
+        vector<float>         res( size_t(n_threads) * RANSAC_CHUNK );
+        vector<RandomSampler> samplers( n_threads );
+        vector<MParams>       hyp( B );
+        vector<int>           samples( size_t(B) * m );
+        vector<int>           hyp_inliers( B );
+        vector<double>        hyp_loss( B );
+        vector<char>          hyp_state( B ); // 0: degenerate, 1: scored, 2: rejected by sprt
+
+        double eps       = 0.0; // inlier ratio of the best model
+        double sprt_a    = 0.0;
+        int    max_iter  = params.max_iterations;
+        bool   found     = false;
+        double best_loss = DBL_MAX;
+        int    best_in   = 0;
+        int    iter      = 0;
+        int    n_reject  = 0;
+        vector<int> idx;
+
+        while( iter < max_iter ) {
+            const int    nb       = std::min( B, max_iter-iter );
+            const bool   use_sprt = params.sprt && eps > params.sprt_delta;
+            const double log_acc  = use_sprt ? std::log( params.sprt_delta / eps ) : 0.0;
+            const double log_rej  = use_sprt ? std::log( ( 1.0 - params.sprt_delta ) / ( 1.0 - eps ) ) : 0.0;
+            const double log_a    = use_sprt ? std::log( sprt_a ) : 0.0;
+
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads) if(params.run_parallel)
+            for( int b=0; b<nb; b++ ) {
+#ifdef _OPENMP
+                const int tid = omp_get_thread_num();
+#else
+                const int tid = 0;
+#endif
+                PhiloxGenerator gen( params.seed, uint64_t(iter+b) );
+                int* smp   = &samples[ size_t(b)*m ];
+                int  range = params.prosac ? std::max( prosac_sample_range( iter+b, n ), m ) : n;
+                samplers[tid].select( 0, range, m, gen, smp );
+                hyp_state[b] = 0;
+                if( !model.fit_minimal( smp, hyp[b] ) )
+                    continue;
+
+                // with sprt the scoring starts from a random chunk so that
+                // the early decisions are not biased by the data order
+                float* r = &res[ size_t(tid) * RANSAC_CHUNK ];
+                int    c = use_sprt ? int( gen.uniform_index( uint32_t(n_chunks) ) ) : 0;
+                int    n_in = 0;
+                double loss = 0.0;
+                double log_lambda = 0.0;
+                hyp_state[b] = 1;
+                for( int k=0; k<n_chunks; k++, c++ ) {
+                    if( c == n_chunks ) c = 0;
+                    int beg = c * RANSAC_CHUNK;
+                    int end = std::min( n, beg+RANSAC_CHUNK );
+                    model.residuals( hyp[b], beg, end, r );
+                    int ci = ransac_score( r, end-beg, params.threshold, loss );
+                    n_in += ci;
+                    if( !use_sprt ) continue;
+                    log_lambda += ci * log_acc + ( end-beg-ci ) * log_rej;
+                    if( log_lambda > log_a ) {
+                        hyp_state[b] = 2;
+                        break;
+                    }
+                }
+                hyp_inliers[b] = n_in;
+                hyp_loss   [b] = loss;
+            }
+
+            // reduced in hypothesis order - independent of the thread count
+            bool improved = false;
+            for( int b=0; b<nb; b++ ) {
+                if( hyp_state[b] == 2 ) n_reject++;
+                if( hyp_state[b] != 1 || hyp_loss[b] >= best_loss ) continue;
+                best      = hyp[b];
+                best_loss = hyp_loss[b];
+                best_in   = hyp_inliers[b];
+                found     = true;
+                improved  = true;
+            }
+            iter += nb;
+            if( !improved ) continue;
+
+            if( params.local_optimization )
+                ransac_local_optimization( model, params, &res[0], idx, best, best_loss, best_in );
+
+            // sprt tests the hypotheses against the inlier ratio of the best
+            // model - it is disabled while the ratio is not above delta
+            eps = std::min( double(best_in) / double(n), 0.999 );
+            if( eps > params.sprt_delta )
+                sprt_a = sprt_threshold( eps, params.sprt_delta, params.sprt_model_cost );
+            int n_needed = ransac_iteration_count( eps, m, params.confidence, params.max_iterations );
+            max_iter = std::max( params.min_iterations, std::min( max_iter, n_needed ) );
+        }
+
+        if( !found ) {
+            inliers.clear();
+            if( stats ) {
+                stats->n_iterations = iter;
+                stats->n_rejected   = n_reject;
+                stats->n_inliers    = 0;
+                stats->score        = DBL_MAX;
+            }
+            return false;
+        }
+
+        best_in = ransac_evaluate( model, best, params.threshold, &res[0], best_loss, &inliers );
+        if( params.refine && best_in >= m ) {
+            MParams p;
+            if( model.fit( &inliers[0], best_in, p ) ) {
+                double loss;
+                int n_in = ransac_evaluate( model, p, params.threshold, &res[0], loss, &idx );
+                if( loss < best_loss ) {
+                    best      = p;
+                    best_loss = loss;
+                    best_in   = n_in;
+                    inliers.swap( idx );
+                }
+            }
+        }
+
+        if( stats ) {
+            stats->n_iterations = iter;
+            stats->n_rejected   = n_reject;
+            stats->n_inliers    = best_in;
+            stats->score        = best_loss;
+        }
+        return true;
+    }
+
+}
+
+#endif
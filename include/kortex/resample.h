@@ -0,0 +1,78 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+#ifndef KORTEX_RESAMPLE_H
+#define KORTEX_RESAMPLE_H
+
+#include <kortex/types.h>
+
+#include <vector>
+using std::vector;
+
+namespace kortex {
+
+    /// RS_BILINEAR: 2 taps, RS_BICUBIC: 4 taps catmull-rom, RS_AREA: average
+    /// of the covered source pixels for downscaling ( bilinear for upscaling )
+    enum ResampleMethod { RS_BILINEAR=0, RS_BICUBIC=1, RS_AREA=2 };
+
+    /// tap table of a 1d resampling. out[i] = sum_k weight[k*n_out+i] *
+    /// in[index[k*n_out+i]]. tables are stored tap major so that consecutive
+    /// outputs are processed together. pixel centers are aligned ( source
+    /// coordinate of output i is (i+0.5)*n_in/n_out-0.5 ) and the source
+    /// indices are clamped to the borders.
+    struct ResampleTaps {
+        int           n_out;     // number of output elements ( pixels x channels )
+        int           n_taps;
+        vector<int>   index;
+        vector<float> weight;
+    };
+
+    /// nc > 1 builds the table for nc interleaved channels: n_out*nc outputs
+    /// indexing an input of n_in*nc elements.
+    void compute_resample_taps( const int& n_in, const int& n_out, const int& nc,
+                                const ResampleMethod& method, ResampleTaps& taps );
+
+    /// applies a tap table to a single line
+    void resample_line( const float* in, const ResampleTaps& taps, float* out );
+
+    /// resizes a w x h image with nc interleaved channels to nw x nh with a
+    /// horizontal and then a vertical pass. dst should not overlap src.
+    void resample    ( const float* src, const int& w, const int& h, const int& nc,
+                       const ResampleMethod& method, const int& nw, const int& nh, float* dst );
+    void resample_par( const float* src, const int& w, const int& h, const int& nc,
+                       const ResampleMethod& method, const int& nw, const int& nh, float* dst );
+
+    /// uchar versions - computed in float and rounded
+    void resample    ( const uchar* src, const int& w, const int& h, const int& nc,
+                       const ResampleMethod& method, const int& nw, const int& nh, uchar* dst );
+    void resample_par( const uchar* src, const int& w, const int& h, const int& nc,
+                       const ResampleMethod& method, const int& nw, const int& nh, uchar* dst );
+
+    /// samples a w x h image with nc interleaved channels ( nc = 1 or 3 ) and
+    /// stride elements between rows at the n points (xs[i],ys[i]) and writes
+    /// out[i*nc+c]. same kernels and
+    /// border handling as bilinear_interpolation / bicubic_interpolation (
+    /// bicubic returns the nearest pixel within 2 pixels of the border ).
+    /// coordinates are clamped to the image.
+    void sample_bilinear( const float* img, const int& w, const int& h, const int& nc, const size_t& stride,
+                          const float* xs, const float* ys, const int& n, float* out );
+    void sample_bilinear( const uchar* img, const int& w, const int& h, const int& nc, const size_t& stride,
+                          const float* xs, const float* ys, const int& n, float* out );
+    void sample_bicubic ( const float* img, const int& w, const int& h, const int& nc, const size_t& stride,
+                          const float* xs, const float* ys, const int& n, float* out );
+    void sample_bicubic ( const uchar* img, const int& w, const int& h, const int& nc, const size_t& stride,
+                          const float* xs, const float* ys, const int& n, float* out );
+
+}
+
+#endif
@@ -14,26 +14,28 @@
 // ---------------------------------------------------------------------------
 //
 //  Sparse Array supporting A[ key ] = val type operations. If you want to have
-//  an array as a data value, check IndexedArray.
+//  an array as a data value, check IndexedArray. the entries are kept in a
+//  FlatHashMap.
 //
 #ifndef KORTEX_SPARSE_ARRAY_F_H
 #define KORTEX_SPARSE_ARRAY_F_H
 
-#include <unordered_map>
-using std::unordered_map;
-
 #include <kortex/keyed_value.h>
+#include <kortex/flat_hash_map.h>
 
 namespace kortex {
 
     template< typename KeyType, typename DataType >
     class SparseArrayT {
     private:
-        unordered_map<KeyType, DataType> m_data;
+        FlatHashMap<KeyType, DataType> m_data;
 
     public:
         void clear();
 
+        /// makes room for n keys without rehashing
+        void reserve( const int& n );
+
         bool check( const KeyType& key ) const; // returns true if key exists
 
         void add( const KeyType& key, const DataType& val );
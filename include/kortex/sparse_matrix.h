@@ -0,0 +1,156 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+//
+// Compressed sparse row/column matrices and iterative solvers for the large
+// systems that cannot be densified for linear_algebra.h ( poisson blending,
+// smoothness regularized depth... ).
+//
+// a csr matrix stores the column indices and values of row r in
+// idx[ptr[r]..ptr[r+1]) and a csc matrix the row indices and values of column
+// c in idx[ptr[c]..ptr[c+1]). indices within a row ( column ) are sorted and
+// unique. the csc arrays of A are the csr arrays of A'.
+//
+// products that gather along the compressed dimension ( A*x for csr, A'*x
+// for csc ) run in parallel. the scattering ones are serial - keep a
+// transposed copy if both are needed often.
+//
+#ifndef KORTEX_SPARSE_MATRIX_H
+#define KORTEX_SPARSE_MATRIX_H
+
+#include <vector>
+#include <cstddef>
+
+namespace kortex {
+
+    using std::vector;
+
+    enum SparseStorage { SPARSE_CSR, SPARSE_CSC };
+
+    struct SparseTriplet {
+        int    r;
+        int    c;
+        double v;
+        SparseTriplet() : r(0), c(0), v(0.0) {}
+        SparseTriplet( int r_, int c_, double v_ ) : r(r_), c(c_), v(v_) {}
+    };
+
+    class SparseMatrix {
+    public:
+        SparseMatrix();
+
+        /// builds an nr x nc matrix from ( row, col, value ) triplets in any
+        /// order. values of repeated entries are summed.
+        void init( int nr, int nc, const vector<SparseTriplet>& triplets,
+                   const SparseStorage& storage=SPARSE_CSR );
+
+        /// copies the compressed arrays - ptr has ( nr or nc )+1 entries and
+        /// idx/val ptr[last] entries. indices of each row ( column ) must be
+        /// sorted and unique.
+        void init( int nr, int nc, const SparseStorage& storage,
+                   const int* ptr, const int* idx, const double* val );
+
+        void release();
+
+        int           rows   () const { return m_nr; }
+        int           cols   () const { return m_nc; }
+        size_t        nnz    () const { return m_idx.size(); }
+        SparseStorage storage() const { return m_storage; }
+
+        const int*    ptr() const { return m_ptr.empty() ? NULL : &m_ptr[0]; }
+        const int*    idx() const { return m_idx.empty() ? NULL : &m_idx[0]; }
+        const double* val() const { return m_val.empty() ? NULL : &m_val[0]; }
+        double*       val()       { return m_val.empty() ? NULL : &m_val[0]; }
+
+        /// returns 0 for entries that are not stored
+        double get( int r, int c ) const;
+
+        /// extracts the diagonal - d has min(rows,cols) entries
+        void   diagonal( double* d ) const;
+
+        /// y = A * x - x has cols() and y rows() entries
+        void   mult      ( const double* x, double* y ) const;
+        /// y = A' * x - x has rows() and y cols() entries
+        void   mult_trans( const double* x, double* y ) const;
+
+        /// At = A' in the same storage format
+        void   transpose( SparseMatrix& At ) const;
+
+        /// B = A in the given storage format
+        void   convert( const SparseStorage& storage, SparseMatrix& B ) const;
+
+        /// copies into the row-major dense array A of size rows() x cols()
+        void   to_dense( double* A ) const;
+
+    private:
+        int           m_nr;
+        int           m_nc;
+        SparseStorage m_storage;
+        vector<int>   m_ptr;
+        vector<int>   m_idx;
+        vector<double> m_val;
+
+        int  n_major() const { return m_storage == SPARSE_CSR ? m_nr : m_nc; }
+        int  n_minor() const { return m_storage == SPARSE_CSR ? m_nc : m_nr; }
+        void gather ( const double* x, double* y ) const;
+        void scatter( const double* x, double* y ) const;
+    };
+
+    enum SparsePreconditioner {
+        PRECONDITIONER_NONE,
+        /// diagonal scaling
+        PRECONDITIONER_JACOBI,
+        /// zero fill-in incomplete cholesky - retried with a growing diagonal
+        /// shift if the factorization breaks down. falls back to jacobi for
+        /// non-positive diagonal entries or if the shift does not help.
+        PRECONDITIONER_ICHOL
+    };
+
+    struct IterativeSolverParams {
+        int                  max_iterations;
+        /// cg stops at |b-Ax| <= tolerance*|b|. lsqr also stops at
+        /// |A'r| <= tolerance*|A||r| for inconsistent systems.
+        double               tolerance;
+        /// used by sparse_solver_pcg
+        SparsePreconditioner preconditioner;
+        /// lsqr solves min |Ax-b|^2 + damp^2 |x|^2
+        double               damp;
+
+        IterativeSolverParams();
+    };
+
+    struct IterativeSolverStats {
+        int    n_iterations;
+        /// |b-Ax| at exit - the lsqr estimate includes the damping term
+        double residual;
+        bool   converged;
+    };
+
+    /// conjugate gradients for the symmetric positive definite A. x holds the
+    /// initial guess and is overwritten by the solution. returns converged.
+    bool sparse_solver_cg ( const SparseMatrix& A, const double* b, double* x,
+                            const IterativeSolverParams& params, IterativeSolverStats* stats=NULL );
+
+    /// preconditioned conjugate gradients with params.preconditioner
+    bool sparse_solver_pcg( const SparseMatrix& A, const double* b, double* x,
+                            const IterativeSolverParams& params, IterativeSolverStats* stats=NULL );
+
+    /// lsqr ( paige & saunders, 1982 ) for the least squares solution of the
+    /// rectangular A x = b. x holds the initial guess. a transposed copy of A
+    /// is made so that both products run in parallel.
+    bool sparse_solver_lsqr( const SparseMatrix& A, const double* b, double* x,
+                             const IterativeSolverParams& params, IterativeSolverStats* stats=NULL );
+
+}
+
+#endif
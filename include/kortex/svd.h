@@ -35,6 +35,11 @@ namespace kortex {
             decompose( A(), A.h(), A.w(), A.w(), compute_u, compute_vt );
         }
 
+        /// decomposes the contiguous nr x nc matrix A without copying it - the
+        /// contents of A are destroyed. use when the input is not needed
+        /// after the decomposition.
+        void decompose_inplace( double* A, int nr, int nc, bool compute_u, bool compute_vt );
+
         void combine( double* A, int lda ) const;
 
         double pseudo_inverse(double* iA, int ldia) const;
@@ -80,6 +85,17 @@ namespace kortex {
                         double* A, int r, int c, int lda ) const;
     };
 
+    /// decomposes the n_mats nr x nc matrices stored consecutively in A (
+    /// A + i*nr*nc ) in parallel - one SVD workspace per thread. the singular
+    /// values of the i'th matrix are written to Sd + i*min(nr,nc), U to
+    /// U + i*nr*nr and Vt to Vt + i*nc*nc. U and Vt are not computed if NULL.
+    void svd_decompose_batch( const double* A, int n_mats, int nr, int nc,
+                              double* Sd, double* U, double* Vt );
+
+    /// svd_decompose_batch without the input copies - A is destroyed.
+    void svd_decompose_batch_inplace( double* A, int n_mats, int nr, int nc,
+                                      double* Sd, double* U, double* Vt );
+
 }
 
 #endif
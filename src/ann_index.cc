@@ -0,0 +1,905 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/ann_index.h>
+#include <kortex/random_generator.h>
+#include <kortex/cpu_features.h>
+#include <kortex/fileio.h>
+#include <kortex/check.h>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <cfloat>
+#include <cmath>
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace kortex {
+
+    //
+    // squared euclidean distances
+    //
+
+    typedef float (*L2SqKernel)( const float* a, const float* b, const int& dim );
+
+    static float l2sq_basic( const float* a, const float* b, const int& dim ) {
+        float s = 0.0f;
+        for( int i=0; i<dim; i++ ) {
+            float d = a[i] - b[i];
+            s += d*d;
+        }
+        return s;
+    }
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+
+    KORTEX_TARGET_AVX2
+    static float l2sq_avx2( const float* a, const float* b, const int& dim ) {
+        __m256 s0 = _mm256_setzero_ps();
+        __m256 s1 = _mm256_setzero_ps();
+        int i = 0;
+        for( ; i+16<=dim; i+=16 ) {
+            __m256 d0 = _mm256_sub_ps( _mm256_loadu_ps( a+i   ), _mm256_loadu_ps( b+i   ) );
+            __m256 d1 = _mm256_sub_ps( _mm256_loadu_ps( a+i+8 ), _mm256_loadu_ps( b+i+8 ) );
+            s0 = _mm256_fmadd_ps( d0, d0, s0 );
+            s1 = _mm256_fmadd_ps( d1, d1, s1 );
+        }
+        for( ; i+8<=dim; i+=8 ) {
+            __m256 d0 = _mm256_sub_ps( _mm256_loadu_ps( a+i ), _mm256_loadu_ps( b+i ) );
+            s0 = _mm256_fmadd_ps( d0, d0, s0 );
+        }
+        s0 = _mm256_add_ps( s0, s1 );
+        __m128 h = _mm_add_ps( _mm256_castps256_ps128( s0 ), _mm256_extractf128_ps( s0, 1 ) );
+        h = _mm_add_ps( h, _mm_movehl_ps( h, h ) );
+        h = _mm_add_ss( h, _mm_shuffle_ps( h, h, 1 ) );
+        return _mm_cvtss_f32( h ) + l2sq_basic( a+i, b+i, dim-i );
+    }
+
+    KORTEX_TARGET_AVX512
+    static float l2sq_avx512( const float* a, const float* b, const int& dim ) {
+        __m512 s0 = _mm512_setzero_ps();
+        __m512 s1 = _mm512_setzero_ps();
+        int i = 0;
+        for( ; i+32<=dim; i+=32 ) {
+            __m512 d0 = _mm512_sub_ps( _mm512_loadu_ps( a+i    ), _mm512_loadu_ps( b+i    ) );
+            __m512 d1 = _mm512_sub_ps( _mm512_loadu_ps( a+i+16 ), _mm512_loadu_ps( b+i+16 ) );
+            s0 = _mm512_fmadd_ps( d0, d0, s0 );
+            s1 = _mm512_fmadd_ps( d1, d1, s1 );
+        }
+        // the remaining < 32 values in at most two masked loads
+        for( ; i<dim; i+=16 ) {
+            __mmask16 m = dim-i >= 16 ? (__mmask16)0xffff : (__mmask16)( ( 1u << (dim-i) ) - 1 );
+            __m512 d0 = _mm512_sub_ps( _mm512_maskz_loadu_ps( m, a+i ), _mm512_maskz_loadu_ps( m, b+i ) );
+            s0 = _mm512_fmadd_ps( d0, d0, s0 );
+        }
+        return _mm512_reduce_add_ps( _mm512_add_ps( s0, s1 ) );
+    }
+
+#endif
+
+    static L2SqKernel select_l2sq_kernel( const int& dim ) {
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        // the call is not worth it for 3d points
+        if( dim >= 8 ) {
+            switch( simd_level() ) {
+            case SIMD_AVX512: return l2sq_avx512;
+            case SIMD_AVX2  : return l2sq_avx2;
+            default: break;
+            }
+        }
+#endif
+        return l2sq_basic;
+    }
+
+    typedef std::pair<float,int> DistId;
+
+    // fills the n x k outputs from the sorted squared distances
+    static void write_neighbors( const DistId* nn, const int& n_nn, const int& k,
+                                 int* indices, float* distances ) {
+        for( int j=0; j<k; j++ ) {
+            if( j < n_nn ) {
+                indices  [j] = nn[j].second;
+                distances[j] = std::sqrt( nn[j].first );
+            } else {
+                indices  [j] = -1;
+                distances[j] = -1.0f;
+            }
+        }
+    }
+
+    //
+    // k-d forest
+    //
+
+    // statistics of a node are computed on its first points - the order of
+    // the points is shuffled per tree
+    static const int KD_SAMPLE_SIZE = 100;
+
+    KdForestParams::KdForestParams() {
+        n_trees      = 4;
+        leaf_size    = 8;
+        n_split_dims = 5;
+        seed         = 0;
+        run_parallel = true;
+    }
+
+    struct KdForest::Builder {
+        PhiloxGenerator gen;
+        vector<double>  mean;
+        vector<double>  var;
+        vector<int>     dims;
+    };
+
+    struct KdBranch {
+        float d;
+        int   tree;
+        int   node;
+        KdBranch( const float& d_, const int& t_, const int& n_ ) : d(d_), tree(t_), node(n_) {}
+        bool operator>( const KdBranch& rhs ) const { return d > rhs.d; }
+    };
+
+    struct KdForest::Search {
+        const float*     q;
+        L2SqKernel       dist;
+        int              n_checks;
+        // k nearest neighbors
+        int              k;
+        vector<DistId>   nn;
+        // radius search collects into nn
+        bool             collect;
+        float            radius2;
+        vector<KdBranch> branches;
+        vector<float>    offsets;
+
+        float bound() const { return collect ? radius2 : nn[k-1].first; }
+    };
+
+    struct VarGreater {
+        const vector<double>& var;
+        VarGreater( const vector<double>& v ) : var(v) {}
+        bool operator()( const int& a, const int& b ) const { return var[a] > var[b]; }
+    };
+
+    struct CoordBelow {
+        const float* data;
+        int          dim;
+        int          d;
+        float        split;
+        CoordBelow( const float* data_, const int& dim_, const int& d_, const float& s_ )
+            : data(data_), dim(dim_), d(d_), split(s_) {}
+        bool operator()( const int& i ) const { return data[ size_t(i)*dim + d ] < split; }
+    };
+
+    struct CoordLess {
+        const float* data;
+        int          dim;
+        int          d;
+        CoordLess( const float* data_, const int& dim_, const int& d_ ) : data(data_), dim(dim_), d(d_) {}
+        bool operator()( const int& a, const int& b ) const {
+            return data[ size_t(a)*dim + d ] < data[ size_t(b)*dim + d ];
+        }
+    };
+
+    KdForest::KdForest() {
+        m_data = NULL;
+        m_n    = 0;
+        m_dim  = 0;
+    }
+
+    void KdForest::release() {
+        m_data = NULL;
+        m_n    = 0;
+        m_dim  = 0;
+        m_nodes.clear();
+        m_index.clear();
+    }
+
+    void KdForest::build( const float* data, int n, int dim, const KdForestParams& params ) {
+        passert_pointer( n == 0 || data );
+        passert_statement_g( n >= 0 && dim > 0, "invalid data size [%d x %d]", n, dim );
+        passert_statement_g( params.n_trees > 0 && params.leaf_size > 0 && params.n_split_dims > 0,
+                             "invalid forest params [trees %d, leaf %d, split dims %d]",
+                             params.n_trees, params.leaf_size, params.n_split_dims );
+        release();
+        m_data   = data;
+        m_n      = n;
+        m_dim    = dim;
+        m_params = params;
+        m_nodes.resize( params.n_trees );
+        m_index.resize( params.n_trees );
+
+#pragma omp parallel for schedule(dynamic,1) if(params.run_parallel)
+        for( int t=0; t<params.n_trees; t++ )
+            build_tree( t );
+    }
+
+    void KdForest::build_tree( const int& t ) {
+        Builder b;
+        b.gen.set_seed( m_params.seed, t );
+        b.mean.resize( m_dim );
+        b.var .resize( m_dim );
+        b.dims.resize( m_dim );
+
+        vector<int>& index = m_index[t];
+        index.resize( m_n );
+        for( int i=0; i<m_n; i++ )
+            index[i] = i;
+        for( int i=m_n-1; i>0; i-- )
+            std::swap( index[i], index[ b.gen.uniform_index( uint32_t(i+1) ) ] );
+
+        m_nodes[t].clear();
+        m_nodes[t].reserve( 2*size_t(m_n)/m_params.leaf_size + 1 );
+        if( m_n > 0 )
+            divide( b, t, 0, m_n );
+    }
+
+    int KdForest::divide( Builder& b, const int& t, const int& begin, const int& end ) {
+        vector<Node>& nodes = m_nodes[t];
+        int id = (int)nodes.size();
+        nodes.push_back( Node() );
+
+        const int count = end - begin;
+        if( count <= m_params.leaf_size ) {
+            nodes[id].split_dim = -1;
+            nodes[id].split     = 0.0f;
+            nodes[id].left      = begin;
+            nodes[id].right     = end;
+            return id;
+        }
+
+        int* index = &m_index[t][0];
+        const int ns = std::min( count, KD_SAMPLE_SIZE );
+        std::fill( b.mean.begin(), b.mean.end(), 0.0 );
+        std::fill( b.var .begin(), b.var .end(), 0.0 );
+        for( int j=0; j<ns; j++ ) {
+            const float* p = m_data + size_t( index[begin+j] )*m_dim;
+            for( int d=0; d<m_dim; d++ )
+                b.mean[d] += p[d];
+        }
+        for( int d=0; d<m_dim; d++ )
+            b.mean[d] /= ns;
+        for( int j=0; j<ns; j++ ) {
+            const float* p = m_data + size_t( index[begin+j] )*m_dim;
+            for( int d=0; d<m_dim; d++ ) {
+                double e = p[d] - b.mean[d];
+                b.var[d] += e*e;
+            }
+        }
+
+        for( int d=0; d<m_dim; d++ )
+            b.dims[d] = d;
+        int r = (int)b.gen.uniform_index( uint32_t( std::min( m_params.n_split_dims, m_dim ) ) );
+        std::nth_element( b.dims.begin(), b.dims.begin()+r, b.dims.end(), VarGreater( b.var ) );
+        const int sd    = b.dims[r];
+        float     split = float( b.mean[sd] );
+
+        int mid = int( std::partition( index+begin, index+end, CoordBelow( m_data, m_dim, sd, split ) ) - index );
+        if( mid == begin || mid == end ) {
+            // all sampled values on one side - split at the median instead.
+            // left <= split <= right still bounds the distances to the far side.
+            mid = begin + count/2;
+            std::nth_element( index+begin, index+mid, index+end, CoordLess( m_data, m_dim, sd ) );
+            split = m_data[ size_t( index[mid] )*m_dim + sd ];
+        }
+
+        int left  = divide( b, t, begin, mid );
+        int right = divide( b, t, mid,   end );
+        nodes[id].split_dim = sd;
+        nodes[id].split     = split;
+        nodes[id].left      = left;
+        nodes[id].right     = right;
+        return id;
+    }
+
+    void KdForest::scan_leaf( Search& s, const int& t, const Node& leaf ) const {
+        const int* index = &m_index[t][0];
+        for( int j=leaf.left; j<leaf.right; j++ ) {
+            const int i = index[j];
+            float d = s.dist( s.q, m_data + size_t(i)*m_dim, m_dim );
+            s.n_checks++;
+            if( s.collect ) {
+                if( d < s.radius2 )
+                    s.nn.push_back( DistId( d, i ) );
+                continue;
+            }
+            if( d >= s.nn[s.k-1].first )
+                continue;
+            // the other trees may have reached i already
+            bool seen = false;
+            for( int m=0; m<s.k && !seen; m++ )
+                seen = ( s.nn[m].second == i );
+            if( seen )
+                continue;
+            int p = s.k-1;
+            while( p > 0 && d < s.nn[p-1].first ) {
+                s.nn[p] = s.nn[p-1];
+                p--;
+            }
+            s.nn[p] = DistId( d, i );
+        }
+    }
+
+    void KdForest::descend( Search& s, int t, int node, float rd ) const {
+        const vector<Node>& nodes = m_nodes[t];
+        while( nodes[node].split_dim >= 0 ) {
+            const Node& nd   = nodes[node];
+            const float diff = s.q[nd.split_dim] - nd.split;
+            const float fd   = rd + diff*diff;
+            int near = nd.left, far = nd.right;
+            if( diff >= 0.0f ) std::swap( near, far );
+            if( fd < s.bound() ) {
+                s.branches.push_back( KdBranch( fd, t, far ) );
+                std::push_heap( s.branches.begin(), s.branches.end(), std::greater<KdBranch>() );
+            }
+            node = near;
+        }
+        scan_leaf( s, t, nodes[node] );
+    }
+
+    // arya & mount's incremental distance to the cell - offsets holds the
+    // distance of q to the cell along each dimension
+    void KdForest::search_exact( Search& s, int node, float rd ) const {
+        const Node& nd = m_nodes[0][node];
+        if( nd.split_dim < 0 ) {
+            scan_leaf( s, 0, nd );
+            return;
+        }
+        const float diff = s.q[nd.split_dim] - nd.split;
+        int near = nd.left, far = nd.right;
+        if( diff >= 0.0f ) std::swap( near, far );
+        search_exact( s, near, rd );
+
+        float& off = s.offsets[nd.split_dim];
+        const float old = off;
+        const float frd = rd - old*old + diff*diff;
+        if( frd < s.bound() ) {
+            off = diff;
+            search_exact( s, far, frd );
+            off = old;
+        }
+    }
+
+    void KdForest::knn( const float* query, int n_query, int k, int checks, bool run_parallel,
+                        int* indices, float* distances ) const {
+        passert_pointer( indices && distances );
+        passert_pointer( n_query == 0 || query );
+        passert_statement_g( k > 0, "invalid number of neighbors [%d]", k );
+
+        const L2SqKernel dist = select_l2sq_kernel( m_dim );
+#pragma omp parallel if(run_parallel)
+        {
+            Search s;
+            s.dist    = dist;
+            s.k       = k;
+            s.collect = false;
+            s.radius2 = 0.0f;
+            s.offsets.resize( m_dim );
+#pragma omp for schedule(dynamic,64)
+            for( int qi=0; qi<n_query; qi++ ) {
+                s.q        = query + size_t(qi)*m_dim;
+                s.n_checks = 0;
+                s.nn.assign( k, DistId( FLT_MAX, -1 ) );
+                s.branches.clear();
+                if( m_n > 0 ) {
+                    if( checks <= 0 ) {
+                        std::fill( s.offsets.begin(), s.offsets.end(), 0.0f );
+                        search_exact( s, 0, 0.0f );
+                    } else {
+                        for( int t=0; t<n_trees(); t++ )
+                            descend( s, t, 0, 0.0f );
+                        while( !s.branches.empty() && s.n_checks < checks ) {
+                            std::pop_heap( s.branches.begin(), s.branches.end(), std::greater<KdBranch>() );
+                            KdBranch br = s.branches.back();
+                            s.branches.pop_back();
+                            if( br.d >= s.bound() ) break;
+                            descend( s, br.tree, br.node, br.d );
+                        }
+                    }
+                }
+                int n_nn = 0;
+                while( n_nn < k && s.nn[n_nn].second >= 0 )
+                    n_nn++;
+                write_neighbors( &s.nn[0], n_nn, k, indices + size_t(qi)*k, distances + size_t(qi)*k );
+            }
+        }
+    }
+
+    void KdForest::radius_search( const float* q, float radius, vector<int>& indices,
+                                  vector<float>* distances ) const {
+        passert_pointer( q );
+        indices.clear();
+        if( distances ) distances->clear();
+        if( m_n == 0 ) return;
+
+        Search s;
+        s.q        = q;
+        s.dist     = select_l2sq_kernel( m_dim );
+        s.n_checks = 0;
+        s.k        = 0;
+        s.collect  = true;
+        s.radius2  = radius*radius;
+        s.offsets.assign( m_dim, 0.0f );
+        search_exact( s, 0, 0.0f );
+
+        std::sort( s.nn.begin(), s.nn.end() );
+        indices.resize( s.nn.size() );
+        if( distances ) distances->resize( s.nn.size() );
+        for( size_t j=0; j<s.nn.size(); j++ ) {
+            indices[j] = s.nn[j].second;
+            if( distances ) (*distances)[j] = std::sqrt( s.nn[j].first );
+        }
+    }
+
+    void KdForest::save( const string& file ) const {
+        ofstream fout;
+        open_or_fail( file, fout, true );
+        insert_binary_stream_begin_tag( fout );
+        write_bparam( fout, string("kdforest") );
+        write_bparam( fout, m_n   );
+        write_bparam( fout, m_dim );
+        write_bparam( fout, n_trees() );
+        write_bparam( fout, m_params.leaf_size    );
+        write_bparam( fout, m_params.n_split_dims );
+        write_bparam( fout, m_params.seed         );
+        for( int t=0; t<n_trees(); t++ ) {
+            int n_nodes = (int)m_nodes[t].size();
+            write_bparam( fout, n_nodes );
+            if( n_nodes ) write_barray( fout, &m_nodes[t][0], n_nodes );
+            if( m_n     ) write_barray( fout, &m_index[t][0], m_n     );
+        }
+        insert_binary_stream_end_tag( fout );
+        fout.close();
+    }
+
+    void KdForest::load( const string& file, const float* data, int n, int dim ) {
+        passert_pointer( n == 0 || data );
+        ifstream fin;
+        open_or_fail( file, fin, true );
+        check_binary_stream_begin_tag( fin );
+        string tag;
+        read_bparam( fin, tag );
+        passert_statement_g( tag == "kdforest", "[%s] is not a k-d forest", file.c_str() );
+
+        release();
+        int fn, fdim, ntrees;
+        read_bparam( fin, fn     );
+        read_bparam( fin, fdim   );
+        read_bparam( fin, ntrees );
+        passert_statement_g( fn == n && fdim == dim, "index of [%d x %d] points given [%d x %d]",
+                             fn, fdim, n, dim );
+        m_data = data;
+        m_n    = n;
+        m_dim  = dim;
+        m_params.n_trees = ntrees;
+        read_bparam( fin, m_params.leaf_size    );
+        read_bparam( fin, m_params.n_split_dims );
+        read_bparam( fin, m_params.seed         );
+        m_nodes.resize( ntrees );
+        m_index.resize( ntrees );
+        for( int t=0; t<ntrees; t++ ) {
+            int n_nodes = 0;
+            read_bparam( fin, n_nodes );
+            m_nodes[t].resize( n_nodes );
+            m_index[t].resize( m_n );
+            if( n_nodes ) read_barray( fin, &m_nodes[t][0], n_nodes );
+            if( m_n     ) read_barray( fin, &m_index[t][0], m_n     );
+        }
+        check_binary_stream_end_tag( fin );
+        fin.close();
+    }
+
+    //
+    // hnsw
+    //
+
+    // lock striping - a thread holds at most one node lock at a time
+    static const int HNSW_N_LOCKS = 1<<16;
+
+    HnswParams::HnswParams() {
+        M               = 16;
+        ef_construction = 200;
+        seed            = 0;
+        run_parallel    = true;
+    }
+
+    struct HnswIndex::Scratch {
+        L2SqKernel       dist;
+        vector<uint16_t> visited;
+        uint16_t         tag;
+        // min-heap of the candidates to expand
+        vector<DistId>   cand;
+        // max-heap of the ef closest points found
+        vector<DistId>   top;
+        // candidates of select - sorted by increasing distance
+        vector<DistId>   sel;
+        vector<int>      chosen;
+        vector<int>      nbrs;
+
+        Scratch( const int& n, const int& dim ) {
+            dist = select_l2sq_kernel( dim );
+            visited.assign( n, 0 );
+            tag  = 0;
+        }
+        void next_tag() {
+            if( ++tag == 0 ) {
+                std::fill( visited.begin(), visited.end(), 0 );
+                tag = 1;
+            }
+        }
+    };
+
+    struct HnswIndex::Locks {
+#ifdef _OPENMP
+        vector<omp_lock_t> node;
+        omp_lock_t         global;
+        Locks() {
+            node.resize( HNSW_N_LOCKS );
+            for( int i=0; i<HNSW_N_LOCKS; i++ )
+                omp_init_lock( &node[i] );
+            omp_init_lock( &global );
+        }
+        ~Locks() {
+            for( int i=0; i<HNSW_N_LOCKS; i++ )
+                omp_destroy_lock( &node[i] );
+            omp_destroy_lock( &global );
+        }
+        void lock         ( const int& i ) { omp_set_lock  ( &node[ i & (HNSW_N_LOCKS-1) ] ); }
+        void unlock       ( const int& i ) { omp_unset_lock( &node[ i & (HNSW_N_LOCKS-1) ] ); }
+        void lock_global  () { omp_set_lock  ( &global ); }
+        void unlock_global() { omp_unset_lock( &global ); }
+#else
+        void lock         ( const int& ) {}
+        void unlock       ( const int& ) {}
+        void lock_global  () {}
+        void unlock_global() {}
+#endif
+    };
+
+    HnswIndex::HnswIndex() {
+        m_data      = NULL;
+        m_n         = 0;
+        m_dim       = 0;
+        m_entry     = -1;
+        m_max_level = -1;
+    }
+
+    void HnswIndex::release() {
+        m_data      = NULL;
+        m_n         = 0;
+        m_dim       = 0;
+        m_entry     = -1;
+        m_max_level = -1;
+        m_levels      .clear();
+        m_links0      .clear();
+        m_upper       .clear();
+        m_upper_offset.clear();
+    }
+
+    int* HnswIndex::links( const int& i, const int& level ) {
+        if( level == 0 )
+            return &m_links0[ size_t(i)*( 2*m_params.M+1 ) ];
+        return &m_upper[ m_upper_offset[i] + size_t(level-1)*( m_params.M+1 ) ];
+    }
+
+    const int* HnswIndex::links( const int& i, const int& level ) const {
+        if( level == 0 )
+            return &m_links0[ size_t(i)*( 2*m_params.M+1 ) ];
+        return &m_upper[ m_upper_offset[i] + size_t(level-1)*( m_params.M+1 ) ];
+    }
+
+    size_t HnswIndex::set_upper_offsets() {
+        m_upper_offset.resize( m_n );
+        size_t sz = 0;
+        for( int i=0; i<m_n; i++ ) {
+            m_upper_offset[i] = sz;
+            sz += size_t( m_levels[i] )*( m_params.M+1 );
+        }
+        return sz;
+    }
+
+    void HnswIndex::build( const float* data, int n, int dim, const HnswParams& params ) {
+        passert_pointer( n == 0 || data );
+        passert_statement_g( n >= 0 && dim > 0, "invalid data size [%d x %d]", n, dim );
+        passert_statement_g( params.M > 1 && params.ef_construction > 0,
+                             "invalid hnsw params [M %d, ef_construction %d]",
+                             params.M, params.ef_construction );
+        release();
+        m_data   = data;
+        m_n      = n;
+        m_dim    = dim;
+        m_params = params;
+        if( n == 0 ) return;
+
+        // level i with probability ( 1/M )^i ( 1 - 1/M )
+        PhiloxGenerator gen( params.seed );
+        const double ml = 1.0 / std::log( double( params.M ) );
+        m_levels.resize( n );
+        for( int i=0; i<n; i++ )
+            m_levels[i] = int( -std::log( 1.0 - gen.uniform_sample() ) * ml );
+
+        m_links0.assign( size_t(n)*( 2*params.M+1 ), 0 );
+        m_upper .assign( set_upper_offsets(), 0 );
+        m_entry     = 0;
+        m_max_level = m_levels[0];
+
+        Locks locks;
+#pragma omp parallel if(params.run_parallel)
+        {
+            Scratch s( m_n, m_dim );
+#pragma omp for schedule(dynamic,256)
+            for( int i=1; i<n; i++ )
+                insert( i, s, locks );
+        }
+    }
+
+    void HnswIndex::insert( const int& i, Scratch& s, Locks& locks ) {
+        const float* q     = m_data + size_t(i)*m_dim;
+        const int    level = m_levels[i];
+
+        locks.lock_global();
+        int cur       = m_entry;
+        int top_level = m_max_level;
+        locks.unlock_global();
+
+        for( int l=top_level; l>level; l-- )
+            cur = greedy( q, cur, l, s, &locks );
+
+        for( int l=std::min( level, top_level ); l>=0; l-- ) {
+            search_layer( q, cur, m_params.ef_construction, l, s, &locks );
+            cur = s.top[0].second;
+
+            s.sel.clear();
+            for( size_t j=0; j<s.top.size(); j++ )
+                if( s.top[j].second != i )
+                    s.sel.push_back( s.top[j] );
+            select( m_params.M, s );
+            s.chosen.resize( s.sel.size() );
+            for( size_t j=0; j<s.sel.size(); j++ )
+                s.chosen[j] = s.sel[j].second;
+
+            locks.lock( i );
+            int* li = links( i, l );
+            li[0] = (int)s.chosen.size();
+            std::copy( s.chosen.begin(), s.chosen.end(), li+1 );
+            locks.unlock( i );
+
+            for( size_t j=0; j<s.chosen.size(); j++ )
+                add_link( s.chosen[j], i, l, s, locks );
+        }
+
+        if( level > top_level ) {
+            locks.lock_global();
+            if( level > m_max_level ) {
+                m_max_level = level;
+                m_entry     = i;
+            }
+            locks.unlock_global();
+        }
+    }
+
+    // malkov's heuristic - a candidate is linked only if it is closer to the
+    // base than to the candidates already linked. keeps links in all
+    // directions instead of clustering them.
+    void HnswIndex::select( const int& M, Scratch& s ) const {
+        vector<DistId>& c = s.sel;
+        int n_kept = 0;
+        for( size_t j=0; j<c.size() && n_kept < M; j++ ) {
+            const float* pj = m_data + size_t( c[j].second )*m_dim;
+            bool good = true;
+            for( int r=0; r<n_kept && good; r++ )
+                good = s.dist( pj, m_data + size_t( c[r].second )*m_dim, m_dim ) >= c[j].first;
+            if( good )
+                c[n_kept++] = c[j];
+        }
+        c.resize( n_kept );
+    }
+
+    void HnswIndex::add_link( const int& from, const int& to, const int& level, Scratch& s, Locks& locks ) {
+        locks.lock( from );
+        int* l = links( from, level );
+        const int cap = capacity( level );
+        if( l[0] < cap ) {
+            l[ 1+l[0] ] = to;
+            l[0]++;
+        } else {
+            const float* p = m_data + size_t(from)*m_dim;
+            s.sel.clear();
+            s.sel.push_back( DistId( s.dist( p, m_data + size_t(to)*m_dim, m_dim ), to ) );
+            for( int j=0; j<l[0]; j++ )
+                s.sel.push_back( DistId( s.dist( p, m_data + size_t( l[1+j] )*m_dim, m_dim ), l[1+j] ) );
+            std::sort( s.sel.begin(), s.sel.end() );
+            select( cap, s );
+            l[0] = (int)s.sel.size();
+            for( size_t j=0; j<s.sel.size(); j++ )
+                l[1+j] = s.sel[j].second;
+        }
+        locks.unlock( from );
+    }
+
+    int HnswIndex::greedy( const float* q, int cur, const int& level, Scratch& s, Locks* locks ) const {
+        float d = s.dist( q, m_data + size_t(cur)*m_dim, m_dim );
+        bool changed = true;
+        while( changed ) {
+            changed = false;
+            const int* l = links( cur, level );
+            if( locks ) {
+                // the list may be rewritten by other insertions
+                locks->lock( cur );
+                s.nbrs.assign( l+1, l+1+l[0] );
+                locks->unlock( cur );
+            } else {
+                s.nbrs.assign( l+1, l+1+l[0] );
+            }
+            for( size_t j=0; j<s.nbrs.size(); j++ ) {
+                float e = s.dist( q, m_data + size_t( s.nbrs[j] )*m_dim, m_dim );
+                if( e < d ) {
+                    d       = e;
+                    cur     = s.nbrs[j];
+                    changed = true;
+                }
+            }
+        }
+        return cur;
+    }
+
+    // beam search from ep - s.top holds the ef closest points found sorted
+    // by increasing distance
+    void HnswIndex::search_layer( const float* q, const int& ep, const int& ef, const int& level,
+                                  Scratch& s, Locks* locks ) const {
+        std::greater<DistId> min_order;
+        s.next_tag();
+        s.cand.clear();
+        s.top .clear();
+
+        DistId e( s.dist( q, m_data + size_t(ep)*m_dim, m_dim ), ep );
+        s.visited[ep] = s.tag;
+        s.cand.push_back( e );
+        s.top .push_back( e );
+
+        while( !s.cand.empty() ) {
+            std::pop_heap( s.cand.begin(), s.cand.end(), min_order );
+            const DistId c = s.cand.back();
+            s.cand.pop_back();
+            if( c.first > s.top.front().first && (int)s.top.size() >= ef )
+                break;
+
+            const int* l = links( c.second, level );
+            if( locks ) {
+                locks->lock( c.second );
+                s.nbrs.assign( l+1, l+1+l[0] );
+                locks->unlock( c.second );
+            } else {
+                s.nbrs.assign( l+1, l+1+l[0] );
+            }
+            const int nn = (int)s.nbrs.size();
+            for( int j=0; j<nn; j++ ) {
+                const int id = s.nbrs[j];
+                if( j+1 < nn )
+                    __builtin_prefetch( m_data + size_t( s.nbrs[j+1] )*m_dim );
+                if( s.visited[id] == s.tag ) continue;
+                s.visited[id] = s.tag;
+
+                float d = s.dist( q, m_data + size_t(id)*m_dim, m_dim );
+                if( (int)s.top.size() < ef || d < s.top.front().first ) {
+                    s.cand.push_back( DistId( d, id ) );
+                    std::push_heap( s.cand.begin(), s.cand.end(), min_order );
+                    s.top.push_back( DistId( d, id ) );
+                    std::push_heap( s.top.begin(), s.top.end() );
+                    if( (int)s.top.size() > ef ) {
+                        std::pop_heap( s.top.begin(), s.top.end() );
+                        s.top.pop_back();
+                    }
+                }
+            }
+        }
+        std::sort_heap( s.top.begin(), s.top.end() );
+    }
+
+    void HnswIndex::knn( const float* query, int n_query, int k, int ef, bool run_parallel,
+                         int* indices, float* distances ) const {
+        passert_pointer( indices && distances );
+        passert_pointer( n_query == 0 || query );
+        passert_statement_g( k > 0, "invalid number of neighbors [%d]", k );
+
+        if( m_n == 0 ) {
+            for( size_t j=0; j<size_t(n_query)*k; j++ ) {
+                indices  [j] = -1;
+                distances[j] = -1.0f;
+            }
+            return;
+        }
+
+        const int width = std::max( ef, k );
+#pragma omp parallel if(run_parallel)
+        {
+            Scratch s( m_n, m_dim );
+#pragma omp for schedule(dynamic,16)
+            for( int qi=0; qi<n_query; qi++ ) {
+                const float* q = query + size_t(qi)*m_dim;
+                int cur = m_entry;
+                for( int l=m_max_level; l>0; l-- )
+                    cur = greedy( q, cur, l, s, NULL );
+                search_layer( q, cur, width, 0, s, NULL );
+                write_neighbors( &s.top[0], (int)s.top.size(), k,
+                                 indices + size_t(qi)*k, distances + size_t(qi)*k );
+            }
+        }
+    }
+
+    void HnswIndex::save( const string& file ) const {
+        ofstream fout;
+        open_or_fail( file, fout, true );
+        insert_binary_stream_begin_tag( fout );
+        write_bparam( fout, string("hnsw") );
+        write_bparam( fout, m_n   );
+        write_bparam( fout, m_dim );
+        write_bparam( fout, m_params.M               );
+        write_bparam( fout, m_params.ef_construction );
+        write_bparam( fout, m_params.seed            );
+        write_bparam( fout, m_entry     );
+        write_bparam( fout, m_max_level );
+        if( m_n ) {
+            write_barray( fout, &m_levels[0], m_n );
+            write_barray( fout, &m_links0[0], m_links0.size() );
+        }
+        if( !m_upper.empty() )
+            write_barray( fout, &m_upper[0], m_upper.size() );
+        insert_binary_stream_end_tag( fout );
+        fout.close();
+    }
+
+    void HnswIndex::load( const string& file, const float* data, int n, int dim ) {
+        passert_pointer( n == 0 || data );
+        ifstream fin;
+        open_or_fail( file, fin, true );
+        check_binary_stream_begin_tag( fin );
+        string tag;
+        read_bparam( fin, tag );
+        passert_statement_g( tag == "hnsw", "[%s] is not an hnsw index", file.c_str() );
+
+        release();
+        int fn, fdim;
+        read_bparam( fin, fn   );
+        read_bparam( fin, fdim );
+        passert_statement_g( fn == n && fdim == dim, "index of [%d x %d] points given [%d x %d]",
+                             fn, fdim, n, dim );
+        m_data = data;
+        m_n    = n;
+        m_dim  = dim;
+        read_bparam( fin, m_params.M               );
+        read_bparam( fin, m_params.ef_construction );
+        read_bparam( fin, m_params.seed            );
+        read_bparam( fin, m_entry     );
+        read_bparam( fin, m_max_level );
+        if( m_n ) {
+            m_levels.resize( m_n );
+            m_links0.resize( size_t(m_n)*( 2*m_params.M+1 ) );
+            read_barray( fin, &m_levels[0], m_n );
+            read_barray( fin, &m_links0[0], m_links0.size() );
+        }
+        m_upper.resize( set_upper_offsets() );
+        if( !m_upper.empty() )
+            read_barray( fin, &m_upper[0], m_upper.size() );
+        check_binary_stream_end_tag( fin );
+        fin.close();
+    }
+
+}
@@ -0,0 +1,108 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+#include <kortex/cpu_features.h>
+#include <kortex/check.h>
+
+#if defined(KORTEX_WITH_SIMD_DISPATCH) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace kortex {
+
+    static SimdLevel g_simd_level_limit = SIMD_AVX512;
+
+    static SimdLevel detect_simd_level() {
+#if defined(KORTEX_WITH_SIMD_DISPATCH) && defined(__GNUC__)
+        __builtin_cpu_init();
+        if( __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512vl") )
+            return SIMD_AVX512;
+        if( __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") )
+            return SIMD_AVX2;
+        if( __builtin_cpu_supports("sse2") )
+            return SIMD_SSE2;
+        return SIMD_NONE;
+#elif defined(KORTEX_WITH_SIMD_DISPATCH) && defined(_MSC_VER)
+        int info[4];
+        __cpuid( info, 0 );
+        int n_ids = info[0];
+        __cpuid( info, 1 );
+        bool sse2  = ( info[3] & (1<<26) ) != 0;
+        bool fma   = ( info[2] & (1<<12) ) != 0;
+        bool osxs  = ( info[2] & (1<<27) ) != 0;
+        bool avx   = ( info[2] & (1<<28) ) != 0;
+        if( !sse2 ) return SIMD_NONE;
+        if( !(osxs && avx && fma) || n_ids < 7 ) return SIMD_SSE2;
+        unsigned long long xcr0 = _xgetbv(0);
+        if( (xcr0 & 0x06) != 0x06 ) return SIMD_SSE2; // ymm state not enabled by os
+        __cpuidex( info, 7, 0 );
+        bool avx2     = ( info[1] & (1<< 5) ) != 0;
+        bool avx512f  = ( info[1] & (1<<16) ) != 0;
+        bool avx512bw = ( info[1] & (1<<30) ) != 0;
+        bool avx512vl = ( info[1] & (1<<31) ) != 0;
+        if( !avx2 ) return SIMD_SSE2;
+        if( avx512f && avx512bw && avx512vl && (xcr0 & 0xE6) == 0xE6 ) return SIMD_AVX512;
+        return SIMD_AVX2;
+#else
+        return SIMD_NONE;
+#endif
+    }
+
+    static bool detect_vpopcntdq() {
+#if defined(KORTEX_WITH_SIMD_DISPATCH) && defined(__GNUC__)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512vpopcntdq");
+#elif defined(KORTEX_WITH_SIMD_DISPATCH) && defined(_MSC_VER)
+        if( detect_simd_level() != SIMD_AVX512 ) return false;
+        int info[4];
+        __cpuidex( info, 7, 0 );
+        return ( info[2] & (1<<14) ) != 0;
+#else
+        return false;
+#endif
+    }
+
+    bool cpu_has_vpopcntdq() {
+        static const bool supported = detect_vpopcntdq() && cpu_simd_level() == SIMD_AVX512;
+        return supported;
+    }
+
+    SimdLevel cpu_simd_level() {
+        static const SimdLevel level = detect_simd_level();
+        return level;
+    }
+
+    SimdLevel simd_level() {
+        SimdLevel level = cpu_simd_level();
+        return ( level < g_simd_level_limit ) ? level : g_simd_level_limit;
+    }
+
+    void set_simd_level_limit( const SimdLevel& level ) {
+        passert_boundary( level, SIMD_NONE, SIMD_AVX512+1 );
+        g_simd_level_limit = level;
+    }
+
+    string simd_level_name( const SimdLevel& level ) {
+        switch( level ) {
+        case SIMD_NONE  : return "none";
+        case SIMD_SSE2  : return "sse2";
+        case SIMD_AVX2  : return "avx2";
+        case SIMD_AVX512: return "avx512";
+        default         : switch_fatality();
+        }
+        return "";
+    }
+
+}
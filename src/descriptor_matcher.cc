@@ -0,0 +1,746 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/descriptor_matcher.h>
+#include <kortex/bit_operations.h>
+#include <kortex/cpu_features.h>
+#include <kortex/check.h>
+
+#include <algorithm>
+#include <limits>
+#include <climits>
+#include <cmath>
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace kortex {
+
+    // a query block is scanned over a train block of 32 kb before moving on
+    static const int MATCH_QUERY_BLOCK = 64;
+    static const int MATCH_TRAIN_BLOCK = 1024;
+
+    MatcherParams::MatcherParams() {
+        max_distance = -1.0f;
+        ratio        = 1.0f;
+        cross_check  = false;
+        run_parallel = true;
+    }
+
+    // inserts ( d, i ) into the sorted k-lists if it is closer than the last
+    // entry. equal distances keep the earlier - lower - index first.
+    template<typename T>
+    static inline void knn_insert( const T& d, const int& i, const int& k, T* bd, int* bi ) {
+        int p = k-1;
+        while( p > 0 && d < bd[p-1] ) {
+            bd[p] = bd[p-1];
+            bi[p] = bi[p-1];
+            p--;
+        }
+        bd[p] = d;
+        bi[p] = i;
+    }
+
+    //
+    // hamming distances of a query to n consecutive train descriptors
+    //
+
+    typedef void (*Hamming256RowKernel)( const uchar* q, const uchar* train, const int& n, int* d );
+
+    static void hamming_256_row_basic( const uchar* q, const uchar* train, const int& n, int* d ) {
+        for( int j=0; j<n; j++ )
+            d[j] = hamming_256( q, train + 32*size_t(j) );
+    }
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+
+    // per-byte popcount through a nibble lookup table
+    KORTEX_TARGET_AVX2
+    static inline __m256i popcount_bytes_avx2( const __m256i& v ) {
+        const __m256i lut  = _mm256_setr_epi8( 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                               0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 );
+        const __m256i mask = _mm256_set1_epi8( 0x0f );
+        __m256i lo = _mm256_and_si256( v, mask );
+        __m256i hi = _mm256_and_si256( _mm256_srli_epi16( v, 4 ), mask );
+        return _mm256_add_epi8( _mm256_shuffle_epi8( lut, lo ), _mm256_shuffle_epi8( lut, hi ) );
+    }
+
+    KORTEX_TARGET_AVX2
+    static inline __m256i hamming_256_partial_avx2( const __m256i& q, const uchar* t ) {
+        __m256i x = _mm256_xor_si256( q, _mm256_loadu_si256( (const __m256i*)t ) );
+        return _mm256_sad_epu8( popcount_bytes_avx2( x ), _mm256_setzero_si256() );
+    }
+
+    KORTEX_TARGET_AVX2
+    static void hamming_256_row_avx2( const uchar* q, const uchar* train, const int& n, int* d ) {
+        const __m256i vq = _mm256_loadu_si256( (const __m256i*)q );
+        const __m256i lo = _mm256_setr_epi32( 0, 2, 4, 6, 0, 2, 4, 6 );
+        int j = 0;
+        for( ; j+4<=n; j+=4 ) {
+            const uchar* t = train + 32*size_t(j);
+            // four 64 bit partial sums per descriptor
+            __m256i a = hamming_256_partial_avx2( vq, t      );
+            __m256i b = hamming_256_partial_avx2( vq, t + 32 );
+            __m256i c = hamming_256_partial_avx2( vq, t + 64 );
+            __m256i e = hamming_256_partial_avx2( vq, t + 96 );
+            __m256i ab = _mm256_add_epi64( _mm256_unpacklo_epi64( a, b ), _mm256_unpackhi_epi64( a, b ) );
+            __m256i ce = _mm256_add_epi64( _mm256_unpacklo_epi64( c, e ), _mm256_unpackhi_epi64( c, e ) );
+            __m256i s  = _mm256_add_epi64( _mm256_permute2x128_si256( ab, ce, 0x20 ),
+                                           _mm256_permute2x128_si256( ab, ce, 0x31 ) );
+            s = _mm256_permutevar8x32_epi32( s, lo );
+            _mm_storeu_si128( (__m128i*)(d+j), _mm256_castsi256_si128( s ) );
+        }
+        hamming_256_row_basic( q, train + 32*size_t(j), n-j, d+j );
+    }
+
+    // two descriptors per register - the qword popcounts of eight descriptors
+    // are reduced with unpack/shuffle adds
+    KORTEX_TARGET_AVX512_VPOPCNT
+    static void hamming_256_row_avx512( const uchar* q, const uchar* train, const int& n, int* d ) {
+        const __m512i vq    = _mm512_broadcast_i64x4( _mm256_loadu_si256( (const __m256i*)q ) );
+        const __m256i order = _mm256_setr_epi32( 0, 2, 1, 3, 4, 6, 5, 7 );
+        int j = 0;
+        for( ; j+8<=n; j+=8 ) {
+            const uchar* t = train + 32*size_t(j);
+            __m512i p0 = _mm512_popcnt_epi64( _mm512_xor_si512( vq, _mm512_loadu_si512( t       ) ) );
+            __m512i p1 = _mm512_popcnt_epi64( _mm512_xor_si512( vq, _mm512_loadu_si512( t +  64 ) ) );
+            __m512i p2 = _mm512_popcnt_epi64( _mm512_xor_si512( vq, _mm512_loadu_si512( t + 128 ) ) );
+            __m512i p3 = _mm512_popcnt_epi64( _mm512_xor_si512( vq, _mm512_loadu_si512( t + 192 ) ) );
+            __m512i s01 = _mm512_add_epi64( _mm512_unpacklo_epi64( p0, p1 ), _mm512_unpackhi_epi64( p0, p1 ) );
+            __m512i s23 = _mm512_add_epi64( _mm512_unpacklo_epi64( p2, p3 ), _mm512_unpackhi_epi64( p2, p3 ) );
+            __m512i s   = _mm512_add_epi64( _mm512_shuffle_i64x2( s01, s23, _MM_SHUFFLE(2,0,2,0) ),
+                                            _mm512_shuffle_i64x2( s01, s23, _MM_SHUFFLE(3,1,3,1) ) );
+            // s holds descriptors 0 2 1 3 4 6 5 7
+            __m256i r = _mm256_permutevar8x32_epi32( _mm512_cvtepi64_epi32( s ), order );
+            _mm256_storeu_si256( (__m256i*)(d+j), r );
+        }
+        hamming_256_row_basic( q, train + 32*size_t(j), n-j, d+j );
+    }
+
+#endif
+
+    static Hamming256RowKernel select_hamming_256_kernel() {
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512:
+            if( cpu_has_vpopcntdq() ) return hamming_256_row_avx512;
+            return hamming_256_row_avx2;
+        case SIMD_AVX2  : return hamming_256_row_avx2;
+        default: break;
+        }
+#endif
+        return hamming_256_row_basic;
+    }
+
+    void hamming_256_knn( const uchar* query, int n_query, const uchar* train, int n_train,
+                          int k, bool run_parallel, int* indices, int* distances ) {
+        passert_pointer( indices && distances );
+        passert_pointer( n_query == 0 || query );
+        passert_pointer( n_train == 0 || train );
+        passert_statement_g( k > 0, "invalid number of neighbors [%d]", k );
+
+        const Hamming256RowKernel kernel = select_hamming_256_kernel();
+        const int n_blocks = ( n_query + MATCH_QUERY_BLOCK - 1 ) / MATCH_QUERY_BLOCK;
+#pragma omp parallel for schedule(dynamic,1) if(run_parallel)
+        for( int b=0; b<n_blocks; b++ ) {
+            const int q0 = b * MATCH_QUERY_BLOCK;
+            const int q1 = std::min( q0 + MATCH_QUERY_BLOCK, n_query );
+            for( int i=q0*k; i<q1*k; i++ ) {
+                indices  [i] = -1;
+                distances[i] = INT_MAX;
+            }
+            int dist[MATCH_TRAIN_BLOCK];
+            for( int t0=0; t0<n_train; t0+=MATCH_TRAIN_BLOCK ) {
+                const int    nt = std::min( MATCH_TRAIN_BLOCK, n_train - t0 );
+                const uchar* tb = train + 32*size_t(t0);
+                for( int q=q0; q<q1; q++ ) {
+                    kernel( query + 32*size_t(q), tb, nt, dist );
+                    int* bd    = distances + size_t(q)*k;
+                    int* bi    = indices   + size_t(q)*k;
+                    int  worst = bd[k-1];
+                    for( int j=0; j<nt; j++ ) {
+                        if( dist[j] < worst ) {
+                            knn_insert( dist[j], t0+j, k, bd, bi );
+                            worst = bd[k-1];
+                        }
+                    }
+                }
+            }
+            for( int i=q0*k; i<q1*k; i++ )
+                if( indices[i] < 0 ) distances[i] = -1;
+        }
+    }
+
+    //
+    // real valued descriptors - blocked gemm with top-2 lists
+    //
+
+    // train panels of a block span about 256 kb
+    static const int KNN2_QUERY_BLOCK       = 96;
+    static const int KNN2_TRAIN_BLOCK_BYTES = 1<<18;
+
+    template<typename T>
+    struct Knn2 {
+        T   d1, d2;
+        int i1, i2;
+    };
+
+    // equal scores keep the earlier - lower - index first
+    template<typename T>
+    static inline void knn2_update( const T& d, const int& i, Knn2<T>& s ) {
+        if( d < s.d1 ) {
+            s.d2 = s.d1;
+            s.i2 = s.i1;
+            s.d1 = d;
+            s.i1 = i;
+        } else if( d < s.d2 ) {
+            s.d2 = d;
+            s.i2 = i;
+        }
+    }
+
+    // merges the scores of the nr trains of a panel starting at j0
+    template<typename T>
+    static inline void knn2_merge( const T* s, const int& nr, const int& j0, Knn2<T>& st ) {
+        for( int j=0; j<nr; j++ )
+            if( s[j] < st.d2 ) knn2_update( s[j], j0+j, st );
+    }
+
+    // scores s_j = beta_j + alpha_j * dot( q, t_j ) of mr ( <= MR ) packed
+    // queries against n_panels train panels of NR trains each. pq holds the
+    // queries depth-major ( pq[p*MR+r] ) and each panel its trains depth-major
+    // ( pt[p*NR+j] ). j0 is the index of the first train.
+    template<typename T, typename P>
+    struct Knn2Kernel {
+        typedef void (*Function)( const P* pq, const P* pt, const int& n_panels, const int& depth,
+                                  const T* alpha, const T* beta, const int& j0, const int& mr,
+                                  Knn2<T>* st );
+        int      MR;
+        int      NR;
+        Function run;
+    };
+
+    static void knn2_kernel_basic( const float* pq, const float* pt, const int& n_panels, const int& depth,
+                                   const float* alpha, const float* beta, const int& j0, const int& mr,
+                                   Knn2<float>* st ) {
+        for( int b=0; b<n_panels; b++ ) {
+            float acc[16] = { 0.0f };
+            for( int p=0; p<depth; p++ ) {
+                for( int r=0; r<4; r++ )
+                    for( int j=0; j<4; j++ )
+                        acc[4*r+j] += pq[4*p+r] * pt[4*p+j];
+            }
+            for( int r=0; r<mr; r++ ) {
+                float s[4];
+                for( int j=0; j<4; j++ )
+                    s[j] = beta[j] + alpha[j] * acc[4*r+j];
+                knn2_merge( s, 4, j0 + 4*b, st[r] );
+            }
+            pt    += 4*size_t(depth);
+            alpha += 4;
+            beta  += 4;
+        }
+    }
+
+    // uchar values are packed in pairs ( low | high<<16 ) - beta - 2 dot is
+    // exact in 32 bits. alpha is not used.
+    static void knn2_kernel_basic( const int32_t* pq, const int32_t* pt, const int& n_panels, const int& depth,
+                                   const int* alpha, const int* beta, const int& j0, const int& mr,
+                                   Knn2<int>* st ) {
+        for( int b=0; b<n_panels; b++ ) {
+            int acc[16] = { 0 };
+            for( int p=0; p<depth; p++ ) {
+                int t0[4], t1[4];
+                for( int j=0; j<4; j++ ) {
+                    t0[j] = pt[4*p+j] & 0xffff;
+                    t1[j] = int( uint32_t( pt[4*p+j] ) >> 16 );
+                }
+                for( int r=0; r<4; r++ ) {
+                    const int q0 = pq[4*p+r] & 0xffff;
+                    const int q1 = int( uint32_t( pq[4*p+r] ) >> 16 );
+                    for( int j=0; j<4; j++ )
+                        acc[4*r+j] += q0 * t0[j] + q1 * t1[j];
+                }
+            }
+            for( int r=0; r<mr; r++ ) {
+                int s[4];
+                for( int j=0; j<4; j++ )
+                    s[j] = beta[j] - 2*acc[4*r+j];
+                knn2_merge( s, 4, j0 + 4*b, st[r] );
+            }
+            pt   += 4*size_t(depth);
+            beta += 4;
+        }
+    }
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+
+    // 6x16 tile - 12 accumulators, 2 train vectors and 1 broadcast
+    KORTEX_TARGET_AVX2
+    static void knn2_kernel_avx2( const float* pq, const float* pt, const int& n_panels, const int& depth,
+                                  const float* alpha, const float* beta, const int& j0, const int& mr,
+                                  Knn2<float>* st ) {
+        for( int b=0; b<n_panels; b++ ) {
+            __m256 acc[12];
+            for( int i=0; i<12; i++ )
+                acc[i] = _mm256_setzero_ps();
+            const float* a  = pq;
+            const float* bp = pt;
+            for( int p=0; p<depth; p++ ) {
+                __m256 b0 = _mm256_loadu_ps( bp   );
+                __m256 b1 = _mm256_loadu_ps( bp+8 );
+                for( int r=0; r<6; r++ ) {
+                    __m256 q = _mm256_broadcast_ss( a+r );
+                    acc[2*r  ] = _mm256_fmadd_ps( q, b0, acc[2*r  ] );
+                    acc[2*r+1] = _mm256_fmadd_ps( q, b1, acc[2*r+1] );
+                }
+                a  += 6;
+                bp += 16;
+            }
+            const __m256 al0 = _mm256_loadu_ps( alpha   ), al1 = _mm256_loadu_ps( alpha+8 );
+            const __m256 be0 = _mm256_loadu_ps( beta    ), be1 = _mm256_loadu_ps( beta +8 );
+            for( int r=0; r<mr; r++ ) {
+                __m256 s0  = _mm256_fmadd_ps( acc[2*r  ], al0, be0 );
+                __m256 s1  = _mm256_fmadd_ps( acc[2*r+1], al1, be1 );
+                __m256 thr = _mm256_set1_ps( st[r].d2 );
+                int m = _mm256_movemask_ps( _mm256_cmp_ps( s0, thr, _CMP_LT_OQ ) ) |
+                        _mm256_movemask_ps( _mm256_cmp_ps( s1, thr, _CMP_LT_OQ ) );
+                if( m ) {
+                    float s[16];
+                    _mm256_storeu_ps( s,   s0 );
+                    _mm256_storeu_ps( s+8, s1 );
+                    knn2_merge( s, 16, j0 + 16*b, st[r] );
+                }
+            }
+            pt    += 16*size_t(depth);
+            alpha += 16;
+            beta  += 16;
+        }
+    }
+
+    KORTEX_TARGET_AVX2
+    static void knn2_kernel_avx2( const int32_t* pq, const int32_t* pt, const int& n_panels, const int& depth,
+                                  const int* alpha, const int* beta, const int& j0, const int& mr,
+                                  Knn2<int>* st ) {
+        for( int b=0; b<n_panels; b++ ) {
+            __m256i acc[12];
+            for( int i=0; i<12; i++ )
+                acc[i] = _mm256_setzero_si256();
+            const int32_t* a  = pq;
+            const int32_t* bp = pt;
+            for( int p=0; p<depth; p++ ) {
+                __m256i b0 = _mm256_loadu_si256( (const __m256i*)(bp  ) );
+                __m256i b1 = _mm256_loadu_si256( (const __m256i*)(bp+8) );
+                for( int r=0; r<6; r++ ) {
+                    __m256i q = _mm256_set1_epi32( a[r] );
+                    acc[2*r  ] = _mm256_add_epi32( acc[2*r  ], _mm256_madd_epi16( q, b0 ) );
+                    acc[2*r+1] = _mm256_add_epi32( acc[2*r+1], _mm256_madd_epi16( q, b1 ) );
+                }
+                a  += 6;
+                bp += 16;
+            }
+            const __m256i be0 = _mm256_loadu_si256( (const __m256i*)(beta  ) );
+            const __m256i be1 = _mm256_loadu_si256( (const __m256i*)(beta+8) );
+            for( int r=0; r<mr; r++ ) {
+                __m256i s0  = _mm256_sub_epi32( be0, _mm256_slli_epi32( acc[2*r  ], 1 ) );
+                __m256i s1  = _mm256_sub_epi32( be1, _mm256_slli_epi32( acc[2*r+1], 1 ) );
+                __m256i thr = _mm256_set1_epi32( st[r].d2 );
+                __m256i lt  = _mm256_or_si256( _mm256_cmpgt_epi32( thr, s0 ), _mm256_cmpgt_epi32( thr, s1 ) );
+                if( !_mm256_testz_si256( lt, lt ) ) {
+                    int s[16];
+                    _mm256_storeu_si256( (__m256i*)(s  ), s0 );
+                    _mm256_storeu_si256( (__m256i*)(s+8), s1 );
+                    knn2_merge( s, 16, j0 + 16*b, st[r] );
+                }
+            }
+            pt   += 16*size_t(depth);
+            beta += 16;
+        }
+    }
+
+    // 6x32 tile
+    KORTEX_TARGET_AVX512
+    static void knn2_kernel_avx512( const float* pq, const float* pt, const int& n_panels, const int& depth,
+                                    const float* alpha, const float* beta, const int& j0, const int& mr,
+                                    Knn2<float>* st ) {
+        for( int b=0; b<n_panels; b++ ) {
+            __m512 acc[12];
+            for( int i=0; i<12; i++ )
+                acc[i] = _mm512_setzero_ps();
+            const float* a  = pq;
+            const float* bp = pt;
+            for( int p=0; p<depth; p++ ) {
+                __m512 b0 = _mm512_loadu_ps( bp    );
+                __m512 b1 = _mm512_loadu_ps( bp+16 );
+                for( int r=0; r<6; r++ ) {
+                    __m512 q = _mm512_set1_ps( a[r] );
+                    acc[2*r  ] = _mm512_fmadd_ps( q, b0, acc[2*r  ] );
+                    acc[2*r+1] = _mm512_fmadd_ps( q, b1, acc[2*r+1] );
+                }
+                a  += 6;
+                bp += 32;
+            }
+            const __m512 al0 = _mm512_loadu_ps( alpha    ), al1 = _mm512_loadu_ps( alpha+16 );
+            const __m512 be0 = _mm512_loadu_ps( beta     ), be1 = _mm512_loadu_ps( beta +16 );
+            for( int r=0; r<mr; r++ ) {
+                __m512 s0  = _mm512_fmadd_ps( acc[2*r  ], al0, be0 );
+                __m512 s1  = _mm512_fmadd_ps( acc[2*r+1], al1, be1 );
+                __m512 thr = _mm512_set1_ps( st[r].d2 );
+                if( _mm512_cmp_ps_mask( s0, thr, _CMP_LT_OQ ) | _mm512_cmp_ps_mask( s1, thr, _CMP_LT_OQ ) ) {
+                    float s[32];
+                    _mm512_storeu_ps( s,    s0 );
+                    _mm512_storeu_ps( s+16, s1 );
+                    knn2_merge( s, 32, j0 + 32*b, st[r] );
+                }
+            }
+            pt    += 32*size_t(depth);
+            alpha += 32;
+            beta  += 32;
+        }
+    }
+
+    KORTEX_TARGET_AVX512
+    static void knn2_kernel_avx512( const int32_t* pq, const int32_t* pt, const int& n_panels, const int& depth,
+                                    const int* alpha, const int* beta, const int& j0, const int& mr,
+                                    Knn2<int>* st ) {
+        for( int b=0; b<n_panels; b++ ) {
+            __m512i acc[12];
+            for( int i=0; i<12; i++ )
+                acc[i] = _mm512_setzero_si512();
+            const int32_t* a  = pq;
+            const int32_t* bp = pt;
+            for( int p=0; p<depth; p++ ) {
+                __m512i b0 = _mm512_loadu_si512( bp    );
+                __m512i b1 = _mm512_loadu_si512( bp+16 );
+                for( int r=0; r<6; r++ ) {
+                    __m512i q = _mm512_set1_epi32( a[r] );
+                    acc[2*r  ] = _mm512_add_epi32( acc[2*r  ], _mm512_madd_epi16( q, b0 ) );
+                    acc[2*r+1] = _mm512_add_epi32( acc[2*r+1], _mm512_madd_epi16( q, b1 ) );
+                }
+                a  += 6;
+                bp += 32;
+            }
+            const __m512i be0 = _mm512_loadu_si512( beta    );
+            const __m512i be1 = _mm512_loadu_si512( beta+16 );
+            for( int r=0; r<mr; r++ ) {
+                __m512i s0  = _mm512_sub_epi32( be0, _mm512_slli_epi32( acc[2*r  ], 1 ) );
+                __m512i s1  = _mm512_sub_epi32( be1, _mm512_slli_epi32( acc[2*r+1], 1 ) );
+                __m512i thr = _mm512_set1_epi32( st[r].d2 );
+                if( _mm512_cmplt_epi32_mask( s0, thr ) | _mm512_cmplt_epi32_mask( s1, thr ) ) {
+                    int s[32];
+                    _mm512_storeu_si512( s,    s0 );
+                    _mm512_storeu_si512( s+16, s1 );
+                    knn2_merge( s, 32, j0 + 32*b, st[r] );
+                }
+            }
+            pt   += 32*size_t(depth);
+            beta += 32;
+        }
+    }
+
+#endif
+
+    template<typename T, typename P>
+    static Knn2Kernel<T,P> select_knn2_kernel() {
+        Knn2Kernel<T,P> k;
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: k.MR = 6; k.NR = 32; k.run = knn2_kernel_avx512; return k;
+        case SIMD_AVX2  : k.MR = 6; k.NR = 16; k.run = knn2_kernel_avx2;   return k;
+        default: break;
+        }
+#endif
+        k.MR = 4; k.NR = 4; k.run = knn2_kernel_basic;
+        return k;
+    }
+
+    // top-2 lists of the queries. query and train rows have depth elements,
+    // alpha/beta are the per train coefficients of the kernel score. beta of
+    // the padding lanes is set to pad ( the largest score ).
+    template<typename T, typename P>
+    static void knn2_blocked( const P* query, int n_query, const P* train, int n_train, int depth,
+                              const T* alpha, const T* beta, const T& pad, bool run_parallel,
+                              Knn2<T>* result ) {
+        const Knn2Kernel<T,P> kernel = select_knn2_kernel<T,P>();
+        const int MR = kernel.MR;
+        const int NR = kernel.NR;
+
+        const int n_panels = ( n_train + NR - 1 ) / NR;
+        vector<P> pt( size_t(n_panels)*NR*depth );
+        vector<T> palpha( size_t(n_panels)*NR, T(0) ), pbeta( size_t(n_panels)*NR, pad );
+#pragma omp parallel for schedule(dynamic,64) if(run_parallel)
+        for( int b=0; b<n_panels; b++ ) {
+            P* panel = &pt[ size_t(b)*NR*depth ];
+            for( int j=0; j<NR; j++ ) {
+                const int t = b*NR + j;
+                if( t < n_train ) {
+                    const P* row = train + size_t(t)*depth;
+                    for( int p=0; p<depth; p++ )
+                        panel[ p*NR+j ] = row[p];
+                    palpha[t] = alpha[t];
+                    pbeta [t] = beta [t];
+                } else {
+                    for( int p=0; p<depth; p++ )
+                        panel[ p*NR+j ] = P(0);
+                }
+            }
+        }
+
+        const int block_panels = std::max( 1, int( KNN2_TRAIN_BLOCK_BYTES / ( sizeof(P)*NR*depth ) ) );
+        const int n_blocks     = ( n_query + KNN2_QUERY_BLOCK - 1 ) / KNN2_QUERY_BLOCK;
+#pragma omp parallel for schedule(dynamic,1) if(run_parallel)
+        for( int qb=0; qb<n_blocks; qb++ ) {
+            const int q0 = qb * KNN2_QUERY_BLOCK;
+            const int nq = std::min( KNN2_QUERY_BLOCK, n_query - q0 );
+            Knn2<T>* st = result + q0;
+            for( int q=0; q<nq; q++ ) {
+                st[q].d1 = st[q].d2 =  pad;
+                st[q].i1 = st[q].i2 = -1;
+            }
+            // query micro panels - rows beyond nq are zero
+            const int n_micro = ( nq + MR - 1 ) / MR;
+            vector<P> pq( size_t(n_micro)*MR*depth );
+            for( int m=0; m<n_micro; m++ ) {
+                P* mp = &pq[ size_t(m)*MR*depth ];
+                for( int r=0; r<MR; r++ ) {
+                    const int q = m*MR + r;
+                    for( int p=0; p<depth; p++ )
+                        mp[ p*MR+r ] = ( q < nq ) ? query[ size_t(q0+q)*depth + p ] : P(0);
+                }
+            }
+            for( int b0=0; b0<n_panels; b0+=block_panels ) {
+                const int nb = std::min( block_panels, n_panels - b0 );
+                for( int m=0; m<n_micro; m++ ) {
+                    kernel.run( &pq[ size_t(m)*MR*depth ], &pt[ size_t(b0)*NR*depth ], nb, depth,
+                                &palpha[ size_t(b0)*NR ], &pbeta[ size_t(b0)*NR ], b0*NR,
+                                std::min( MR, nq - m*MR ), st + m*MR );
+                }
+            }
+        }
+    }
+
+    static void knn2_float( const float* query, int n_query, const float* train, int n_train, int dim,
+                            const DescriptorMetric& metric, bool run_parallel,
+                            int* indices, float* distances ) {
+        const float inf = std::numeric_limits<float>::infinity();
+        // l2 : |q|^2 + ( |t|^2 - 2 q.t ), cosine : 1 + ( -q.t/|t| ) / |q|
+        vector<float> alpha( n_train ), beta( n_train );
+        for( int t=0; t<n_train; t++ ) {
+            const float* row = train + size_t(t)*dim;
+            float n2 = 0.0f;
+            for( int p=0; p<dim; p++ )
+                n2 += row[p]*row[p];
+            if( metric == DESCRIPTOR_L2 ) {
+                alpha[t] = -2.0f;
+                beta [t] = n2;
+            } else {
+                alpha[t] = ( n2 > 0.0f ) ? -1.0f/std::sqrt( n2 ) : 0.0f;
+                beta [t] = 0.0f;
+            }
+        }
+        vector< Knn2<float> > st( n_query );
+        knn2_blocked( query, n_query, train, n_train, dim, &alpha[0], &beta[0], inf, run_parallel, &st[0] );
+
+        for( int q=0; q<n_query; q++ ) {
+            const float* row = query + size_t(q)*dim;
+            float n2 = 0.0f;
+            for( int p=0; p<dim; p++ )
+                n2 += row[p]*row[p];
+            const float s[2] = { st[q].d1, st[q].d2 };
+            const int   i[2] = { st[q].i1, st[q].i2 };
+            for( int k=0; k<2; k++ ) {
+                float d = -1.0f;
+                if( i[k] >= 0 ) {
+                    if( metric == DESCRIPTOR_L2 ) d = std::sqrt( std::max( 0.0f, n2 + s[k] ) );
+                    else                          d = 1.0f + ( n2 > 0.0f ? s[k]/std::sqrt( n2 ) : 0.0f );
+                }
+                indices  [2*q+k] = i[k];
+                distances[2*q+k] = d;
+            }
+        }
+    }
+
+    void descriptor_knn2( const float* query, int n_query, const float* train, int n_train,
+                          int dim, const DescriptorMetric& metric, bool run_parallel,
+                          int* indices, float* distances ) {
+        passert_pointer( indices && distances );
+        passert_pointer( n_query == 0 || query );
+        passert_pointer( n_train == 0 || train );
+        passert_statement_g( dim > 0, "invalid descriptor dimension [%d]", dim );
+        if( n_query <= 0 || n_train <= 0 ) {
+            for( int i=0; i<2*n_query; i++ ) {
+                indices  [i] = -1;
+                distances[i] = -1.0f;
+            }
+            return;
+        }
+        knn2_float( query, n_query, train, n_train, dim, metric, run_parallel, indices, distances );
+    }
+
+    // uchar pairs as ( low | high<<16 ) for the 16 bit multiply-adds
+    static void pack_uchar_pairs( const uchar* D, int n, int dim, vector<int32_t>& P ) {
+        const int depth = ( dim + 1 ) / 2;
+        P.resize( size_t(n)*depth );
+        for( int i=0; i<n; i++ ) {
+            const uchar* row = D + size_t(i)*dim;
+            int32_t*     out = &P[ size_t(i)*depth ];
+            for( int p=0; p<depth; p++ ) {
+                const int hi = ( 2*p+1 < dim ) ? row[2*p+1] : 0;
+                out[p] = int32_t( row[2*p] ) | int32_t( hi << 16 );
+            }
+        }
+    }
+
+    void descriptor_knn2( const uchar* query, int n_query, const uchar* train, int n_train,
+                          int dim, const DescriptorMetric& metric, bool run_parallel,
+                          int* indices, float* distances ) {
+        passert_pointer( indices && distances );
+        passert_pointer( n_query == 0 || query );
+        passert_pointer( n_train == 0 || train );
+        passert_statement_g( dim > 0 && dim <= 1<<14, "invalid descriptor dimension [%d]", dim );
+        if( n_query <= 0 || n_train <= 0 ) {
+            for( int i=0; i<2*n_query; i++ ) {
+                indices  [i] = -1;
+                distances[i] = -1.0f;
+            }
+            return;
+        }
+
+        if( metric == DESCRIPTOR_COSINE ) {
+            vector<float> fq( size_t(n_query)*dim ), ft( size_t(n_train)*dim );
+            for( size_t i=0; i<fq.size(); i++ ) fq[i] = query[i];
+            for( size_t i=0; i<ft.size(); i++ ) ft[i] = train[i];
+            knn2_float( &fq[0], n_query, &ft[0], n_train, dim, metric, run_parallel, indices, distances );
+            return;
+        }
+
+        vector<int32_t> pq, pt;
+        pack_uchar_pairs( query, n_query, dim, pq );
+        pack_uchar_pairs( train, n_train, dim, pt );
+        vector<int> alpha( n_train, -2 ), beta( n_train );
+        for( int t=0; t<n_train; t++ ) {
+            const uchar* row = train + size_t(t)*dim;
+            int n2 = 0;
+            for( int p=0; p<dim; p++ )
+                n2 += int(row[p])*row[p];
+            beta[t] = n2;
+        }
+        vector< Knn2<int> > st( n_query );
+        knn2_blocked( &pq[0], n_query, &pt[0], n_train, ( dim + 1 ) / 2, &alpha[0], &beta[0],
+                      int(INT_MAX), run_parallel, &st[0] );
+
+        for( int q=0; q<n_query; q++ ) {
+            const uchar* row = query + size_t(q)*dim;
+            int n2 = 0;
+            for( int p=0; p<dim; p++ )
+                n2 += int(row[p])*row[p];
+            indices  [2*q  ] = st[q].i1;
+            indices  [2*q+1] = st[q].i2;
+            distances[2*q  ] = ( st[q].i1 >= 0 ) ? std::sqrt( float( n2 + st[q].d1 ) ) : -1.0f;
+            distances[2*q+1] = ( st[q].i2 >= 0 ) ? std::sqrt( float( n2 + st[q].d2 ) ) : -1.0f;
+        }
+    }
+
+    // filters the nearest neighbors of the k-lists by params. rindices are
+    // the nearest queries of the train descriptors for the cross check.
+    template<typename T>
+    static void collect_matches( const int* indices, const T* distances, const int& k, const int& n_query,
+                                 const int* rindices, const MatcherParams& params,
+                                 vector<DescriptorMatch>& matches ) {
+        const bool ratio_test = ( k > 1 && params.ratio < 1.0f );
+        for( int q=0; q<n_query; q++ ) {
+            const int*  bi = indices   + size_t(q)*k;
+            const T*    bd = distances + size_t(q)*k;
+            const float d  = float( bd[0] );
+            if( bi[0] < 0 )
+                continue;
+            if( params.max_distance >= 0.0f && d > params.max_distance )
+                continue;
+            if( ratio_test && bi[1] >= 0 && !( d < params.ratio * float( bd[1] ) ) )
+                continue;
+            if( rindices && rindices[ bi[0] ] != q )
+                continue;
+            DescriptorMatch m;
+            m.query    = q;
+            m.train    = bi[0];
+            m.distance = d;
+            matches.push_back( m );
+        }
+    }
+
+    void hamming_256_match( const uchar* query, int n_query, const uchar* train, int n_train,
+                            const MatcherParams& params, vector<DescriptorMatch>& matches ) {
+        matches.clear();
+        if( n_query <= 0 || n_train <= 0 )
+            return;
+
+        const int k = ( params.ratio < 1.0f ) ? 2 : 1;
+        vector<int> indices( size_t(n_query)*k ), distances( size_t(n_query)*k );
+        hamming_256_knn( query, n_query, train, n_train, k, params.run_parallel, &indices[0], &distances[0] );
+
+        vector<int> rindices, rdistances;
+        if( params.cross_check ) {
+            rindices  .resize( n_train );
+            rdistances.resize( n_train );
+            hamming_256_knn( train, n_train, query, n_query, 1, params.run_parallel, &rindices[0], &rdistances[0] );
+        }
+        collect_matches( &indices[0], &distances[0], k, n_query,
+                         params.cross_check ? &rindices[0] : NULL, params, matches );
+    }
+
+    template<typename D>
+    static void descriptor_match_( const D* query, int n_query, const D* train, int n_train,
+                                   int dim, const DescriptorMetric& metric, const MatcherParams& params,
+                                   vector<DescriptorMatch>& matches ) {
+        matches.clear();
+        if( n_query <= 0 || n_train <= 0 )
+            return;
+        vector<int>   indices( 2*size_t(n_query) );
+        vector<float> distances( 2*size_t(n_query) );
+        descriptor_knn2( query, n_query, train, n_train, dim, metric, params.run_parallel,
+                         &indices[0], &distances[0] );
+
+        vector<int>   rindices;
+        vector<float> rdistances;
+        if( params.cross_check ) {
+            rindices  .resize( 2*size_t(n_train) );
+            rdistances.resize( 2*size_t(n_train) );
+            descriptor_knn2( train, n_train, query, n_query, dim, metric, params.run_parallel,
+                             &rindices[0], &rdistances[0] );
+            // nearest query of each train descriptor
+            for( int t=0; t<n_train; t++ )
+                rindices[t] = rindices[2*t];
+        }
+        collect_matches( &indices[0], &distances[0], 2, n_query,
+                         params.cross_check ? &rindices[0] : NULL, params, matches );
+    }
+
+    void descriptor_match( const float* query, int n_query, const float* train, int n_train,
+                           int dim, const DescriptorMetric& metric, const MatcherParams& params,
+                           vector<DescriptorMatch>& matches ) {
+        descriptor_match_( query, n_query, train, n_train, dim, metric, params, matches );
+    }
+
+    void descriptor_match( const uchar* query, int n_query, const uchar* train, int n_train,
+                           int dim, const DescriptorMetric& metric, const MatcherParams& params,
+                           vector<DescriptorMatch>& matches ) {
+        descriptor_match_( query, n_query, train, n_train, dim, metric, params, matches );
+    }
+
+}
@@ -12,11 +12,20 @@
 //
 // ---------------------------------------------------------------------------
 #include <kortex/filter.h>
-#include <kortex/sse_extensions.h>
-#include <kortex/mem_manager.h>
-#include <kortex/defs.h>
+#include <kortex/cpu_features.h>
+#include <kortex/mem_unit.h>
+#include <kortex/check.h>
 
 #include <cstring>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
 
 namespace kortex {
 
@@ -120,396 +129,689 @@ namespace kortex {
 
 
 
-#ifdef KORTEX_WITH_SSE
-    void filter_buffer_05_sse_u(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            xmm_a = _mm_loadu_ps(bi);
-            xmm_b = _mm_loadu_ps(kernel);
-            xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] + bi[4]*kernel[4];
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+    //
+    // vectorized engine: instead of summing the taps of one output pixel in a
+    // vector register, the kernel taps are broadcast and each pass over the
+    // taps computes 4 registers worth of consecutive outputs ( 16, 32 or 64
+    // pixels for sse2, avx2 and avx512 respectively ). outputs are written
+    // back to buffer[i] only after all of their inputs buffer[i..i+ksize) are
+    // read, therefore in-place operation is safe. the remaining pixels are
+    // handled by the scalar version.
+    //
+    void filter_buffer_sse2(float* buffer, const int& bsz, const float* kernel, const int& ksize) {
+        int i = 0;
+        for( ; i+16<=bsz; i+=16 ) {
+            const float* bi = buffer+i;
+            __m128 s0 = _mm_setzero_ps();
+            __m128 s1 = _mm_setzero_ps();
+            __m128 s2 = _mm_setzero_ps();
+            __m128 s3 = _mm_setzero_ps();
+            for( int j=0; j<ksize; j++ ) {
+                __m128 kj = _mm_set1_ps( kernel[j] );
+                s0 = _mm_add_ps( s0, _mm_mul_ps( kj, _mm_loadu_ps(bi+j   ) ) );
+                s1 = _mm_add_ps( s1, _mm_mul_ps( kj, _mm_loadu_ps(bi+j+ 4) ) );
+                s2 = _mm_add_ps( s2, _mm_mul_ps( kj, _mm_loadu_ps(bi+j+ 8) ) );
+                s3 = _mm_add_ps( s3, _mm_mul_ps( kj, _mm_loadu_ps(bi+j+12) ) );
+            }
+            _mm_storeu_ps( buffer+i   , s0 );
+            _mm_storeu_ps( buffer+i+ 4, s1 );
+            _mm_storeu_ps( buffer+i+ 8, s2 );
+            _mm_storeu_ps( buffer+i+12, s3 );
         }
-    }
-    void filter_buffer_05_sse_a(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            xmm_a = _mm_loadu_ps(bi);
-            xmm_b = _mm_load_ps(kernel);
-            xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] + bi[4]*kernel[4];
+        for( ; i+4<=bsz; i+=4 ) {
+            const float* bi = buffer+i;
+            __m128 s0 = _mm_setzero_ps();
+            for( int j=0; j<ksize; j++ )
+                s0 = _mm_add_ps( s0, _mm_mul_ps( _mm_set1_ps(kernel[j]), _mm_loadu_ps(bi+j) ) );
+            _mm_storeu_ps( buffer+i, s0 );
         }
+        if( i<bsz ) filter_buffer_g_basic( buffer+i, bsz-i, kernel, ksize );
     }
-    void filter_buffer_07_sse_u(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            xmm_a = _mm_loadu_ps(bi);
-            xmm_b = _mm_loadu_ps(kernel);
-            xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] +
-                bi[4]*kernel[4] + bi[5]*kernel[5] + bi[6]*kernel[6];
+
+    KORTEX_TARGET_AVX2
+    void filter_buffer_avx2(float* buffer, const int& bsz, const float* kernel, const int& ksize) {
+        int i = 0;
+        for( ; i+32<=bsz; i+=32 ) {
+            const float* bi = buffer+i;
+            __m256 s0 = _mm256_setzero_ps();
+            __m256 s1 = _mm256_setzero_ps();
+            __m256 s2 = _mm256_setzero_ps();
+            __m256 s3 = _mm256_setzero_ps();
+            for( int j=0; j<ksize; j++ ) {
+                __m256 kj = _mm256_broadcast_ss( kernel+j );
+                s0 = _mm256_fmadd_ps( kj, _mm256_loadu_ps(bi+j   ), s0 );
+                s1 = _mm256_fmadd_ps( kj, _mm256_loadu_ps(bi+j+ 8), s1 );
+                s2 = _mm256_fmadd_ps( kj, _mm256_loadu_ps(bi+j+16), s2 );
+                s3 = _mm256_fmadd_ps( kj, _mm256_loadu_ps(bi+j+24), s3 );
+            }
+            _mm256_storeu_ps( buffer+i   , s0 );
+            _mm256_storeu_ps( buffer+i+ 8, s1 );
+            _mm256_storeu_ps( buffer+i+16, s2 );
+            _mm256_storeu_ps( buffer+i+24, s3 );
         }
-    }
-    void filter_buffer_07_sse_a(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            xmm_a = _mm_loadu_ps(bi);
-            xmm_b = _mm_load_ps(kernel);
-            xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] +
-                bi[4]*kernel[4] + bi[5]*kernel[5] + bi[6]*kernel[6];
+        for( ; i+8<=bsz; i+=8 ) {
+            const float* bi = buffer+i;
+            __m256 s0 = _mm256_setzero_ps();
+            for( int j=0; j<ksize; j++ )
+                s0 = _mm256_fmadd_ps( _mm256_broadcast_ss(kernel+j), _mm256_loadu_ps(bi+j), s0 );
+            _mm256_storeu_ps( buffer+i, s0 );
         }
+        if( i<bsz ) filter_buffer_g_basic( buffer+i, bsz-i, kernel, ksize );
     }
-    void filter_buffer_09_sse_u(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            for( int j=0; j<8; j+=4 ) {
-                xmm_a = _mm_loadu_ps(bi+j);
-                xmm_b = _mm_loadu_ps(kernel+j);
-                xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
+
+    KORTEX_TARGET_AVX512
+    void filter_buffer_avx512(float* buffer, const int& bsz, const float* kernel, const int& ksize) {
+        int i = 0;
+        for( ; i+64<=bsz; i+=64 ) {
+            const float* bi = buffer+i;
+            __m512 s0 = _mm512_setzero_ps();
+            __m512 s1 = _mm512_setzero_ps();
+            __m512 s2 = _mm512_setzero_ps();
+            __m512 s3 = _mm512_setzero_ps();
+            for( int j=0; j<ksize; j++ ) {
+                __m512 kj = _mm512_set1_ps( kernel[j] );
+                s0 = _mm512_fmadd_ps( kj, _mm512_loadu_ps(bi+j   ), s0 );
+                s1 = _mm512_fmadd_ps( kj, _mm512_loadu_ps(bi+j+16), s1 );
+                s2 = _mm512_fmadd_ps( kj, _mm512_loadu_ps(bi+j+32), s2 );
+                s3 = _mm512_fmadd_ps( kj, _mm512_loadu_ps(bi+j+48), s3 );
             }
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] + bi[8]*kernel[8];
+            _mm512_storeu_ps( buffer+i   , s0 );
+            _mm512_storeu_ps( buffer+i+16, s1 );
+            _mm512_storeu_ps( buffer+i+32, s2 );
+            _mm512_storeu_ps( buffer+i+48, s3 );
         }
+        for( ; i+16<=bsz; i+=16 ) {
+            const float* bi = buffer+i;
+            __m512 s0 = _mm512_setzero_ps();
+            for( int j=0; j<ksize; j++ )
+                s0 = _mm512_fmadd_ps( _mm512_set1_ps(kernel[j]), _mm512_loadu_ps(bi+j), s0 );
+            _mm512_storeu_ps( buffer+i, s0 );
+        }
+        if( i<bsz ) filter_buffer_avx2( buffer+i, bsz-i, kernel, ksize );
     }
-    void filter_buffer_09_sse_a(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            for( int j=0; j<8; j+=4 ) {
-                xmm_a = _mm_loadu_ps(bi+j);
-                xmm_b = _mm_load_ps(kernel+j);
-                xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
-            }
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] + bi[8]*kernel[8];
+#endif
+
+
+    void filter_buffer(float* buffer, const int& bsz, const float* kernel, const int& ksize) {
+        // buffer should be padded with +-ksize -- see filter_horizontal for
+        // example use.
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: filter_buffer_avx512(buffer, bsz, kernel, ksize); return;
+        case SIMD_AVX2  : filter_buffer_avx2  (buffer, bsz, kernel, ksize); return;
+        case SIMD_SSE2  : filter_buffer_sse2  (buffer, bsz, kernel, ksize); return;
+        default         : break;
         }
+#endif
+        filter_buffer_basic(buffer, bsz, kernel, ksize);
     }
-    void filter_buffer_11_sse_u(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            for( int j=0; j<8; j+=4 ) {
-                xmm_a = _mm_loadu_ps(bi+j);
-                xmm_b = _mm_loadu_ps(kernel+j);
-                xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
-            }
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] +
-                bi[8]*kernel[8] + bi[9]*kernel[9] + bi[10]*kernel[10];
+
+
+    void filter_rows_basic(const float* const* rows, const float* kernel, const int& ksize, const int& n, float* out) {
+        for( int x=0; x<n; x++ ) {
+            float sum = 0.0f;
+            for( int j=0; j<ksize; j++ )
+                sum += rows[j][x]*kernel[j];
+            out[x] = sum;
         }
     }
-    void filter_buffer_11_sse_a(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            for( int j=0; j<8; j+=4 ) {
-                xmm_a = _mm_loadu_ps(bi+j);
-                xmm_b = _mm_load_ps(kernel+j);
-                xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+    //
+    // row accumulation kernels: every tap of the kernel scales a whole input
+    // row, so the loads are contiguous and there is no horizontal sum.
+    //
+    void filter_rows_sse2(const float* const* rows, const float* kernel, const int& ksize, const int& n, float* out) {
+        int x = 0;
+        for( ; x+16<=n; x+=16 ) {
+            __m128 s0 = _mm_setzero_ps();
+            __m128 s1 = _mm_setzero_ps();
+            __m128 s2 = _mm_setzero_ps();
+            __m128 s3 = _mm_setzero_ps();
+            for( int j=0; j<ksize; j++ ) {
+                const float* rj = rows[j]+x;
+                __m128 kj = _mm_set1_ps( kernel[j] );
+                s0 = _mm_add_ps( s0, _mm_mul_ps( kj, _mm_loadu_ps(rj   ) ) );
+                s1 = _mm_add_ps( s1, _mm_mul_ps( kj, _mm_loadu_ps(rj+ 4) ) );
+                s2 = _mm_add_ps( s2, _mm_mul_ps( kj, _mm_loadu_ps(rj+ 8) ) );
+                s3 = _mm_add_ps( s3, _mm_mul_ps( kj, _mm_loadu_ps(rj+12) ) );
             }
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] +
-                bi[8]*kernel[8] + bi[9]*kernel[9] + bi[10]*kernel[10];
+            _mm_storeu_ps( out+x   , s0 );
+            _mm_storeu_ps( out+x+ 4, s1 );
+            _mm_storeu_ps( out+x+ 8, s2 );
+            _mm_storeu_ps( out+x+12, s3 );
+        }
+        for( ; x+4<=n; x+=4 ) {
+            __m128 s0 = _mm_setzero_ps();
+            for( int j=0; j<ksize; j++ )
+                s0 = _mm_add_ps( s0, _mm_mul_ps( _mm_set1_ps(kernel[j]), _mm_loadu_ps(rows[j]+x) ) );
+            _mm_storeu_ps( out+x, s0 );
+        }
+        for( ; x<n; x++ ) {
+            float sum = 0.0f;
+            for( int j=0; j<ksize; j++ )
+                sum += rows[j][x]*kernel[j];
+            out[x] = sum;
         }
     }
-    void filter_buffer_13_sse_u(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            for( int j=0; j<12; j+=4 ) {
-                xmm_a = _mm_loadu_ps(bi+j);
-                xmm_b = _mm_loadu_ps(kernel+j);
-                xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
+
+    KORTEX_TARGET_AVX2
+    void filter_rows_avx2(const float* const* rows, const float* kernel, const int& ksize, const int& n, float* out) {
+        int x = 0;
+        for( ; x+32<=n; x+=32 ) {
+            __m256 s0 = _mm256_setzero_ps();
+            __m256 s1 = _mm256_setzero_ps();
+            __m256 s2 = _mm256_setzero_ps();
+            __m256 s3 = _mm256_setzero_ps();
+            for( int j=0; j<ksize; j++ ) {
+                const float* rj = rows[j]+x;
+                __m256 kj = _mm256_broadcast_ss( kernel+j );
+                s0 = _mm256_fmadd_ps( kj, _mm256_loadu_ps(rj   ), s0 );
+                s1 = _mm256_fmadd_ps( kj, _mm256_loadu_ps(rj+ 8), s1 );
+                s2 = _mm256_fmadd_ps( kj, _mm256_loadu_ps(rj+16), s2 );
+                s3 = _mm256_fmadd_ps( kj, _mm256_loadu_ps(rj+24), s3 );
             }
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] +
-                bi[12]*kernel[12];
+            _mm256_storeu_ps( out+x   , s0 );
+            _mm256_storeu_ps( out+x+ 8, s1 );
+            _mm256_storeu_ps( out+x+16, s2 );
+            _mm256_storeu_ps( out+x+24, s3 );
+        }
+        for( ; x+8<=n; x+=8 ) {
+            __m256 s0 = _mm256_setzero_ps();
+            for( int j=0; j<ksize; j++ )
+                s0 = _mm256_fmadd_ps( _mm256_broadcast_ss(kernel+j), _mm256_loadu_ps(rows[j]+x), s0 );
+            _mm256_storeu_ps( out+x, s0 );
+        }
+        for( ; x<n; x++ ) {
+            float sum = 0.0f;
+            for( int j=0; j<ksize; j++ )
+                sum += rows[j][x]*kernel[j];
+            out[x] = sum;
         }
     }
-    void filter_buffer_13_sse_a(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            for( int j=0; j<12; j+=4 ) {
-                xmm_a = _mm_loadu_ps(bi+j);
-                xmm_b = _mm_load_ps (kernel+j);
-                xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
+
+    KORTEX_TARGET_AVX512
+    void filter_rows_avx512(const float* const* rows, const float* kernel, const int& ksize, const int& n, float* out) {
+        int x = 0;
+        for( ; x+64<=n; x+=64 ) {
+            __m512 s0 = _mm512_setzero_ps();
+            __m512 s1 = _mm512_setzero_ps();
+            __m512 s2 = _mm512_setzero_ps();
+            __m512 s3 = _mm512_setzero_ps();
+            for( int j=0; j<ksize; j++ ) {
+                const float* rj = rows[j]+x;
+                __m512 kj = _mm512_set1_ps( kernel[j] );
+                s0 = _mm512_fmadd_ps( kj, _mm512_loadu_ps(rj   ), s0 );
+                s1 = _mm512_fmadd_ps( kj, _mm512_loadu_ps(rj+16), s1 );
+                s2 = _mm512_fmadd_ps( kj, _mm512_loadu_ps(rj+32), s2 );
+                s3 = _mm512_fmadd_ps( kj, _mm512_loadu_ps(rj+48), s3 );
             }
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] +
-                bi[12]*kernel[12];
+            _mm512_storeu_ps( out+x   , s0 );
+            _mm512_storeu_ps( out+x+16, s1 );
+            _mm512_storeu_ps( out+x+32, s2 );
+            _mm512_storeu_ps( out+x+48, s3 );
+        }
+        for( ; x+16<=n; x+=16 ) {
+            __m512 s0 = _mm512_setzero_ps();
+            for( int j=0; j<ksize; j++ )
+                s0 = _mm512_fmadd_ps( _mm512_set1_ps(kernel[j]), _mm512_loadu_ps(rows[j]+x), s0 );
+            _mm512_storeu_ps( out+x, s0 );
+        }
+        for( ; x<n; x++ ) {
+            float sum = 0.0f;
+            for( int j=0; j<ksize; j++ )
+                sum += rows[j][x]*kernel[j];
+            out[x] = sum;
         }
     }
-    void filter_buffer_15_sse_u(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            for( int j=0; j<12; j+=4 ) {
-                xmm_a = _mm_loadu_ps(bi+j    );
-                xmm_b = _mm_loadu_ps(kernel+j);
-                xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
-            }
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] +
-                bi[12]*kernel[12] + bi[13]*kernel[13] + bi[14]*kernel[14];
+#endif
+
+    void filter_rows(const float* const* rows, const float* kernel, const int& ksize, const int& n, float* out) {
+        assert_pointer( rows && kernel && out );
+        assert_pointer_size( ksize );
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: filter_rows_avx512(rows, kernel, ksize, n, out); return;
+        case SIMD_AVX2  : filter_rows_avx2  (rows, kernel, ksize, n, out); return;
+        case SIMD_SSE2  : filter_rows_sse2  (rows, kernel, ksize, n, out); return;
+        default         : break;
         }
+#endif
+        filter_rows_basic(rows, kernel, ksize, n, out);
     }
-    void filter_buffer_15_sse_a(float* buffer, const int& bsz, const float* kernel) {
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            float* bi = buffer+i;
-            xmm_s.pack = _mm_set1_ps(0.0);
-            for( int j=0; j<12; j+=4 ) {
-                xmm_a = _mm_loadu_ps(bi+j    );
-                xmm_b = _mm_load_ps (kernel+j);
-                xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
-            }
-            bi[0] = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3] +
-                bi[12]*kernel[12] + bi[13]*kernel[13] + bi[14]*kernel[14];
+
+
+
+    /// per-thread scratch memory of the filtering routines. it is kept alive
+    /// across calls ( and only grows ) so repeated filtering does not go
+    /// through the allocator and there is no limit on the image dimensions.
+    float* filter_scratch( const size_t& n_elem ) {
+        static thread_local MemUnit scratch;
+        scratch.resize( n_elem*sizeof(float) );
+        return (float*)scratch.get_buffer();
+    }
+
+    /// filling the halfsize regions with 0 --> otherwise blending produces saturated results
+    ///
+    /// buffer should have at least w+ksize elements
+    void filter_hor_row(const float* im, const int& w, const float* kernel, const int& ksize,
+                        float* buffer, float* out) {
+        int halfsize = ksize / 2;
+        memset( buffer,            0,  sizeof(*buffer)*halfsize );
+        memcpy( buffer+halfsize,   im, sizeof(*im)*w            );
+        memset( buffer+halfsize+w, 0,  sizeof(*buffer)*halfsize );
+        filter_buffer(buffer, w, kernel, ksize);
+        memcpy(out, buffer, w*sizeof(*out));
+    }
+
+    void filter_hor(const float* im, const int& w, const int& h, const size_t& in_stride,
+                    const float* kernel, const int& ksize, float* out, const size_t& out_stride) {
+        assert_statement( im != out || in_stride == out_stride, "in-place filtering needs equal strides" );
+        float* buffer = filter_scratch( size_t(w)+size_t(ksize) );
+        for( int r=0; r<h; r++ )
+            filter_hor_row( im+size_t(r)*in_stride, w, kernel, ksize, buffer, out+size_t(r)*out_stride );
+    }
+
+    void filter_hor_par(const float* im, const int& w, const int& h, const size_t& in_stride,
+                        const float* kernel, const int& ksize, float* out, const size_t& out_stride) {
+        assert_statement( im != out || in_stride == out_stride, "in-place filtering needs equal strides" );
+#pragma omp parallel
+        {
+            float* buffer = filter_scratch( size_t(w)+size_t(ksize) );
+#pragma omp for
+            for( int r=0; r<h; r++ )
+                filter_hor_row( im+size_t(r)*in_stride, w, kernel, ksize, buffer, out+size_t(r)*out_stride );
         }
     }
-    void filter_buffer_g_sse_u (float* buffer, const int& bsz, const float* kernel, const int& ksize) {
-        int ksimdlen = ksize/4*4;
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; ++i ) {
-            xmm_s.pack = _mm_set1_ps(0.0);
-            int j;
-            for( j=0; j<ksimdlen; j+=4 ) {
-                xmm_a = _mm_loadu_ps(buffer+i+j);
-                xmm_b = _mm_loadu_ps(kernel+j  );
-                xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
-            }
-            float sum = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3];
-            for(; j<ksize; j++) sum += buffer[i+j] * kernel[j];
-            buffer[i] = sum;
+
+    /// width of the column strips of the vertical pass. chosen such that the
+    /// ksize row segments of a strip stay around 64KB ( within L2 ) and that
+    /// there are at least n_strips strips to distribute over the threads.
+    int filter_ver_strip_width( const int& w, const int& ksize, const int& n_strips ) {
+        int sw = ( 16384 / ksize ) / 64 * 64;
+        sw = std::max( sw, 64 );
+        if( n_strips > 1 ) {
+            int psw = ( (w+n_strips-1) / n_strips + 15 ) / 16 * 16;
+            sw = std::min( sw, psw );
         }
+        return std::min( sw, w );
     }
-    void filter_buffer_g_sse_a (float* buffer, const int& bsz, const float* kernel, const int& ksize) {
-        int ksimdlen = ksize/4*4;
-        __m128 xmm_a, xmm_b;
-        F128 xmm_s;
-        for( int i=0; i<bsz; i++ ) {
-            xmm_s.pack = _mm_set1_ps(0.0);
-            int j;
-            for( j=0; j<ksimdlen; j+=4 ) {
-                xmm_a = _mm_loadu_ps(buffer+i+j);
-                xmm_b = _mm_load_ps (kernel+j  );
-                xmm_s.pack = _mm_add_ps(xmm_s.pack, _mm_mul_ps(xmm_a, xmm_b));
+
+    /// vertical pass over the columns [c0,c0+nc) that walks the rows top to
+    /// bottom: every output row segment is accumulated from the ksize input
+    /// row segments around it with contiguous loads. for in-place operation
+    /// the input rows are first copied to a ring buffer of ksize row segments
+    /// ( ring ) so that the rows overwritten by the outputs are still
+    /// available. rows should have space for ksize pointers.
+    void filter_ver_strip(const float* im, const int& h, const size_t& in_stride, const int& c0, const int& nc,
+                          const float* kernel, const int& ksize, float* ring, const float** rows,
+                          float* out, const size_t& out_stride) {
+        int  halfsize = ksize / 2;
+        bool in_place = ( im == out );
+        int  next_row = 0;
+        for( int y=0; y<h; y++ ) {
+            int r0 = y-halfsize;                     // first row of the window
+            int j0 = std::max( 0, -r0 );             // taps falling in the image
+            int j1 = std::min( ksize, h-r0 );
+            if( in_place ) {
+                for( ; next_row < r0+j1; next_row++ ) {
+                    float* slot = ring + size_t(next_row%ksize)*size_t(nc);
+                    memcpy( slot, im+size_t(next_row)*in_stride+c0, sizeof(*slot)*nc );
+                }
+                for( int j=j0; j<j1; j++ )
+                    rows[j-j0] = ring + size_t((r0+j)%ksize)*size_t(nc);
+            } else {
+                for( int j=j0; j<j1; j++ )
+                    rows[j-j0] = im + size_t(r0+j)*in_stride + c0;
             }
-            float sum = xmm_s.f[0] + xmm_s.f[1] + xmm_s.f[2] + xmm_s.f[3];
-            for(; j<ksize; j++) sum += buffer[i+j] * kernel[j];
-            buffer[i] = sum;
+            filter_rows( rows, kernel+j0, j1-j0, nc, out+size_t(y)*out_stride+c0 );
         }
     }
-    void filter_buffer_sse_u   (float* buffer, const int& bsz, const float* kernel, const int& ksize) {
-        switch(ksize) {
-        case  3: filter_buffer_03_basic(buffer,bsz,kernel); return;
-        case  5: filter_buffer_05_sse_u(buffer,bsz,kernel); return;
-        case  7: filter_buffer_07_sse_u(buffer,bsz,kernel); return;
-        case  9: filter_buffer_09_sse_u(buffer,bsz,kernel); return;
-        case 11: filter_buffer_11_sse_u(buffer,bsz,kernel); return;
-        case 13: filter_buffer_13_sse_u(buffer,bsz,kernel); return;
-        case 15: filter_buffer_15_sse_u(buffer,bsz,kernel); return;
-        default: filter_buffer_g_sse_u(buffer,bsz,kernel,ksize);
-            return;
+
+    void filter_ver(const float* im, const int& w, const int& h, const size_t& in_stride,
+                    const float* kernel, const int& ksize, float* out, const size_t& out_stride) {
+        assert_statement( im != out || in_stride == out_stride, "in-place filtering needs equal strides" );
+        int sw = filter_ver_strip_width( w, ksize, 1 );
+        float* ring = filter_scratch( size_t(ksize)*size_t(sw) );
+        vector<const float*> rows( ksize );
+        for( int c=0; c<w; c+=sw ) {
+            int nc = std::min( sw, w-c );
+            filter_ver_strip( im, h, in_stride, c, nc, kernel, ksize, ring, &rows[0], out, out_stride );
         }
     }
-    void filter_buffer_sse_a   (float* buffer, const int& bsz, const float* kernel, const int& ksize) {
-        switch(ksize) {
-        case  3: filter_buffer_03_basic(buffer,bsz,kernel); return;
-        case  5: filter_buffer_05_sse_a(buffer,bsz,kernel); return;
-        case  7: filter_buffer_07_sse_a(buffer,bsz,kernel); return;
-        case  9: filter_buffer_09_sse_a(buffer,bsz,kernel); return;
-        case 11: filter_buffer_11_sse_a(buffer,bsz,kernel); return;
-        case 13: filter_buffer_13_sse_a(buffer,bsz,kernel); return;
-        case 15: filter_buffer_15_sse_a(buffer,bsz,kernel); return;
-        default: filter_buffer_g_sse_a(buffer,bsz,kernel,ksize);
-            return;
+
+    void filter_ver_par(const float* im, const int& w, const int& h, const size_t& in_stride,
+                        const float* kernel, const int& ksize, float* out, const size_t& out_stride) {
+        assert_statement( im != out || in_stride == out_stride, "in-place filtering needs equal strides" );
+        int n_threads = 1;
+#ifdef _OPENMP
+        n_threads = omp_get_max_threads();
+#endif
+        int sw      = filter_ver_strip_width( w, ksize, 4*n_threads );
+        int n_strips = (w+sw-1) / sw;
+#pragma omp parallel
+        {
+            float* ring = filter_scratch( size_t(ksize)*size_t(sw) );
+            vector<const float*> rows( ksize );
+#pragma omp for schedule(dynamic)
+            for( int s=0; s<n_strips; s++ ) {
+                int c  = s*sw;
+                int nc = std::min( sw, w-c );
+                filter_ver_strip( im, h, in_stride, c, nc, kernel, ksize, ring, &rows[0], out, out_stride );
+            }
+        }
+    }
+    /// fused separable convolution of the rows [y0,y1). the horizontally
+    /// filtered rows are kept in a ring buffer of ksize_v rows ( ring ) and an
+    /// output row is emitted as soon as the ksize_v rows around it are
+    /// available - so the intermediate image is never written out. the rows
+    /// [y0-ksize_v/2,y0) and [y1,y1+ksize_v/2) falling outside the band should
+    /// be prepared in ring and halo with filter_separable_band_halo.
+    ///
+    /// safe for in-place operation: output row y is written only after the
+    /// input rows up to y+ksize_v/2 are consumed.
+    void filter_separable_band(const float* im, const int& w, const int& h, const size_t& in_stride,
+                               const int& y0, const int& y1,
+                               const float* kernel_h, const int& ksize_h,
+                               const float* kernel_v, const int& ksize_v,
+                               float* buffer, float* ring, const float* halo, const float** rows,
+                               float* out, const size_t& out_stride) {
+        int halfsize = ksize_v / 2;
+        int next_row = y0;
+        for( int y=y0; y<y1; y++ ) {
+            int r0 = y-halfsize;
+            int j0 = std::max( 0, -r0 );
+            int j1 = std::min( ksize_v, h-r0 );
+            for( ; next_row < std::min( r0+j1, y1 ); next_row++ ) {
+                float* slot = ring + size_t(next_row%ksize_v)*size_t(w);
+                filter_hor_row( im+size_t(next_row)*in_stride, w, kernel_h, ksize_h, buffer, slot );
+            }
+            for( int j=j0; j<j1; j++ ) {
+                int r = r0+j;
+                if( r < y1 ) rows[j-j0] = ring + size_t(r%ksize_v)*size_t(w);
+                else         rows[j-j0] = halo + size_t(r-y1)*size_t(w);
+            }
+            filter_rows( rows, kernel_v+j0, j1-j0, w, out+size_t(y)*out_stride );
         }
     }
-#endif
-
 
-    void filter_buffer(float* buffer, const int& bsz, const float* kernel, const int& ksize, const MemoryMode& mode) {
-        // buffer should be padded with +-ksize -- see filter_horizontal for
-        // example use.
-#ifdef KORTEX_WITH_SSE
-        switch( mode ) {
-        case MM_16_ALIGNED  : filter_buffer_sse_a(buffer, bsz, kernel, ksize); break;
-        case MM_16_UNALIGNED: filter_buffer_sse_u(buffer, bsz, kernel, ksize); break;
-        default:              logman_fatal("something is wrong here"); break;
+    /// horizontally filters the rows above and below the band [y0,y1) that
+    /// are read by filter_separable_band. these rows belong to the
+    /// neighbouring bands and have to be consumed before any band is written
+    /// when filtering in-place.
+    void filter_separable_band_halo(const float* im, const int& w, const int& h, const size_t& in_stride,
+                                    const int& y0, const int& y1,
+                                    const float* kernel_h, const int& ksize_h, const int& ksize_v,
+                                    float* buffer, float* ring, float* halo) {
+        int halfsize = ksize_v / 2;
+        for( int r=std::max(0,y0-halfsize); r<y0; r++ ) {
+            float* slot = ring + size_t(r%ksize_v)*size_t(w);
+            filter_hor_row( im+size_t(r)*in_stride, w, kernel_h, ksize_h, buffer, slot );
+        }
+        for( int r=y1; r<std::min(h,y1+halfsize); r++ ) {
+            filter_hor_row( im+size_t(r)*in_stride, w, kernel_h, ksize_h, buffer, halo+size_t(r-y1)*size_t(w) );
         }
-#else
-        filter_buffer_basic(buffer, bsz, kernel, ksize);
-#endif
     }
 
+    /// scratch layout for the fused filter: [ buffer | ring | halo ]
+    size_t filter_separable_scratch_size( const int& w, const int& ksize_h, const int& ksize_v ) {
+        return size_t(w)+size_t(ksize_h) + size_t(ksize_v+ksize_v/2)*size_t(w);
+    }
 
+    void filter_separable(const float* im, const int& w, const int& h, const size_t& in_stride,
+                          const float* kernel_h, const int& ksize_h,
+                          const float* kernel_v, const int& ksize_v, float* out, const size_t& out_stride) {
+        assert_pointer( im && kernel_h && kernel_v && out );
+        assert_pointer_size( ksize_h*ksize_v );
+        assert_statement( im != out || in_stride == out_stride, "in-place filtering needs equal strides" );
+        float* buffer = filter_scratch( filter_separable_scratch_size(w, ksize_h, ksize_v) );
+        float* ring   = buffer + w + ksize_h;
+        float* halo   = ring   + size_t(ksize_v)*size_t(w);
+        vector<const float*> rows( ksize_v );
+        filter_separable_band( im, w, h, in_stride, 0, h, kernel_h, ksize_h, kernel_v, ksize_v,
+                               buffer, ring, halo, &rows[0], out, out_stride );
+    }
 
-    /// filling the halfsize regions with 0 --> otherwise blending produces saturated results
-    void filter_hor(const float* im, const int& w, const int& h, const float* kernel, const int& ksize,
-                    float* out) {
-        float buffer[MAX_IMAGE_DIM];
-        passert_statement( w+ksize < MAX_IMAGE_DIM, "w+ksize is larger than max buffer size" );
-        int halfsize = ksize / 2;
-        MemoryMode opmode = get_alignment(kernel); // buffer is already loaded with mm_loadu
-        for( int r=0; r<h; r++ ) {
-            int rw = r*w;
-            memset( buffer,            0,     sizeof(*buffer)*halfsize );
-            memcpy( buffer+halfsize,   im+rw, sizeof(*im)*w            );
-            memset( buffer+halfsize+w, 0,     sizeof(*buffer)*halfsize );
-            filter_buffer(buffer, w, kernel, ksize, opmode);
-            memcpy(out+rw, buffer, w*sizeof(*im));
+    void filter_separable_par(const float* im, const int& w, const int& h, const size_t& in_stride,
+                              const float* kernel_h, const int& ksize_h,
+                              const float* kernel_v, const int& ksize_v, float* out, const size_t& out_stride) {
+        assert_pointer( im && kernel_h && kernel_v && out );
+        assert_pointer_size( ksize_h*ksize_v );
+        assert_statement( im != out || in_stride == out_stride, "in-place filtering needs equal strides" );
+#pragma omp parallel
+        {
+            int n_bands = 1;
+            int band    = 0;
+#ifdef _OPENMP
+            n_bands = omp_get_num_threads();
+            band    = omp_get_thread_num();
+#endif
+            int y0 = int( size_t(h)*size_t(band  ) / size_t(n_bands) );
+            int y1 = int( size_t(h)*size_t(band+1) / size_t(n_bands) );
+            float* buffer = filter_scratch( filter_separable_scratch_size(w, ksize_h, ksize_v) );
+            float* ring   = buffer + w + ksize_h;
+            float* halo   = ring   + size_t(ksize_v)*size_t(w);
+            vector<const float*> rows( ksize_v );
+            if( y0 < y1 )
+                filter_separable_band_halo( im, w, h, in_stride, y0, y1, kernel_h, ksize_h, ksize_v, buffer, ring, halo );
+#pragma omp barrier
+            if( y0 < y1 )
+                filter_separable_band( im, w, h, in_stride, y0, y1, kernel_h, ksize_h, kernel_v, ksize_v,
+                                       buffer, ring, halo, &rows[0], out, out_stride );
         }
     }
 
+    void filter_hv(const float* im, const int& w, const int& h, const size_t& in_stride,
+                   const float* kernel, const int& ksize, float* out, const size_t& out_stride) {
+        filter_separable( im, w, h, in_stride, kernel, ksize, kernel, ksize, out, out_stride );
+    }
 
-    void filter_hor_par( const float* im, const int& w, const int& h, const float* kernel, const int& ksize,
-                         float* out ) {
-        passert_statement( w+ksize < MAX_IMAGE_DIM, "w+ksize is larger than max buffer size" );
-        int halfsize = ksize / 2;
-        MemoryMode opmode = get_alignment(kernel); // buffer is already loaded with mm_loadu
-#pragma omp parallel for
-        for( int r=0; r<h; r++ ) {
-            float buffer[MAX_IMAGE_DIM];
-            int rw = r*w;
-            memset( buffer,            0,     sizeof(*buffer)*halfsize );
-            memcpy( buffer+halfsize,   im+rw, sizeof(*buffer)*w        );
-            memset( buffer+halfsize+w, 0,     sizeof(*buffer)*halfsize );
-            filter_buffer(buffer, w, kernel, ksize, opmode );
-            memcpy( out+rw, buffer, w*sizeof(*out) );
-        }
+    void filter_hv_par(const float* im, const int& w, const int& h, const size_t& in_stride,
+                       const float* kernel, const int& ksize, float* out, const size_t& out_stride) {
+        filter_separable_par( im, w, h, in_stride, kernel, ksize, kernel, ksize, out, out_stride );
     }
 
 
-    void filter_ver( const float* im, const int& w, const int& h, const float* kernel, const int& ksize,
-                     float* out ) {
-        passert_statement( h+ksize < MAX_IMAGE_DIM, "h+ksize is larger than max buffer size" );
+    //
+    // recursive gaussian
+    //
+    // fourth order deriche filter ( "recursively implementing the gaussian
+    // and its derivatives", inria rr-1893, 1993 ). the gaussian is split into
+    // a causal part ( taps 0..inf ) and an anti-causal part ( taps -1..-inf )
+    // that are run over the signal in opposite directions and summed. both
+    // start from a zero state, which is exactly the zero padding of the fir
+    // filters, and the relative error to the sampled gaussian is below 1e-3.
+    //
+    // both passes are applied to a set of lines at once: n rows of nc lanes.
+    // the lanes are independent signals and the recursions are carried out
+    // with filter_rows over whole rows so they are vectorized over the
+    // lanes. the vertical pass runs on column strips of the image, the
+    // horizontal pass on transposed blocks of rows.
+    //
 
-        float buffer0[MAX_IMAGE_DIM], buffer1[MAX_IMAGE_DIM], buffer2[MAX_IMAGE_DIM], buffer3[MAX_IMAGE_DIM];
-        float buffer4[MAX_IMAGE_DIM], buffer5[MAX_IMAGE_DIM], buffer6[MAX_IMAGE_DIM], buffer7[MAX_IMAGE_DIM];
+    struct GaussianIIR {
+        // per second order section: weights of x[n], x[n-1], y[n-1], y[n-2]
+        // for the causal and of x[n+1], x[n+2], y[n+1], y[n+2] for the
+        // anti-causal part.
+        float causal    [2][4];
+        float anticausal[2][4];
+    };
 
-        int halfsize = ksize / 2;
-        int i, c, r;
-
-        MemoryMode opmode = get_alignment(kernel);
-
-        const float* imp;
-        for( c=0; c<w-8; c+=8 ) {
-            imp=im+c;
-            memset( buffer0, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer1, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer2, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer3, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer4, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer5, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer6, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer7, 0, sizeof(*buffer0)*halfsize );
-
-            for( i=0; i<h; i++ ) {
-                imp = im+i*w+c;
-                buffer0[halfsize+i] = imp[0];
-                buffer1[halfsize+i] = imp[1];
-                buffer2[halfsize+i] = imp[2];
-                buffer3[halfsize+i] = imp[3];
-                buffer4[halfsize+i] = imp[4];
-                buffer5[halfsize+i] = imp[5];
-                buffer6[halfsize+i] = imp[6];
-                buffer7[halfsize+i] = imp[7];
-            }
+    void compute_gaussian_iir( const float& sigma, GaussianIIR& g ) {
+        passert_statement_g( sigma >= 0.5f, "[sigma %f] iir gaussian needs sigma >= 0.5", sigma );
+        // h[k] = sum_i ( a_i cos(w_i k/sigma) + c_i sin(w_i k/sigma) ) exp(-b_i k/sigma), k>=0
+        const double a[2] = { 1.680,  -0.6803 };
+        const double c[2] = { 3.735,  -0.2598 };
+        const double b[2] = { 1.783,   1.723  };
+        const double w[2] = { 0.6318,  1.997  };
+        double s = sigma;
 
-            memset( buffer0+halfsize+h, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer1+halfsize+h, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer2+halfsize+h, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer3+halfsize+h, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer4+halfsize+h, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer5+halfsize+h, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer6+halfsize+h, 0, sizeof(*buffer0)*halfsize );
-            memset( buffer7+halfsize+h, 0, sizeof(*buffer0)*halfsize );
-
-            filter_buffer( buffer0, h, kernel, ksize, opmode );
-            filter_buffer( buffer1, h, kernel, ksize, opmode );
-            filter_buffer( buffer2, h, kernel, ksize, opmode );
-            filter_buffer( buffer3, h, kernel, ksize, opmode );
-            filter_buffer( buffer4, h, kernel, ksize, opmode );
-            filter_buffer( buffer5, h, kernel, ksize, opmode );
-            filter_buffer( buffer6, h, kernel, ksize, opmode );
-            filter_buffer( buffer7, h, kernel, ksize, opmode );
-
-            for( r=0; r<h; r++ ) {
-                out[r*w+c  ] = buffer0[r];
-                out[r*w+c+1] = buffer1[r];
-                out[r*w+c+2] = buffer2[r];
-                out[r*w+c+3] = buffer3[r];
-                out[r*w+c+4] = buffer4[r];
-                out[r*w+c+5] = buffer5[r];
-                out[r*w+c+6] = buffer6[r];
-                out[r*w+c+7] = buffer7[r];
+        // the causal response of each damped sinusoid is realized by a second
+        // order section. the sections are kept separate ( instead of a single
+        // fourth order recursion ) as their coefficients stay well
+        // conditioned in float precision for large sigma.
+        double h[2][3], d[2][2];
+        double dc = 0.0;
+        for( int i=0; i<2; i++ ) {
+            for( int k=0; k<3; k++ )
+                h[i][k] = ( a[i]*std::cos(w[i]*k/s) + c[i]*std::sin(w[i]*k/s) ) * std::exp(-b[i]*k/s);
+            d[i][0] = -2.0*std::exp(-b[i]/s)*std::cos(w[i]/s);
+            d[i][1] =      std::exp(-2.0*b[i]/s);
+            // sum_k h[|k|] = 2*N(1)/D(1) - h[0]
+            double num = h[i][0] + h[i][1] + d[i][0]*h[i][0];
+            dc += 2.0*num/( 1.0+d[i][0]+d[i][1] ) - h[i][0];
+        }
+        for( int i=0; i<2; i++ ) {
+            g.causal    [i][0] = float(   h[i][0]                     / dc );
+            g.causal    [i][1] = float( ( h[i][1] + d[i][0]*h[i][0] ) / dc );
+            g.anticausal[i][0] = float(   h[i][1]                     / dc );
+            g.anticausal[i][1] = float( ( h[i][2] + d[i][0]*h[i][1] ) / dc );
+            g.causal[i][2] = g.anticausal[i][2] = float( -d[i][0] );
+            g.causal[i][3] = g.anticausal[i][3] = float( -d[i][1] );
+        }
+    }
+
+    /// in-place gaussian of n rows of nc lanes that are stride apart. scratch
+    /// should have space for (n+9)*nc floats.
+    void filter_gaussian_iir_lines( const GaussianIIR& g, float* data, const int& n, const int& nc,
+                                    const size_t& stride, float* scratch ) {
+        static const float ones[3] = { 1.0f, 1.0f, 1.0f };
+        size_t snc   = size_t(nc);
+        float* zero  = scratch;              // rows outside the signal
+        float* xring = zero  +   snc;        // x[n-1] copies for the causal pass
+        float* ring0 = xring + 2*snc;        // last outputs of the sections
+        float* ring1 = ring0 + 3*snc;
+        float* acaus = ring1 + 3*snc;        // anti-causal output
+        memset( zero, 0, sizeof(*zero)*nc );
+        float*       ring[2] = { ring0, ring1 };
+        const float* rows[4];
+        const float* sum [3];
+
+        // anti-causal pass bottom-up
+        for( int y=n-1; y>=0; y-- ) {
+            for( int i=0; i<2; i++ ) {
+                for( int k=1; k<=2; k++ ) {
+                    bool in = ( y+k < n );
+                    rows[k-1] = in ? data    + size_t(y+k)*stride    : zero;
+                    rows[k+1] = in ? ring[i] + size_t((y+k)%3)*snc : zero;
+                }
+                filter_rows( rows, g.anticausal[i], 4, nc, ring[i]+size_t(y%3)*snc );
+                sum[i] = ring[i]+size_t(y%3)*snc;
             }
+            filter_rows( sum, ones, 2, nc, acaus+size_t(y)*snc );
         }
-        for(; c<w; c++ ) {
-            memset( buffer0, 0, sizeof(*buffer0)*halfsize );
-            for( i=0; i<h; i++ ) buffer0[halfsize+i  ] = im[i*w+c ];
-            memset( buffer0+halfsize+h, 0, sizeof(*buffer0)*halfsize );
-            filter_buffer(buffer0, h, kernel, ksize, get_alignment(kernel) );
-            for( r=0; r<h; r++ ) out[r*w+c] = buffer0[r];
+
+        // causal pass top-down, summed with the anti-causal output into data.
+        // the input row is saved in xring before it is overwritten.
+        for( int y=0; y<n; y++ ) {
+            float* dy = data + size_t(y)*stride;
+            for( int i=0; i<2; i++ ) {
+                rows[0] = dy;
+                rows[1] = ( y >= 1 ) ? xring   + size_t((y-1)%2)*snc : zero;
+                rows[2] = ( y >= 1 ) ? ring[i] + size_t((y-1)%3)*snc : zero;
+                rows[3] = ( y >= 2 ) ? ring[i] + size_t((y-2)%3)*snc : zero;
+                filter_rows( rows, g.causal[i], 4, nc, ring[i]+size_t(y%3)*snc );
+                sum[i] = ring[i]+size_t(y%3)*snc;
+            }
+            memcpy( xring+size_t(y%2)*snc, dy, sizeof(*dy)*nc );
+            sum[2] = acaus + size_t(y)*snc;
+            filter_rows( sum, ones, 3, nc, dy );
         }
     }
 
-    void filter_ver_par(const float* im, const int& w, const int& h, const float* kernel, const int& ksize,
-                        float* out ) {
-        passert_statement( h+ksize < MAX_IMAGE_DIM, "h+ksize is larger than max buffer size" );
-        int halfsize = ksize / 2;
-        MemoryMode opmode = get_alignment(kernel);
-#pragma omp parallel for
-        for( int c=0; c<w; c++ ) {
-            float buffer[MAX_IMAGE_DIM];
-            const float* imp = im+c;
-            int i, r;
-            memset( buffer,            0, sizeof(*buffer)*halfsize );
-            for( i=0; i<h; i++ ) {
-                imp = im+i*w+c;
-                buffer[halfsize+i] = imp[0];
+    static const int FILTER_IIR_LANES = 64;
+
+    /// horizontal pass over the rows [y0,y0+nr), nr <= FILTER_IIR_LANES. the
+    /// rows are transposed into lanes of block, filtered, and written back.
+    void filter_gaussian_iir_hor_block( const GaussianIIR& g, const float* im, const int& w,
+                                        const size_t& in_stride, const int& y0, const int& nr,
+                                        float* block, float* scratch, float* out, const size_t& out_stride ) {
+        const int L = FILTER_IIR_LANES;
+        if( nr < L ) memset( block, 0, sizeof(*block)*size_t(w)*L );
+        for( int x0=0; x0<w; x0+=16 ) {
+            int x1 = std::min( x0+16, w );
+            for( int r=0; r<nr; r++ ) {
+                const float* row = im + size_t(y0+r)*in_stride;
+                for( int x=x0; x<x1; x++ )
+                    block[size_t(x)*L+r] = row[x];
             }
-            memset( buffer+h+halfsize, 0, sizeof(*buffer)*halfsize );
-            filter_buffer( buffer, h, kernel, ksize, opmode );
-            for( r=0; r<h; r++ ) {
-                out[r*w+c  ] = buffer[r];
+        }
+        filter_gaussian_iir_lines( g, block, w, L, L, scratch );
+        for( int x0=0; x0<w; x0+=16 ) {
+            int x1 = std::min( x0+16, w );
+            for( int r=0; r<nr; r++ ) {
+                float* row = out + size_t(y0+r)*out_stride;
+                for( int x=x0; x<x1; x++ )
+                    row[x] = block[size_t(x)*L+r];
             }
         }
     }
 
-    void filter_hv( const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out ) {
-        filter_hor(im, w,h,kernel,ksize,out);
-        filter_ver(out,w,h,kernel,ksize,out);
+    /// width of the column strips of the vertical pass. the strips are kept
+    /// wide so that the strided row segments stream well while the strip
+    /// scratch of (h+9)*sw floats stays around 4MB.
+    int filter_gaussian_iir_strip_width( const int& w, const int& h, const int& n_strips ) {
+        int sw = ( 1048576 / (h+9) ) / 16 * 16;
+        sw = std::max( sw, 16 );
+        if( n_strips > 1 ) {
+            int psw = ( (w+n_strips-1) / n_strips + 15 ) / 16 * 16;
+            sw = std::min( sw, psw );
+        }
+        return std::min( sw, w );
     }
 
-    void filter_hv_par(const float* im, const int& w, const int& h, const float* kernel, const int& ksize, float* out) {
-        filter_hor_par(im, w,h,kernel,ksize,out);
-        filter_ver_par(out,w,h,kernel,ksize,out);
+    void filter_gaussian_iir( const float* im, const int& w, const int& h, const size_t& in_stride,
+                              const float& sigma, float* out, const size_t& out_stride ) {
+        assert_pointer( im && out );
+        assert_pointer_size( w*h );
+        assert_statement( im != out || in_stride == out_stride, "in-place filtering needs equal strides" );
+        GaussianIIR g;
+        compute_gaussian_iir( sigma, g );
+        const int L  = FILTER_IIR_LANES;
+        int       sw = filter_gaussian_iir_strip_width( w, h, 1 );
+        size_t hsz = size_t(w)*L + (size_t(w)+9)*L;
+        size_t vsz = (size_t(h)+9)*size_t(sw);
+        float* scratch = filter_scratch( std::max( hsz, vsz ) );
+        for( int y=0; y<h; y+=L )
+            filter_gaussian_iir_hor_block( g, im, w, in_stride, y, std::min(L, h-y), scratch, scratch+size_t(w)*L,
+                                           out, out_stride );
+        for( int c=0; c<w; c+=sw )
+            filter_gaussian_iir_lines( g, out+c, h, std::min(sw, w-c), out_stride, scratch );
     }
 
+    void filter_gaussian_iir_par( const float* im, const int& w, const int& h, const size_t& in_stride,
+                                  const float& sigma, float* out, const size_t& out_stride ) {
+        assert_pointer( im && out );
+        assert_pointer_size( w*h );
+        assert_statement( im != out || in_stride == out_stride, "in-place filtering needs equal strides" );
+        GaussianIIR g;
+        compute_gaussian_iir( sigma, g );
+        int n_threads = 1;
+#ifdef _OPENMP
+        n_threads = omp_get_max_threads();
+#endif
+        const int L        = FILTER_IIR_LANES;
+        int       n_blocks = (h+L-1) / L;
+        int       sw       = filter_gaussian_iir_strip_width( w, h, 4*n_threads );
+        int       n_strips = (w+sw-1) / sw;
+        size_t hsz = size_t(w)*L + (size_t(w)+9)*L;
+        size_t vsz = (size_t(h)+9)*size_t(sw);
+#pragma omp parallel
+        {
+            float* scratch = filter_scratch( std::max( hsz, vsz ) );
+#pragma omp for schedule(dynamic)
+            for( int b=0; b<n_blocks; b++ ) {
+                int y = b*L;
+                filter_gaussian_iir_hor_block( g, im, w, in_stride, y, std::min(L, h-y), scratch, scratch+size_t(w)*L,
+                                               out, out_stride );
+            }
+#pragma omp for schedule(dynamic)
+            for( int s=0; s<n_strips; s++ ) {
+                int c = s*sw;
+                filter_gaussian_iir_lines( g, out+c, h, std::min(sw, w-c), out_stride, scratch );
+            }
+        }
+    }
 
 }
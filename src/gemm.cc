@@ -0,0 +1,323 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/gemm.h>
+#include <kortex/check.h>
+#include <kortex/cpu_features.h>
+#include <kortex/mem_manager.h>
+#include <kortex/lapack_externs.h>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace kortex {
+
+    // blocking parameters - a KC x NC panel of op(B) stays in L3/L2 and an
+    // MC x KC block of op(A) in L2 while MR x NR tiles of C are accumulated
+    // in registers. MC is a multiple of every MR.
+    static const int GEMM_KC = 256;
+    static const int GEMM_MC = 96;
+    static const int GEMM_NC = 2048;
+
+    /// micro-kernel: c[0:MR,0:NR] ( += ) pa * pb where pa is a packed MR x kc
+    /// panel and pb a packed kc x NR panel
+    typedef void (*GemmKernel)( const int& kc, const double* pa, const double* pb,
+                                double* c, const int& ldc, const bool& accumulate );
+
+    static void gemm_kernel_basic( const int& kc, const double* pa, const double* pb,
+                                   double* c, const int& ldc, const bool& accumulate ) {
+        const int MR = 4, NR = 4;
+        double acc[MR][NR];
+        memset( acc, 0, sizeof(acc) );
+        for( int p=0; p<kc; p++ ) {
+            for( int r=0; r<MR; r++ )
+                for( int j=0; j<NR; j++ )
+                    acc[r][j] += pa[r] * pb[j];
+            pa += MR;
+            pb += NR;
+        }
+        for( int r=0; r<MR; r++ ) {
+            double* cr = c + r*ldc;
+            for( int j=0; j<NR; j++ )
+                cr[j] = accumulate ? cr[j] + acc[r][j] : acc[r][j];
+        }
+    }
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+    KORTEX_TARGET_AVX2
+    static void gemm_kernel_avx2( const int& kc, const double* pa, const double* pb,
+                                  double* c, const int& ldc, const bool& accumulate ) {
+        // 6x8 tile - 12 accumulators, 2 b vectors and 1 broadcast
+        __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+        __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+        __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+        __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+        __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+        __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+        for( int p=0; p<kc; p++ ) {
+            __m256d b0 = _mm256_loadu_pd( pb   );
+            __m256d b1 = _mm256_loadu_pd( pb+4 );
+            __m256d a;
+            a = _mm256_broadcast_sd( pa   ); c00 = _mm256_fmadd_pd( a, b0, c00 ); c01 = _mm256_fmadd_pd( a, b1, c01 );
+            a = _mm256_broadcast_sd( pa+1 ); c10 = _mm256_fmadd_pd( a, b0, c10 ); c11 = _mm256_fmadd_pd( a, b1, c11 );
+            a = _mm256_broadcast_sd( pa+2 ); c20 = _mm256_fmadd_pd( a, b0, c20 ); c21 = _mm256_fmadd_pd( a, b1, c21 );
+            a = _mm256_broadcast_sd( pa+3 ); c30 = _mm256_fmadd_pd( a, b0, c30 ); c31 = _mm256_fmadd_pd( a, b1, c31 );
+            a = _mm256_broadcast_sd( pa+4 ); c40 = _mm256_fmadd_pd( a, b0, c40 ); c41 = _mm256_fmadd_pd( a, b1, c41 );
+            a = _mm256_broadcast_sd( pa+5 ); c50 = _mm256_fmadd_pd( a, b0, c50 ); c51 = _mm256_fmadd_pd( a, b1, c51 );
+            pa += 6;
+            pb += 8;
+        }
+        __m256d acc[12] = { c00, c01, c10, c11, c20, c21, c30, c31, c40, c41, c50, c51 };
+        for( int r=0; r<6; r++ ) {
+            double* cr = c + r*ldc;
+            if( accumulate ) {
+                _mm256_storeu_pd( cr,   _mm256_add_pd( _mm256_loadu_pd( cr   ), acc[2*r  ] ) );
+                _mm256_storeu_pd( cr+4, _mm256_add_pd( _mm256_loadu_pd( cr+4 ), acc[2*r+1] ) );
+            } else {
+                _mm256_storeu_pd( cr,   acc[2*r  ] );
+                _mm256_storeu_pd( cr+4, acc[2*r+1] );
+            }
+        }
+    }
+
+    KORTEX_TARGET_AVX512
+    static void gemm_kernel_avx512( const int& kc, const double* pa, const double* pb,
+                                    double* c, const int& ldc, const bool& accumulate ) {
+        // 8x16 tile - 16 accumulators, 2 b vectors and 1 broadcast
+        __m512d acc[16];
+        for( int i=0; i<16; i++ )
+            acc[i] = _mm512_setzero_pd();
+        for( int p=0; p<kc; p++ ) {
+            __m512d b0 = _mm512_loadu_pd( pb   );
+            __m512d b1 = _mm512_loadu_pd( pb+8 );
+            for( int r=0; r<8; r++ ) {
+                __m512d a = _mm512_set1_pd( pa[r] );
+                acc[2*r  ] = _mm512_fmadd_pd( a, b0, acc[2*r  ] );
+                acc[2*r+1] = _mm512_fmadd_pd( a, b1, acc[2*r+1] );
+            }
+            pa += 8;
+            pb += 16;
+        }
+        for( int r=0; r<8; r++ ) {
+            double* cr = c + r*ldc;
+            if( accumulate ) {
+                _mm512_storeu_pd( cr,   _mm512_add_pd( _mm512_loadu_pd( cr   ), acc[2*r  ] ) );
+                _mm512_storeu_pd( cr+8, _mm512_add_pd( _mm512_loadu_pd( cr+8 ), acc[2*r+1] ) );
+            } else {
+                _mm512_storeu_pd( cr,   acc[2*r  ] );
+                _mm512_storeu_pd( cr+8, acc[2*r+1] );
+            }
+        }
+    }
+#endif
+
+    /// packs rows [i0,i0+mc) and columns [p0,p0+kc) of op(A) into MR row
+    /// panels - rows beyond mc are zero
+    static void gemm_pack_a( const bool& trans_a, const double* A, const int& lda,
+                             const int& i0, const int& mc, const int& p0, const int& kc,
+                             const int& MR, double* pa ) {
+        for( int ir=0; ir<mc; ir+=MR ) {
+            int mr = std::min( MR, mc-ir );
+            for( int p=0; p<kc; p++ ) {
+                for( int r=0; r<mr; r++ ) {
+                    int i = i0+ir+r;
+                    pa[r] = trans_a ? A[ size_t(p0+p)*lda + i ] : A[ size_t(i)*lda + p0+p ];
+                }
+                for( int r=mr; r<MR; r++ )
+                    pa[r] = 0.0;
+                pa += MR;
+            }
+        }
+    }
+
+    /// packs rows [p0,p0+kc) and columns [j0,j0+nc) of op(B) into NR column
+    /// panels - columns beyond nc are zero
+    static void gemm_pack_b( const bool& trans_b, const double* B, const int& ldb,
+                             const int& p0, const int& kc, const int& j0, const int& nc,
+                             const int& NR, double* pb ) {
+        for( int jr=0; jr<nc; jr+=NR ) {
+            int nr = std::min( NR, nc-jr );
+            double* pbj = pb + size_t(jr)*kc;
+            for( int p=0; p<kc; p++ ) {
+                if( !trans_b ) {
+                    const double* brow = B + size_t(p0+p)*ldb + j0+jr;
+                    for( int j=0; j<nr; j++ )
+                        pbj[j] = brow[j];
+                } else {
+                    for( int j=0; j<nr; j++ )
+                        pbj[j] = B[ size_t(j0+jr+j)*ldb + p0+p ];
+                }
+                for( int j=nr; j<NR; j++ )
+                    pbj[j] = 0.0;
+                pbj += NR;
+            }
+        }
+    }
+
+    void mat_gemm_packed( const bool& trans_a, const bool& trans_b, const int& m, const int& n, const int& k,
+                          const double* A, const int& lda, const double* B, const int& ldb,
+                          double* C, const int& ldc ) {
+        passert_statement_g( m >= 0 && n >= 0 && k >= 0, "invalid dimensions [%d %d %d]", m, n, k );
+        passert_pointer( A && B && C );
+        if( m == 0 || n == 0 ) return;
+        if( k == 0 ) {
+            for( int i=0; i<m; i++ )
+                memset( C + size_t(i)*ldc, 0, sizeof(*C)*n );
+            return;
+        }
+
+        GemmKernel kernel = gemm_kernel_basic;
+        int MR = 4, NR = 4;
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: kernel = gemm_kernel_avx512; MR = 8; NR = 16; break;
+        case SIMD_AVX2  : kernel = gemm_kernel_avx2;   MR = 6; NR =  8; break;
+        default         : break;
+        }
+#endif
+        const int    nc_max = std::min( GEMM_NC, ( n + NR-1 ) / NR * NR );
+        const int    kc_max = std::min( GEMM_KC, k );
+        const int    n_mblocks = ( m + GEMM_MC-1 ) / GEMM_MC;
+        const double flops  = double(m) * double(n) * double(k);
+#ifdef _OPENMP
+        const int    n_threads = ( flops > 4.0e6 ) ? std::min( omp_get_max_threads(), n_mblocks ) : 1;
+#else
+        const int    n_threads = 1;
+#endif
+
+        double* pb = NULL;
+        allocate( pb, size_t(kc_max) * size_t(nc_max) );
+
+#pragma omp parallel num_threads(n_threads)
+        {
+            double* pa = NULL;
+            allocate( pa, size_t(GEMM_MC) * size_t(kc_max) );
+            double tile[ 8*16 ];
+
+            for( int jc=0; jc<n; jc+=GEMM_NC ) {
+                const int nc = std::min( GEMM_NC, n-jc );
+                for( int pc=0; pc<k; pc+=GEMM_KC ) {
+                    const int  kc    = std::min( GEMM_KC, k-pc );
+                    const bool accum = ( pc != 0 );
+                    const int  n_panels = ( nc + NR-1 ) / NR;
+
+#pragma omp for schedule(static)
+                    for( int jp=0; jp<n_panels; jp++ )
+                        gemm_pack_b( trans_b, B, ldb, pc, kc, jc+jp*NR, std::min( NR, nc-jp*NR ), NR,
+                                     pb + size_t(jp)*NR*kc );
+
+#pragma omp for schedule(dynamic)
+                    for( int ib=0; ib<n_mblocks; ib++ ) {
+                        const int ic = ib * GEMM_MC;
+                        const int mc = std::min( GEMM_MC, m-ic );
+                        gemm_pack_a( trans_a, A, lda, ic, mc, pc, kc, MR, pa );
+                        for( int jr=0; jr<nc; jr+=NR ) {
+                            const int     nr  = std::min( NR, nc-jr );
+                            const double* pbj = pb + size_t(jr)*kc;
+                            for( int ir=0; ir<mc; ir+=MR ) {
+                                const int     mr  = std::min( MR, mc-ir );
+                                const double* pai = pa + size_t(ir)*kc;
+                                double*       cij = C + size_t(ic+ir)*ldc + jc+jr;
+                                if( mr == MR && nr == NR ) {
+                                    kernel( kc, pai, pbj, cij, ldc, accum );
+                                    continue;
+                                }
+                                // edge tiles go through a full-size buffer
+                                kernel( kc, pai, pbj, tile, NR, false );
+                                for( int r=0; r<mr; r++ ) {
+                                    double*       cr = cij + size_t(r)*ldc;
+                                    const double* tr = tile + r*NR;
+                                    for( int j=0; j<nr; j++ )
+                                        cr[j] = accum ? cr[j] + tr[j] : tr[j];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            deallocate( pa );
+        }
+        deallocate( pb );
+    }
+
+#ifdef WITH_BLAS
+    void mat_gemm_blas( const bool& trans_a, const bool& trans_b, const int& m, const int& n, const int& k,
+                        const double* A, const int& lda, const double* B, const int& ldb,
+                        double* C, const int& ldc ) {
+        passert_pointer( A && B && C );
+        if( m == 0 || n == 0 ) return;
+        // row-major C = op(A) op(B) is column-major C' = op(B)' op(A)'
+        char   ta    = trans_a ? 'T' : 'N';
+        char   tb    = trans_b ? 'T' : 'N';
+        int    mm    = m, nn = n, kk = k;
+        int    la    = lda, lb = ldb, lc = ldc;
+        double alpha = 1.0, beta = 0.0;
+        dgemm_( &tb, &ta, &nn, &mm, &kk, &alpha, const_cast<double*>(B), &lb,
+                const_cast<double*>(A), &la, &beta, C, &lc );
+    }
+#endif
+
+    static void mat_gemm_small( const bool& trans_a, const bool& trans_b, const int& m, const int& n, const int& k,
+                                const double* A, const int& lda, const double* B, const int& ldb,
+                                double* C, const int& ldc ) {
+        const int sa_r = trans_a ? 1   : lda; // op(A) row step
+        const int sa_c = trans_a ? lda : 1;   // op(A) column step
+        for( int i=0; i<m; i++ ) {
+            const double* arow = A + size_t(i)*sa_r;
+            double      * crow = C + size_t(i)*ldc;
+            if( !trans_b ) {
+                // streams the rows of B
+                for( int j=0; j<n; j++ )
+                    crow[j] = 0.0;
+                for( int p=0; p<k; p++ ) {
+                    const double  a    = arow[ size_t(p)*sa_c ];
+                    const double* brow = B + size_t(p)*ldb;
+                    for( int j=0; j<n; j++ )
+                        crow[j] += a * brow[j];
+                }
+            } else {
+                for( int j=0; j<n; j++ ) {
+                    const double* brow = B + size_t(j)*ldb;
+                    double res = 0.0;
+                    for( int p=0; p<k; p++ )
+                        res += arow[ size_t(p)*sa_c ] * brow[p];
+                    crow[j] = res;
+                }
+            }
+        }
+    }
+
+    void mat_gemm( const bool& trans_a, const bool& trans_b, const int& m, const int& n, const int& k,
+                   const double* A, const int& lda, const double* B, const int& ldb,
+                   double* C, const int& ldc ) {
+        if( double(m) * double(n) * double(k) < GEMM_SMALL_PRODUCT ) {
+            mat_gemm_small( trans_a, trans_b, m, n, k, A, lda, B, ldb, C, ldc );
+            return;
+        }
+#ifdef WITH_BLAS
+        mat_gemm_blas  ( trans_a, trans_b, m, n, k, A, lda, B, ldb, C, ldc );
+#else
+        mat_gemm_packed( trans_a, trans_b, m, n, k, A, lda, B, ldb, C, ldc );
+#endif
+    }
+
+}
@@ -14,7 +14,8 @@
 // ---------------------------------------------------------------------------
 #include <kortex/geometry.h>
 #include <kortex/math.h>
-#include <kortex/svd.h>
+#include <kortex/matrix.h>
+#include <kortex/check.h>
 
 namespace kortex {
 
@@ -49,6 +50,24 @@ namespace kortex {
         mean[2] /= static_cast<float>(n_pnts);
     }
 
+    /// normal of the plane fitting to the points with the ( unnormalized )
+    /// covariance Cov - the eigenvector of the smallest eigenvalue. returns
+    /// the curvature estimate.
+    static double plane_normal_from_covariance( const double Cov[9], double normal[3] ) {
+        // need to divide by number of samples to compute the actual covariance
+        // but it is not necessary here as we divide eigenvalues to each
+        // other and the n_pnts will just cancel each oher.
+        double evals[3], evecs[9];
+        mat_eigen_sym_3( Cov, evals, evecs );
+        normal[0] = evecs[6];
+        normal[1] = evecs[7];
+        normal[2] = evecs[8];
+        double l0 = fabs(evals[0]);
+        double l1 = fabs(evals[1]);
+        double l2 = fabs(evals[2]);
+        return l2 / (l0+l1+l2);
+    }
+
     /// computes the plane equation fitting to the points. returning value is
     /// the curvature estimate for the points.
     double compute_plane( const vector<const double*> pnts, double plane[4] ) {
@@ -75,24 +94,9 @@ namespace kortex {
             mat_add_3( ppt, Cov );
         }
 
-        // need to divide by number of samples to compute the actual covariance
-        // but it is not necessary here as we divide singular values to each
-        // other and the n_pnts will just cancel each oher.
-
-        SVD svd;
-        svd.decompose( Cov, 3, 3, true, true );
-
-        const double* components = svd.Vt();
-        memcpy( plane, components+6, sizeof(*plane)*3 );
-
+        double curvature = plane_normal_from_covariance( Cov, plane );
         plane[3] = -dot3(plane, mu);
-
-        const double* sd = svd.Sd();
-        double l0 = fabs(sd[0]);
-        double l1 = fabs(sd[1]);
-        double l2 = fabs(sd[2]);
-
-        return l2 / (l0+l1+l2);
+        return curvature;
     }
 
     float compute_plane( const vector< Vec3f >& pnts, float plane[4] ) {
@@ -118,21 +122,13 @@ namespace kortex {
             mat_mat_trans( nX, 3, 1, nX, 3, 1, ppt, 9 );
             mat_add_3( ppt, Cov );
         }
-        SVD svd;
-        svd.decompose( Cov, 3, 3, true, true );
-
-        const double* components = svd.Vt();
-        plane[0] = (float)components[6];
-        plane[1] = (float)components[7];
-        plane[2] = (float)components[8];
+        double normal[3];
+        double curvature = plane_normal_from_covariance( Cov, normal );
+        plane[0] = (float)normal[0];
+        plane[1] = (float)normal[1];
+        plane[2] = (float)normal[2];
         plane[3] = -dot3(plane, mu());
-
-        const double* sd = svd.Sd();
-        double l0 = fabs(sd[0]);
-        double l1 = fabs(sd[1]);
-        double l2 = fabs(sd[2]);
-
-        return float( l2 / (l0+l1+l2) );
+        return float( curvature );
     }
 
     /// computes the plane equation fitting to the points. returning value is
@@ -162,21 +158,76 @@ namespace kortex {
             mat_add_3( ppt, Cov );
         }
 
-        SVD svd;
-        svd.decompose( Cov, 3, 3, true, true );
-
-        const double* components = svd.Vt();
-        plane[0] = (float)components[6];
-        plane[1] = (float)components[7];
-        plane[2] = (float)components[8];
+        double normal[3];
+        double curvature = plane_normal_from_covariance( Cov, normal );
+        plane[0] = (float)normal[0];
+        plane[1] = (float)normal[1];
+        plane[2] = (float)normal[2];
         plane[3] = -dot3(plane, mu);
+        return float( curvature );
+    }
 
-        const double* sd = svd.Sd();
-        double l0 = fabs(sd[0]);
-        double l1 = fabs(sd[1]);
-        double l2 = fabs(sd[2]);
+    /// compute_plane for the points pnts[ 3*idx[i] ], i < n
+    static float compute_plane_indexed( const float* pnts, const int& n_pnts, const int* idx, const int& n,
+                                        float plane[4] ) {
+        if( n < 4 ) {
+            plane[0] = plane[1] = plane[2] = plane[3] = 0.0f;
+            return -1.0f;
+        }
+        double mu[3] = { 0.0, 0.0, 0.0 };
+        for( int i=0; i<n; i++ ) {
+            assert_boundary( idx[i], 0, n_pnts );
+            const float* X = pnts + 3*size_t(idx[i]);
+            mu[0] += X[0];
+            mu[1] += X[1];
+            mu[2] += X[2];
+        }
+        mu[0] /= n;
+        mu[1] /= n;
+        mu[2] /= n;
+
+        double Cov[9] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+        for( int i=0; i<n; i++ ) {
+            const float* X = pnts + 3*size_t(idx[i]);
+            double x = X[0]-mu[0];
+            double y = X[1]-mu[1];
+            double z = X[2]-mu[2];
+            Cov[0] += x*x; Cov[1] += x*y; Cov[2] += x*z;
+            Cov[4] += y*y; Cov[5] += y*z;
+            Cov[8] += z*z;
+        }
+        Cov[3] = Cov[1];
+        Cov[6] = Cov[2];
+        Cov[7] = Cov[5];
+
+        double normal[3];
+        double curvature = plane_normal_from_covariance( Cov, normal );
+        plane[0] = (float)normal[0];
+        plane[1] = (float)normal[1];
+        plane[2] = (float)normal[2];
+        plane[3] = (float)-dot3( normal, mu );
+        return float( curvature );
+    }
+
+    void compute_planes( const float* pnts, const int& n_pnts, const int* nbh, const int* nbh_offsets,
+                         const int& n_nbh, float* planes, float* curvatures ) {
+        passert_pointer( pnts && nbh && nbh_offsets && planes );
+#pragma omp parallel for schedule(dynamic,256)
+        for( int i=0; i<n_nbh; i++ ) {
+            int   b = nbh_offsets[i];
+            float c = compute_plane_indexed( pnts, n_pnts, nbh+b, nbh_offsets[i+1]-b, planes+4*size_t(i) );
+            if( curvatures ) curvatures[i] = c;
+        }
+    }
 
-        return float( l2 / (l0+l1+l2) );
+    void compute_knn_planes( const float* pnts, const int& n_pnts, const int* nbh, const int& k,
+                             const int& n_nbh, float* planes, float* curvatures ) {
+        passert_pointer( pnts && nbh && planes );
+#pragma omp parallel for schedule(dynamic,256)
+        for( int i=0; i<n_nbh; i++ ) {
+            float c = compute_plane_indexed( pnts, n_pnts, nbh+size_t(i)*k, k, planes+4*size_t(i) );
+            if( curvatures ) curvatures[i] = c;
+        }
     }
 
     double point_to_plane_distance( const double X[3], const double plane[4] ) {
@@ -18,6 +18,7 @@
 #include <kortex/image_io.h>
 #include <kortex/check.h>
 #include <kortex/fileio.h>
+#include <kortex/mem_manager.h>
 
 #include <cstring>
 
@@ -27,6 +28,8 @@ namespace kortex {
 		m_w            = 0;
 		m_h            = 0;
 		m_ch           = 0;
+		m_stride       = 0;
+		m_plane        = 0;
 		m_type         = IT_U_GRAY;
 		m_channel_type = ITC_PIXEL;
 		m_data_i       = NULL;
@@ -57,14 +60,66 @@ namespace kortex {
 		return *this;
 	}
 
+	Image::Image( Image&& img ) noexcept {
+		init_();
+		take_( img );
+	}
+
+	Image& Image::operator=( Image&& p ) {
+		if( &p != this )
+			take_( p );
+		return *this;
+	}
+
+	void Image::take_( Image& img ) {
+		if( m_wrapper || img.m_wrapper ) {
+			this->copy( &img );
+			return;
+		}
+		release();
+		m_w            = img.m_w;
+		m_h            = img.m_h;
+		m_ch           = img.m_ch;
+		m_stride       = img.m_stride;
+		m_plane        = img.m_plane;
+		m_type         = img.m_type;
+		m_channel_type = img.m_channel_type;
+		m_data_u       = img.m_data_u;
+		m_data_f       = img.m_data_f;
+		m_data_i       = img.m_data_i;
+		m_data_u16     = img.m_data_u16;
+		m_memory.swap( &img.m_memory );
+		img.init_();
+	}
+
+	/// number of elements in a packed row ( of a plane for image-ordered types )
+	static size_t packed_stride( int w, ImageType type ) {
+		if( image_channel_type(type) == ITC_IMAGE ) return size_t(w);
+		return size_t(w) * size_t( image_no_channels(type) );
+	}
+
 	void Image::create( int w, int h, ImageType type ) {
+		create_( w, h, type, packed_stride(w,type) );
+	}
+
+	void Image::create_padded( int w, int h, ImageType type ) {
+		size_t esz    = get_data_byte_size( image_precision(type) );
+		size_t rbytes = packed_stride(w,type) * esz;
+		rbytes = ( rbytes + MEMORY_ALIGNMENT-1 ) / MEMORY_ALIGNMENT * MEMORY_ALIGNMENT;
+		create_( w, h, type, rbytes/esz );
+	}
+
+	void Image::create_( int w, int h, ImageType type, size_t stride ) {
 		passert_statement( w*h>0, "will not create null image" );
-		size_t sz = req_mem( w, h, type );
 		if( m_wrapper ) {
 			passert_statement( (m_w==w) && (m_h==h) && (type==m_type), "cannot change the attributes of a wrapper image" );
 			return;
 		}
-		m_memory.resize( sz );
+		int    n_planes = image_channel_type(type) == ITC_IMAGE ? image_no_channels(type) : 1;
+		size_t esz      = get_data_byte_size( image_precision(type) );
+		m_memory.resize( stride * size_t(h) * size_t(n_planes) * esz + sizeof(Image) );
+		m_stride = stride;
+		m_plane  = stride * size_t(h);
 		switch( image_precision(type) ) {
 		case TYPE_UCHAR  : m_data_u   = (uchar   *) m_memory.get_buffer(); break;
 		case TYPE_FLOAT  : m_data_f   = (float   *) m_memory.get_buffer(); break;
@@ -79,6 +134,56 @@ namespace kortex {
 		m_channel_type = image_channel_type( type );
 	}
 
+	void Image::create_wrapper( int w, int h, ImageType type, void* buffer ) {
+		passert_statement( w*h>0, "will not create null image" );
+		passert_pointer( buffer );
+		release();
+		switch( image_precision(type) ) {
+		case TYPE_UCHAR  : m_data_u   = (uchar   *) buffer; break;
+		case TYPE_FLOAT  : m_data_f   = (float   *) buffer; break;
+		case TYPE_INT    : m_data_i   = (int     *) buffer; break;
+		case TYPE_UINT16 : m_data_u16 = (uint16_t*) buffer; break;
+		default          : switch_fatality();
+		}
+		m_w       = w;
+		m_h       = h;
+		m_type    = type;
+		m_ch      = image_no_channels( type );
+		m_channel_type = image_channel_type( type );
+		m_stride  = packed_stride( w, type );
+		m_plane   = m_stride * size_t(h);
+		m_wrapper = true;
+	}
+
+	void Image::create_wrapper( const Image& img, const Rect2i& roi ) {
+		passert_statement( &img != this, "cannot create a view of self" );
+		passert_statement_g( roi.lx >= 0 && roi.ly >= 0 && roi.lx < roi.ux && roi.ly < roi.uy &&
+							 roi.ux <= img.w() && roi.uy <= img.h(),
+							 "invalid region [%d %d]-[%d %d] for [%d %d]", roi.lx, roi.ly, roi.ux, roi.uy, img.w(), img.h() );
+		release();
+		size_t step = ( img.m_channel_type == ITC_IMAGE ) ? 1 : size_t(img.m_ch);
+		size_t sft  = size_t(roi.ly) * img.m_stride + size_t(roi.lx) * step;
+		switch( image_precision(img.m_type) ) {
+		case TYPE_UCHAR  : m_data_u   = img.m_data_u   + sft; break;
+		case TYPE_FLOAT  : m_data_f   = img.m_data_f   + sft; break;
+		case TYPE_INT    : m_data_i   = img.m_data_i   + sft; break;
+		case TYPE_UINT16 : m_data_u16 = img.m_data_u16 + sft; break;
+		default          : switch_fatality();
+		}
+		m_w            = roi.ux - roi.lx;
+		m_h            = roi.uy - roi.ly;
+		m_ch           = img.m_ch;
+		m_type         = img.m_type;
+		m_channel_type = img.m_channel_type;
+		m_stride       = img.m_stride;
+		m_plane        = img.m_plane;
+		m_wrapper      = true;
+	}
+
+	bool Image::is_contiguous() const {
+		return m_stride == packed_stride( m_w, m_type ) && m_plane == m_stride * size_t(m_h);
+	}
+
 	void Image::release() {
 		m_memory.deallocate();
 		init_();
@@ -97,7 +202,9 @@ namespace kortex {
 	}
 
 	size_t Image::mem_usage() const {
-		return req_mem( this );
+		if( is_empty() ) return req_mem( this );
+		int n_planes = ( m_channel_type == ITC_IMAGE ) ? m_ch : 1;
+		return m_stride * size_t(m_h) * size_t(n_planes) * get_data_byte_size( precision() ) + sizeof(Image);
 	}
 
 	void Image::convert( ImageType im_type ) {
@@ -115,6 +222,8 @@ namespace kortex {
 		std::swap( m_w            , img->m_w            );
 		std::swap( m_h            , img->m_h            );
 		std::swap( m_ch           , img->m_ch           );
+		std::swap( m_stride       , img->m_stride       );
+		std::swap( m_plane        , img->m_plane        );
 		std::swap( m_type         , img->m_type         );
 		std::swap( m_channel_type , img->m_channel_type );
 		std::swap( m_data_i       , img->m_data_i       );
@@ -128,6 +237,10 @@ namespace kortex {
 		passert_pointer( img );
 		passert_statement( img != this, "cannot copy self" );
 		create( img->w(), img->h(), img->type() );
+		if( !is_contiguous() || !img->is_contiguous() ) {
+			copy_from_region( img, 0, 0, m_w, m_h, 0, 0 );
+			return;
+		}
 		size_t imsz = size_t(m_w) * size_t(m_h) * size_t(m_ch);
 		switch( image_precision(m_type) ) {
 		case TYPE_UCHAR  : memcpy( m_data_u, img->m_data_u, sizeof(*m_data_u)* imsz ); break;
@@ -139,6 +252,23 @@ namespace kortex {
 	}
 
 	void Image::zero() {
+		if( !is_contiguous() ) {
+			int    n_planes = ( m_channel_type == ITC_IMAGE ) ? m_ch : 1;
+			size_t esz      = get_data_byte_size( precision() );
+			size_t row_sz   = packed_stride( m_w, m_type ) * esz;
+			uchar* data     = NULL;
+			switch( precision() ) {
+			case TYPE_UCHAR  : data = (uchar*)m_data_u;   break;
+			case TYPE_FLOAT  : data = (uchar*)m_data_f;   break;
+			case TYPE_INT    : data = (uchar*)m_data_i;   break;
+			case TYPE_UINT16 : data = (uchar*)m_data_u16; break;
+			default          : switch_fatality();
+			}
+			for( int c=0; c<n_planes; c++ )
+				for( int y=0; y<m_h; y++ )
+					memset( data + ( size_t(c)*m_plane + size_t(y)*m_stride ) * esz, 0, row_sz );
+			return;
+		}
 		size_t im_sz = size_t(m_w) * size_t(m_h) * size_t(m_ch);
 		switch( precision() ) {
 		case TYPE_UCHAR  : memset( m_data_u, 0, sizeof(*m_data_u)*im_sz ); break;
@@ -213,43 +343,43 @@ namespace kortex {
 	uchar      * Image::get_channel_u( int cid ) {
 		assert_type( IT_U_GRAY | IT_U_IRGB );
 		assert_boundary( cid, 0, m_ch );
-		size_t sft = size_t(cid) * size_t(m_h) * size_t(m_w);
+		size_t sft = size_t(cid) * m_plane;
 		return m_data_u + sft;
 	}
 	const uchar* Image::get_channel_u( int cid ) const {
 		assert_type( IT_U_GRAY | IT_U_IRGB );
 		assert_boundary( cid, 0, m_ch );
-		size_t sft = size_t(cid) * size_t(m_h) * size_t(m_w);
+		size_t sft = size_t(cid) * m_plane;
 		return m_data_u + sft;
 	}
 	float      * Image::get_channel_f( int cid ) {
 		assert_type( IT_F_GRAY | IT_F_IRGB );
 		assert_boundary( cid, 0, m_ch );
-		size_t sft = size_t(cid) * size_t(m_h) * size_t(m_w);
+		size_t sft = size_t(cid) * m_plane;
 		return m_data_f + sft;
 	}
 	const float* Image::get_channel_f( int cid ) const {
 		assert_type( IT_F_GRAY | IT_F_IRGB );
 		assert_boundary( cid, 0, m_ch );
-		size_t sft = size_t(cid) * size_t(m_h) * size_t(m_w);
+		size_t sft = size_t(cid) * m_plane;
 		return m_data_f + sft;
 	}
 	int        * Image::get_channel_i( int cid ) {
 		assert_type( IT_I_GRAY );
 		assert_boundary( cid, 0, m_ch );
-		size_t sft = size_t(cid) * size_t(m_h) * size_t(m_w);
+		size_t sft = size_t(cid) * m_plane;
 		return m_data_i + sft;
 	}
 	const int  * Image::get_channel_i( int cid ) const {
 		assert_type( IT_I_GRAY );
 		assert_boundary( cid, 0, m_ch );
-		size_t sft = size_t(cid) * size_t(m_h) * size_t(m_w);
+		size_t sft = size_t(cid) * m_plane;
 		return m_data_i + sft;
 	}
 	const uint16_t* Image::get_channel_u16( int cid ) const {
 		assert_type( IT_J_GRAY );
 		assert_boundary( cid, 0, m_ch );
-		size_t sft = size_t(cid) * size_t(m_h) * size_t(m_w);
+		size_t sft = size_t(cid) * m_plane;
 		return m_data_u16 + sft;
 	}
 
@@ -259,74 +389,74 @@ namespace kortex {
 	int* Image::get_row_i ( int y0 ) { // use for int gray
 		assert_type( IT_I_GRAY );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = size_t(y0) * size_t(m_w) * size_t(m_ch);
+		size_t sft = size_t(y0) * m_stride;
 		return m_data_i + sft;
 	}
 	uint16_t* Image::get_row_u16( int y0 ) { // use for int gray
 		assert_type( IT_J_GRAY );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = size_t(y0) * size_t(m_w) * size_t(m_ch);
+		size_t sft = size_t(y0) * m_stride;
 		return m_data_u16 + sft;
 	}
 	uchar* Image::get_row_u ( int y0 ) { // use for u gray, prgb
 		assert_type( IT_U_GRAY | IT_U_PRGB | IT_U_PRGBA );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = size_t(y0) * size_t(m_w) * size_t(m_ch);
+		size_t sft = size_t(y0) * m_stride;
 		return m_data_u + sft;
 	}
 	float* Image::get_row_f ( int y0 ) { // use for f gray, prgb
 		assert_type( IT_F_GRAY | IT_F_PRGB );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = size_t(y0) * size_t(m_w) * size_t(m_ch);
+		size_t sft = size_t(y0) * m_stride;
 		return m_data_f + sft;
 	}
 	uchar* Image::get_row_ui( int y0, int cid ) { // cid'th channel y0'th row
 		assert_type( IT_U_IRGB | IT_U_GRAY );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = ( size_t(cid) * size_t(m_h) + size_t(y0) ) * size_t(m_w);
+		size_t sft = size_t(cid) * m_plane + size_t(y0) * m_stride;
 		return m_data_u + sft;
 	}
 	float* Image::get_row_fi( int y0, int cid ) { // cid'th channel y0'th row
 		assert_type( IT_F_IRGB | IT_F_GRAY );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = ( size_t(cid) * size_t(m_h) + size_t(y0) ) * size_t(m_w);
+		size_t sft = size_t(cid) * m_plane + size_t(y0) * m_stride;
 		return m_data_f + sft;
 	}
 
 	const int* Image::get_row_i ( int y0 ) const { // use for u gray, prgb
 		assert_type( IT_I_GRAY );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = size_t(y0) * size_t(m_w) * size_t(m_ch);
+		size_t sft = size_t(y0) * m_stride;
 		return m_data_i + sft;
 	}
 	const uint16_t* Image::get_row_u16( int y0 ) const { // use for u gray, prgb
 		assert_type( IT_J_GRAY );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = size_t(y0) * size_t(m_w) * size_t(m_ch);
+		size_t sft = size_t(y0) * m_stride;
 		return m_data_u16 + sft;
 	}
 	const uchar* Image::get_row_u ( int y0 ) const { // use for u gray, prgb
 		assert_type( IT_U_GRAY | IT_U_PRGB );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = size_t(y0) * size_t(m_w) * size_t(m_ch);
+		size_t sft = size_t(y0) * m_stride;
 		return m_data_u + sft;
 	}
 	const float* Image::get_row_f ( int y0 ) const { // use for f gray, prgb
 		assert_type( IT_F_GRAY | IT_F_PRGB );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = size_t(y0) * size_t(m_w) * size_t(m_ch);
+		size_t sft = size_t(y0) * m_stride;
 		return m_data_f + sft;
 	}
 	const uchar* Image::get_row_ui( int y0, int cid ) const { // cid'th channel y0'th row
 		assert_type( IT_U_IRGB | IT_U_GRAY );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = ( size_t(cid) * size_t(m_h) + size_t(y0) ) * size_t(m_w);
+		size_t sft = size_t(cid) * m_plane + size_t(y0) * m_stride;
 		return m_data_u + sft;
 	}
 	const float* Image::get_row_fi( int y0, int cid ) const { // cid'th channel y0'th row
 		assert_type( IT_F_IRGB | IT_F_GRAY );
 		assert_statement_g( kortex::is_inside(y0,0,m_h), "[y0 %d] oob", y0 );
-		size_t sft = ( size_t(cid) * size_t(m_h) + size_t(y0) ) * size_t(m_w);
+		size_t sft = size_t(cid) * m_plane + size_t(y0) * m_stride;
 		return m_data_f + sft;
 	}
 
@@ -334,25 +464,25 @@ namespace kortex {
 	float& Image::getf( int x0, int y0 ) {
 		assert_type  ( IT_F_GRAY );
 		assert_statement_g(is_inside(x0,y0), "[x %d] [y %d] oob", x0, y0);
-		size_t p = size_t(y0) * size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		return m_data_f[ p ];
 	}
 	uchar& Image::getu( int x0, int y0 ) {
 		assert_type  ( IT_U_GRAY );
 		assert_statement_g(is_inside(x0,y0), "[x %d] [y %d] oob", x0, y0);
-		size_t p = size_t(y0) * size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		return m_data_u[ p ];
 	}
 	int&  Image::geti( int x0, int y0 ) {
 		assert_type  ( IT_I_GRAY );
 		assert_statement_g(is_inside(x0,y0), "[x %d] [y %d] oob", x0, y0);
-		size_t p = size_t(y0) * size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		return m_data_i[ p ];
 	}
 	uint16_t& Image::getu16( int x0, int y0 ) {
 		assert_type  ( IT_J_GRAY );
 		assert_statement_g(is_inside(x0,y0), "[x %d] [y %d] oob", x0, y0);
-		size_t p = size_t(y0) * size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		return m_data_u16[ p ];
 	}
 
@@ -360,31 +490,31 @@ namespace kortex {
 	const float& Image::getf( int x0, int y0 ) const {
 		assert_type  ( IT_F_GRAY );
 		assert_statement_g(is_inside(x0,y0), "[x %d] [y %d] oob", x0, y0);
-		size_t p = size_t(y0) * size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		return m_data_f[ p ];
 	}
 	const uchar& Image::getu( int x0, int y0 ) const {
 		assert_type  ( IT_U_GRAY );
 		assert_statement_g(is_inside(x0,y0), "[x %d] [y %d] oob", x0, y0);
-		size_t p = size_t(y0) * size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		return m_data_u[ p ];
 	}
 	const int&  Image::geti( int x0, int y0 ) const {
 		assert_type  ( IT_I_GRAY );
 		assert_statement_g(is_inside(x0,y0), "[x %d] [y %d] oob", x0, y0);
-		size_t p = size_t(y0) * size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		return m_data_i[ p ];
 	}
 	const uint16_t& Image::getu16( int x0, int y0 ) const {
 		assert_type  ( IT_J_GRAY );
 		assert_statement_g(is_inside(x0,y0), "[x %d] [y %d] oob", x0, y0);
-		size_t p = size_t(y0) * size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		return m_data_u16[ p ];
 	}
 
 	float Image::get( int x0, int y0 ) const {
 		assert_type( IT_U_GRAY | IT_F_GRAY );
-		size_t p = size_t(y0) * size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		switch( m_type ) {
 		case IT_U_GRAY: return static_cast<float>(m_data_u[p]); break;
 		case IT_F_GRAY: return m_data_f[p]; break;
@@ -410,21 +540,21 @@ namespace kortex {
 	}
 	float Image::get_bilinear_u( const float& x0, const float& y0 ) const {
 		assert_type  ( IT_U_GRAY );
-		return bilinear_interpolation( m_data_u, m_w, m_h, 1, 0, x0, y0 );
+		return bilinear_interpolation( m_data_u, m_w, m_h, 1, m_stride, 0, x0, y0 );
 	}
 	float Image::get_bilinear_f( const float& x0, const float& y0 ) const {
 		assert_type  ( IT_F_GRAY );
-		return bilinear_interpolation( m_data_f, m_w, m_h, 1, 0, x0, y0 );
+		return bilinear_interpolation( m_data_f, m_w, m_h, 1, m_stride, 0, x0, y0 );
 	}
 	float Image::get_bicubic_u( const float& x0, const float& y0 ) const {
 		assert_type  ( IT_U_GRAY );
 		assert_statement_g(is_inside_margin(x0,y0,2), "[x %f] [y %f] oob", x0, y0);
-		return bicubic_interpolation( m_data_u, m_w, m_h, 1, 0, x0, y0 );
+		return bicubic_interpolation( m_data_u, m_w, m_h, 1, m_stride, 0, x0, y0 );
 	}
 	float Image::get_bicubic_f( const float& x0, const float& y0 ) const {
 		assert_type  ( IT_F_GRAY );
 		assert_statement_g(is_inside_margin(x0,y0,2), "[x %f] [y %f] oob", x0, y0);
-		return bicubic_interpolation( m_data_f, m_w, m_h, 1, 0, x0, y0 );
+		return bicubic_interpolation( m_data_f, m_w, m_h, 1, m_stride, 0, x0, y0 );
 	}
 
 	void Image::get( int x0, int y0, uchar& r, uchar& g, uchar& b ) const {
@@ -437,16 +567,16 @@ namespace kortex {
 		r = g = b = 0;
 		switch( m_channel_type ) {
 		case ITC_PIXEL:
-			shft = size_t(y0) * size_t(m_w) * size_t(m_ch) + size_t(x0*m_ch);
+			shft = size_t(y0) * m_stride + size_t(x0*m_ch);
 			r = m_data_u[ shft   ];
 			g = m_data_u[ shft+1 ];
 			b = m_data_u[ shft+2 ];
 			break;
 		case ITC_IMAGE:
-			shft = size_t(y0)*size_t(m_w)+size_t(x0);
+			shft = size_t(y0) * m_stride + size_t(x0);
 			r = m_data_u[ shft             ];
-			g = m_data_u[ shft + m_w*m_h   ];
-			b = m_data_u[ shft + m_w*m_h*2 ];
+			g = m_data_u[ shft + m_plane   ];
+			b = m_data_u[ shft + m_plane*2 ];
 			break;
 		default: switch_fatality();
 		}
@@ -462,18 +592,18 @@ namespace kortex {
 		r = g = b = 0;
 		switch( m_channel_type ) {
 		case ITC_PIXEL:
-			shft = size_t(y0) * size_t(m_w) * size_t(m_ch) + size_t(x0*m_ch);
+			shft = size_t(y0) * m_stride + size_t(x0*m_ch);
 			r = m_data_u[ shft   ];
 			g = m_data_u[ shft+1 ];
 			b = m_data_u[ shft+2 ];
 			a = m_data_u[ shft+3 ];
 			break;
 		case ITC_IMAGE:
-			shft = size_t(y0)*size_t(m_w)+size_t(x0);
+			shft = size_t(y0) * m_stride + size_t(x0);
 			r = m_data_u[ shft             ];
-			g = m_data_u[ shft + m_w*m_h   ];
-			b = m_data_u[ shft + m_w*m_h*2 ];
-			a = m_data_u[ shft + m_w*m_h*3 ];
+			g = m_data_u[ shft + m_plane   ];
+			b = m_data_u[ shft + m_plane*2 ];
+			a = m_data_u[ shft + m_plane*3 ];
 			break;
 		default: switch_fatality();
 		}
@@ -488,16 +618,16 @@ namespace kortex {
 		r = g = b = 0.0f;
 		switch( m_channel_type ) {
 		case ITC_PIXEL:
-			shft = size_t(y0) * size_t(m_w) * size_t(m_ch) + size_t(x0*m_ch);
+			shft = size_t(y0) * m_stride + size_t(x0*m_ch);
 			r = m_data_f[ shft   ];
 			g = m_data_f[ shft+1 ];
 			b = m_data_f[ shft+2 ];
 			break;
 		case ITC_IMAGE:
-			shft = size_t(y0)*size_t(m_w)+size_t(x0);
+			shft = size_t(y0) * m_stride + size_t(x0);
 			r = m_data_f[ shft             ];
-			g = m_data_f[ shft + m_w*m_h   ];
-			b = m_data_f[ shft + m_w*m_h*2 ];
+			g = m_data_f[ shft + m_plane   ];
+			b = m_data_f[ shft + m_plane*2 ];
 			break;
 		default: switch_fatality();
 		}
@@ -516,35 +646,35 @@ namespace kortex {
 		assert_type( IT_U_PRGB );
 		passert_statement_g( x0>=0 && x0<=m_w-1, "pixel oob [%f %f]", x0, y0 );
 		passert_statement_g( y0>=0 && y0<=m_h-1, "pixel oob [%f %f]", x0, y0 );
-		r = bilinear_interpolation( m_data_u, m_w, m_h, m_ch, 0, x0, y0 );
-		g = bilinear_interpolation( m_data_u, m_w, m_h, m_ch, 1, x0, y0 );
-		b = bilinear_interpolation( m_data_u, m_w, m_h, m_ch, 2, x0, y0 );
+		r = bilinear_interpolation( m_data_u, m_w, m_h, m_ch, m_stride, 0, x0, y0 );
+		g = bilinear_interpolation( m_data_u, m_w, m_h, m_ch, m_stride, 1, x0, y0 );
+		b = bilinear_interpolation( m_data_u, m_w, m_h, m_ch, m_stride, 2, x0, y0 );
 	}
 	void Image::get_bilinear_ui( const float& x0, const float& y0, float& r, float& g, float& b ) const {
 		assert_type( IT_U_IRGB );
 		passert_statement_g( x0>=0 && x0<=m_w-1, "pixel oob [%f %f]", x0, y0 );
 		passert_statement_g( y0>=0 && y0<=m_h-1, "pixel oob [%f %f]", x0, y0 );
 		const uchar* channel = NULL;
-		channel = get_channel_u(0); r = bilinear_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
-		channel = get_channel_u(1); g = bilinear_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
-		channel = get_channel_u(2); b = bilinear_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
+		channel = get_channel_u(0); r = bilinear_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
+		channel = get_channel_u(1); g = bilinear_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
+		channel = get_channel_u(2); b = bilinear_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
 	}
 	void Image::get_bilinear_fp( const float& x0, const float& y0, float& r, float& g, float& b ) const {
 		assert_type( IT_F_PRGB );
 		passert_statement_g( x0>=0 && x0<=m_w-1, "pixel oob [%f %f]", x0, y0 );
 		passert_statement_g( y0>=0 && y0<=m_h-1, "pixel oob [%f %f]", x0, y0 );
-		r = bilinear_interpolation( m_data_f, m_w, m_h, 3, 0, x0, y0 );
-		g = bilinear_interpolation( m_data_f, m_w, m_h, 3, 1, x0, y0 );
-		b = bilinear_interpolation( m_data_f, m_w, m_h, 3, 2, x0, y0 );
+		r = bilinear_interpolation( m_data_f, m_w, m_h, 3, m_stride, 0, x0, y0 );
+		g = bilinear_interpolation( m_data_f, m_w, m_h, 3, m_stride, 1, x0, y0 );
+		b = bilinear_interpolation( m_data_f, m_w, m_h, 3, m_stride, 2, x0, y0 );
 	}
 	void Image::get_bilinear_fi( const float& x0, const float& y0, float& r, float& g, float& b ) const {
 		assert_type( IT_F_IRGB );
 		passert_statement_g( x0>=0 && x0<=m_w-1, "pixel oob [%f %f]", x0, y0 );
 		passert_statement_g( y0>=0 && y0<=m_h-1, "pixel oob [%f %f]", x0, y0 );
 		const float* channel = NULL;
-		channel = get_channel_f(0); r = bilinear_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
-		channel = get_channel_f(1); g = bilinear_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
-		channel = get_channel_f(2); b = bilinear_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
+		channel = get_channel_f(0); r = bilinear_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
+		channel = get_channel_f(1); g = bilinear_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
+		channel = get_channel_f(2); b = bilinear_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
 	}
 
 	void Image::get_bicubic   (const float& x0, const float& y0, float& r, float& g, float& b) const {
@@ -559,32 +689,76 @@ namespace kortex {
 	void Image::get_bicubic_up( const float& x0, const float& y0, float& r, float& g, float& b ) const {
 		assert_type( IT_U_PRGB );
 		passert_statement( is_inside_margin(x0,y0,2), "pixel oob" );
-		r = bicubic_interpolation( m_data_u, m_w, m_h, m_ch, 0, x0, y0 );
-		g = bicubic_interpolation( m_data_u, m_w, m_h, m_ch, 1, x0, y0 );
-		b = bicubic_interpolation( m_data_u, m_w, m_h, m_ch, 2, x0, y0 );
+		r = bicubic_interpolation( m_data_u, m_w, m_h, m_ch, m_stride, 0, x0, y0 );
+		g = bicubic_interpolation( m_data_u, m_w, m_h, m_ch, m_stride, 1, x0, y0 );
+		b = bicubic_interpolation( m_data_u, m_w, m_h, m_ch, m_stride, 2, x0, y0 );
 	}
 	void Image::get_bicubic_ui( const float& x0, const float& y0, float& r, float& g, float& b ) const {
 		assert_type( IT_U_IRGB );
 		passert_statement( is_inside_margin(x0,y0,2), "pixel oob" );
 		const uchar* channel = NULL;
-		channel = get_channel_u(0); r = bicubic_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
-		channel = get_channel_u(1); g = bicubic_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
-		channel = get_channel_u(2); b = bicubic_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
+		channel = get_channel_u(0); r = bicubic_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
+		channel = get_channel_u(1); g = bicubic_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
+		channel = get_channel_u(2); b = bicubic_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
 	}
 	void Image::get_bicubic_fp( const float& x0, const float& y0, float& r, float& g, float& b ) const {
 		assert_type( IT_F_PRGB );
 		passert_statement( is_inside_margin(x0,y0,2), "pixel oob" );
-		r = bicubic_interpolation( m_data_f, m_w, m_h, 3, 0, x0, y0 );
-		g = bicubic_interpolation( m_data_f, m_w, m_h, 3, 1, x0, y0 );
-		b = bicubic_interpolation( m_data_f, m_w, m_h, 3, 2, x0, y0 );
+		r = bicubic_interpolation( m_data_f, m_w, m_h, 3, m_stride, 0, x0, y0 );
+		g = bicubic_interpolation( m_data_f, m_w, m_h, 3, m_stride, 1, x0, y0 );
+		b = bicubic_interpolation( m_data_f, m_w, m_h, 3, m_stride, 2, x0, y0 );
 	}
 	void Image::get_bicubic_fi( const float& x0, const float& y0, float& r, float& g, float& b ) const {
 		assert_type( IT_F_IRGB );
 		passert_statement( is_inside_margin(x0,y0,2), "pixel oob" );
 		const float* channel = NULL;
-		channel = get_channel_f(0); r = bicubic_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
-		channel = get_channel_f(1); g = bicubic_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
-		channel = get_channel_f(2); b = bicubic_interpolation( channel, m_w, m_h, 1, 0, x0, y0 );
+		channel = get_channel_f(0); r = bicubic_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
+		channel = get_channel_f(1); g = bicubic_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
+		channel = get_channel_f(2); b = bicubic_interpolation( channel, m_w, m_h, 1, m_stride, 0, x0, y0 );
+	}
+
+	/// image-ordered channels are sampled plane by plane in chunks and
+	/// interleaved
+	template<typename T>
+	static void sample_planes( const T* img, const int& w, const int& h, const size_t& stride, const size_t& plane,
+							   const bool& bicubic, const float* xs, const float* ys, const int& n, float* out ) {
+		const int chunk = 256;
+		float tmp[chunk];
+		for( int i=0; i<n; i+=chunk ) {
+			int m = std::min( chunk, n-i );
+			for( int c=0; c<3; c++ ) {
+				if( bicubic ) sample_bicubic ( img+c*plane, w, h, 1, stride, xs+i, ys+i, m, tmp );
+				else          sample_bilinear( img+c*plane, w, h, 1, stride, xs+i, ys+i, m, tmp );
+				for( int k=0; k<m; k++ )
+					out[ size_t(i+k)*3+c ] = tmp[k];
+			}
+		}
+	}
+
+	void Image::get_bilinear( const float* xs, const float* ys, const int& n, float* out ) const {
+		passert_pointer( xs && ys && out );
+		switch( m_type ) {
+		case IT_U_GRAY:
+		case IT_U_PRGB: sample_bilinear( m_data_u, m_w, m_h, m_ch, m_stride, xs, ys, n, out ); break;
+		case IT_F_GRAY:
+		case IT_F_PRGB: sample_bilinear( m_data_f, m_w, m_h, m_ch, m_stride, xs, ys, n, out ); break;
+		case IT_U_IRGB: sample_planes  ( m_data_u, m_w, m_h, m_stride, m_plane, false, xs, ys, n, out ); break;
+		case IT_F_IRGB: sample_planes  ( m_data_f, m_w, m_h, m_stride, m_plane, false, xs, ys, n, out ); break;
+		default       : logman_fatal("invalid type for this function"); break;
+		}
+	}
+
+	void Image::get_bicubic( const float* xs, const float* ys, const int& n, float* out ) const {
+		passert_pointer( xs && ys && out );
+		switch( m_type ) {
+		case IT_U_GRAY:
+		case IT_U_PRGB: sample_bicubic( m_data_u, m_w, m_h, m_ch, m_stride, xs, ys, n, out ); break;
+		case IT_F_GRAY:
+		case IT_F_PRGB: sample_bicubic( m_data_f, m_w, m_h, m_ch, m_stride, xs, ys, n, out ); break;
+		case IT_U_IRGB: sample_planes ( m_data_u, m_w, m_h, m_stride, m_plane, true, xs, ys, n, out ); break;
+		case IT_F_IRGB: sample_planes ( m_data_f, m_w, m_h, m_stride, m_plane, true, xs, ys, n, out ); break;
+		default       : logman_fatal("invalid type for this function"); break;
+		}
 	}
 
 	float Image::get_min_neighbour_f( const int& x0, const int& y0, int rsz ) const {
@@ -622,7 +796,7 @@ namespace kortex {
 	void Image::add( const int& x0, const int& y0, const float& v ) {
 		assert_type( IT_F_GRAY );
 		assert_statement_g( is_inside(x0,y0), "xy %d %d oob", x0, y0 );
-		size_t p = size_t(y0)*size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		m_data_f[ p ] += v;
 	}
 
@@ -641,7 +815,7 @@ namespace kortex {
 	void Image::inc( const int& x0, const int& y0 ) {
 		assert_type( IT_U_GRAY );
 		assert_statement_g( is_inside(x0,y0), "xy %d %d oob", x0, y0 );
-		size_t pidx = size_t(y0)*size_t(m_w) + size_t(x0);
+		size_t pidx = size_t(y0) * m_stride + size_t(x0);
 		if( m_data_u[pidx] < UINT8_MAX-1 )
 			m_data_u[pidx]++;
 	}
@@ -649,7 +823,7 @@ namespace kortex {
 	void Image::dec( const int& x0, const int& y0 ) {
 		assert_type( IT_U_GRAY );
 		assert_statement_g( is_inside(x0,y0), "xy %d %d oob", x0, y0 );
-		size_t pidx = size_t(y0)*size_t(m_w) + size_t(x0);
+		size_t pidx = size_t(y0) * m_stride + size_t(x0);
 		if( m_data_u[pidx] > 0 )
 			m_data_u[pidx]--;
 	}
@@ -661,16 +835,16 @@ namespace kortex {
 		size_t shft = 0;
 		switch( m_channel_type ) {
 		case ITC_PIXEL:
-			shft = ( size_t(y0)*size_t(m_w) + size_t(x0) ) * size_t(m_ch);
+			shft = size_t(y0) * m_stride + size_t(x0)*size_t(m_ch);
 			m_data_f[ shft   ] += r;
 			m_data_f[ shft+1 ] += g;
 			m_data_f[ shft+2 ] += b;
 			break;
 		case ITC_IMAGE:
-			shft = size_t(y0)*size_t(m_w) + size_t(x0);
+			shft = size_t(y0) * m_stride + size_t(x0);
 			m_data_f[ shft             ] += r;
-			m_data_f[ shft + size_t(m_w)*size_t(m_h)   ] += g;
-			m_data_f[ shft + size_t(m_w)*size_t(m_h)*2 ] += b;
+			m_data_f[ shft + m_plane   ] += g;
+			m_data_f[ shft + m_plane*2 ] += b;
 			break;
 		default: switch_fatality();
 		}
@@ -682,25 +856,25 @@ namespace kortex {
 	void Image::set ( const int& x0, const int& y0, const float& v ) {
 		assert_type( IT_F_GRAY );
 		assert_statement_g( is_inside(x0,y0), "[x0 %d] [y0 %d] oob", x0, y0 );
-		size_t p = size_t(y0)*size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		m_data_f[p] = v;
 	}
 	void Image::set ( const int& x0, const int& y0, const uchar& v ) {
 		assert_type( IT_U_GRAY );
 		assert_statement_g( is_inside(x0,y0), "[x0 %d] [y0 %d] oob", x0, y0 );
-		size_t p = size_t(y0)*size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		m_data_u[p] = v;
 	}
 	void Image::set ( const int& x0, const int& y0, const int  & v ) {
 		assert_type( IT_I_GRAY );
 		assert_statement_g( is_inside(x0,y0), "[x0 %d] [y0 %d] oob", x0, y0 );
-		size_t p = size_t(y0)*size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		m_data_i[p] = v;
 	}
 	void Image::set ( const int& x0, const int& y0, const uint16_t  & v ) {
 		assert_type( IT_J_GRAY );
 		assert_statement_g( is_inside(x0,y0), "[x0 %d] [y0 %d] oob", x0, y0 );
-		size_t p = size_t(y0)*size_t(m_w) + size_t(x0);
+		size_t p = size_t(y0) * m_stride + size_t(x0);
 		m_data_u16[p] = v;
 	}
 
@@ -764,16 +938,16 @@ namespace kortex {
 		size_t shft = 0;
 		switch( m_channel_type ) {
 		case ITC_PIXEL:
-			shft = (size_t(y0)*size_t(m_w) + size_t(x0))*size_t(m_ch);
+			shft = size_t(y0) * m_stride + size_t(x0)*size_t(m_ch);
 			m_data_u[ shft   ] = r;
 			m_data_u[ shft+1 ] = g;
 			m_data_u[ shft+2 ] = b;
 			break;
 		case ITC_IMAGE:
-			shft = size_t(y0)*size_t(m_w) + size_t(x0);
+			shft = size_t(y0) * m_stride + size_t(x0);
 			m_data_u[ shft             ] = r;
-			m_data_u[ shft + size_t(m_w)*size_t(m_h)   ] = g;
-			m_data_u[ shft + size_t(m_w)*size_t(m_h)*2 ] = b;
+			m_data_u[ shft + m_plane   ] = g;
+			m_data_u[ shft + m_plane*2 ] = b;
 			break;
 		default: switch_fatality();
 		}
@@ -784,16 +958,16 @@ namespace kortex {
 		size_t shft = 0;
 		switch( m_channel_type ) {
 		case ITC_PIXEL:
-			shft = (size_t(y0)*size_t(m_w) + size_t(x0))*size_t(m_ch);
+			shft = size_t(y0) * m_stride + size_t(x0)*size_t(m_ch);
 			m_data_f[ shft   ] = r;
 			m_data_f[ shft+1 ] = g;
 			m_data_f[ shft+2 ] = b;
 			break;
 		case ITC_IMAGE:
-			shft = size_t(y0)*size_t(m_w) + size_t(x0);
+			shft = size_t(y0) * m_stride + size_t(x0);
 			m_data_f[ shft             ] = r;
-			m_data_f[ shft + size_t(m_w)*size_t(m_h)   ] = g;
-			m_data_f[ shft + size_t(m_w)*size_t(m_h)*2 ] = b;
+			m_data_f[ shft + m_plane   ] = g;
+			m_data_f[ shft + m_plane*2 ] = b;
 			break;
 		default: switch_fatality();
 		}
@@ -806,7 +980,7 @@ namespace kortex {
 		size_t shft = 0;
 		switch( m_channel_type ) {
 		case ITC_PIXEL:
-			shft = (size_t(y0)*size_t(m_w) + size_t(x0))*size_t(m_ch);
+			shft = size_t(y0) * m_stride + size_t(x0)*size_t(m_ch);
 			m_data_u[ shft   ] = r;
 			m_data_u[ shft+1 ] = g;
 			m_data_u[ shft+2 ] = b;
@@ -853,6 +1027,11 @@ namespace kortex {
 	}
 
 	void Image::save( ofstream& fout ) const {
+		if( !is_contiguous() ) {
+			Image packed( *this );
+			packed.save( fout );
+			return;
+		}
 		insert_binary_stream_begin_tag( fout );
 		write_bparam( fout, m_w );
 		write_bparam( fout, m_h );
@@ -1014,17 +1193,19 @@ namespace kortex {
 		img->m_w = m_w;
 		img->m_h = m_h;
 		img->m_ch = 1;
+		img->m_stride = m_stride;
+		img->m_plane  = m_plane;
 		img->m_channel_type = ITC_IMAGE;
 		img->m_wrapper = true;
 		switch( precision() ) {
 		case TYPE_UCHAR:
 			img->m_type = IT_U_GRAY;
-			img->m_data_u = m_data_u + size_t(cid) * size_t(m_w) * size_t(m_h);
+			img->m_data_u = m_data_u + size_t(cid) * m_plane;
 			img->m_data_f = NULL;
 			break;
 		case TYPE_FLOAT:
 			img->m_type = IT_F_GRAY;
-			img->m_data_f = m_data_f + size_t(cid) * size_t(m_w) * size_t(m_h);
+			img->m_data_f = m_data_f + size_t(cid) * m_plane;
 			img->m_data_u = NULL;
 			break;
 		default: switch_fatality();
@@ -1037,17 +1218,19 @@ namespace kortex {
 		img->m_w = m_w;
 		img->m_h = m_h;
 		img->m_ch = 1;
+		img->m_stride = m_stride;
+		img->m_plane  = m_plane;
 		img->m_channel_type = ITC_IMAGE;
 		img->m_wrapper = true;
 		switch( precision() ) {
 		case TYPE_UCHAR:
 			img->m_type = IT_U_GRAY;
-			img->m_data_u = m_data_u + size_t(cid) * size_t(m_w) * size_t(m_h);
+			img->m_data_u = m_data_u + size_t(cid) * m_plane;
 			img->m_data_f = NULL;
 			break;
 		case TYPE_FLOAT:
 			img->m_type = IT_F_GRAY;
-			img->m_data_f = m_data_f + size_t(cid) * size_t(m_w) * size_t(m_h);
+			img->m_data_f = m_data_f + size_t(cid) * m_plane;
 			img->m_data_u = NULL;
 			break;
 		default: switch_fatality();
@@ -1067,9 +1250,9 @@ namespace kortex {
 		assert_type( IT_F_GRAY );
 		passert_boundary( x0, 0, m_w );
 		const float* col = m_data_f + x0;
-		if     ( y0 >= m_h-1 ) return 2.0f * ( col[  size_t(m_h-2)*size_t(m_w) ] - col[ size_t(m_h-1)*size_t(m_w) ] );
-		else if( y0 <= 0     ) return 2.0f * ( col[           0 ] - col[         m_w ] );
-		else                   return        ( col[  size_t(y0-1)*size_t(m_w) ] - col[  size_t(y0+1)*size_t(m_w) ] );
+		if     ( y0 >= m_h-1 ) return 2.0f * ( col[  size_t(m_h-2)*m_stride ] - col[ size_t(m_h-1)*m_stride ] );
+		else if( y0 <= 0     ) return 2.0f * ( col[           0 ] - col[    m_stride ] );
+		else                   return        ( col[  size_t(y0-1)*m_stride ] - col[  size_t(y0+1)*m_stride ] );
 	}
 
 	bool Image::is_non_zero( const int& x0, const int& y0, const int& rsz ) const {
@@ -1192,6 +1375,8 @@ namespace kortex {
 		assert_statement_g( x1>0 && y1>0, "invalid region [sp %d %d] [ep %d %d]", x0, y1, x1, y1 );
 		int px = x1-x0;
 		int py = y1-y0;
+		if( patch.is_wrapper() )
+			patch.release();
 		patch.create( px, py, img.type() );
 		patch.zero();
 
@@ -1212,6 +1397,15 @@ namespace kortex {
 		patch.copy_from_region( &img, sx0, sy0, sx1-sx0, sy1-sy0, dx, dy );
 	}
 
+	void extract_region_view( const Image& img, int x0, int y0, int x1, int y1, Image& patch ) {
+		if( x0 < 0 || y0 < 0 || x1 > img.w() || y1 > img.h() ) {
+			extract_region_patch( img, x0, y0, x1, y1, patch );
+			return;
+		}
+		assert_statement_g( x0<x1 && y0<y1, "[sp %d %d] [ep %d %d]", x0, y0, x1, y1 );
+		patch.create_wrapper( img, Rect2i( x0, x1, y0, y1 ) );
+	}
+
 	void extract_centered_patch( const Image& img, int x0, int y0, int pw, int ph, Image& patch ) {
 		int x1 = x0 + pw/2;
 		int y1 = y0 + ph/2;
@@ -24,6 +24,11 @@ namespace kortex {
 
     void save_binary( const string& file, const Image* img ) {
         passert_pointer( img );
+        if( !img->is_contiguous() ) {
+            Image packed( *img );
+            save_binary( file, &packed );
+            return;
+        }
         ofstream fout;
         open_or_fail( file, fout, true );
         insert_binary_stream_begin_tag( fout );
@@ -56,6 +61,7 @@ namespace kortex {
         read_bparam( fin, ch );
         read_bparam( fin, type );
         img->create( w, h, get_image_type(type) );
+        img->passert_contiguous();
         size_t imsz = img->element_count();
         switch( img->type() ) {
         case IT_U_GRAY: read_barray( fin, img->get_row_u (0  ), imsz ); break;
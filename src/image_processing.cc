@@ -35,6 +35,10 @@ namespace kortex {
     template float bilinear_interpolation(const float* img, const int& w, const int& h, const int& nc, const int& c,  const float& x, const float& y);
     template float  bicubic_interpolation(const uchar* im,  const int& w, const int& h, const int& nc, const int& ch, const float& x, const float& y);
     template float  bicubic_interpolation(const float* im,  const int& w, const int& h, const int& nc, const int& ch, const float& x, const float& y);
+    template float bilinear_interpolation(const uchar* img, const int& w, const int& h, const int& nc, const size_t& stride, const int& c,  const float& x, const float& y);
+    template float bilinear_interpolation(const float* img, const int& w, const int& h, const int& nc, const size_t& stride, const int& c,  const float& x, const float& y);
+    template float  bicubic_interpolation(const uchar* im,  const int& w, const int& h, const int& nc, const size_t& stride, const int& ch, const float& x, const float& y);
+    template float  bicubic_interpolation(const float* im,  const int& w, const int& h, const int& nc, const size_t& stride, const int& ch, const float& x, const float& y);
 
     bool image_min_max( const Image& img,
                         const int& xmin, const int& ymin,
@@ -146,7 +150,8 @@ namespace kortex {
 
         switch( img.type() ) {
         case IT_F_GRAY:
-            filter_hv( img.get_row_f(0), img.w(), img.h(), kernel, ksz, out.get_row_f(0) );
+            filter_hv( img.get_row_f(0), img.w(), img.h(), img.stride(), kernel, ksz,
+                       out.get_row_f(0), out.stride() );
             break;
         case IT_F_IRGB: {
             for( int c=0; c<3; c++ ) {
@@ -173,7 +178,8 @@ namespace kortex {
 
         switch( img.type() ) {
         case IT_F_GRAY:
-            filter_hor( img.get_row_f(0), img.w(), img.h(), kernel, ksz, out.get_row_f(0) );
+            filter_hor( img.get_row_f(0), img.w(), img.h(), img.stride(), kernel, ksz,
+                        out.get_row_f(0), out.stride() );
             break;
         case IT_F_IRGB: {
             for( int c=0; c<3; c++ ) {
@@ -201,7 +207,8 @@ namespace kortex {
 
         switch( img.type() ) {
         case IT_F_GRAY:
-            filter_hor_par( img.get_row_f(0), img.w(), img.h(), kernel, ksz, out.get_row_f(0) );
+            filter_hor_par( img.get_row_f(0), img.w(), img.h(), img.stride(), kernel, ksz,
+                            out.get_row_f(0), out.stride() );
             break;
         case IT_F_IRGB: {
             for( int c=0; c<3; c++ ) {
@@ -228,7 +235,8 @@ namespace kortex {
 
         switch( img.type() ) {
         case IT_F_GRAY:
-            filter_ver( img.get_row_f(0), img.w(), img.h(), kernel, ksz, out.get_row_f(0) );
+            filter_ver( img.get_row_f(0), img.w(), img.h(), img.stride(), kernel, ksz,
+                        out.get_row_f(0), out.stride() );
             break;
         case IT_F_IRGB: {
             for( int c=0; c<3; c++ ) {
@@ -255,7 +263,8 @@ namespace kortex {
 
         switch( img.type() ) {
         case IT_F_GRAY:
-            filter_ver_par( img.get_row_f(0), img.w(), img.h(), kernel, ksz, out.get_row_f(0) );
+            filter_ver_par( img.get_row_f(0), img.w(), img.h(), img.stride(), kernel, ksz,
+                            out.get_row_f(0), out.stride() );
             break;
         case IT_F_IRGB: {
             for( int c=0; c<3; c++ ) {
@@ -284,7 +293,8 @@ namespace kortex {
                                                 // for now
         switch( img.type() ) {
         case IT_F_GRAY:
-            filter_hv_par( img.get_row_f(0), img.w(), img.h(), kernel, ksz, out.get_row_f(0) );
+            filter_hv_par( img.get_row_f(0), img.w(), img.h(), img.stride(), kernel, ksz,
+                           out.get_row_f(0), out.stride() );
             break;
         case IT_F_IRGB: {
             for( int c=0; c<3; c++ ) {
@@ -299,6 +309,64 @@ namespace kortex {
         }
     }
 
+    // allows img out to be point to the same mem location -> therefore passerts
+    // that out image is mem-allocated.
+    void filter_separable( const Image& img, const float* kernel_h, const int& ksz_h,
+                           const float* kernel_v, const int& ksz_v, Image& out ) {
+        assert_pointer( kernel_h && kernel_v );
+        assert_pointer_size( ksz_h*ksz_v );
+        assert_statement( !img.is_empty(), "image is empty" );
+        passert_statement( out.type() == img.type(), "image types not agree" );
+        passert_statement( check_dimensions(img, out), "dimension mismatch" );
+        img.passert_type( IT_F_GRAY | IT_F_IRGB );
+
+        switch( img.type() ) {
+        case IT_F_GRAY:
+            filter_separable( img.get_row_f(0), img.w(), img.h(), img.stride(), kernel_h, ksz_h, kernel_v, ksz_v,
+                              out.get_row_f(0), out.stride() );
+            break;
+        case IT_F_IRGB: {
+            for( int c=0; c<3; c++ ) {
+                const Image* sch = img.get_channel_wrapper( c );
+                Image      * dch = out.get_channel_wrapper( c );
+                filter_separable( *sch, kernel_h, ksz_h, kernel_v, ksz_v, *dch );
+                delete sch;
+                delete dch;
+            }
+        } break;
+        default: switch_fatality();
+        }
+    }
+
+    // allows img out to be point to the same mem location -> therefore passerts
+    // that out image is mem-allocated.
+    void filter_separable_par( const Image& img, const float* kernel_h, const int& ksz_h,
+                               const float* kernel_v, const int& ksz_v, Image& out ) {
+        assert_pointer( kernel_h && kernel_v );
+        assert_pointer_size( ksz_h*ksz_v );
+        assert_statement( !img.is_empty(), "image is empty" );
+        passert_statement( out.type() == img.type(), "image types not agree" );
+        passert_statement( check_dimensions(img, out), "dimension mismatch" );
+        img.passert_type( IT_F_GRAY | IT_F_IRGB );
+
+        switch( img.type() ) {
+        case IT_F_GRAY:
+            filter_separable_par( img.get_row_f(0), img.w(), img.h(), img.stride(), kernel_h, ksz_h, kernel_v, ksz_v,
+                                  out.get_row_f(0), out.stride() );
+            break;
+        case IT_F_IRGB: {
+            for( int c=0; c<3; c++ ) {
+                const Image* sch = img.get_channel_wrapper( c );
+                Image      * dch = out.get_channel_wrapper( c );
+                filter_separable_par( *sch, kernel_h, ksz_h, kernel_v, ksz_v, *dch );
+                delete sch;
+                delete dch;
+            }
+        } break;
+        default: switch_fatality();
+        }
+    }
+
     int  filter_size( const float& sigma ) {
         passert_statement( sigma > 0.0f, "sigma should be positive" );
         const int gauss_truncate = 4;
@@ -308,12 +376,48 @@ namespace kortex {
         return fsz;
     }
 
+    static bool use_gaussian_iir( const float& sigma, const GaussianMode& mode ) {
+        switch( mode ) {
+        case GM_FIR : return false;
+        case GM_IIR : return true;
+        case GM_AUTO: return sigma >= GAUSSIAN_IIR_MIN_SIGMA;
+        default     : switch_fatality();
+        }
+        return false;
+    }
+
+    void filter_gaussian_iir( const Image& img, const float& sigma, const bool& run_parallel, Image& out ) {
+        img.passert_type( IT_F_GRAY | IT_F_IRGB );
+        switch( img.type() ) {
+        case IT_F_GRAY:
+            if( run_parallel ) filter_gaussian_iir_par( img.get_row_f(0), img.w(), img.h(), img.stride(), sigma,
+                                                          out.get_row_f(0), out.stride() );
+            else               filter_gaussian_iir    ( img.get_row_f(0), img.w(), img.h(), img.stride(), sigma,
+                                                          out.get_row_f(0), out.stride() );
+            break;
+        case IT_F_IRGB: {
+            for( int c=0; c<3; c++ ) {
+                const Image* sch = img.get_channel_wrapper( c );
+                Image      * dch = out.get_channel_wrapper( c );
+                filter_gaussian_iir( *sch, sigma, run_parallel, *dch );
+                delete sch;
+                delete dch;
+            }
+        } break;
+        default: switch_fatality();
+        }
+    }
+
     // allows img out to be point to the same mem location -> therefore passerts
     // that out image is mem-allocated.
-    void filter_gaussian( const Image& img, const float& sigma, Image& out ) {
+    void filter_gaussian( const Image& img, const float& sigma, const GaussianMode& mode, Image& out ) {
         assert_statement( !img.is_empty(), "image is empty" );
         passert_statement( check_dimensions(img, out), "dimension mismatch" );
         passert_statement( out.type() == img.type(), "image types not agree" );
+        if( use_gaussian_iir(sigma, mode) ) {
+            filter_gaussian_iir( img, sigma, false, out );
+            return;
+        }
         int sz = filter_size(sigma);
         float* sfilter = NULL;
         allocate(sfilter, sz);
@@ -324,10 +428,14 @@ namespace kortex {
 
     // allows img out to be point to the same mem location -> therefore passerts
     // that out image is mem-allocated.
-    void filter_gaussian_par( const Image& img, const float& sigma, Image& out ) {
+    void filter_gaussian_par( const Image& img, const float& sigma, const GaussianMode& mode, Image& out ) {
         assert_statement( !img.is_empty(), "image is empty" );
         passert_statement( check_dimensions(img, out), "dimension mismatch" );
         passert_statement( out.type() == img.type(), "image types not agree" );
+        if( use_gaussian_iir(sigma, mode) ) {
+            filter_gaussian_iir( img, sigma, true, out );
+            return;
+        }
         int sz = filter_size(sigma);
         float* sfilter = NULL;
         allocate(sfilter, sz);
@@ -461,321 +569,87 @@ namespace kortex {
         passert_statement( check_dimensions(img, msk), "dimension mismatch" );
         img.passert_type( IT_F_GRAY );
         msk.passert_type( IT_F_GRAY );
-        int pc = img.pixel_count();
-        const float* irow = img.get_row_f(0);
-        float      * orow = msk.get_row_f(0);
-        for( int x=0; x<pc; x++ ) {
-            if( irow[x] > th ) orow[x] = 1.0f;
-            else               orow[x] = 0.0f;
-        }
-    }
-
-    void image_resize_coarse_rgb    ( const Image& src, const int& nw, const int& nh, Image& dst ) {
-
-        passert_statement( nw > 0 && nh > 0, "invalid new image size" );
-        src.passert_type( IT_U_PRGB | IT_U_IRGB | IT_F_IRGB | IT_F_PRGB );
-
-        dst.create( nw, nh, src.type() );
-        dst.zero();
-
-        float ratioy = static_cast<float>( src.h() ) / static_cast<float>(nh);
-        float ratiox = static_cast<float>( src.w() ) / static_cast<float>(nw);
-        float max_y = static_cast<float>( src.h()-1 );
-        float max_x = static_cast<float>( src.w()-1 );
-
-        DataType dtype = image_precision( src.type() );
-
-        float r, g, b;
-        for( int y=0; y<nh; y++ ) {
-            float ny = static_cast<float>(y)*ratioy;
-            if( ny >= max_y ) ny = max_y;
-            for( int x=0; x<nw; x++ ) {
-                float nx = static_cast<float>(x)*ratiox;
-                if( nx >= max_x ) nx = max_x;
-                src.get_bilinear(nx, ny, r, g, b);
-                switch( dtype ) {
-                case TYPE_FLOAT: dst.set(x, y, r, g, b); break;
-                case TYPE_UCHAR: {
-                    uchar ur = cast_to_gray_range( r );
-                    uchar ug = cast_to_gray_range( g );
-                    uchar ub = cast_to_gray_range( b );
-                    dst.set(x, y, ur, ug, ub);
-                } break;
-                default: switch_fatality();
-                }
+        int w = img.w();
+        int h = img.h();
+        for( int y=0; y<h; y++ ) {
+            const float* irow = img.get_row_f(y);
+            float      * orow = msk.get_row_f(y);
+            for( int x=0; x<w; x++ ) {
+                if( irow[x] > th ) orow[x] = 1.0f;
+                else               orow[x] = 0.0f;
             }
         }
     }
-    void image_resize_coarse_rgb_par( const Image& src, const int& nw, const int& nh, Image& dst ) {
-
-        passert_statement( nw > 0 && nh > 0, "invalid new image size" );
-        src.passert_type( IT_U_PRGB | IT_U_IRGB | IT_F_IRGB | IT_F_PRGB );
-
-        dst.create( nw, nh, src.type() );
-        dst.zero();
 
-        float ratioy = static_cast<float>( src.h() ) / static_cast<float>(nh);
-        float ratiox = static_cast<float>( src.w() ) / static_cast<float>(nw);
-        float max_y  = static_cast<float>( src.h()-1 );
-        float max_x  = static_cast<float>( src.w()-1 );
-
-        DataType dtype = image_precision( src.type() );
-
-#pragma omp parallel for
-        for( int y=0; y<nh; y++ ) {
-            float ny = static_cast<float>(y)*ratioy;
-            if( ny >= max_y ) ny = max_y;
-            for( int x=0; x<nw; x++ ) {
-                float nx = static_cast<float>(x)*ratiox;
-                if( nx >= max_x ) nx = max_x;
-                float r, g, b;
-                src.get_bilinear(nx, ny, r, g, b);
-                switch( dtype ) {
-                case TYPE_FLOAT: dst.set(x, y, r, g, b); break;
-                case TYPE_UCHAR: {
-                    uchar ur = cast_to_gray_range( r );
-                    uchar ug = cast_to_gray_range( g );
-                    uchar ub = cast_to_gray_range( b );
-                    dst.set(x, y, ur, ug, ub);
-                } break;
-                default: switch_fatality();
-                }
-            }
+    void image_decimate( const Image& img, Image& out ) {
+        img.passert_type( IT_F_GRAY );
+        int w = std::max( img.w()/2, 1 );
+        int h = std::max( img.h()/2, 1 );
+        out.create( w, h, IT_F_GRAY );
+        for( int y=0; y<h; y++ ) {
+            const float* src = img.get_row_f( 2*y );
+            float*       dst = out.get_row_f( y );
+            for( int x=0; x<w; x++ )
+                dst[x] = src[2*x];
         }
     }
-    void image_resize_coarse_g    ( const Image& src, const int& nw, const int& nh, Image& dst ) {
-        passert_statement( nw > 0 && nh > 0, "invalid new image size" );
-        src.passert_type( IT_U_GRAY | IT_F_GRAY );
 
-        dst.create( nw, nh, src.type() );
-        dst.zero();
-
-        float ratioy = static_cast<float>( src.h() ) / static_cast<float>(nh);
-        float ratiox = static_cast<float>( src.w() ) / static_cast<float>(nw);
-        float max_y  = static_cast<float>( src.h()-1 );
-        float max_x  = static_cast<float>( src.w()-1 );
-
-        DataType dtype = image_precision( src.type() );
-
-        for( int y=0; y<nh; y++ ) {
-            float ny = static_cast<float>(y)*ratioy;
-            if( ny >= max_y ) ny = max_y;
-            for( int x=0; x<nw; x++ ) {
-                float nx = static_cast<float>(x)*ratiox;
-                if( nx >= max_x ) nx = max_x;
-                float v = src.get_bilinear(nx, ny);
-                switch( dtype ) {
-                case TYPE_FLOAT: dst.set(x, y, v); break;
-                case TYPE_UCHAR: {
-                    uchar uv = cast_to_gray_range( v );
-                    dst.set(x, y, uv);
-                } break;
-                default: switch_fatality();
-                }
-            }
-        }
-    }
-    void image_resize_coarse_g_par( const Image& src, const int& nw, const int& nh, Image& dst ) {
+    void image_resize( const Image& src, const int& nw, const int& nh, const ResampleMethod& method,
+                       const bool& run_parallel, Image& dst ) {
         passert_statement( nw > 0 && nh > 0, "invalid new image size" );
-        src.passert_type( IT_U_GRAY | IT_F_GRAY );
-
-        dst.create( nw, nh, src.type() );
-        dst.zero();
-
-        float ratioy = static_cast<float>( src.h() ) / static_cast<float>(nh);
-        float ratiox = static_cast<float>( src.w() ) / static_cast<float>(nw);
-        float max_y  = static_cast<float>( src.h()-1 );
-        float max_x  = static_cast<float>( src.w()-1 );
+        passert_statement( !src.is_empty(), "image is empty" );
+        passert_statement( &src != &dst, "cannot resize in-place" );
+        src.passert_type( IT_U_GRAY | IT_F_GRAY | IT_U_PRGB | IT_F_PRGB | IT_U_IRGB | IT_F_IRGB | IT_U_PRGBA );
 
-        DataType dtype = image_precision( src.type() );
-
-#pragma omp parallel for
-        for( int y=0; y<nh; y++ ) {
-            float ny = static_cast<float>(y)*ratioy;
-            if( ny >= max_y ) ny = max_y;
-            for( int x=0; x<nw; x++ ) {
-                float nx = static_cast<float>(x)*ratiox;
-                if( nx >= max_x ) nx = max_x;
-                float v = src.get_bilinear(nx, ny);
-                switch( dtype ) {
-                case TYPE_FLOAT: dst.set(x, y, v); break;
-                case TYPE_UCHAR: {
-                    uchar uv = cast_to_gray_range( v );
-                    dst.set(x, y, uv);
-                } break;
-                default: switch_fatality();
-                }
-            }
-        }
-    }
-
-    void image_resize_coarse( const Image& src, const int& nw, const int& nh, bool run_parallel, Image& dst ) {
-
-        if( run_parallel ) {
-            switch( src.ch() ) {
-            case 1: image_resize_coarse_g_par  ( src, nw, nh, dst ); break;
-            case 3: image_resize_coarse_rgb_par( src, nw, nh, dst ); break;
-            default: switch_fatality();
-            }
-        } else {
-            switch( src.ch() ) {
-            case 1: image_resize_coarse_g  ( src, nw, nh, dst ); break;
-            case 3: image_resize_coarse_rgb( src, nw, nh, dst ); break;
-            default: switch_fatality();
-            }
+        if( !src.is_contiguous() ) {
+            Image packed( src );
+            image_resize( packed, nw, nh, method, run_parallel, dst );
+            return;
         }
-    }
-
-    void image_resize_fine_g( const Image& src, const int& nw, const int& nh, Image& dst ) {
-        passert_statement( nw > 0 && nh > 0, "invalid new image size" );
-        src.passert_type( IT_U_GRAY | IT_F_GRAY );
-
         dst.create( nw, nh, src.type() );
-        dst.zero();
-
-        float ratioy = static_cast<float>( src.h() ) / static_cast<float>(nh);
-        float ratiox = static_cast<float>( src.w() ) / static_cast<float>(nw);
-        float max_y  = static_cast<float>( src.h()-1 );
-        float max_x  = static_cast<float>( src.w()-1 );
-
-        DataType dtype = image_precision( src.type() );
-
-        for( int y=0; y<nh; y++ ) {
-            float ny = static_cast<float>(y)*ratioy;
-            if( ny >= max_y ) ny = max_y;
-            for( int x=0; x<nw; x++ ) {
-                float nx = static_cast<float>(x)*ratiox;
-                if( nx >= max_x ) nx = max_x;
-                if( !src.is_inside_margin(nx, ny, 2) ) continue;
-                float v = src.get_bicubic(nx, ny);
-                switch( dtype ) {
-                case TYPE_FLOAT: dst.set(x, y, v); break;
-                case TYPE_UCHAR: {
-                    uchar uv = cast_to_gray_range( v );
-                    dst.set(x, y, uv);
-                } break;
-                default: switch_fatality();
-                }
-            }
+        if( !dst.is_contiguous() ) {
+            // the resamplers write packed planes
+            Image packed;
+            image_resize( src, nw, nh, method, run_parallel, packed );
+            dst.copy( &packed );
+            return;
         }
-    }
-    void image_resize_fine_g_par( const Image& src, const int& nw, const int& nh, Image& dst ) {
-        passert_statement( nw > 0 && nh > 0, "invalid new image size" );
-        src.passert_type( IT_U_GRAY | IT_F_GRAY );
 
-        dst.create( nw, nh, src.type() );
-        dst.zero();
-
-        float ratioy = static_cast<float>( src.h() ) / static_cast<float>(nh);
-        float ratiox = static_cast<float>( src.w() ) / static_cast<float>(nw);
-        float max_y  = static_cast<float>( src.h()-1 );
-        float max_x  = static_cast<float>( src.w()-1 );
-
-        DataType dtype = image_precision( src.type() );
-
-#pragma omp parallel for
-        for( int y=0; y<nh; y++ ) {
-            float ny = static_cast<float>(y)*ratioy;
-            if( ny >= max_y ) ny = max_y;
-            for( int x=0; x<nw; x++ ) {
-                float nx = static_cast<float>(x)*ratiox;
-                if( nx >= max_x ) nx = max_x;
-                if( !src.is_inside_margin(nx, ny, 2) ) continue;
-                float v = src.get_bicubic(nx, ny);
-                switch( dtype ) {
-                case TYPE_FLOAT: dst.set(x, y, v); break;
-                case TYPE_UCHAR: {
-                    uchar uv = cast_to_gray_range( v );
-                    dst.set(x, y, uv);
-                } break;
-                default: switch_fatality();
-                }
-            }
-        }
-    }
-
-    void image_resize_fine_rgb( const Image& src, const int& nw, const int& nh, Image& dst ) {
-        passert_statement( nw > 0 && nh > 0, "invalid new image size" );
-        src.passert_type( IT_U_PRGB | IT_U_IRGB | IT_F_IRGB | IT_F_PRGB );
-
-        dst.create( nw, nh, src.type() );
-        dst.zero();
-
-        float ratioy = static_cast<float>( src.h() ) / static_cast<float>(nh);
-        float ratiox = static_cast<float>( src.w() ) / static_cast<float>(nw);
-
-        DataType dtype = image_precision( src.type() );
-
-        for( int y=0; y<nh; y++ ) {
-            float ny = static_cast<float>(y)*ratioy;
-            for( int x=0; x<nw; x++ ) {
-                float nx = static_cast<float>(x)*ratiox;
-                if( !src.is_inside_margin(nx, ny, 2) ) continue;
-                float r, g, b;
-                src.get_bicubic(nx, ny, r, g, b);
-                switch( dtype ) {
-                case TYPE_FLOAT: dst.set(x, y, r, g, b); break;
-                case TYPE_UCHAR: {
-                    uchar ur = cast_to_gray_range( r );
-                    uchar ug = cast_to_gray_range( g );
-                    uchar ub = cast_to_gray_range( b );
-                    dst.set(x, y, ur, ug, ub);
-                } break;
-                default: switch_fatality();
-                }
+        // image-ordered channels are resized plane by plane
+        int n_planes = 1;
+        int nc       = src.ch();
+        if( src.channel_type() == ITC_IMAGE ) {
+            n_planes = src.ch();
+            nc       = 1;
+        }
+        size_t src_plane = size_t(src.w())*size_t(src.h());
+        size_t dst_plane = size_t(nw)*size_t(nh);
+
+        for( int p=0; p<n_planes; p++ ) {
+            switch( src.precision() ) {
+            case TYPE_FLOAT: {
+                const float* sp = src.get_fptr() + p*src_plane;
+                float*       dp = dst.get_fptr() + p*dst_plane;
+                if( run_parallel ) resample_par( sp, src.w(), src.h(), nc, method, nw, nh, dp );
+                else               resample    ( sp, src.w(), src.h(), nc, method, nw, nh, dp );
+            } break;
+            case TYPE_UCHAR: {
+                const uchar* sp = src.get_uptr() + p*src_plane;
+                uchar*       dp = dst.get_uptr() + p*dst_plane;
+                if( run_parallel ) resample_par( sp, src.w(), src.h(), nc, method, nw, nh, dp );
+                else               resample    ( sp, src.w(), src.h(), nc, method, nw, nh, dp );
+            } break;
+            default: switch_fatality();
             }
         }
     }
 
-    void image_resize_fine_rgb_par( const Image& src, const int& nw, const int& nh, Image& dst ) {
-        passert_statement( nw > 0 && nh > 0, "invalid new image size" );
-        src.passert_type( IT_U_PRGB | IT_U_IRGB | IT_F_IRGB | IT_F_PRGB );
-
-        dst.create( nw, nh, src.type() );
-        dst.zero();
-
-        float ratioy = static_cast<float>( src.h() ) / static_cast<float>(nh);
-        float ratiox = static_cast<float>( src.w() ) / static_cast<float>(nw);
-
-        DataType dtype = image_precision( src.type() );
-
-#pragma omp parallel for
-        for( int y=0; y<nh; y++ ) {
-            float ny = static_cast<float>(y)*ratioy;
-            for( int x=0; x<nw; x++ ) {
-                float nx = static_cast<float>(x)*ratiox;
-                if( !src.is_inside_margin(nx, ny, 2) ) continue;
-                float r, g, b;
-                src.get_bicubic(nx, ny, r, g, b);
-                switch( dtype ) {
-                case TYPE_FLOAT: dst.set(x, y, r, g, b); break;
-                case TYPE_UCHAR: {
-                    uchar ur = cast_to_gray_range( r );
-                    uchar ug = cast_to_gray_range( g );
-                    uchar ub = cast_to_gray_range( b );
-                    dst.set(x, y, ur, ug, ub);
-                } break;
-                default: switch_fatality();
-                }
-            }
-        }
+    void image_resize_coarse( const Image& src, const int& nw, const int& nh, bool run_parallel, Image& dst ) {
+        image_resize( src, nw, nh, RS_BILINEAR, run_parallel, dst );
     }
 
-
     void image_resize_fine( const Image& src, const int& nw, const int& nh, bool run_parallel, Image& dst ) {
-        if( run_parallel ) {
-            switch( src.ch() ) {
-            case 1: image_resize_fine_g_par  ( src, nw, nh, dst ); break;
-            case 3: image_resize_fine_rgb_par( src, nw, nh, dst ); break;
-            default: switch_fatality();
-            }
-        } else {
-            switch( src.ch() ) {
-            case 1: image_resize_fine_g  ( src, nw, nh, dst ); break;
-            case 3: image_resize_fine_rgb( src, nw, nh, dst ); break;
-            default: switch_fatality();
-            }
-        }
+        image_resize( src, nw, nh, RS_BICUBIC, run_parallel, dst );
     }
 
     void image_subtract( const Image& im0, const Image& im1, Image& out ) {
@@ -833,6 +707,25 @@ namespace kortex {
         }
     }
 
+    // elementwise operations on float images walk rows of each plane - h
+    // rows of w*3 floats for IT_F_PRGB, ch*h rows of w floats for the
+    // image-ordered and gray images - so that padded images and region
+    // views are handled through their strides.
+    static int elementwise_row_count( const Image& img ) {
+        return img.type() == IT_F_PRGB ? img.h() : img.ch()*img.h();
+    }
+    static int elementwise_row_length( const Image& img ) {
+        return img.type() == IT_F_PRGB ? img.w()*img.ch() : img.w();
+    }
+    static const float* elementwise_row_f( const Image& img, const int& r ) {
+        if( img.type() == IT_F_PRGB ) return img.get_row_f( r );
+        return img.get_row_fi( r%img.h(), r/img.h() );
+    }
+    static float* elementwise_row_f( Image& img, const int& r ) {
+        if( img.type() == IT_F_PRGB ) return img.get_row_f( r );
+        return img.get_row_fi( r%img.h(), r/img.h() );
+    }
+
     void image_add( const Image& im0, const Image& im1, Image& out ) {
         passert_statement( check_dimensions(im0,im1), "dimension mismatch" );
         passert_statement( check_dimensions(im0,out), "dimension mismatch" );
@@ -842,13 +735,15 @@ namespace kortex {
         passert_statement( im0.type() == im1.type(), "type mismatch" );
         passert_statement( im0.type() == out.type(), "type mismatch" );
 
-        const float* ptr0 = im0.get_fptr();
-        const float* ptr1 = im1.get_fptr();
-        float      * optr = out.get_fptr();
-
-        size_t n_elems = im0.element_count();
-        for( size_t i=0; i<n_elems; i++ )
-            optr[i] = ptr0[i] + ptr1[i];
+        int n_rows = elementwise_row_count ( im0 );
+        int n      = elementwise_row_length( im0 );
+        for( int r=0; r<n_rows; r++ ) {
+            const float* row0 = elementwise_row_f( im0, r );
+            const float* row1 = elementwise_row_f( im1, r );
+            float      * orow = elementwise_row_f( out, r );
+            for( int i=0; i<n; i++ )
+                orow[i] = row0[i] + row1[i];
+        }
     }
 
     void image_add_par( const Image& im0, const Image& im1, Image& out ) {
@@ -860,14 +755,16 @@ namespace kortex {
         passert_statement( im0.type() == im1.type(), "type mismatch" );
         passert_statement( im0.type() == out.type(), "type mismatch" );
 
-        const float* ptr0 = im0.get_fptr();
-        const float* ptr1 = im1.get_fptr();
-        float      * optr = out.get_fptr();
-
-        omp_size_t n_elems = (omp_size_t)im0.element_count();
+        int n_rows = elementwise_row_count ( im0 );
+        int n      = elementwise_row_length( im0 );
 #pragma omp parallel for
-        for( omp_size_t i=0; i<n_elems; i++ )
-            optr[i] = ptr0[i] + ptr1[i];
+        for( int r=0; r<n_rows; r++ ) {
+            const float* row0 = elementwise_row_f( im0, r );
+            const float* row1 = elementwise_row_f( im1, r );
+            float      * orow = elementwise_row_f( out, r );
+            for( int i=0; i<n; i++ )
+                orow[i] = row0[i] + row1[i];
+        }
     }
 
     /// r = p/q for q(i,j) > 1e-6
@@ -1006,17 +903,23 @@ namespace kortex {
         assert_statement( check_dimensions(p,q), "dimension mismatch" );
         passert_statement( p.type() == q.type(), "image types do not agree" );
         p.passert_type( IT_F_GRAY | IT_F_IRGB | IT_F_PRGB );
-        size_t psz = p.element_count();
-        const float* pptr = p.get_fptr();
-        float      * qptr = q.get_fptr();
+        int n_rows = elementwise_row_count ( p );
+        int n      = elementwise_row_length( p );
         if( run_parallel ) {
 #pragma omp parallel for
-            for( omp_size_t i=0; i<(omp_size_t)psz; i++ ) {
-                qptr[i] = s * pptr[i];
+            for( int r=0; r<n_rows; r++ ) {
+                const float* prow = elementwise_row_f( p, r );
+                float      * qrow = elementwise_row_f( q, r );
+                for( int i=0; i<n; i++ )
+                    qrow[i] = s * prow[i];
             }
         } else {
-            for( size_t i=0; i<psz; i++ )
-                qptr[i] = s * pptr[i];
+            for( int r=0; r<n_rows; r++ ) {
+                const float* prow = elementwise_row_f( p, r );
+                float      * qrow = elementwise_row_f( q, r );
+                for( int i=0; i<n; i++ )
+                    qrow[i] = s * prow[i];
+            }
         }
     }
 
@@ -1025,17 +928,23 @@ namespace kortex {
         assert_statement( check_dimensions(p,q), "dimension mismatch" );
         passert_statement( p.type() == q.type(), "image types do not agree" );
         p.passert_type( IT_U_GRAY );
-        size_t psz = p.element_count();
-        const uchar* pptr = p.get_uptr();
-        uchar      * qptr = q.get_uptr();
+        int w = p.w();
+        int h = p.h();
         if( run_parallel ) {
 #pragma omp parallel for
-            for( omp_size_t i=0; i<(omp_size_t)psz; i++ ) {
-                qptr[i] = cast_to_gray_range( s * (float)pptr[i] );
+            for( int y=0; y<h; y++ ) {
+                const uchar* prow = p.get_row_u(y);
+                uchar      * qrow = q.get_row_u(y);
+                for( int x=0; x<w; x++ )
+                    qrow[x] = cast_to_gray_range( s * (float)prow[x] );
             }
         } else {
-            for( size_t i=0; i<psz; i++ )
-                qptr[i] = cast_to_gray_range( s * (float)pptr[i] );
+            for( int y=0; y<h; y++ ) {
+                const uchar* prow = p.get_row_u(y);
+                uchar      * qrow = q.get_row_u(y);
+                for( int x=0; x<w; x++ )
+                    qrow[x] = cast_to_gray_range( s * (float)prow[x] );
+            }
         }
     }
 
@@ -1055,12 +964,15 @@ namespace kortex {
     bool is_binarized_u( const Image& p ) {
         assert_statement( !p.is_empty(), "passed empty image" );
         p.assert_type( IT_U_GRAY );
-        int sz = p.pixel_count();
-        const uchar* row = p.get_row_u(0);
-        for( int i=0; i<sz; i++ ) {
-            if( row[i] == 0 ) continue;
-            if( row[i] == 1 ) continue;
-            return false;
+        int w = p.w();
+        int h = p.h();
+        for( int y=0; y<h; y++ ) {
+            const uchar* row = p.get_row_u(y);
+            for( int x=0; x<w; x++ ) {
+                if( row[x] == 0 ) continue;
+                if( row[x] == 1 ) continue;
+                return false;
+            }
         }
         return true;
     }
@@ -1069,12 +981,15 @@ namespace kortex {
     bool is_binarized_f( const Image& p ) {
         assert_statement( !p.is_empty(), "passed empty image" );
         p.assert_type( IT_F_GRAY );
-        int sz = p.pixel_count();
-        const float* prow = p.get_row_f(0);
-        for( int i=0; i<sz; i++ ) {
-            if( prow[i] == 0.0f ) continue;
-            if( prow[i] == 1.0f ) continue;
-            return false;
+        int w = p.w();
+        int h = p.h();
+        for( int y=0; y<h; y++ ) {
+            const float* prow = p.get_row_f(y);
+            for( int x=0; x<w; x++ ) {
+                if( prow[x] == 0.0f ) continue;
+                if( prow[x] == 1.0f ) continue;
+                return false;
+            }
         }
         return true;
     }
@@ -1094,11 +1009,14 @@ namespace kortex {
     bool is_normalized( const Image& p ) {
         assert_statement( !p.is_empty(), "passed empty image" );
         p.assert_type( IT_F_GRAY );
-        int sz = p.pixel_count();
-        const float* prow = p.get_row_f(0);
-        for( int i=0; i<sz; i++ ) {
-            if( prow[i] < 0.0f ) return false;
-            if( prow[i] > 1.0f ) return false;
+        int w = p.w();
+        int h = p.h();
+        for( int y=0; y<h; y++ ) {
+            const float* prow = p.get_row_f(y);
+            for( int x=0; x<w; x++ ) {
+                if( prow[x] < 0.0f ) return false;
+                if( prow[x] > 1.0f ) return false;
+            }
         }
         return true;
     }
@@ -1215,11 +1133,14 @@ namespace kortex {
         }
         float isrange = 1.0f/srange;
 
-        const float* sptr = src.get_row_f(0);
-        float      * dptr = dst.get_row_f(0);
-        int pc = src.pixel_count();
-        for( int i=0; i<pc; i++ ) {
-            dptr[i] = ( sptr[i] - mins ) * isrange;
+        int w = src.w();
+        int h = src.h();
+        for( int y=0; y<h; y++ ) {
+            const float* srow = src.get_row_f(y);
+            float      * drow = dst.get_row_f(y);
+            for( int x=0; x<w; x++ ) {
+                drow[x] = ( srow[x] - mins ) * isrange;
+            }
         }
     }
 
@@ -1258,19 +1179,26 @@ namespace kortex {
         Image dx, dy;
         image_gradient( src, "simple", dx, dy );
 
-        const float* xptr = dx.get_row_f(0);
-        const float* yptr = dy.get_row_f(0);
-        float      * mptr = mag.get_row_f(0);
-        int pc = src.pixel_count();
-
+        int w = src.w();
+        int h = src.h();
         if( run_parallel ) {
 #pragma omp parallel for
-            for( int i=0; i<pc; i++ ) {
-                mptr[i] = std::sqrt( sq( xptr[i] ) + sq( yptr[i] ) );
+            for( int y=0; y<h; y++ ) {
+                const float* xrow = dx.get_row_f(y);
+                const float* yrow = dy.get_row_f(y);
+                float      * mrow = mag.get_row_f(y);
+                for( int x=0; x<w; x++ ) {
+                    mrow[x] = std::sqrt( sq( xrow[x] ) + sq( yrow[x] ) );
+                }
             }
         } else {
-            for( int i=0; i<pc; i++ ) {
-                mptr[i] = std::sqrt( sq( xptr[i] ) + sq( yptr[i] ) );
+            for( int y=0; y<h; y++ ) {
+                const float* xrow = dx.get_row_f(y);
+                const float* yrow = dy.get_row_f(y);
+                float      * mrow = mag.get_row_f(y);
+                for( int x=0; x<w; x++ ) {
+                    mrow[x] = std::sqrt( sq( xrow[x] ) + sq( yrow[x] ) );
+                }
             }
         }
     }
@@ -1279,17 +1207,24 @@ namespace kortex {
         src.assert_type( IT_F_GRAY );
         passert_statement( check_dimensions(src,out), "image dimension mismatch" );
 
-        const float* sptr = src.get_row_f(0);
-        float*       optr = out.get_row_f(0);
-
-        if( !run_parallel ) {
-            for( int i=0; i<src.pixel_count(); i++ ) {
-                optr[i] = std::max( min_v, sptr[i] );
+        int w = src.w();
+        int h = src.h();
+        if( run_parallel ) {
+#pragma omp parallel for
+            for( int y=0; y<h; y++ ) {
+                const float* srow = src.get_row_f(y);
+                float*       orow = out.get_row_f(y);
+                for( int x=0; x<w; x++ ) {
+                    orow[x] = std::max( min_v, srow[x] );
+                }
             }
         } else {
-#pragma omp parallel for
-            for( int i=0; i<src.pixel_count(); i++ ) {
-                optr[i] = std::max( min_v, sptr[i] );
+            for( int y=0; y<h; y++ ) {
+                const float* srow = src.get_row_f(y);
+                float*       orow = out.get_row_f(y);
+                for( int x=0; x<w; x++ ) {
+                    orow[x] = std::max( min_v, srow[x] );
+                }
             }
         }
     }
@@ -1299,17 +1234,24 @@ namespace kortex {
         src.assert_type( IT_F_GRAY );
         passert_statement( check_dimensions(src,out), "image dimension mismatch" );
 
-        const float* sptr = src.get_row_f(0);
-        float*       optr = out.get_row_f(0);
-
-        if( !run_parallel ) {
-            for( int i=0; i<src.pixel_count(); i++ ) {
-                optr[i] = std::max( min_v, std::min( sptr[i], max_v ) );
+        int w = src.w();
+        int h = src.h();
+        if( run_parallel ) {
+#pragma omp parallel for
+            for( int y=0; y<h; y++ ) {
+                const float* srow = src.get_row_f(y);
+                float*       orow = out.get_row_f(y);
+                for( int x=0; x<w; x++ ) {
+                    orow[x] = std::max( min_v, std::min( srow[x], max_v ) );
+                }
             }
         } else {
-#pragma omp parallel for
-            for( int i=0; i<src.pixel_count(); i++ ) {
-                optr[i] = std::max( min_v, std::min( sptr[i], max_v ) );
+            for( int y=0; y<h; y++ ) {
+                const float* srow = src.get_row_f(y);
+                float*       orow = out.get_row_f(y);
+                for( int x=0; x<w; x++ ) {
+                    orow[x] = std::max( min_v, std::min( srow[x], max_v ) );
+                }
             }
         }
     }
@@ -1351,17 +1293,22 @@ namespace kortex {
         passert_statement( check_dimensions( img, out ), "dimension mismatch" );
         passert_statement( img.type() == out.type(), "image types do not agree" );
 
-        size_t psz = img.element_count();
-        const float* iptr = img.get_fptr();
-        float      * optr = out.get_fptr();
-
-        if( !run_parallel ) {
-            for( size_t i=0; i<psz; i++ )
-                optr[i] = std::fabs( iptr[i] );
-        } else {
+        int n_rows = elementwise_row_count ( img );
+        int n      = elementwise_row_length( img );
+        if( run_parallel ) {
 #pragma omp parallel for
-            for( omp_size_t i=0; i<(omp_size_t)psz; i++ ) {
-                optr[i] = std::fabs( iptr[i] );
+            for( int r=0; r<n_rows; r++ ) {
+                const float* irow = elementwise_row_f( img, r );
+                float      * orow = elementwise_row_f( out, r );
+                for( int i=0; i<n; i++ )
+                    orow[i] = std::fabs( irow[i] );
+            }
+        } else {
+            for( int r=0; r<n_rows; r++ ) {
+                const float* irow = elementwise_row_f( img, r );
+                float      * orow = elementwise_row_f( out, r );
+                for( int i=0; i<n; i++ )
+                    orow[i] = std::fabs( irow[i] );
             }
         }
     }
@@ -1400,19 +1347,14 @@ namespace kortex {
         int h = img.h();
         int w = img.w();
 
-        gx.create( w, h, IT_F_GRAY ); gx.zero();
-        gy.create( w, h, IT_F_GRAY ); gy.zero();
+        gx.create( w, h, IT_F_GRAY );
+        gy.create( w, h, IT_F_GRAY );
 
         float filter1[] = { -1.0f/2.0f, 0.0f,      1.0f/2.0f };
         float filter2[] = {  1.0f/3.0f, 1.0f/3.0f, 1.0f/3.0f };
 
-        Image timg(w, h, IT_F_GRAY);
-
-        filter_hor( img,  filter1, 3, gx );
-        filter_ver( gx,   filter2, 3      );
-
-        filter_hor( img,  filter2, 3, gy );
-        filter_ver( gy,   filter1, 3      );
+        filter_separable( img, filter1, 3, filter2, 3, gx );
+        filter_separable( img, filter2, 3, filter1, 3, gy );
 
         image_reset_boundary( gx, 1 );
         image_reset_boundary( gy, 1 );
@@ -1423,25 +1365,25 @@ namespace kortex {
         int h = img.h();
         int w = img.w();
 
-        gx.create( w, h, IT_F_GRAY ); gx.zero();
-        gy.create( w, h, IT_F_GRAY ); gy.zero();
+        gx.create( w, h, IT_F_GRAY );
+        gy.create( w, h, IT_F_GRAY );
 
         float filter1[] = { -1.0f/2.0f, 0.0f,      1.0f/2.0f };
         float filter2[] = {  1.0f/4.0f, 2.0f/4.0f, 1.0f/4.0f };
 
-        Image timg(w, h, IT_F_GRAY);
-
-        filter_hor( img,  filter1, 3, gx );
-        filter_ver( gx,   filter2, 3      );
-
-        filter_hor( img,  filter2, 3, gy );
-        filter_ver( gy,   filter1, 3      );
+        filter_separable( img, filter1, 3, filter2, 3, gx );
+        filter_separable( img, filter2, 3, filter1, 3, gy );
 
         image_reset_boundary( gx, 1 );
         image_reset_boundary( gy, 1 );
     }
 
     void image_gradient_simple(const float* im, int w, int h, float* dx, float* dy) {
+        image_gradient_simple( im, w, h, size_t(w), dx, dy, size_t(w) );
+    }
+
+    void image_gradient_simple(const float* im, int w, int h, size_t in_stride,
+                               float* dx, float* dy, size_t out_stride) {
 
         assert_pointer( im && dx && dy );
         passert_statement_g( is_positive_number(w), "[w %d] should be positive", w );
@@ -1449,59 +1391,69 @@ namespace kortex {
 
         // x=1:w-1; y=1:h-1
         for( int y=1; y<h-1; y++ ) {
-            const float* imy  = im + y*w;
-            const float* imyn = im + (y+1)*w;
-            const float* imyp = im + (y-1)*w;
-            float* dxr = dx + y*w;
-            float* dyr = dy + y*w;
+            const float* imy  = im + y*in_stride;
+            const float* imyn = im + (y+1)*in_stride;
+            const float* imyp = im + (y-1)*in_stride;
+            float* dxr = dx + y*out_stride;
+            float* dyr = dy + y*out_stride;
             for( int x=1; x<w-1; x++ ) {
                 dxr[x] = imy [x+1] - imy [x-1];
                 dyr[x] = imyp[x  ] - imyn[x  ];
             }
         }
 
-        // x=0; y=1:h-1
+        // x=0 and x=w-1; y=1:h-1
         for( int y=1; y<h-1; y++ ) {
-            dx[ y*w ] = 2.0f * ( im[y*w+1]-im[y*w] );
-            dy[ y*w ] = im[ (y-1)*w ] - im[ (y+1)*w ];
-        }
-
-        // x=w-1; y=1:h-1
-        for( int y=1; y<h-1; y++ ) {
-            dx[ y*w+w-1 ] = 2.0f * ( im[y*w+w-1]-im[y*w+w-2] );
-            dy[ y*w+w-1 ] =        ( im[(y-1)*w+w-1]-im[(y+1)*w+w-1] );
-        }
+            const float* imy  = im + y*in_stride;
+            const float* imyn = im + (y+1)*in_stride;
+            const float* imyp = im + (y-1)*in_stride;
+            float* dxr = dx + y*out_stride;
+            float* dyr = dy + y*out_stride;
+            dxr[ 0 ] = 2.0f * ( imy[1]-imy[0] );
+            dyr[ 0 ] = imyp[0] - imyn[0];
+            dxr[w-1] = 2.0f * ( imy[w-1]-imy[w-2] );
+            dyr[w-1] =        ( imyp[w-1]-imyn[w-1] );
+        }
+
+        const float* imf  = im;                      // first row
+        const float* imfn = im + in_stride;
+        const float* iml  = im + (h-1)*in_stride;    // last row
+        const float* imlp = im + (h-2)*in_stride;
+        float* dxl = dx + (h-1)*out_stride;
+        float* dyl = dy + (h-1)*out_stride;
 
         // x=1:w-1; y=0
         for( int x=1; x<w-1; x++ ) {
-            dx[x] = ( im[x+1] - im[x-1] );
-            dy[x] = 2.0f * ( im[x] - im[w+x] );
+            dx[x] = ( imf[x+1] - imf[x-1] );
+            dy[x] = 2.0f * ( imf[x] - imfn[x] );
         }
 
         // x=1:w-1; y=h-1
         for( int x=1; x<w-1; x++ ) {
-            dx[ (h-1)*w + x ] = im[ x+1 ] - im[ x-1 ];
-            dy[ (h-1)*w + x ] = 2.0f * ( im[ (h-2)*w + x ] - im[ (h-1)*w + x ] );
+            dxl[x] = iml[ x+1 ] - iml[ x-1 ];
+            dyl[x] = 2.0f * ( imlp[x] - iml[x] );
         }
 
         // x=0 y=0
-        dx[0] = 2.0f * ( im[1] - im[0] );
-        dy[0] = 2.0f * ( im[0] - im[w] );
+        dx[0] = 2.0f * ( imf[1] - imf[0] );
+        dy[0] = 2.0f * ( imf[0] - imfn[0] );
 
         // x=0 y=h-1
-        dx[ (h-1)*w ] = 2.0f * ( im[ (h-1)*w+1 ] - im[ (h-1)*w ] );
-        dy[ (h-1)*w ] = 2.0f * ( im[ (h-2)*w   ] - im[ (h-1)*w ] );
+        dxl[0] = 2.0f * ( iml [1] - iml[0] );
+        dyl[0] = 2.0f * ( imlp[0] - iml[0] );
 
         // x=w-1 y=0
-        dx[ w-1 ] = 2.0f * ( im[ w-1 ] - im[   w-2 ] );
-        dy[ w-1 ] = 2.0f * ( im[ w-1 ] - im[ 2*w-1 ] );
+        dx[ w-1 ] = 2.0f * ( imf[ w-1 ] - imf [ w-2 ] );
+        dy[ w-1 ] = 2.0f * ( imf[ w-1 ] - imfn[ w-1 ] );
 
         // x=w-1 y=h-1
-        dx[ (h-1)*w + w-1 ] = 2.0f * ( im[ (h-1)*w + w-1 ] - im[ (h-1)*w + w-2 ] );
-        dy[ (h-1)*w + w-1 ] = 2.0f * ( im[ (h-2)*w + w-1 ] - im[ (h-1)*w + w-1 ] );
+        dxl[ w-1 ] = 2.0f * ( iml [ w-1 ] - iml[ w-2 ] );
+        dyl[ w-1 ] = 2.0f * ( imlp[ w-1 ] - iml[ w-1 ] );
 
-        assert_array( "dx", dx, w*h );
-        assert_array( "dy", dy, w*h );
+        for( int y=0; y<h; y++ ) {
+            assert_array( "dx", dx+y*out_stride, w );
+            assert_array( "dy", dy+y*out_stride, w );
+        }
     }
 
     void image_gradient_simple( const Image& img, Image& gx, Image& gy ) {
@@ -1510,7 +1462,8 @@ namespace kortex {
         int h = img.h();
         gx.create( w, h, IT_F_GRAY );
         gy.create( w, h, IT_F_GRAY );
-        image_gradient_simple( img.get_row_f(0), w, h, gx.get_row_f(0), gy.get_row_f(0) );
+        passert_statement( gx.stride() == gy.stride(), "gradient images should have the same stride" );
+        image_gradient_simple( img.get_row_f(0), w, h, img.stride(), gx.get_row_f(0), gy.get_row_f(0), gx.stride() );
     }
 
     void image_reset_boundary( Image& img, int nb ) {
@@ -1554,13 +1507,15 @@ namespace kortex {
         out.assert_type( IT_U_GRAY );
         assert_statement( is_binarized(img), "image needs to be binarized" );
 
-        const uchar* src = img.get_row_u(0);
-        uchar      * dst = out.get_row_u(0);
-
-        int sz  = img.pixel_count();
-        for( int i=0; i<sz; i++ ) {
-            if( src[i] ) dst[i] = 0;
-            else         dst[i] = 1;
+        int w = img.w();
+        int h = img.h();
+        for( int y=0; y<h; y++ ) {
+            const uchar* src = img.get_row_u(y);
+            uchar      * dst = out.get_row_u(y);
+            for( int x=0; x<w; x++ ) {
+                if( src[x] ) dst[x] = 0;
+                else         dst[x] = 1;
+            }
         }
     }
 
@@ -1570,13 +1525,15 @@ namespace kortex {
         img.assert_type( IT_U_GRAY );
         out.assert_type( IT_U_GRAY );
 
-        const uchar* src = img.get_row_u(0);
-        uchar      * dst = out.get_row_u(0);
-
-        int sz  = img.pixel_count();
-        for( int i=0; i<sz; i++ ) {
-            if( src[i] == v ) dst[i] = 1;
-            else              dst[i] = 0;
+        int w = img.w();
+        int h = img.h();
+        for( int y=0; y<h; y++ ) {
+            const uchar* src = img.get_row_u(y);
+            uchar      * dst = out.get_row_u(y);
+            for( int x=0; x<w; x++ ) {
+                if( src[x] == v ) dst[x] = 1;
+                else              dst[x] = 0;
+            }
         }
     }
 
@@ -1586,18 +1543,24 @@ namespace kortex {
         q.assert_type( IT_F_GRAY );
         passert_statement( check_dimensions(p,q), "dimension mismatch" );
 
-        int sz = p.pixel_count();
-        const float* src = p.get_row_f(0);
-        float      * dst = q.get_row_f(0);
-
+        int w = p.w();
+        int h = p.h();
         if( run_parallel ) {
 #pragma omp parallel for
-            for( int i=0; i<sz; i++ ) {
-                dst[i] = op( src[i] );
+            for( int y=0; y<h; y++ ) {
+                const float* src = p.get_row_f(y);
+                float      * dst = q.get_row_f(y);
+                for( int x=0; x<w; x++ ) {
+                    dst[x] = op( src[x] );
+                }
             }
         } else {
-            for( int i=0; i<sz; i++ ) {
-                dst[i] = op( src[i] );
+            for( int y=0; y<h; y++ ) {
+                const float* src = p.get_row_f(y);
+                float      * dst = q.get_row_f(y);
+                for( int x=0; x<w; x++ ) {
+                    dst[x] = op( src[x] );
+                }
             }
         }
     }
@@ -1606,12 +1569,15 @@ namespace kortex {
         src.passert_type( IT_U_GRAY );
         dst.passert_type( IT_U_GRAY );
         passert_statement( check_dimensions(src,dst), "dimension mismatch" );
-        int sz = src.pixel_count();
-        const uchar* srow = src.get_row_u(0);
-        uchar      * drow = dst.get_row_u(0);
-        for( int i=0; i<sz; i++ ) {
-            if( srow[i] > 0 ) drow[i] = 1;
-            else              drow[i] = 0;
+        int w = src.w();
+        int h = src.h();
+        for( int y=0; y<h; y++ ) {
+            const uchar* srow = src.get_row_u(y);
+            uchar      * drow = dst.get_row_u(y);
+            for( int x=0; x<w; x++ ) {
+                if( srow[x] > 0 ) drow[x] = 1;
+                else              drow[x] = 0;
+            }
         }
     }
 
@@ -1625,19 +1591,13 @@ namespace kortex {
 
         switch( im.precision() ) {
         case TYPE_FLOAT: {
-            const float* iptr = im.get_fptr();
-            float      * optr = out.get_channel_f(cid);
-            int pix_count = im.pixel_count();
-            for( int i=0; i<pix_count; i++ )
-                optr[i] = iptr[i];
+            for( int y=0; y<im.h(); y++ )
+                memcpy( out.get_row_fi(y,cid), im.get_row_fi(y,0), sizeof(float)*im.w() );
         } break;
 
         case TYPE_UCHAR: {
-            const uchar* iptr = im.get_uptr();
-            uchar      * optr = out.get_channel_u(cid);
-            int pix_count = im.pixel_count();
-            for( int i=0; i<pix_count; i++ )
-                optr[i] = iptr[i];
+            for( int y=0; y<im.h(); y++ )
+                memcpy( out.get_row_ui(y,cid), im.get_row_ui(y,0), sizeof(uchar)*im.w() );
         } break;
         default:
             switch_fatality();
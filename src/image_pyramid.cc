@@ -0,0 +1,173 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+#include <kortex/image_pyramid.h>
+#include <kortex/image_processing.h>
+#include <kortex/check.h>
+
+#include <cmath>
+
+namespace kortex {
+
+    static const int PYRAMID_MIN_OCTAVE_SIZE = 16;
+
+    /// level offsets in the memory block are aligned to this many floats
+    static const size_t PYRAMID_LEVEL_ALIGNMENT = 16;
+
+    ImagePyramid::ImagePyramid() {
+        m_w           = 0;
+        m_h           = 0;
+        m_n_octaves   = 0;
+        m_n_scales    = 0;
+        m_n_levels    = 0;
+        m_sigma0      = 0.0f;
+        m_input_sigma = 0.0f;
+    }
+
+    void ImagePyramid::create( const int& w, const int& h, const int& n_octaves, const int& n_scales,
+                               const int& n_levels, const float& sigma0, const float& input_sigma ) {
+        passert_statement_g( w > 0 && h > 0, "[w %d] [h %d] invalid image size", w, h );
+        passert_statement_g( n_scales > 0, "[n_scales %d] should be positive", n_scales );
+        passert_statement_g( n_levels > n_scales, "[n_levels %d] should be larger than [n_scales %d]", n_levels, n_scales );
+        passert_statement( sigma0 > 0.0f, "sigma0 should be positive" );
+        passert_statement( input_sigma >= 0.0f && input_sigma <= sigma0, "input_sigma should be in [0,sigma0]" );
+
+        int n_oct = n_octaves;
+        if( n_oct <= 0 ) {
+            n_oct = 1;
+            while( std::min( w>>n_oct, h>>n_oct ) >= PYRAMID_MIN_OCTAVE_SIZE )
+                n_oct++;
+        }
+        passert_statement_g( n_oct < 31 && (w>>(n_oct-1)) > 0 && (h>>(n_oct-1)) > 0,
+                             "[n_octaves %d] too many octaves for [%dx%d]", n_oct, w, h );
+
+        if( m_w == w && m_h == h && m_n_octaves == n_oct && m_n_levels == n_levels ) {
+            m_n_scales    = n_scales;
+            m_sigma0      = sigma0;
+            m_input_sigma = input_sigma;
+            return;
+        }
+
+        m_w           = w;
+        m_h           = h;
+        m_n_octaves   = n_oct;
+        m_n_scales    = n_scales;
+        m_n_levels    = n_levels;
+        m_sigma0      = sigma0;
+        m_input_sigma = input_sigma;
+
+        vector<size_t> offsets( n_oct*n_levels );
+        size_t n_floats = 0;
+        for( int o=0; o<n_oct; o++ ) {
+            size_t osz = size_t(octave_w(o)) * size_t(octave_h(o));
+            osz = ( osz + PYRAMID_LEVEL_ALIGNMENT-1 ) / PYRAMID_LEVEL_ALIGNMENT * PYRAMID_LEVEL_ALIGNMENT;
+            for( int l=0; l<n_levels; l++ ) {
+                offsets[o*n_levels+l] = n_floats;
+                n_floats += osz;
+            }
+        }
+
+        m_levels.clear();
+        m_levels.resize( n_oct*n_levels );
+        m_memory.resize( n_floats*sizeof(float) );
+        float* buffer = (float*)m_memory.get_buffer();
+        for( int o=0; o<n_oct; o++ ) {
+            for( int l=0; l<n_levels; l++ ) {
+                int idx = o*n_levels+l;
+                m_levels[idx].create_wrapper( octave_w(o), octave_h(o), IT_F_GRAY, buffer+offsets[idx] );
+            }
+        }
+    }
+
+    void ImagePyramid::release() {
+        m_levels.clear();
+        m_memory.deallocate();
+        m_w         = 0;
+        m_h         = 0;
+        m_n_octaves = 0;
+        m_n_levels  = 0;
+    }
+
+    int ImagePyramid::octave_w( const int& octave ) const {
+        assert_boundary( octave, 0, m_n_octaves );
+        return std::max( m_w >> octave, 1 );
+    }
+
+    int ImagePyramid::octave_h( const int& octave ) const {
+        assert_boundary( octave, 0, m_n_octaves );
+        return std::max( m_h >> octave, 1 );
+    }
+
+    const Image* ImagePyramid::get_level( const int& octave, const int& level ) const {
+        assert_boundary( octave, 0, m_n_octaves );
+        assert_boundary( level,  0, m_n_levels  );
+        return &m_levels[ octave*m_n_levels + level ];
+    }
+
+    Image* ImagePyramid::get_level( const int& octave, const int& level ) {
+        assert_boundary( octave, 0, m_n_octaves );
+        assert_boundary( level,  0, m_n_levels  );
+        return &m_levels[ octave*m_n_levels + level ];
+    }
+
+    float ImagePyramid::level_sigma( const int& level ) const {
+        return m_sigma0 * std::pow( 2.0f, float(level)/float(m_n_scales) );
+    }
+
+    float ImagePyramid::scale( const int& octave, const int& level ) const {
+        return level_sigma( level ) * float( 1<<octave );
+    }
+
+    size_t ImagePyramid::mem_usage() const {
+        return m_memory.capacity() + m_levels.size()*sizeof(Image) + sizeof(*this);
+    }
+
+    /// blur that takes an image with blur s0 to s1
+    static float incremental_sigma( const float& s0, const float& s1 ) {
+        return std::sqrt( std::max( s1*s1 - s0*s0, 0.0f ) );
+    }
+
+    /// copies img to the first level and brings its blur to sigma0
+    void ImagePyramid::build_base( const Image& img, const bool& run_parallel ) {
+        img.passert_type( IT_F_GRAY );
+        passert_statement_g( img.w() == m_w && img.h() == m_h,
+                             "[%dx%d] image size does not match the pyramid [%dx%d]", img.w(), img.h(), m_w, m_h );
+        Image* base = get_level( 0, 0 );
+        base->copy_from_region( &img, 0, 0, m_w, m_h, 0, 0 );
+        float sigma = incremental_sigma( m_input_sigma, m_sigma0 );
+        if( sigma > 0.0f )
+            filter_gaussian( *base, sigma, run_parallel, *base );
+    }
+
+    void ImagePyramid::build_levels( const Image& img, const bool& run_parallel ) {
+        passert_statement( m_n_octaves > 0, "pyramid is not created" );
+        build_base( img, run_parallel );
+        for( int o=0; o<m_n_octaves; o++ ) {
+            if( o > 0 )
+                image_decimate( *get_level(o-1, m_n_scales), *get_level(o, 0) );
+            for( int l=1; l<m_n_levels; l++ ) {
+                float sigma = incremental_sigma( level_sigma(l-1), level_sigma(l) );
+                filter_gaussian( *get_level(o, l-1), sigma, run_parallel, *get_level(o, l) );
+            }
+        }
+    }
+
+    void ImagePyramid::build( const Image& img ) {
+        build_levels( img, false );
+    }
+
+    void ImagePyramid::build_par( const Image& img ) {
+        build_levels( img, true );
+    }
+
+}
@@ -53,6 +53,38 @@ namespace kortex {
         copy( rhs );
     }
 
+    KMatrix::KMatrix( KMatrix&& rhs ) noexcept {
+        init_();
+        if( rhs.is_wrapper() ) {
+            copy( rhs );
+            return;
+        }
+        take_( rhs );
+    }
+
+    KMatrix& KMatrix::operator=( KMatrix&& rhs ) {
+        if( this == &rhs )
+            return *this;
+        if( is_wrapper() || rhs.is_wrapper() ) {
+            copy( rhs );
+            return *this;
+        }
+        release();
+        take_( rhs );
+        return *this;
+    }
+
+    void KMatrix::take_( KMatrix& rhs ) {
+        m_memory.swap( &rhs.m_memory );
+        m_ro_data = rhs.m_ro_data;
+        m_data    = rhs.m_data;
+        m_wrapper = false;
+        m_const   = false;
+        nr        = rhs.nr;
+        nc        = rhs.nc;
+        rhs.init_();
+    }
+
     KMatrix::KMatrix( double* data, int h, int w ) {
         init_();
         m_data    = data;
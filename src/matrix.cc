@@ -16,6 +16,8 @@
 #include <kortex/check.h>
 #include <kortex/linear_algebra.h>
 #include <kortex/mem_manager.h>
+#include <kortex/gemm.h>
+#include <kortex/math.h>
 
 #include <cstring>
 
@@ -315,6 +317,63 @@ namespace kortex {
         return true;
     }
 
+    void mat_eigen_sym_3( const double* A, double evals[3], double evecs[9] ) {
+        assert_pointer( A && evals && evecs );
+        double a[9] = { A[0], A[1], A[2],
+                        A[1], A[4], A[5],
+                        A[2], A[5], A[8] };
+        double v[9] = { 1.0, 0.0, 0.0,
+                        0.0, 1.0, 0.0,
+                        0.0, 0.0, 1.0 };
+        const int pairs[3][2] = { {0,1}, {0,2}, {1,2} };
+        for( int sweep=0; sweep<32; sweep++ ) {
+            double off  = sq( a[1] ) + sq( a[2] ) + sq( a[5] );
+            double diag = sq( a[0] ) + sq( a[4] ) + sq( a[8] );
+            if( off <= 1e-32 * diag || off == 0.0 )
+                break;
+            for( int r=0; r<3; r++ ) {
+                int p = pairs[r][0];
+                int q = pairs[r][1];
+                double apq = a[3*p+q];
+                if( apq == 0.0 ) continue;
+                // rotation angle zeroing a(p,q) - the smaller root of
+                // t^2 + 2 theta t - 1 = 0 for stability
+                double theta = ( a[3*q+q] - a[3*p+p] ) / ( 2.0*apq );
+                double t;
+                if( fabs(theta) > 1e150 ) t = 0.5 / theta;
+                else                      t = ( theta < 0.0 ? -1.0 : 1.0 ) / ( fabs(theta) + sqrt( theta*theta + 1.0 ) );
+                double c = 1.0 / sqrt( t*t + 1.0 );
+                double s = t * c;
+                // a <- P' a P, v <- v P
+                for( int k=0; k<3; k++ ) {
+                    double x = a[3*k+p], y = a[3*k+q];
+                    a[3*k+p] = c*x - s*y;
+                    a[3*k+q] = s*x + c*y;
+                }
+                for( int k=0; k<3; k++ ) {
+                    double x = a[3*p+k], y = a[3*q+k];
+                    a[3*p+k] = c*x - s*y;
+                    a[3*q+k] = s*x + c*y;
+                }
+                a[3*p+q] = a[3*q+p] = 0.0;
+                for( int k=0; k<3; k++ ) {
+                    double x = v[3*k+p], y = v[3*k+q];
+                    v[3*k+p] = c*x - s*y;
+                    v[3*k+q] = s*x + c*y;
+                }
+            }
+        }
+        int o[3] = { 0, 1, 2 };
+        if( a[4*o[0]] < a[4*o[1]] ) std::swap( o[0], o[1] );
+        if( a[4*o[1]] < a[4*o[2]] ) std::swap( o[1], o[2] );
+        if( a[4*o[0]] < a[4*o[1]] ) std::swap( o[0], o[1] );
+        for( int i=0; i<3; i++ ) {
+            evals[i] = a[4*o[i]];
+            for( int k=0; k<3; k++ )
+                evecs[3*i+k] = v[3*k+o[i]];
+        }
+    }
+
     bool mat_inv( const double* A, int nra, int nca,
                   double* iA, int nria, int ncia ) {
         assert_pointer( A && iA );
@@ -346,6 +405,10 @@ namespace kortex {
         assert_number( csz );
         assert_matrix_compat( MO_MUL, nra, nca, nrb, ncb );
         assert_matrix_size( MO_MUL, nra, nca, nrb, ncb, csz );
+        if( double(nra)*double(ncb)*double(nca) >= GEMM_SMALL_PRODUCT ) {
+            mat_gemm( false, false, nra, ncb, nca, A, nca, B, ncb, C, ncb );
+            return;
+        }
         double res=0.0;
         int r, c, k;
         for( r=0; r<nra; r++ ) {
@@ -371,6 +434,10 @@ namespace kortex {
         assert_number( csz );
         assert_matrix_compat( MO_MUL_T, nra, nca, nrb, ncb );
         assert_matrix_size( MO_MUL_T, nra, nca, nrb, ncb, csz );
+        if( double(nra)*double(nrb)*double(nca) >= GEMM_SMALL_PRODUCT ) {
+            mat_gemm( false, true, nra, nrb, nca, A, nca, B, ncb, C, nrb );
+            return;
+        }
         for( int r=0; r<nra; r++ ) {
             const double* arow = A+r*nca;
             double      * crow = C+r*nrb;
@@ -394,6 +461,10 @@ namespace kortex {
         assert_number( csz );
         assert_matrix_compat( MO_T_MUL, nra, nca, nrb, ncb );
         assert_matrix_size( MO_T_MUL, nra, nca, nrb, ncb, csz );
+        if( double(nca)*double(ncb)*double(nra) >= GEMM_SMALL_PRODUCT ) {
+            mat_gemm( true, false, nca, ncb, nra, A, nca, B, ncb, C, ncb );
+            return;
+        }
         for( int r=0; r<nca; r++ ) {
             const double* acol = A+r;
             double      * crow = C+r*ncb;
@@ -0,0 +1,744 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/matrix_batch.h>
+#include <kortex/kfixed_matrix.h>
+#include <kortex/rotation.h>
+#include <kortex/check.h>
+#include <kortex/cpu_features.h>
+#include <kortex/mem_manager.h>
+
+#include <cmath>
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace kortex {
+
+    void batch_aos_to_soa( const double* A, const int& n, const int& esz, double* S ) {
+        passert_pointer( A && S );
+        passert_noalias_p( A, S );
+        for( int i=0; i<n; i++ )
+            for( int e=0; e<esz; e++ )
+                S[ size_t(e)*n + i ] = A[ size_t(i)*esz + e ];
+    }
+
+    void batch_soa_to_aos( const double* S, const int& n, const int& esz, double* A ) {
+        passert_pointer( A && S );
+        passert_noalias_p( A, S );
+        for( int i=0; i<n; i++ )
+            for( int e=0; e<esz; e++ )
+                A[ size_t(i)*esz + e ] = S[ size_t(e)*n + i ];
+    }
+
+//
+// scalar kernels - process the matrices [i0,n) of the batch
+//
+    template<int ESZ>
+    static inline void batch_get( const double* S, const int& n, const int& i, double* a ) {
+        for( int e=0; e<ESZ; e++ )
+            a[e] = S[ size_t(e)*n + i ];
+    }
+
+    template<int ESZ>
+    static inline void batch_set( const double* a, const int& n, const int& i, double* S ) {
+        for( int e=0; e<ESZ; e++ )
+            S[ size_t(e)*n + i ] = a[e];
+    }
+
+    template<int D>
+    static void batch_det_basic( const double* A, const int& n, const int& i0, double* d ) {
+        for( int i=i0; i<n; i++ ) {
+            KFixedMatrix<double,D,D> M;
+            batch_get<D*D>( A, n, i, M() );
+            d[i] = mat_det( M );
+        }
+    }
+
+    template<int D>
+    static int batch_inv_basic( const double* A, const int& n, const int& i0, const double& inversion_threshold,
+                                double* iA, uchar* valid ) {
+        int n_valid = 0;
+        for( int i=i0; i<n; i++ ) {
+            KFixedMatrix<double,D,D> M, iM;
+            batch_get<D*D>( A, n, i, M() );
+            bool ok = mat_inv( M, iM, inversion_threshold );
+            batch_set<D*D>( iM(), n, i, iA );
+            if( valid ) valid[i] = ok;
+            n_valid += ok;
+        }
+        return n_valid;
+    }
+
+    template<int D>
+    static void batch_mat_vec_basic( const double* A, const double* x, const int& n, const int& i0,
+                                     const bool& trans, double* y ) {
+        for( int i=i0; i<n; i++ ) {
+            double a[D*D], v[D], r[D];
+            batch_get<D*D>( A, n, i, a );
+            batch_get<D>  ( x, n, i, v );
+            for( int row=0; row<D; row++ ) {
+                r[row] = 0.0;
+                for( int c=0; c<D; c++ )
+                    r[row] += ( trans ? a[c*D+row] : a[row*D+c] ) * v[c];
+            }
+            batch_set<D>( r, n, i, y );
+        }
+    }
+
+    static void batch_quaternion_to_rotation_basic( const double* q, const int& n, const int& i0, double* R ) {
+        for( int i=i0; i<n; i++ ) {
+            double qi[4], Ri[9];
+            batch_get<4>( q, n, i, qi );
+            quaternion_to_rotation( qi, Ri );
+            batch_set<9>( Ri, n, i, R );
+        }
+    }
+
+    static void batch_rotation_to_quaternion_basic( const double* R, const int& n, const int& i0, double* q ) {
+        for( int i=i0; i<n; i++ ) {
+            double qi[4], Ri[9];
+            batch_get<9>( R, n, i, Ri );
+            rotation_to_quaternion( Ri, qi );
+            batch_set<4>( qi, n, i, q );
+        }
+    }
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+//
+// avx2 kernels - 4 matrices per iteration
+//
+    template<int ESZ> KORTEX_TARGET_AVX2
+    static inline void batch_load_avx2( const double* S, const int& n, const int& i, __m256d* a ) {
+        for( int e=0; e<ESZ; e++ )
+            a[e] = _mm256_loadu_pd( S + size_t(e)*n + i );
+    }
+
+    template<int ESZ> KORTEX_TARGET_AVX2
+    static inline void batch_store_avx2( const __m256d* a, const int& n, const int& i, double* S ) {
+        for( int e=0; e<ESZ; e++ )
+            _mm256_storeu_pd( S + size_t(e)*n + i, a[e] );
+    }
+
+    /// a*d - b*c
+    KORTEX_TARGET_AVX2
+    static inline __m256d det2_avx2( const __m256d& a, const __m256d& b, const __m256d& c, const __m256d& d ) {
+        return _mm256_fmsub_pd( a, d, _mm256_mul_pd( b, c ) );
+    }
+
+    /// x0*y0 - x1*y1 + x2*y2
+    KORTEX_TARGET_AVX2
+    static inline __m256d pmp_avx2( const __m256d& x0, const __m256d& y0, const __m256d& x1, const __m256d& y1,
+                                    const __m256d& x2, const __m256d& y2 ) {
+        return _mm256_fmadd_pd( x2, y2, _mm256_fnmadd_pd( x1, y1, _mm256_mul_pd( x0, y0 ) ) );
+    }
+
+    /// cofactors of the first column and the determinant
+    KORTEX_TARGET_AVX2
+    static inline __m256d det3_avx2( const __m256d* a, __m256d* c ) {
+        c[0] = det2_avx2( a[4], a[5], a[7], a[8] );
+        c[1] = det2_avx2( a[5], a[3], a[8], a[6] );
+        c[2] = det2_avx2( a[3], a[4], a[6], a[7] );
+        return _mm256_fmadd_pd( a[2], c[2], _mm256_fmadd_pd( a[1], c[1], _mm256_mul_pd( a[0], c[0] ) ) );
+    }
+
+    /// 2x2 minors of the top ( s ) and bottom ( c ) row pairs and the determinant
+    KORTEX_TARGET_AVX2
+    static inline __m256d det4_avx2( const __m256d* a, __m256d* s, __m256d* c ) {
+        s[0] = det2_avx2( a[0],  a[1],  a[4],  a[5]  );
+        s[1] = det2_avx2( a[0],  a[2],  a[4],  a[6]  );
+        s[2] = det2_avx2( a[0],  a[3],  a[4],  a[7]  );
+        s[3] = det2_avx2( a[1],  a[2],  a[5],  a[6]  );
+        s[4] = det2_avx2( a[1],  a[3],  a[5],  a[7]  );
+        s[5] = det2_avx2( a[2],  a[3],  a[6],  a[7]  );
+        c[0] = det2_avx2( a[8],  a[9],  a[12], a[13] );
+        c[1] = det2_avx2( a[8],  a[10], a[12], a[14] );
+        c[2] = det2_avx2( a[8],  a[11], a[12], a[15] );
+        c[3] = det2_avx2( a[9],  a[10], a[13], a[14] );
+        c[4] = det2_avx2( a[9],  a[11], a[13], a[15] );
+        c[5] = det2_avx2( a[10], a[11], a[14], a[15] );
+        __m256d d = _mm256_mul_pd( s[0], c[5] );
+        d = _mm256_fnmadd_pd( s[1], c[4], d );
+        d = _mm256_fmadd_pd ( s[2], c[3], d );
+        d = _mm256_fmadd_pd ( s[3], c[2], d );
+        d = _mm256_fnmadd_pd( s[4], c[1], d );
+        return _mm256_fmadd_pd( s[5], c[0], d );
+    }
+
+    /// returns the lanes with |d| > threshold and sets id = 1/d on them
+    KORTEX_TARGET_AVX2
+    static inline __m256d inv_mask_avx2( const __m256d& d, const __m256d& threshold, __m256d& id ) {
+        const __m256d sign = _mm256_set1_pd( -0.0 );
+        __m256d mask = _mm256_cmp_pd( _mm256_andnot_pd( sign, d ), threshold, _CMP_GT_OQ );
+        id = _mm256_and_pd( _mm256_div_pd( _mm256_set1_pd( 1.0 ), d ), mask );
+        return mask;
+    }
+
+    KORTEX_TARGET_AVX2
+    static inline int inv_flags_avx2( const __m256d& mask, const int& i, uchar* valid ) {
+        int bits = _mm256_movemask_pd( mask );
+        if( valid ) {
+            for( int l=0; l<4; l++ )
+                valid[i+l] = ( bits >> l ) & 1;
+        }
+        return __builtin_popcount( bits );
+    }
+
+    KORTEX_TARGET_AVX2
+    static void batch_det_3_avx2( const double* A, const int& n, double* d ) {
+        int i = 0;
+        for( ; i+4<=n; i+=4 ) {
+            __m256d a[9], c[3];
+            batch_load_avx2<9>( A, n, i, a );
+            _mm256_storeu_pd( d+i, det3_avx2( a, c ) );
+        }
+        batch_det_basic<3>( A, n, i, d );
+    }
+
+    KORTEX_TARGET_AVX2
+    static void batch_det_4_avx2( const double* A, const int& n, double* d ) {
+        int i = 0;
+        for( ; i+4<=n; i+=4 ) {
+            __m256d a[16], s[6], c[6];
+            batch_load_avx2<16>( A, n, i, a );
+            _mm256_storeu_pd( d+i, det4_avx2( a, s, c ) );
+        }
+        batch_det_basic<4>( A, n, i, d );
+    }
+
+    KORTEX_TARGET_AVX2
+    static int batch_inv_3_avx2( const double* A, const int& n, const double& inversion_threshold,
+                                 double* iA, uchar* valid ) {
+        const __m256d thr = _mm256_set1_pd( inversion_threshold );
+        int n_valid = 0;
+        int i = 0;
+        for( ; i+4<=n; i+=4 ) {
+            __m256d a[9], c[3], b[9], id;
+            batch_load_avx2<9>( A, n, i, a );
+            __m256d mask = inv_mask_avx2( det3_avx2( a, c ), thr, id );
+            b[0] = _mm256_mul_pd( c[0], id );
+            b[1] = _mm256_mul_pd( det2_avx2( a[2], a[1], a[8], a[7] ), id );
+            b[2] = _mm256_mul_pd( det2_avx2( a[1], a[2], a[4], a[5] ), id );
+            b[3] = _mm256_mul_pd( c[1], id );
+            b[4] = _mm256_mul_pd( det2_avx2( a[0], a[2], a[6], a[8] ), id );
+            b[5] = _mm256_mul_pd( det2_avx2( a[2], a[0], a[5], a[3] ), id );
+            b[6] = _mm256_mul_pd( c[2], id );
+            b[7] = _mm256_mul_pd( det2_avx2( a[1], a[0], a[7], a[6] ), id );
+            b[8] = _mm256_mul_pd( det2_avx2( a[0], a[1], a[3], a[4] ), id );
+            batch_store_avx2<9>( b, n, i, iA );
+            n_valid += inv_flags_avx2( mask, i, valid );
+        }
+        return n_valid + batch_inv_basic<3>( A, n, i, inversion_threshold, iA, valid );
+    }
+
+    KORTEX_TARGET_AVX2
+    static int batch_inv_4_avx2( const double* A, const int& n, const double& inversion_threshold,
+                                 double* iA, uchar* valid ) {
+        const __m256d thr = _mm256_set1_pd( inversion_threshold );
+        int n_valid = 0;
+        int i = 0;
+        for( ; i+4<=n; i+=4 ) {
+            __m256d a[16], s[6], c[6], b[16], id;
+            batch_load_avx2<16>( A, n, i, a );
+            __m256d mask = inv_mask_avx2( det4_avx2( a, s, c ), thr, id );
+            __m256d nid  = _mm256_sub_pd( _mm256_setzero_pd(), id );
+            b[0]  = _mm256_mul_pd( pmp_avx2( a[5],  c[5], a[6],  c[4], a[7],  c[3] ),  id );
+            b[1]  = _mm256_mul_pd( pmp_avx2( a[1],  c[5], a[2],  c[4], a[3],  c[3] ), nid );
+            b[2]  = _mm256_mul_pd( pmp_avx2( a[13], s[5], a[14], s[4], a[15], s[3] ),  id );
+            b[3]  = _mm256_mul_pd( pmp_avx2( a[9],  s[5], a[10], s[4], a[11], s[3] ), nid );
+            b[4]  = _mm256_mul_pd( pmp_avx2( a[4],  c[5], a[6],  c[2], a[7],  c[1] ), nid );
+            b[5]  = _mm256_mul_pd( pmp_avx2( a[0],  c[5], a[2],  c[2], a[3],  c[1] ),  id );
+            b[6]  = _mm256_mul_pd( pmp_avx2( a[12], s[5], a[14], s[2], a[15], s[1] ), nid );
+            b[7]  = _mm256_mul_pd( pmp_avx2( a[8],  s[5], a[10], s[2], a[11], s[1] ),  id );
+            b[8]  = _mm256_mul_pd( pmp_avx2( a[4],  c[4], a[5],  c[2], a[7],  c[0] ),  id );
+            b[9]  = _mm256_mul_pd( pmp_avx2( a[0],  c[4], a[1],  c[2], a[3],  c[0] ), nid );
+            b[10] = _mm256_mul_pd( pmp_avx2( a[12], s[4], a[13], s[2], a[15], s[0] ),  id );
+            b[11] = _mm256_mul_pd( pmp_avx2( a[8],  s[4], a[9],  s[2], a[11], s[0] ), nid );
+            b[12] = _mm256_mul_pd( pmp_avx2( a[4],  c[3], a[5],  c[1], a[6],  c[0] ), nid );
+            b[13] = _mm256_mul_pd( pmp_avx2( a[0],  c[3], a[1],  c[1], a[2],  c[0] ),  id );
+            b[14] = _mm256_mul_pd( pmp_avx2( a[12], s[3], a[13], s[1], a[14], s[0] ), nid );
+            b[15] = _mm256_mul_pd( pmp_avx2( a[8],  s[3], a[9],  s[1], a[10], s[0] ),  id );
+            batch_store_avx2<16>( b, n, i, iA );
+            n_valid += inv_flags_avx2( mask, i, valid );
+        }
+        return n_valid + batch_inv_basic<4>( A, n, i, inversion_threshold, iA, valid );
+    }
+
+    template<int D> KORTEX_TARGET_AVX2
+    static void batch_mat_vec_avx2( const double* A, const double* x, const int& n, const bool& trans, double* y ) {
+        int i = 0;
+        for( ; i+4<=n; i+=4 ) {
+            __m256d a[D*D], v[D], r[D];
+            batch_load_avx2<D*D>( A, n, i, a );
+            batch_load_avx2<D>  ( x, n, i, v );
+            for( int row=0; row<D; row++ ) {
+                r[row] = _mm256_mul_pd( trans ? a[row] : a[row*D], v[0] );
+                for( int c=1; c<D; c++ )
+                    r[row] = _mm256_fmadd_pd( trans ? a[c*D+row] : a[row*D+c], v[c], r[row] );
+            }
+            batch_store_avx2<D>( r, n, i, y );
+        }
+        batch_mat_vec_basic<D>( A, x, n, i, trans, y );
+    }
+
+    KORTEX_TARGET_AVX2
+    static void batch_quaternion_to_rotation_avx2( const double* q, const int& n, double* R ) {
+        const __m256d one = _mm256_set1_pd( 1.0 );
+        const __m256d two = _mm256_set1_pd( 2.0 );
+        int i = 0;
+        for( ; i+4<=n; i+=4 ) {
+            __m256d v[4], r[9];
+            batch_load_avx2<4>( q, n, i, v );
+            __m256d x2 = _mm256_mul_pd( v[0], v[0] ), y2 = _mm256_mul_pd( v[1], v[1] ), z2 = _mm256_mul_pd( v[2], v[2] );
+            __m256d xy = _mm256_mul_pd( v[0], v[1] ), xz = _mm256_mul_pd( v[0], v[2] ), xw = _mm256_mul_pd( v[0], v[3] );
+            __m256d yz = _mm256_mul_pd( v[1], v[2] ), yw = _mm256_mul_pd( v[1], v[3] ), zw = _mm256_mul_pd( v[2], v[3] );
+            r[0] = _mm256_fnmadd_pd( two, _mm256_add_pd( y2, z2 ), one );
+            r[1] = _mm256_mul_pd   ( two, _mm256_sub_pd( xy, zw ) );
+            r[2] = _mm256_mul_pd   ( two, _mm256_add_pd( xz, yw ) );
+            r[3] = _mm256_mul_pd   ( two, _mm256_add_pd( xy, zw ) );
+            r[4] = _mm256_fnmadd_pd( two, _mm256_add_pd( x2, z2 ), one );
+            r[5] = _mm256_mul_pd   ( two, _mm256_sub_pd( yz, xw ) );
+            r[6] = _mm256_mul_pd   ( two, _mm256_sub_pd( xz, yw ) );
+            r[7] = _mm256_mul_pd   ( two, _mm256_add_pd( yz, xw ) );
+            r[8] = _mm256_fnmadd_pd( two, _mm256_add_pd( x2, y2 ), one );
+            batch_store_avx2<9>( r, n, i, R );
+        }
+        batch_quaternion_to_rotation_basic( q, n, i, R );
+    }
+
+    /// picks vx, vy, vz or vw per lane - the masks are disjoint
+    KORTEX_TARGET_AVX2
+    static inline __m256d select_avx2( const __m256d& my, const __m256d& mz, const __m256d& mw,
+                                       const __m256d& vx, const __m256d& vy, const __m256d& vz, const __m256d& vw ) {
+        __m256d v = _mm256_blendv_pd( vx, vy, my );
+        v = _mm256_blendv_pd( v, vz, mz );
+        return _mm256_blendv_pd( v, vw, mw );
+    }
+
+    /// branch-free version of rotation_to_quaternion: the lanes with a
+    /// positive trace use the trace formula, the others the formula of their
+    /// largest diagonal element.
+    KORTEX_TARGET_AVX2
+    static void batch_rotation_to_quaternion_avx2( const double* R, const int& n, double* q ) {
+        const __m256d one  = _mm256_set1_pd( 1.0 );
+        const __m256d half = _mm256_set1_pd( 0.5 );
+        const __m256d zero = _mm256_setzero_pd();
+        int i = 0;
+        for( ; i+4<=n; i+=4 ) {
+            __m256d r[9], v[4];
+            batch_load_avx2<9>( R, n, i, r );
+            __m256d tr  = _mm256_add_pd( _mm256_add_pd( r[0], r[4] ), r[8] );
+            __m256d mw  = _mm256_cmp_pd( tr, zero, _CMP_GT_OQ );
+            __m256d m1  = _mm256_cmp_pd( r[4], r[0], _CMP_GT_OQ );
+            __m256d m2  = _mm256_cmp_pd( r[8], _mm256_blendv_pd( r[0], r[4], m1 ), _CMP_GT_OQ );
+            __m256d mz  = _mm256_andnot_pd( mw, m2 );
+            __m256d my  = _mm256_andnot_pd( mw, _mm256_andnot_pd( m2, m1 ) );
+            __m256d tx  = _mm256_sub_pd( _mm256_sub_pd( _mm256_add_pd( one, r[0] ), r[4] ), r[8] );
+            __m256d ty  = _mm256_sub_pd( _mm256_sub_pd( _mm256_add_pd( one, r[4] ), r[0] ), r[8] );
+            __m256d tz  = _mm256_sub_pd( _mm256_sub_pd( _mm256_add_pd( one, r[8] ), r[0] ), r[4] );
+            __m256d tw  = _mm256_add_pd( one, tr );
+            __m256d s   = _mm256_sqrt_pd( select_avx2( my, mz, mw, tx, ty, tz, tw ) );
+            __m256d h   = _mm256_mul_pd( half, s );
+            __m256d f   = _mm256_div_pd( half, s );
+            __m256d a   = _mm256_mul_pd( _mm256_sub_pd( r[7], r[5] ), f );
+            __m256d b   = _mm256_mul_pd( _mm256_sub_pd( r[2], r[6] ), f );
+            __m256d c   = _mm256_mul_pd( _mm256_sub_pd( r[3], r[1] ), f );
+            __m256d sxy = _mm256_mul_pd( _mm256_add_pd( r[1], r[3] ), f );
+            __m256d sxz = _mm256_mul_pd( _mm256_add_pd( r[2], r[6] ), f );
+            __m256d syz = _mm256_mul_pd( _mm256_add_pd( r[5], r[7] ), f );
+            v[0] = select_avx2( my, mz, mw, h,   sxy, sxz, a );
+            v[1] = select_avx2( my, mz, mw, sxy, h,   syz, b );
+            v[2] = select_avx2( my, mz, mw, sxz, syz, h,   c );
+            v[3] = select_avx2( my, mz, mw, a,   b,   c,   h );
+            batch_store_avx2<4>( v, n, i, q );
+        }
+        batch_rotation_to_quaternion_basic( R, n, i, q );
+    }
+
+//
+// avx512 kernels - 8 matrices per iteration
+//
+    template<int ESZ> KORTEX_TARGET_AVX512
+    static inline void batch_load_avx512( const double* S, const int& n, const int& i, __m512d* a ) {
+        for( int e=0; e<ESZ; e++ )
+            a[e] = _mm512_loadu_pd( S + size_t(e)*n + i );
+    }
+
+    template<int ESZ> KORTEX_TARGET_AVX512
+    static inline void batch_store_avx512( const __m512d* a, const int& n, const int& i, double* S ) {
+        for( int e=0; e<ESZ; e++ )
+            _mm512_storeu_pd( S + size_t(e)*n + i, a[e] );
+    }
+
+    KORTEX_TARGET_AVX512
+    static inline __m512d det2_avx512( const __m512d& a, const __m512d& b, const __m512d& c, const __m512d& d ) {
+        return _mm512_fmsub_pd( a, d, _mm512_mul_pd( b, c ) );
+    }
+
+    KORTEX_TARGET_AVX512
+    static inline __m512d pmp_avx512( const __m512d& x0, const __m512d& y0, const __m512d& x1, const __m512d& y1,
+                                      const __m512d& x2, const __m512d& y2 ) {
+        return _mm512_fmadd_pd( x2, y2, _mm512_fnmadd_pd( x1, y1, _mm512_mul_pd( x0, y0 ) ) );
+    }
+
+    KORTEX_TARGET_AVX512
+    static inline __m512d det3_avx512( const __m512d* a, __m512d* c ) {
+        c[0] = det2_avx512( a[4], a[5], a[7], a[8] );
+        c[1] = det2_avx512( a[5], a[3], a[8], a[6] );
+        c[2] = det2_avx512( a[3], a[4], a[6], a[7] );
+        return _mm512_fmadd_pd( a[2], c[2], _mm512_fmadd_pd( a[1], c[1], _mm512_mul_pd( a[0], c[0] ) ) );
+    }
+
+    KORTEX_TARGET_AVX512
+    static inline __m512d det4_avx512( const __m512d* a, __m512d* s, __m512d* c ) {
+        s[0] = det2_avx512( a[0],  a[1],  a[4],  a[5]  );
+        s[1] = det2_avx512( a[0],  a[2],  a[4],  a[6]  );
+        s[2] = det2_avx512( a[0],  a[3],  a[4],  a[7]  );
+        s[3] = det2_avx512( a[1],  a[2],  a[5],  a[6]  );
+        s[4] = det2_avx512( a[1],  a[3],  a[5],  a[7]  );
+        s[5] = det2_avx512( a[2],  a[3],  a[6],  a[7]  );
+        c[0] = det2_avx512( a[8],  a[9],  a[12], a[13] );
+        c[1] = det2_avx512( a[8],  a[10], a[12], a[14] );
+        c[2] = det2_avx512( a[8],  a[11], a[12], a[15] );
+        c[3] = det2_avx512( a[9],  a[10], a[13], a[14] );
+        c[4] = det2_avx512( a[9],  a[11], a[13], a[15] );
+        c[5] = det2_avx512( a[10], a[11], a[14], a[15] );
+        __m512d d = _mm512_mul_pd( s[0], c[5] );
+        d = _mm512_fnmadd_pd( s[1], c[4], d );
+        d = _mm512_fmadd_pd ( s[2], c[3], d );
+        d = _mm512_fmadd_pd ( s[3], c[2], d );
+        d = _mm512_fnmadd_pd( s[4], c[1], d );
+        return _mm512_fmadd_pd( s[5], c[0], d );
+    }
+
+    KORTEX_TARGET_AVX512
+    static inline __mmask8 inv_mask_avx512( const __m512d& d, const __m512d& threshold, __m512d& id ) {
+        __mmask8 mask = _mm512_cmp_pd_mask( _mm512_abs_pd( d ), threshold, _CMP_GT_OQ );
+        id = _mm512_maskz_div_pd( mask, _mm512_set1_pd( 1.0 ), d );
+        return mask;
+    }
+
+    static inline int inv_flags_avx512( const __mmask8& mask, const int& i, uchar* valid ) {
+        if( valid ) {
+            for( int l=0; l<8; l++ )
+                valid[i+l] = ( mask >> l ) & 1;
+        }
+        return __builtin_popcount( mask );
+    }
+
+    KORTEX_TARGET_AVX512
+    static void batch_det_3_avx512( const double* A, const int& n, double* d ) {
+        int i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m512d a[9], c[3];
+            batch_load_avx512<9>( A, n, i, a );
+            _mm512_storeu_pd( d+i, det3_avx512( a, c ) );
+        }
+        batch_det_basic<3>( A, n, i, d );
+    }
+
+    KORTEX_TARGET_AVX512
+    static void batch_det_4_avx512( const double* A, const int& n, double* d ) {
+        int i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m512d a[16], s[6], c[6];
+            batch_load_avx512<16>( A, n, i, a );
+            _mm512_storeu_pd( d+i, det4_avx512( a, s, c ) );
+        }
+        batch_det_basic<4>( A, n, i, d );
+    }
+
+    KORTEX_TARGET_AVX512
+    static int batch_inv_3_avx512( const double* A, const int& n, const double& inversion_threshold,
+                                   double* iA, uchar* valid ) {
+        const __m512d thr = _mm512_set1_pd( inversion_threshold );
+        int n_valid = 0;
+        int i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m512d a[9], c[3], b[9], id;
+            batch_load_avx512<9>( A, n, i, a );
+            __mmask8 mask = inv_mask_avx512( det3_avx512( a, c ), thr, id );
+            b[0] = _mm512_mul_pd( c[0], id );
+            b[1] = _mm512_mul_pd( det2_avx512( a[2], a[1], a[8], a[7] ), id );
+            b[2] = _mm512_mul_pd( det2_avx512( a[1], a[2], a[4], a[5] ), id );
+            b[3] = _mm512_mul_pd( c[1], id );
+            b[4] = _mm512_mul_pd( det2_avx512( a[0], a[2], a[6], a[8] ), id );
+            b[5] = _mm512_mul_pd( det2_avx512( a[2], a[0], a[5], a[3] ), id );
+            b[6] = _mm512_mul_pd( c[2], id );
+            b[7] = _mm512_mul_pd( det2_avx512( a[1], a[0], a[7], a[6] ), id );
+            b[8] = _mm512_mul_pd( det2_avx512( a[0], a[1], a[3], a[4] ), id );
+            batch_store_avx512<9>( b, n, i, iA );
+            n_valid += inv_flags_avx512( mask, i, valid );
+        }
+        return n_valid + batch_inv_basic<3>( A, n, i, inversion_threshold, iA, valid );
+    }
+
+    KORTEX_TARGET_AVX512
+    static int batch_inv_4_avx512( const double* A, const int& n, const double& inversion_threshold,
+                                   double* iA, uchar* valid ) {
+        const __m512d thr = _mm512_set1_pd( inversion_threshold );
+        int n_valid = 0;
+        int i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m512d a[16], s[6], c[6], b[16], id;
+            batch_load_avx512<16>( A, n, i, a );
+            __mmask8 mask = inv_mask_avx512( det4_avx512( a, s, c ), thr, id );
+            __m512d  nid  = _mm512_sub_pd( _mm512_setzero_pd(), id );
+            b[0]  = _mm512_mul_pd( pmp_avx512( a[5],  c[5], a[6],  c[4], a[7],  c[3] ),  id );
+            b[1]  = _mm512_mul_pd( pmp_avx512( a[1],  c[5], a[2],  c[4], a[3],  c[3] ), nid );
+            b[2]  = _mm512_mul_pd( pmp_avx512( a[13], s[5], a[14], s[4], a[15], s[3] ),  id );
+            b[3]  = _mm512_mul_pd( pmp_avx512( a[9],  s[5], a[10], s[4], a[11], s[3] ), nid );
+            b[4]  = _mm512_mul_pd( pmp_avx512( a[4],  c[5], a[6],  c[2], a[7],  c[1] ), nid );
+            b[5]  = _mm512_mul_pd( pmp_avx512( a[0],  c[5], a[2],  c[2], a[3],  c[1] ),  id );
+            b[6]  = _mm512_mul_pd( pmp_avx512( a[12], s[5], a[14], s[2], a[15], s[1] ), nid );
+            b[7]  = _mm512_mul_pd( pmp_avx512( a[8],  s[5], a[10], s[2], a[11], s[1] ),  id );
+            b[8]  = _mm512_mul_pd( pmp_avx512( a[4],  c[4], a[5],  c[2], a[7],  c[0] ),  id );
+            b[9]  = _mm512_mul_pd( pmp_avx512( a[0],  c[4], a[1],  c[2], a[3],  c[0] ), nid );
+            b[10] = _mm512_mul_pd( pmp_avx512( a[12], s[4], a[13], s[2], a[15], s[0] ),  id );
+            b[11] = _mm512_mul_pd( pmp_avx512( a[8],  s[4], a[9],  s[2], a[11], s[0] ), nid );
+            b[12] = _mm512_mul_pd( pmp_avx512( a[4],  c[3], a[5],  c[1], a[6],  c[0] ), nid );
+            b[13] = _mm512_mul_pd( pmp_avx512( a[0],  c[3], a[1],  c[1], a[2],  c[0] ),  id );
+            b[14] = _mm512_mul_pd( pmp_avx512( a[12], s[3], a[13], s[1], a[14], s[0] ), nid );
+            b[15] = _mm512_mul_pd( pmp_avx512( a[8],  s[3], a[9],  s[1], a[10], s[0] ),  id );
+            batch_store_avx512<16>( b, n, i, iA );
+            n_valid += inv_flags_avx512( mask, i, valid );
+        }
+        return n_valid + batch_inv_basic<4>( A, n, i, inversion_threshold, iA, valid );
+    }
+
+    template<int D> KORTEX_TARGET_AVX512
+    static void batch_mat_vec_avx512( const double* A, const double* x, const int& n, const bool& trans, double* y ) {
+        int i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m512d a[D*D], v[D], r[D];
+            batch_load_avx512<D*D>( A, n, i, a );
+            batch_load_avx512<D>  ( x, n, i, v );
+            for( int row=0; row<D; row++ ) {
+                r[row] = _mm512_mul_pd( trans ? a[row] : a[row*D], v[0] );
+                for( int c=1; c<D; c++ )
+                    r[row] = _mm512_fmadd_pd( trans ? a[c*D+row] : a[row*D+c], v[c], r[row] );
+            }
+            batch_store_avx512<D>( r, n, i, y );
+        }
+        batch_mat_vec_basic<D>( A, x, n, i, trans, y );
+    }
+
+    KORTEX_TARGET_AVX512
+    static void batch_quaternion_to_rotation_avx512( const double* q, const int& n, double* R ) {
+        const __m512d one = _mm512_set1_pd( 1.0 );
+        const __m512d two = _mm512_set1_pd( 2.0 );
+        int i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m512d v[4], r[9];
+            batch_load_avx512<4>( q, n, i, v );
+            __m512d x2 = _mm512_mul_pd( v[0], v[0] ), y2 = _mm512_mul_pd( v[1], v[1] ), z2 = _mm512_mul_pd( v[2], v[2] );
+            __m512d xy = _mm512_mul_pd( v[0], v[1] ), xz = _mm512_mul_pd( v[0], v[2] ), xw = _mm512_mul_pd( v[0], v[3] );
+            __m512d yz = _mm512_mul_pd( v[1], v[2] ), yw = _mm512_mul_pd( v[1], v[3] ), zw = _mm512_mul_pd( v[2], v[3] );
+            r[0] = _mm512_fnmadd_pd( two, _mm512_add_pd( y2, z2 ), one );
+            r[1] = _mm512_mul_pd   ( two, _mm512_sub_pd( xy, zw ) );
+            r[2] = _mm512_mul_pd   ( two, _mm512_add_pd( xz, yw ) );
+            r[3] = _mm512_mul_pd   ( two, _mm512_add_pd( xy, zw ) );
+            r[4] = _mm512_fnmadd_pd( two, _mm512_add_pd( x2, z2 ), one );
+            r[5] = _mm512_mul_pd   ( two, _mm512_sub_pd( yz, xw ) );
+            r[6] = _mm512_mul_pd   ( two, _mm512_sub_pd( xz, yw ) );
+            r[7] = _mm512_mul_pd   ( two, _mm512_add_pd( yz, xw ) );
+            r[8] = _mm512_fnmadd_pd( two, _mm512_add_pd( x2, y2 ), one );
+            batch_store_avx512<9>( r, n, i, R );
+        }
+        batch_quaternion_to_rotation_basic( q, n, i, R );
+    }
+
+    KORTEX_TARGET_AVX512
+    static inline __m512d select_avx512( const __mmask8& my, const __mmask8& mz, const __mmask8& mw,
+                                         const __m512d& vx, const __m512d& vy, const __m512d& vz, const __m512d& vw ) {
+        __m512d v = _mm512_mask_blend_pd( my, vx, vy );
+        v = _mm512_mask_blend_pd( mz, v, vz );
+        return _mm512_mask_blend_pd( mw, v, vw );
+    }
+
+    KORTEX_TARGET_AVX512
+    static void batch_rotation_to_quaternion_avx512( const double* R, const int& n, double* q ) {
+        const __m512d one  = _mm512_set1_pd( 1.0 );
+        const __m512d half = _mm512_set1_pd( 0.5 );
+        const __m512d zero = _mm512_setzero_pd();
+        int i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m512d r[9], v[4];
+            batch_load_avx512<9>( R, n, i, r );
+            __m512d  tr  = _mm512_add_pd( _mm512_add_pd( r[0], r[4] ), r[8] );
+            __mmask8 mw  = _mm512_cmp_pd_mask( tr, zero, _CMP_GT_OQ );
+            __mmask8 m1  = _mm512_cmp_pd_mask( r[4], r[0], _CMP_GT_OQ );
+            __mmask8 m2  = _mm512_cmp_pd_mask( r[8], _mm512_mask_blend_pd( m1, r[0], r[4] ), _CMP_GT_OQ );
+            __mmask8 mz  = __mmask8( ~mw & m2 );
+            __mmask8 my  = __mmask8( ~mw & ~m2 & m1 );
+            __m512d  tx  = _mm512_sub_pd( _mm512_sub_pd( _mm512_add_pd( one, r[0] ), r[4] ), r[8] );
+            __m512d  ty  = _mm512_sub_pd( _mm512_sub_pd( _mm512_add_pd( one, r[4] ), r[0] ), r[8] );
+            __m512d  tz  = _mm512_sub_pd( _mm512_sub_pd( _mm512_add_pd( one, r[8] ), r[0] ), r[4] );
+            __m512d  tw  = _mm512_add_pd( one, tr );
+            __m512d  s   = _mm512_sqrt_pd( select_avx512( my, mz, mw, tx, ty, tz, tw ) );
+            __m512d  h   = _mm512_mul_pd( half, s );
+            __m512d  f   = _mm512_div_pd( half, s );
+            __m512d  a   = _mm512_mul_pd( _mm512_sub_pd( r[7], r[5] ), f );
+            __m512d  b   = _mm512_mul_pd( _mm512_sub_pd( r[2], r[6] ), f );
+            __m512d  c   = _mm512_mul_pd( _mm512_sub_pd( r[3], r[1] ), f );
+            __m512d  sxy = _mm512_mul_pd( _mm512_add_pd( r[1], r[3] ), f );
+            __m512d  sxz = _mm512_mul_pd( _mm512_add_pd( r[2], r[6] ), f );
+            __m512d  syz = _mm512_mul_pd( _mm512_add_pd( r[5], r[7] ), f );
+            v[0] = select_avx512( my, mz, mw, h,   sxy, sxz, a );
+            v[1] = select_avx512( my, mz, mw, sxy, h,   syz, b );
+            v[2] = select_avx512( my, mz, mw, sxz, syz, h,   c );
+            v[3] = select_avx512( my, mz, mw, a,   b,   c,   h );
+            batch_store_avx512<4>( v, n, i, q );
+        }
+        batch_rotation_to_quaternion_basic( R, n, i, q );
+    }
+#endif
+
+//
+// dispatch
+//
+    void batch_det_3( const double* A, const int& n, double* d ) {
+        passert_pointer( A && d );
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: batch_det_3_avx512( A, n, d ); return;
+        case SIMD_AVX2  : batch_det_3_avx2  ( A, n, d ); return;
+        default         : break;
+        }
+#endif
+        batch_det_basic<3>( A, n, 0, d );
+    }
+
+    void batch_det_4( const double* A, const int& n, double* d ) {
+        passert_pointer( A && d );
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: batch_det_4_avx512( A, n, d ); return;
+        case SIMD_AVX2  : batch_det_4_avx2  ( A, n, d ); return;
+        default         : break;
+        }
+#endif
+        batch_det_basic<4>( A, n, 0, d );
+    }
+
+    int batch_inv_3( const double* A, const int& n, const double& inversion_threshold,
+                     double* iA, uchar* valid ) {
+        passert_pointer( A && iA );
+        passert_noalias_p( A, iA );
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: return batch_inv_3_avx512( A, n, inversion_threshold, iA, valid );
+        case SIMD_AVX2  : return batch_inv_3_avx2  ( A, n, inversion_threshold, iA, valid );
+        default         : break;
+        }
+#endif
+        return batch_inv_basic<3>( A, n, 0, inversion_threshold, iA, valid );
+    }
+
+    int batch_inv_4( const double* A, const int& n, const double& inversion_threshold,
+                     double* iA, uchar* valid ) {
+        passert_pointer( A && iA );
+        passert_noalias_p( A, iA );
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: return batch_inv_4_avx512( A, n, inversion_threshold, iA, valid );
+        case SIMD_AVX2  : return batch_inv_4_avx2  ( A, n, inversion_threshold, iA, valid );
+        default         : break;
+        }
+#endif
+        return batch_inv_basic<4>( A, n, 0, inversion_threshold, iA, valid );
+    }
+
+    template<int D>
+    static void batch_mat_vec( const double* A, const double* x, const int& n, const bool& trans, double* y ) {
+        passert_pointer( A && x && y );
+        passert_noalias_p( x, y );
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: batch_mat_vec_avx512<D>( A, x, n, trans, y ); return;
+        case SIMD_AVX2  : batch_mat_vec_avx2<D>  ( A, x, n, trans, y ); return;
+        default         : break;
+        }
+#endif
+        batch_mat_vec_basic<D>( A, x, n, 0, trans, y );
+    }
+
+    void batch_mat_vec_3( const double* A, const double* x, const int& n, double* y ) {
+        batch_mat_vec<3>( A, x, n, false, y );
+    }
+
+    void batch_mat_vec_4( const double* A, const double* x, const int& n, double* y ) {
+        batch_mat_vec<4>( A, x, n, false, y );
+    }
+
+    void batch_mat_trans_vec_3( const double* A, const double* x, const int& n, double* y ) {
+        batch_mat_vec<3>( A, x, n, true, y );
+    }
+
+    void batch_quaternion_to_rotation( const double* q, const int& n, double* R ) {
+        passert_pointer( q && R );
+        passert_noalias_p( q, R );
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: batch_quaternion_to_rotation_avx512( q, n, R ); return;
+        case SIMD_AVX2  : batch_quaternion_to_rotation_avx2  ( q, n, R ); return;
+        default         : break;
+        }
+#endif
+        batch_quaternion_to_rotation_basic( q, n, 0, R );
+    }
+
+    void batch_rotation_to_quaternion( const double* R, const int& n, double* q ) {
+        passert_pointer( q && R );
+        passert_noalias_p( q, R );
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: batch_rotation_to_quaternion_avx512( R, n, q ); return;
+        case SIMD_AVX2  : batch_rotation_to_quaternion_avx2  ( R, n, q ); return;
+        default         : break;
+        }
+#endif
+        batch_rotation_to_quaternion_basic( R, n, 0, q );
+    }
+
+    /// sin/cos are evaluated with the scalar libm - the rest is a few
+    /// multiplications which the compiler vectorizes on the soa layout.
+    void batch_axisangle_to_quaternion( const double* aa, const int& n, double* q ) {
+        passert_pointer( aa && q );
+        const double* ax = aa;
+        const double* ay = aa +   size_t(n);
+        const double* az = aa + 2*size_t(n);
+        const double* an = aa + 3*size_t(n);
+        for( int i=0; i<n; i++ ) {
+            double t = 0.5*an[i];
+            double s = std::sin( t );
+            q[ i              ] = ax[i] * s;
+            q[ i +   size_t(n)] = ay[i] * s;
+            q[ i + 2*size_t(n)] = az[i] * s;
+            q[ i + 3*size_t(n)] = std::cos( t );
+        }
+    }
+
+    void batch_axisangle_to_rotation( const double* aa, const int& n, double* R ) {
+        passert_pointer( aa && R );
+        if( n <= 0 ) return;
+        double* q = NULL;
+        allocate( q, 4*size_t(n) );
+        batch_axisangle_to_quaternion( aa, n, q );
+        batch_quaternion_to_rotation ( q,  n, R );
+        deallocate( q );
+    }
+
+}
@@ -15,9 +15,19 @@
 #include <kortex/check.h>
 #include <kortex/defs.h>
 
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#include <malloc.h>
+#endif
+
 namespace kortex {
 
-    const static size_t simd_alignment = 2*sizeof(double);
+    const static size_t simd_alignment = MEMORY_ALIGNMENT;
 
     /// creates a memory segment such that the returned memory address is
     /// divisible by 'alignment'. 'alignment' is intended to be 16, 32, 64
@@ -36,21 +46,130 @@ namespace kortex {
         free(ptr);
     }
 
-    void* allocate(const size_t& sz) {
+    static void* system_allocate( const size_t& sz ) {
         void* ptr = NULL;
-
-#if defined( __GNUC__ ) && defined( WITH_SSE )
-        const int ret = posix_memalign(&ptr, simd_alignment, sz);
-        if (ret != 0) ptr = NULL;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+        ptr = _aligned_malloc( sz, simd_alignment );
 #else
-        ptr = (void*)malloc(sz);
+        if( posix_memalign( &ptr, simd_alignment, sz ) != 0 ) ptr = NULL;
 #endif
         return ptr;
     }
 
+    static void system_deallocate( void* ptr ) {
+#if defined(_MSC_VER) || defined(__MINGW32__)
+        _aligned_free( ptr );
+#else
+        free( ptr );
+#endif
+    }
+
+    /// released blocks are kept in free lists per size class. the pool is
+    /// never destroyed so that static objects can still release their memory
+    /// at exit.
+    struct MemoryPool {
+        std::mutex                                  lock;
+        std::map< size_t, std::vector<void*> >      blocks;
+        std::atomic<bool>                           enabled;
+        size_t                                      cached;
+        size_t                                      max_cached;
+        MemoryPool() : enabled(false), cached(0), max_cached(0) {}
+    };
+
+    static MemoryPool& memory_pool() {
+        static MemoryPool* pool = new MemoryPool();
+        return *pool;
+    }
+
+    /// 4 size classes per power of two - a pooled block is at most 25% larger
+    /// than requested
+    static size_t pool_size_class( const size_t& sz ) {
+        if( sz <= simd_alignment ) return simd_alignment;
+        int b = 0;
+        while( ( size_t(1) << (b+1) ) < sz ) b++;
+        size_t step = size_t(1) << (b-2);
+        return ( sz + step-1 ) & ~( step-1 );
+    }
+
+    /// every block starts with a header of one alignment unit holding the
+    /// size class of the block ( 0 for blocks allocated while the pool was
+    /// disabled - they are never pooled ).
+    static const size_t block_header = simd_alignment;
+
+    void* allocate( const size_t& sz ) {
+        MemoryPool& pool = memory_pool();
+        size_t cls = 0;
+        if( pool.enabled ) {
+            std::lock_guard<std::mutex> guard( pool.lock );
+            // disable_memory_pool() may have run since the unlocked check
+            if( pool.enabled ) {
+                cls = pool_size_class( sz );
+                std::map< size_t, std::vector<void*> >::iterator it = pool.blocks.find( cls );
+                if( it != pool.blocks.end() && !it->second.empty() ) {
+                    void* ptr = it->second.back();
+                    it->second.pop_back();
+                    pool.cached -= cls;
+                    return ptr;
+                }
+            }
+        }
+        uchar* base = (uchar*)system_allocate( ( cls ? cls : sz ) + block_header );
+        if( base == NULL ) return NULL;
+        *(size_t*)base = cls;
+        return base + block_header;
+    }
+
     void deallocate( void *ptr ) {
-        free((void*)ptr);
-        ptr = NULL;
+        if( ptr == NULL ) return;
+        uchar* base = (uchar*)ptr - block_header;
+        size_t cls  = *(size_t*)base;
+        MemoryPool& pool = memory_pool();
+        if( cls && pool.enabled ) {
+            std::lock_guard<std::mutex> guard( pool.lock );
+            if( pool.enabled && pool.cached + cls <= pool.max_cached ) {
+                pool.blocks[cls].push_back( ptr );
+                pool.cached += cls;
+                return;
+            }
+        }
+        system_deallocate( base );
+    }
+
+    void enable_memory_pool( const size_t& max_cached_bytes ) {
+        MemoryPool& pool = memory_pool();
+        std::lock_guard<std::mutex> guard( pool.lock );
+        pool.max_cached = max_cached_bytes;
+        pool.enabled    = true;
+    }
+
+    // pool.lock has to be held
+    static void release_pool_blocks( MemoryPool& pool ) {
+        std::map< size_t, std::vector<void*> >::iterator it;
+        for( it=pool.blocks.begin(); it!=pool.blocks.end(); it++ ) {
+            for( size_t i=0; i<it->second.size(); i++ )
+                system_deallocate( (uchar*)it->second[i] - block_header );
+        }
+        pool.blocks.clear();
+        pool.cached = 0;
+    }
+
+    void release_memory_pool() {
+        MemoryPool& pool = memory_pool();
+        std::lock_guard<std::mutex> guard( pool.lock );
+        release_pool_blocks( pool );
+    }
+
+    void disable_memory_pool() {
+        MemoryPool& pool = memory_pool();
+        std::lock_guard<std::mutex> guard( pool.lock );
+        pool.enabled = false;
+        release_pool_blocks( pool );
+    }
+
+    size_t memory_pool_cached_bytes() {
+        MemoryPool& pool = memory_pool();
+        std::lock_guard<std::mutex> guard( pool.lock );
+        return pool.cached;
     }
 
     void allocate( int*& ptr, const size_t& n_elem ) {
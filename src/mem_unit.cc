@@ -42,6 +42,18 @@ namespace kortex {
         return *this;
     }
 
+    MemUnit::MemUnit( MemUnit&& mem ) noexcept {
+        init_();
+        swap( &mem );
+    }
+    MemUnit& MemUnit::operator=( MemUnit&& mem ) {
+        if( &mem != this ) {
+            deallocate();
+            swap( &mem );
+        }
+        return *this;
+    }
+
     void MemUnit::copy( const MemUnit& mem ) {
         init_();
         resize( mem.capacity() );
@@ -30,10 +30,10 @@ namespace kortex {
         return num2str(val);
     }
 
-    // template< typename T >
-    // void PairIndexedArray<T>::reserve( const int& n_samples ) {
-        // m_array.reserve( n_samples );
-    // }
+    template< typename IndexType, typename T >
+    void PairIndexedArray<IndexType,T>::reserve( const int& n_samples ) {
+        m_array.reserve( n_samples );
+    }
 
     // template< typename IndexType, typename T >
     // void PairIndexedArray<IndexType,T>::report( int mode ) const {
@@ -75,25 +75,17 @@ namespace kortex {
 
     template< typename IndexType, typename T >
     const T& PairIndexedArray<IndexType,T>::add( const IndexType& x, const IndexType& y, const T& val ) {
-        itpair p = itpair(x,y);
-        auto it = m_array.find( p );
-        if( it == m_array.end() ) {
-            m_array[ p ] = val;
-        } else {
-            it->second += val;
-        }
-        // if( is_present( x,y ) )
-            // m_array[ p ] += val;
-        // else
-            // m_array[ p ] = val;
-
-        return it->second;
+        auto ins = m_array.insert( std::make_pair( itpair(x,y), val ) );
+        if( !ins.second )
+            ins.first->second += val;
+        return ins.first->second;
     }
 
     template< typename IndexType, typename T >
     T PairIndexedArray<IndexType,T>::get( const IndexType& x, const IndexType& y ) const {
-        assert_statement_g( is_present(x,y), "key does not exist [x,y] = [%d,%d]", x, y );
-        return m_array.at( itpair(x,y) );
+        auto it = m_array.find( itpair(x,y) );
+        passert_statement_g( it != m_array.end(), "key does not exist [x,y] = [%d,%d]", (int)x, (int)y );
+        return it->second;
     }
 
     template< typename IndexType, typename T >
@@ -104,18 +96,21 @@ namespace kortex {
         for( auto it=m_array.begin(); it !=m_array.end(); ++it, ++cnt ) {
             pairs[cnt].init( it->first.first, it->first.second, it->second );
         }
+        sort( pairs.begin(), pairs.end(), pair_value_cmp_ids<IndexType,T> );
     }
 
     template< typename IndexType, typename T >
-    int PairIndexedArray<IndexType,T>::filter_array( const T& th ) {
-        int cnt = 0;
-        for( auto it=m_array.begin(); it!=m_array.end(); ++it ) {
-            if( it->second >= th )
-                continue;
-            m_array.erase( it );
-            cnt++;
+    struct PairValueBelow {
+        T th;
+        PairValueBelow( const T& th_ ) : th(th_) {}
+        bool operator()( const std::pair< std::pair<IndexType,IndexType>, T >& p ) const {
+            return p.second < th;
         }
-        return cnt;
+    };
+
+    template< typename IndexType, typename T >
+    int PairIndexedArray<IndexType,T>::filter_array( const T& th ) {
+        return (int)m_array.erase_if( PairValueBelow<IndexType,T>( th ) );
     }
 
     template< typename IndexType, typename T >
@@ -149,8 +144,9 @@ namespace kortex {
         int sz=0;
         read_bparam( fin, sz );
 
-        int x, y;
-        T   val;
+        m_array.reserve( sz );
+        IndexType x, y;
+        T         val;
         for( int i=0; i<sz; i++ ) {
             read_bparam( fin, x );
             read_bparam( fin, y );
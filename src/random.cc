@@ -18,8 +18,6 @@
 #include <climits>
 
 #include <kortex/check.h>
-#include <kortex/keyed_value.h>
-#include <kortex/mem_manager.h>
 
 #include <kortex/random.h>
 
@@ -41,99 +39,143 @@ namespace kortex {
 
     double uniform_sample() {
         // return double(rand())/RAND_MAX;
-        return random_generator()->uniform_sample();
+        return thread_random_generator()->uniform_sample();
     }
 
     double normal_sample() {
-        return random_generator()->normal_sample();
+        return thread_random_generator()->normal_sample();
     }
 
     uint32_t random_sample() {
-        return random_generator()->rv();
+        return thread_random_generator()->rv();
     }
 
     uint32_t max_random_sample() {
-        return random_generator()->max();
+        return thread_random_generator()->max();
     }
 
-    bool select_random_samples(const int& minval, const int& maxval, const int& no_samples,
-                               int *selected_samples) {
+    void uniform_samples( float* out, const size_t& n ) {
+        thread_random_generator()->fill_uniform( out, n );
+    }
+
+    void uniform_samples( double* out, const size_t& n ) {
+        thread_random_generator()->fill_uniform( out, n );
+    }
 
+    void normal_samples( float* out, const size_t& n ) {
+        thread_random_generator()->fill_normal( out, n );
+    }
+
+    void normal_samples( double* out, const size_t& n ) {
+        thread_random_generator()->fill_normal( out, n );
+    }
+
+    RandomSampler::RandomSampler() {
+        m_stamp = 0;
+    }
+
+    /// inserts v to the scratch table - returns false if v is already in
+    bool RandomSampler::insert( const int& v ) {
+        uint32_t mask = uint32_t( m_keys.size() ) - 1;
+        uint32_t h    = uint32_t(v) * 0x9E3779B1u;
+        h = ( h ^ ( h >> 16 ) ) & mask;
+        while( m_stamps[h] == m_stamp ) {
+            if( m_keys[h] == v )
+                return false;
+            h = ( h+1 ) & mask;
+        }
+        m_stamps[h] = m_stamp;
+        m_keys  [h] = v;
+        return true;
+    }
+
+    bool RandomSampler::select( const int& minval, const int& maxval, const int& no_samples,
+                                int* selected_samples ) {
+        return select( minval, maxval, no_samples, *thread_random_generator(), selected_samples );
+    }
+
+    bool RandomSampler::select( const int& minval, const int& maxval, const int& no_samples, PhiloxGenerator& gen,
+                                int* selected_samples ) {
         assert_pointer( selected_samples );
         assert_statement_g( is_positive_number(no_samples), "[no_samples %d] must be positive", no_samples );
 
         int range = maxval - minval;
         if( range < no_samples ) return false;
 
-        // if range is larger than no_samples then there's no problem
-        if( range > no_samples*2 ) {
-            int counter = 0;
-            while( counter < no_samples ) {
-                int sample = (int)(uniform_sample()*range)+minval;
-                if( sample >= maxval ) continue;
+        // floyd: for j in [range-k, range) pick t in [0,j] - if t is already
+        // selected select j which cannot be.
+        int counter = 0;
+        if( no_samples <= 16 ) { // a linear scan beats the table for minimal samples
+            for( int j=range-no_samples; j<range; j++ ) {
+                int sample = int( gen.uniform_index( uint32_t(j+1) ) ) + minval;
                 if( counter != 0 && is_inside(selected_samples, counter, sample) )
-                    continue;
-                selected_samples[counter] = sample;
-                counter ++;
+                    sample = j + minval;
+                selected_samples[counter++] = sample;
             }
             return true;
-        } else { // select which samples not to select since they are less in number
-            // logman_warning( "Beware - this segment was not tested throughly - could have bugs" );
-            int excluded_sample_no = range - no_samples;
-            assert_statement( excluded_sample_no > 0, "this should not be" );
-            int * temp_space = NULL;
-            allocate( temp_space, excluded_sample_no );
-            int counter = 0;
-            while( counter < excluded_sample_no ) {
-                int sample = (int)(uniform_sample()*range)+minval;
-                if( counter != 0 && is_inside(temp_space, counter, sample) )
-                    continue;
-                temp_space[counter] = sample;
-                counter ++;
-            }
-            counter = 0;
-            for( int i=minval; i<maxval; i++ ) {
-                if( is_inside(temp_space, excluded_sample_no, i) )
-                    continue;
-                selected_samples[counter] = i;
-                counter++;
+        }
+
+        size_t tsz = 1;
+        while( tsz < 2*size_t(no_samples) ) tsz <<= 1;
+        if( m_keys.size() < tsz ) {
+            m_keys  .assign( tsz, 0 );
+            m_stamps.assign( tsz, 0 );
+            m_stamp = 0;
+        }
+        if( ++m_stamp == 0 ) { // stamps wrapped - clear the table
+            std::fill( m_stamps.begin(), m_stamps.end(), 0 );
+            m_stamp = 1;
+        }
+        for( int j=range-no_samples; j<range; j++ ) {
+            int sample = int( gen.uniform_index( uint32_t(j+1) ) );
+            if( !insert(sample) ) {
+                sample = j;
+                insert( sample );
             }
-            deallocate( temp_space );
-            return true;
+            selected_samples[counter++] = sample + minval;
         }
+        return true;
+    }
+
+    bool select_random_samples(const int& minval, const int& maxval, const int& no_samples,
+                               int *selected_samples) {
+        RandomSampler sampler;
+        return sampler.select( minval, maxval, no_samples, selected_samples );
+    }
+
+    int prosac_sample_range( const int& prosac_iter, const int& selection_limit ) {
+        int   prosac_start = 32;
+        // float prosac_inc   = 0.5f;
+        return std::min( selection_limit, prosac_start + (prosac_iter/2) );
     }
 
     void select_prosac_like_random_samples(const int& prosac_iter, const int& selection_limit, const int& no_samples_to_select,
                                            int* selected_samples) {
+        RandomSampler sampler;
+        select_prosac_like_random_samples( prosac_iter, selection_limit, no_samples_to_select, sampler, selected_samples );
+    }
+
+    void select_prosac_like_random_samples(const int& prosac_iter, const int& selection_limit, const int& no_samples_to_select,
+                                           RandomSampler& sampler, int* selected_samples) {
         // implements select_from_top for use with prosac.
         assert_pointer( selected_samples );
         assert_statement_g( is_nonnegative_number(prosac_iter),       "prosac iteration must be a positive integer [%d]", prosac_iter );
         assert_statement_g( is_positive_number(no_samples_to_select), "no_samples_to_select must be > 0 [%d]", no_samples_to_select);
         assert_statement_g( is_positive_number(selection_limit),      "selection_limit must be > 0 [%d]", selection_limit);
 
-        int   prosac_start = 32;
-        // float prosac_inc   = 0.5f;
-        int allowed_range = std::min( selection_limit, prosac_start + (prosac_iter/2) );
+        int allowed_range = prosac_sample_range( prosac_iter, selection_limit );
         assert_statement_g( no_samples_to_select < selection_limit, "[no_samples %d] [iter %d], [n_max_samples %d] [allowed range %d] > [no_samples %d]", no_samples_to_select, prosac_iter, selection_limit, allowed_range, no_samples_to_select );
         assert_statement_g( allowed_range > no_samples_to_select,   "[no_samples %d] [iter %d], [n_max_samples %d] [allowed range %d] > [no_samples %d]", no_samples_to_select, prosac_iter, selection_limit, allowed_range, no_samples_to_select );
-        if( !select_random_samples(0, allowed_range, no_samples_to_select, selected_samples) )
+        if( !sampler.select(0, allowed_range, no_samples_to_select, selected_samples) )
             logman_fatal_g("could not select enough random samples [prosac_iter %d] [no_samples_to_select %d] [selection_limit %d]", prosac_iter, no_samples_to_select, selection_limit);
     }
 
     void random_permutation( int n, std::vector<int>& perm ) {
         assert_statement( n>0, "number of samples is not positive" );
-
-        vector<ifloat> nums( n );
-        for( int i=0; i<n; i++ ) {
-            nums[i].key = i;
-            nums[i].val = (float)uniform_sample();
-        }
-        sort_ascending( nums );
-
-        perm.clear();
         perm.resize( n );
         for( int i=0; i<n; i++ )
-            perm[i] = nums[i].key;
+            perm[i] = i;
+        random_shuffle( &perm[0], n );
     }
 
 }
@@ -14,11 +14,726 @@
 // ---------------------------------------------------------------------------
 
 #include <kortex/random_generator.h>
+#include <kortex/cpu_features.h>
+#include <kortex/check.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
 
 namespace kortex {
 
+    using std::vector;
+
     RandomGenerator g_random;
 
     RandomGenerator* random_generator() { return &g_random; }
 
+    //
+    // philox4x32-10 - salmon et al. "parallel random numbers: as easy as
+    // 1, 2, 3", sc 2011.
+    //
+    static const uint32_t PHILOX_M0 = 0xD2511F53;
+    static const uint32_t PHILOX_M1 = 0xCD9E8D57;
+    static const uint32_t PHILOX_W0 = 0x9E3779B9;
+    static const uint32_t PHILOX_W1 = 0xBB67AE85;
+    static const int      PHILOX_ROUNDS = 10;
+
+    static inline void mulhilo( const uint32_t& a, const uint32_t& b, uint32_t& hi, uint32_t& lo ) {
+        uint64_t p = uint64_t(a) * uint64_t(b);
+        hi = uint32_t( p >> 32 );
+        lo = uint32_t( p );
+    }
+
+    void philox4x32( const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4] ) {
+        uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+        uint32_t k0 = key[0], k1 = key[1];
+        for( int r=0; r<PHILOX_ROUNDS; r++ ) {
+            uint32_t hi0, lo0, hi1, lo1;
+            mulhilo( PHILOX_M0, c0, hi0, lo0 );
+            mulhilo( PHILOX_M1, c2, hi1, lo1 );
+            c0 = hi1 ^ c1 ^ k0;
+            c1 = lo1;
+            c2 = hi0 ^ c3 ^ k1;
+            c3 = lo0;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+    /// block index b of stream s with seed k: ctr = ( b, s ), key = k
+    static inline void philox_block( const uint64_t& seed, const uint64_t& stream, const uint64_t& block,
+                                     uint32_t out[4] ) {
+        const uint32_t ctr[4] = { uint32_t(block), uint32_t(block>>32), uint32_t(stream), uint32_t(stream>>32) };
+        const uint32_t key[2] = { uint32_t(seed), uint32_t(seed>>32) };
+        philox4x32( ctr, key, out );
+    }
+
+    static void philox_blocks_basic( const uint64_t& seed, const uint64_t& stream, const uint64_t& block,
+                                     const size_t& n_blocks, uint32_t* out ) {
+        for( size_t i=0; i<n_blocks; i++ )
+            philox_block( seed, stream, block+i, out+4*i );
+    }
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+    // the kernels evaluate 8 ( 16 ) consecutive counters in the lanes and
+    // transpose the results to the block order of the scalar generator.
+
+    KORTEX_TARGET_AVX2
+    static inline void mulhilo_avx2( const __m256i& a, const __m256i& m, __m256i& hi, __m256i& lo ) {
+        __m256i pe = _mm256_mul_epu32( a, m );
+        __m256i po = _mm256_mul_epu32( _mm256_srli_epi64( a, 32 ), m );
+        lo = _mm256_blend_epi32( pe, _mm256_slli_epi64( po, 32 ), 0xAA );
+        hi = _mm256_blend_epi32( _mm256_srli_epi64( pe, 32 ), po, 0xAA );
+    }
+
+    KORTEX_TARGET_AVX2
+    static void philox_blocks_avx2( const uint64_t& seed, const uint64_t& stream, const uint64_t& block,
+                                    const size_t& n_blocks, uint32_t* out ) {
+        const __m256i m0   = _mm256_set1_epi32( int(PHILOX_M0) );
+        const __m256i m1   = _mm256_set1_epi32( int(PHILOX_M1) );
+        const __m256i lane = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+        size_t i = 0;
+        for( ; i+8<=n_blocks; i+=8 ) {
+            uint64_t b = block + i;
+            if( uint32_t(b) > UINT32_MAX-7 ) { // low counter word wraps inside the batch
+                philox_blocks_basic( seed, stream, b, 8, out+4*i );
+                continue;
+            }
+            __m256i c0 = _mm256_add_epi32( _mm256_set1_epi32( int(uint32_t(b)) ), lane );
+            __m256i c1 = _mm256_set1_epi32( int(uint32_t(b>>32)) );
+            __m256i c2 = _mm256_set1_epi32( int(uint32_t(stream)) );
+            __m256i c3 = _mm256_set1_epi32( int(uint32_t(stream>>32)) );
+            uint32_t k0 = uint32_t(seed);
+            uint32_t k1 = uint32_t(seed>>32);
+            for( int r=0; r<PHILOX_ROUNDS; r++ ) {
+                __m256i hi0, lo0, hi1, lo1;
+                mulhilo_avx2( c0, m0, hi0, lo0 );
+                mulhilo_avx2( c2, m1, hi1, lo1 );
+                c0 = _mm256_xor_si256( _mm256_xor_si256( hi1, c1 ), _mm256_set1_epi32( int(k0) ) );
+                c1 = lo1;
+                c2 = _mm256_xor_si256( _mm256_xor_si256( hi0, c3 ), _mm256_set1_epi32( int(k1) ) );
+                c3 = lo0;
+                k0 += PHILOX_W0;
+                k1 += PHILOX_W1;
+            }
+            __m256i t0 = _mm256_unpacklo_epi32( c0, c1 );
+            __m256i t1 = _mm256_unpacklo_epi32( c2, c3 );
+            __m256i t2 = _mm256_unpackhi_epi32( c0, c1 );
+            __m256i t3 = _mm256_unpackhi_epi32( c2, c3 );
+            __m256i r0 = _mm256_unpacklo_epi64( t0, t1 ); // blocks 0 | 4
+            __m256i r1 = _mm256_unpackhi_epi64( t0, t1 ); // blocks 1 | 5
+            __m256i r2 = _mm256_unpacklo_epi64( t2, t3 ); // blocks 2 | 6
+            __m256i r3 = _mm256_unpackhi_epi64( t2, t3 ); // blocks 3 | 7
+            __m256i* dst = (__m256i*)( out + 4*i );
+            _mm256_storeu_si256( dst  , _mm256_permute2x128_si256( r0, r1, 0x20 ) );
+            _mm256_storeu_si256( dst+1, _mm256_permute2x128_si256( r2, r3, 0x20 ) );
+            _mm256_storeu_si256( dst+2, _mm256_permute2x128_si256( r0, r1, 0x31 ) );
+            _mm256_storeu_si256( dst+3, _mm256_permute2x128_si256( r2, r3, 0x31 ) );
+        }
+        philox_blocks_basic( seed, stream, block+i, n_blocks-i, out+4*i );
+    }
+
+    KORTEX_TARGET_AVX512
+    static inline void mulhilo_avx512( const __m512i& a, const __m512i& m, __m512i& hi, __m512i& lo ) {
+        __m512i pe = _mm512_mul_epu32( a, m );
+        __m512i po = _mm512_mul_epu32( _mm512_srli_epi64( a, 32 ), m );
+        lo = _mm512_mask_blend_epi32( 0xAAAA, pe, _mm512_slli_epi64( po, 32 ) );
+        hi = _mm512_mask_blend_epi32( 0xAAAA, _mm512_srli_epi64( pe, 32 ), po );
+    }
+
+    KORTEX_TARGET_AVX512
+    static void philox_blocks_avx512( const uint64_t& seed, const uint64_t& stream, const uint64_t& block,
+                                      const size_t& n_blocks, uint32_t* out ) {
+        const __m512i m0   = _mm512_set1_epi32( int(PHILOX_M0) );
+        const __m512i m1   = _mm512_set1_epi32( int(PHILOX_M1) );
+        const __m512i lane = _mm512_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 );
+        size_t i = 0;
+        for( ; i+16<=n_blocks; i+=16 ) {
+            uint64_t b = block + i;
+            if( uint32_t(b) > UINT32_MAX-15 ) {
+                philox_blocks_basic( seed, stream, b, 16, out+4*i );
+                continue;
+            }
+            __m512i c0 = _mm512_add_epi32( _mm512_set1_epi32( int(uint32_t(b)) ), lane );
+            __m512i c1 = _mm512_set1_epi32( int(uint32_t(b>>32)) );
+            __m512i c2 = _mm512_set1_epi32( int(uint32_t(stream)) );
+            __m512i c3 = _mm512_set1_epi32( int(uint32_t(stream>>32)) );
+            uint32_t k0 = uint32_t(seed);
+            uint32_t k1 = uint32_t(seed>>32);
+            for( int r=0; r<PHILOX_ROUNDS; r++ ) {
+                __m512i hi0, lo0, hi1, lo1;
+                mulhilo_avx512( c0, m0, hi0, lo0 );
+                mulhilo_avx512( c2, m1, hi1, lo1 );
+                c0 = _mm512_xor_si512( _mm512_xor_si512( hi1, c1 ), _mm512_set1_epi32( int(k0) ) );
+                c1 = lo1;
+                c2 = _mm512_xor_si512( _mm512_xor_si512( hi0, c3 ), _mm512_set1_epi32( int(k1) ) );
+                c3 = lo0;
+                k0 += PHILOX_W0;
+                k1 += PHILOX_W1;
+            }
+            __m512i t0 = _mm512_unpacklo_epi32( c0, c1 );
+            __m512i t1 = _mm512_unpacklo_epi32( c2, c3 );
+            __m512i t2 = _mm512_unpackhi_epi32( c0, c1 );
+            __m512i t3 = _mm512_unpackhi_epi32( c2, c3 );
+            __m512i r0 = _mm512_unpacklo_epi64( t0, t1 ); // blocks 0 | 4 |  8 | 12
+            __m512i r1 = _mm512_unpackhi_epi64( t0, t1 ); // blocks 1 | 5 |  9 | 13
+            __m512i r2 = _mm512_unpacklo_epi64( t2, t3 ); // blocks 2 | 6 | 10 | 14
+            __m512i r3 = _mm512_unpackhi_epi64( t2, t3 ); // blocks 3 | 7 | 11 | 15
+            // regroup the 128-bit lanes as ( 0 1 2 3 ) ( 4 5 6 7 ) ...
+            const __m512i lo_idx = _mm512_setr_epi64( 0, 1,  8,  9, 2, 3, 10, 11 );
+            const __m512i hi_idx = _mm512_setr_epi64( 4, 5, 12, 13, 6, 7, 14, 15 );
+            __m512i a0 = _mm512_permutex2var_epi64( r0, lo_idx, r1 ); // 0 1 4 5
+            __m512i a1 = _mm512_permutex2var_epi64( r2, lo_idx, r3 ); // 2 3 6 7
+            __m512i a2 = _mm512_permutex2var_epi64( r0, hi_idx, r1 ); // 8 9 12 13
+            __m512i a3 = _mm512_permutex2var_epi64( r2, hi_idx, r3 ); // 10 11 14 15
+            const __m512i lo_cat = _mm512_setr_epi64( 0, 1, 2, 3,  8,  9, 10, 11 );
+            const __m512i hi_cat = _mm512_setr_epi64( 4, 5, 6, 7, 12, 13, 14, 15 );
+            __m512i* dst = (__m512i*)( out + 4*i );
+            _mm512_storeu_si512( dst  , _mm512_permutex2var_epi64( a0, lo_cat, a1 ) );
+            _mm512_storeu_si512( dst+1, _mm512_permutex2var_epi64( a0, hi_cat, a1 ) );
+            _mm512_storeu_si512( dst+2, _mm512_permutex2var_epi64( a2, lo_cat, a3 ) );
+            _mm512_storeu_si512( dst+3, _mm512_permutex2var_epi64( a2, hi_cat, a3 ) );
+        }
+        philox_blocks_basic( seed, stream, block+i, n_blocks-i, out+4*i );
+    }
+#endif
+
+    static void philox_blocks( const uint64_t& seed, const uint64_t& stream, const uint64_t& block,
+                               const size_t& n_blocks, uint32_t* out ) {
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: philox_blocks_avx512( seed, stream, block, n_blocks, out ); return;
+        case SIMD_AVX2  : philox_blocks_avx2  ( seed, stream, block, n_blocks, out ); return;
+        default         : break;
+        }
+#endif
+        philox_blocks_basic( seed, stream, block, n_blocks, out );
+    }
+
+    static inline float to_uniform_f( const uint32_t& a ) {
+        return float( a >> 8 ) * ( 1.0f / 16777216.0f );
+    }
+
+    static inline double to_uniform_d( const uint32_t& a, const uint32_t& b ) {
+        return ( double( a >> 5 ) * 67108864.0 + double( b >> 6 ) ) * ( 1.0 / 9007199254740992.0 );
+    }
+
+    //
+    // box-muller. log and sincos are polynomial approximations ( fdlibm
+    // coefficients, about 1 ulp ) evaluated with the same sequence of
+    // correctly rounded operations in the scalar and the simd kernels - every
+    // product that feeds a sum is an explicit fma - so the bulk fills give
+    // bit for bit the values of normal_sample() at every simd level.
+    //
+    static const double BM_LG1 = 6.666666666666735130e-01;
+    static const double BM_LG2 = 3.999999999940941908e-01;
+    static const double BM_LG3 = 2.857142874366239149e-01;
+    static const double BM_LG4 = 2.222219843214978396e-01;
+    static const double BM_LG5 = 1.818357216161805012e-01;
+    static const double BM_LG6 = 1.531383769920937332e-01;
+    static const double BM_LG7 = 1.479819860511658591e-01;
+    static const double BM_LN2_HI = 6.93147180369123816490e-01;
+    static const double BM_LN2_LO = 1.90821492927058770002e-10;
+
+    static const double BM_S1 = -1.66666666666666324348e-01;
+    static const double BM_S2 =  8.33333333332248946124e-03;
+    static const double BM_S3 = -1.98412698298579493134e-04;
+    static const double BM_S4 =  2.75573137070700676789e-06;
+    static const double BM_S5 = -2.50507602534068634195e-08;
+    static const double BM_S6 =  1.58969099521155010221e-10;
+    static const double BM_C1 =  4.16666666666666019037e-02;
+    static const double BM_C2 = -1.38888888888741095749e-03;
+    static const double BM_C3 =  2.48015872894767294178e-05;
+    static const double BM_C4 = -2.75573143513906633035e-07;
+    static const double BM_C5 =  2.08757232129817482790e-09;
+    static const double BM_C6 = -1.13596475577881948265e-11;
+    static const double BM_TWO_PI = 6.283185307179586;
+
+    // x = 2^k m with m in [sqrt(2)/2,sqrt(2)) - the offset moves the
+    // exponent boundary to sqrt(2)
+    static const uint64_t BM_LOG_OFFSET = 0x3ff0000000000000ULL - 0x3fe6a09e667f3bcdULL;
+    static const uint64_t BM_MANT_MASK  = 0x000fffffffffffffULL;
+
+    /// natural log of a normal positive x
+    static inline double bm_log( const double& x ) {
+        uint64_t ix;
+        memcpy( &ix, &x, sizeof(ix) );
+        ix += BM_LOG_OFFSET;
+        double   k  = double( int64_t( ix >> 52 ) - 1023 );
+        uint64_t im = ( ix & BM_MANT_MASK ) + 0x3fe6a09e667f3bcdULL;
+        double   m;
+        memcpy( &m, &im, sizeof(m) );
+        // log(1+f) = f - f^2/2 + s (f^2/2 + R(s^2)) with s = f/(2+f)
+        double f    = m - 1.0;
+        double hfsq = 0.5 * f * f;
+        double s    = f / ( 2.0 + f );
+        double z    = s * s;
+        double p    = BM_LG7;
+        p = std::fma( p, z, BM_LG6 );
+        p = std::fma( p, z, BM_LG5 );
+        p = std::fma( p, z, BM_LG4 );
+        p = std::fma( p, z, BM_LG3 );
+        p = std::fma( p, z, BM_LG2 );
+        p = std::fma( p, z, BM_LG1 );
+        double t = std::fma( z, p, hfsq );
+        double u = std::fma( s, t, k * BM_LN2_LO );
+        return std::fma( k, BM_LN2_HI, ( u - hfsq ) + f );
+    }
+
+    /// cos and sin of 2 pi u for u in [0,1). u is reduced to the nearest
+    /// quarter turn exactly - the polynomials only see [-pi/4,pi/4].
+    static inline void bm_sincos_2pi( const double& u, double& c, double& s ) {
+        double q  = std::floor( std::fma( u, 4.0, 0.5 ) );
+        double a  = std::fma( q, -0.25, u ) * BM_TWO_PI;
+        double z  = a * a;
+        double sp = BM_S6;
+        sp = std::fma( sp, z, BM_S5 );
+        sp = std::fma( sp, z, BM_S4 );
+        sp = std::fma( sp, z, BM_S3 );
+        sp = std::fma( sp, z, BM_S2 );
+        sp = std::fma( sp, z, BM_S1 );
+        double cp = BM_C6;
+        cp = std::fma( cp, z, BM_C5 );
+        cp = std::fma( cp, z, BM_C4 );
+        cp = std::fma( cp, z, BM_C3 );
+        cp = std::fma( cp, z, BM_C2 );
+        cp = std::fma( cp, z, BM_C1 );
+        double sa = std::fma( a * z, sp, a );
+        double ca = std::fma( z * z, cp, std::fma( z, -0.5, 1.0 ) );
+        switch( int( q ) & 3 ) {
+        case 0: c =  ca; s =  sa; break;
+        case 1: c = -sa; s =  ca; break;
+        case 2: c = -ca; s = -sa; break;
+        case 3: c =  sa; s = -ca; break;
+        }
+    }
+
+    static inline void box_muller( const double& u1, const double& u2, double& z0, double& z1 ) {
+        double r = std::sqrt( -2.0 * bm_log( 1.0 - u1 ) );
+        double c, s;
+        bm_sincos_2pi( u2, c, s );
+        z0 = r * c;
+        z1 = r * s;
+    }
+
+    /// out[2i], out[2i+1] = box_muller( u1[i], u2[i] )
+    static void box_muller_basic( const double* u1, const double* u2, const size_t& n, double* out ) {
+        for( size_t i=0; i<n; i++ )
+            box_muller( u1[i], u2[i], out[2*i], out[2*i+1] );
+    }
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+    // the same operations with fma instructions instead of libm calls
+    KORTEX_TARGET_AVX2
+    static void box_muller_fma( const double& u1, const double& u2, double& z0, double& z1 ) {
+        box_muller( u1, u2, z0, z1 );
+    }
+
+    KORTEX_TARGET_AVX2
+    static inline __m256d bm_log_avx2( const __m256d& x ) {
+        __m256i ix = _mm256_add_epi64( _mm256_castpd_si256( x ), _mm256_set1_epi64x( int64_t(BM_LOG_OFFSET) ) );
+        // exponent to double - exact through the 2^52 bias
+        __m256d k  = _mm256_castsi256_pd( _mm256_or_si256( _mm256_srli_epi64( ix, 52 ),
+                                                           _mm256_set1_epi64x( 0x4330000000000000LL ) ) );
+        k = _mm256_sub_pd( _mm256_sub_pd( k, _mm256_set1_pd( 4503599627370496.0 ) ), _mm256_set1_pd( 1023.0 ) );
+        __m256i im = _mm256_add_epi64( _mm256_and_si256( ix, _mm256_set1_epi64x( int64_t(BM_MANT_MASK) ) ),
+                                       _mm256_set1_epi64x( 0x3fe6a09e667f3bcdLL ) );
+        __m256d f    = _mm256_sub_pd( _mm256_castsi256_pd( im ), _mm256_set1_pd( 1.0 ) );
+        __m256d hfsq = _mm256_mul_pd( _mm256_mul_pd( _mm256_set1_pd( 0.5 ), f ), f );
+        __m256d s    = _mm256_div_pd( f, _mm256_add_pd( _mm256_set1_pd( 2.0 ), f ) );
+        __m256d z    = _mm256_mul_pd( s, s );
+        __m256d p    = _mm256_set1_pd( BM_LG7 );
+        p = _mm256_fmadd_pd( p, z, _mm256_set1_pd( BM_LG6 ) );
+        p = _mm256_fmadd_pd( p, z, _mm256_set1_pd( BM_LG5 ) );
+        p = _mm256_fmadd_pd( p, z, _mm256_set1_pd( BM_LG4 ) );
+        p = _mm256_fmadd_pd( p, z, _mm256_set1_pd( BM_LG3 ) );
+        p = _mm256_fmadd_pd( p, z, _mm256_set1_pd( BM_LG2 ) );
+        p = _mm256_fmadd_pd( p, z, _mm256_set1_pd( BM_LG1 ) );
+        __m256d t = _mm256_fmadd_pd( z, p, hfsq );
+        __m256d u = _mm256_fmadd_pd( s, t, _mm256_mul_pd( k, _mm256_set1_pd( BM_LN2_LO ) ) );
+        return _mm256_fmadd_pd( k, _mm256_set1_pd( BM_LN2_HI ), _mm256_add_pd( _mm256_sub_pd( u, hfsq ), f ) );
+    }
+
+    KORTEX_TARGET_AVX2
+    static inline void bm_sincos_2pi_avx2( const __m256d& u, __m256d& c, __m256d& s ) {
+        __m256d q  = _mm256_floor_pd( _mm256_fmadd_pd( u, _mm256_set1_pd( 4.0 ), _mm256_set1_pd( 0.5 ) ) );
+        __m256d a  = _mm256_mul_pd( _mm256_fmadd_pd( q, _mm256_set1_pd( -0.25 ), u ), _mm256_set1_pd( BM_TWO_PI ) );
+        __m256d z  = _mm256_mul_pd( a, a );
+        __m256d sp = _mm256_set1_pd( BM_S6 );
+        sp = _mm256_fmadd_pd( sp, z, _mm256_set1_pd( BM_S5 ) );
+        sp = _mm256_fmadd_pd( sp, z, _mm256_set1_pd( BM_S4 ) );
+        sp = _mm256_fmadd_pd( sp, z, _mm256_set1_pd( BM_S3 ) );
+        sp = _mm256_fmadd_pd( sp, z, _mm256_set1_pd( BM_S2 ) );
+        sp = _mm256_fmadd_pd( sp, z, _mm256_set1_pd( BM_S1 ) );
+        __m256d cp = _mm256_set1_pd( BM_C6 );
+        cp = _mm256_fmadd_pd( cp, z, _mm256_set1_pd( BM_C5 ) );
+        cp = _mm256_fmadd_pd( cp, z, _mm256_set1_pd( BM_C4 ) );
+        cp = _mm256_fmadd_pd( cp, z, _mm256_set1_pd( BM_C3 ) );
+        cp = _mm256_fmadd_pd( cp, z, _mm256_set1_pd( BM_C2 ) );
+        cp = _mm256_fmadd_pd( cp, z, _mm256_set1_pd( BM_C1 ) );
+        __m256d sa = _mm256_fmadd_pd( _mm256_mul_pd( a, z ), sp, a );
+        __m256d ca = _mm256_fmadd_pd( _mm256_mul_pd( z, z ), cp,
+                                      _mm256_fmadd_pd( z, _mm256_set1_pd( -0.5 ), _mm256_set1_pd( 1.0 ) ) );
+        // quadrant q = 4 is q = 0
+        __m256d q1   = _mm256_cmp_pd( q, _mm256_set1_pd( 1.0 ), _CMP_EQ_OQ );
+        __m256d q2   = _mm256_cmp_pd( q, _mm256_set1_pd( 2.0 ), _CMP_EQ_OQ );
+        __m256d q3   = _mm256_cmp_pd( q, _mm256_set1_pd( 3.0 ), _CMP_EQ_OQ );
+        __m256d swap = _mm256_or_pd( q1, q3 );
+        __m256d sign = _mm256_set1_pd( -0.0 );
+        c = _mm256_blendv_pd( ca, sa, swap );
+        s = _mm256_blendv_pd( sa, ca, swap );
+        c = _mm256_xor_pd( c, _mm256_and_pd( _mm256_or_pd( q1, q2 ), sign ) );
+        s = _mm256_xor_pd( s, _mm256_and_pd( _mm256_or_pd( q2, q3 ), sign ) );
+    }
+
+    KORTEX_TARGET_AVX2
+    static void box_muller_avx2( const double* u1, const double* u2, const size_t& n, double* out ) {
+        size_t i = 0;
+        for( ; i+4<=n; i+=4 ) {
+            __m256d x = _mm256_sub_pd( _mm256_set1_pd( 1.0 ), _mm256_loadu_pd( u1+i ) );
+            __m256d r = _mm256_sqrt_pd( _mm256_mul_pd( _mm256_set1_pd( -2.0 ), bm_log_avx2( x ) ) );
+            __m256d c, s;
+            bm_sincos_2pi_avx2( _mm256_loadu_pd( u2+i ), c, s );
+            __m256d z0 = _mm256_mul_pd( r, c );
+            __m256d z1 = _mm256_mul_pd( r, s );
+            __m256d lo = _mm256_unpacklo_pd( z0, z1 ); // pairs 0 | 2
+            __m256d hi = _mm256_unpackhi_pd( z0, z1 ); // pairs 1 | 3
+            _mm256_storeu_pd( out+2*i  , _mm256_permute2f128_pd( lo, hi, 0x20 ) );
+            _mm256_storeu_pd( out+2*i+4, _mm256_permute2f128_pd( lo, hi, 0x31 ) );
+        }
+        for( ; i<n; i++ )
+            box_muller( u1[i], u2[i], out[2*i], out[2*i+1] );
+    }
+
+    KORTEX_TARGET_AVX512
+    static inline __m512d bm_log_avx512( const __m512d& x ) {
+        __m512i ix = _mm512_add_epi64( _mm512_castpd_si512( x ), _mm512_set1_epi64( int64_t(BM_LOG_OFFSET) ) );
+        __m512d k  = _mm512_castsi512_pd( _mm512_or_si512( _mm512_srli_epi64( ix, 52 ),
+                                                           _mm512_set1_epi64( 0x4330000000000000LL ) ) );
+        k = _mm512_sub_pd( _mm512_sub_pd( k, _mm512_set1_pd( 4503599627370496.0 ) ), _mm512_set1_pd( 1023.0 ) );
+        __m512i im = _mm512_add_epi64( _mm512_and_si512( ix, _mm512_set1_epi64( int64_t(BM_MANT_MASK) ) ),
+                                       _mm512_set1_epi64( 0x3fe6a09e667f3bcdLL ) );
+        __m512d f    = _mm512_sub_pd( _mm512_castsi512_pd( im ), _mm512_set1_pd( 1.0 ) );
+        __m512d hfsq = _mm512_mul_pd( _mm512_mul_pd( _mm512_set1_pd( 0.5 ), f ), f );
+        __m512d s    = _mm512_div_pd( f, _mm512_add_pd( _mm512_set1_pd( 2.0 ), f ) );
+        __m512d z    = _mm512_mul_pd( s, s );
+        __m512d p    = _mm512_set1_pd( BM_LG7 );
+        p = _mm512_fmadd_pd( p, z, _mm512_set1_pd( BM_LG6 ) );
+        p = _mm512_fmadd_pd( p, z, _mm512_set1_pd( BM_LG5 ) );
+        p = _mm512_fmadd_pd( p, z, _mm512_set1_pd( BM_LG4 ) );
+        p = _mm512_fmadd_pd( p, z, _mm512_set1_pd( BM_LG3 ) );
+        p = _mm512_fmadd_pd( p, z, _mm512_set1_pd( BM_LG2 ) );
+        p = _mm512_fmadd_pd( p, z, _mm512_set1_pd( BM_LG1 ) );
+        __m512d t = _mm512_fmadd_pd( z, p, hfsq );
+        __m512d u = _mm512_fmadd_pd( s, t, _mm512_mul_pd( k, _mm512_set1_pd( BM_LN2_LO ) ) );
+        return _mm512_fmadd_pd( k, _mm512_set1_pd( BM_LN2_HI ), _mm512_add_pd( _mm512_sub_pd( u, hfsq ), f ) );
+    }
+
+    KORTEX_TARGET_AVX512
+    static inline void bm_sincos_2pi_avx512( const __m512d& u, __m512d& c, __m512d& s ) {
+        __m512d q  = _mm512_roundscale_pd( _mm512_fmadd_pd( u, _mm512_set1_pd( 4.0 ), _mm512_set1_pd( 0.5 ) ),
+                                           _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC );
+        __m512d a  = _mm512_mul_pd( _mm512_fmadd_pd( q, _mm512_set1_pd( -0.25 ), u ), _mm512_set1_pd( BM_TWO_PI ) );
+        __m512d z  = _mm512_mul_pd( a, a );
+        __m512d sp = _mm512_set1_pd( BM_S6 );
+        sp = _mm512_fmadd_pd( sp, z, _mm512_set1_pd( BM_S5 ) );
+        sp = _mm512_fmadd_pd( sp, z, _mm512_set1_pd( BM_S4 ) );
+        sp = _mm512_fmadd_pd( sp, z, _mm512_set1_pd( BM_S3 ) );
+        sp = _mm512_fmadd_pd( sp, z, _mm512_set1_pd( BM_S2 ) );
+        sp = _mm512_fmadd_pd( sp, z, _mm512_set1_pd( BM_S1 ) );
+        __m512d cp = _mm512_set1_pd( BM_C6 );
+        cp = _mm512_fmadd_pd( cp, z, _mm512_set1_pd( BM_C5 ) );
+        cp = _mm512_fmadd_pd( cp, z, _mm512_set1_pd( BM_C4 ) );
+        cp = _mm512_fmadd_pd( cp, z, _mm512_set1_pd( BM_C3 ) );
+        cp = _mm512_fmadd_pd( cp, z, _mm512_set1_pd( BM_C2 ) );
+        cp = _mm512_fmadd_pd( cp, z, _mm512_set1_pd( BM_C1 ) );
+        __m512d sa = _mm512_fmadd_pd( _mm512_mul_pd( a, z ), sp, a );
+        __m512d ca = _mm512_fmadd_pd( _mm512_mul_pd( z, z ), cp,
+                                      _mm512_fmadd_pd( z, _mm512_set1_pd( -0.5 ), _mm512_set1_pd( 1.0 ) ) );
+        __mmask8 q1   = _mm512_cmp_pd_mask( q, _mm512_set1_pd( 1.0 ), _CMP_EQ_OQ );
+        __mmask8 q2   = _mm512_cmp_pd_mask( q, _mm512_set1_pd( 2.0 ), _CMP_EQ_OQ );
+        __mmask8 q3   = _mm512_cmp_pd_mask( q, _mm512_set1_pd( 3.0 ), _CMP_EQ_OQ );
+        __mmask8 swap = q1 | q3;
+        __m512i  sign = _mm512_set1_epi64( int64_t( 0x8000000000000000ULL ) );
+        __m512i  ci   = _mm512_castpd_si512( _mm512_mask_blend_pd( swap, ca, sa ) );
+        __m512i  si   = _mm512_castpd_si512( _mm512_mask_blend_pd( swap, sa, ca ) );
+        c = _mm512_castsi512_pd( _mm512_mask_xor_epi64( ci, q1 | q2, ci, sign ) );
+        s = _mm512_castsi512_pd( _mm512_mask_xor_epi64( si, q2 | q3, si, sign ) );
+    }
+
+    KORTEX_TARGET_AVX512
+    static void box_muller_avx512( const double* u1, const double* u2, const size_t& n, double* out ) {
+        const __m512i lo_idx = _mm512_setr_epi64( 0, 8, 1, 9,  2, 10,  3, 11 );
+        const __m512i hi_idx = _mm512_setr_epi64( 4, 12, 5, 13, 6, 14, 7, 15 );
+        size_t i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m512d x = _mm512_sub_pd( _mm512_set1_pd( 1.0 ), _mm512_loadu_pd( u1+i ) );
+            __m512d r = _mm512_sqrt_pd( _mm512_mul_pd( _mm512_set1_pd( -2.0 ), bm_log_avx512( x ) ) );
+            __m512d c, s;
+            bm_sincos_2pi_avx512( _mm512_loadu_pd( u2+i ), c, s );
+            __m512d z0 = _mm512_mul_pd( r, c );
+            __m512d z1 = _mm512_mul_pd( r, s );
+            _mm512_storeu_pd( out+2*i  , _mm512_permutex2var_pd( z0, lo_idx, z1 ) );
+            _mm512_storeu_pd( out+2*i+8, _mm512_permutex2var_pd( z0, hi_idx, z1 ) );
+        }
+        box_muller_avx2( u1+i, u2+i, n-i, out+2*i );
+    }
+#endif
+
+    static void box_muller_dispatch( const double& u1, const double& u2, double& z0, double& z1 ) {
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        if( simd_level() >= SIMD_AVX2 ) {
+            box_muller_fma( u1, u2, z0, z1 );
+            return;
+        }
+#endif
+        box_muller( u1, u2, z0, z1 );
+    }
+
+    static void box_muller_pairs( const double* u1, const double* u2, const size_t& n, double* out ) {
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: box_muller_avx512( u1, u2, n, out ); return;
+        case SIMD_AVX2  : box_muller_avx2  ( u1, u2, n, out ); return;
+        default         : break;
+        }
+#endif
+        box_muller_basic( u1, u2, n, out );
+    }
+
+    PhiloxGenerator::PhiloxGenerator( const uint64_t& seed, const uint64_t& stream ) {
+        set_seed( seed, stream );
+    }
+
+    void PhiloxGenerator::set_seed( const uint64_t& seed, const uint64_t& stream ) {
+        m_seed      = seed;
+        m_stream    = stream;
+        m_block     = 0;
+        m_buffered  = 0;
+        m_spare     = 0.0;
+        m_has_spare = false;
+    }
+
+    void PhiloxGenerator::skip( const uint64_t& n_blocks ) {
+        m_block    += n_blocks;
+        m_buffered  = 0;
+        m_has_spare = false;
+    }
+
+    void PhiloxGenerator::refill() {
+        philox_block( m_seed, m_stream, m_block, m_buffer );
+        m_block++;
+        m_buffered = 4;
+    }
+
+    uint32_t PhiloxGenerator::rv() {
+        if( m_buffered == 0 )
+            refill();
+        return m_buffer[ 4 - m_buffered-- ];
+    }
+
+    // lemire, "fast random integer generation in an interval", 2019
+    uint32_t PhiloxGenerator::uniform_index( const uint32_t& n ) {
+        assert_statement( n > 0, "empty range" );
+        uint64_t m = uint64_t( rv() ) * uint64_t( n );
+        uint32_t l = uint32_t( m );
+        if( l < n ) {
+            uint32_t t = uint32_t( -n ) % n;
+            while( l < t ) {
+                m = uint64_t( rv() ) * uint64_t( n );
+                l = uint32_t( m );
+            }
+        }
+        return uint32_t( m >> 32 );
+    }
+
+    double PhiloxGenerator::uniform_sample() {
+        uint32_t a = rv();
+        uint32_t b = rv();
+        return to_uniform_d( a, b );
+    }
+
+    float PhiloxGenerator::uniform_sample_f() {
+        return to_uniform_f( rv() );
+    }
+
+    double PhiloxGenerator::normal_sample() {
+        if( m_has_spare ) {
+            m_has_spare = false;
+            return m_spare;
+        }
+        double u1 = uniform_sample();
+        double u2 = uniform_sample();
+        double z0;
+        box_muller_dispatch( u1, u2, z0, m_spare );
+        m_has_spare = true;
+        return z0;
+    }
+
+    void PhiloxGenerator::fill_rv( uint32_t* out, const size_t& n ) {
+        assert_pointer( out || n == 0 );
+        size_t i = 0;
+        while( i < n && m_buffered )
+            out[i++] = rv();
+        size_t n_blocks = ( n - i ) / 4;
+        if( n_blocks ) {
+            philox_blocks( m_seed, m_stream, m_block, n_blocks, out+i );
+            m_block += n_blocks;
+            i       += 4*n_blocks;
+        }
+        while( i < n )
+            out[i++] = rv();
+    }
+
+    static const size_t RANDOM_CHUNK = 1024;
+
+    void PhiloxGenerator::fill_uniform( float* out, const size_t& n ) {
+        assert_pointer( out || n == 0 );
+        uint32_t tmp[RANDOM_CHUNK];
+        for( size_t i=0; i<n; i+=RANDOM_CHUNK ) {
+            size_t m = std::min( RANDOM_CHUNK, n-i );
+            fill_rv( tmp, m );
+            for( size_t k=0; k<m; k++ )
+                out[i+k] = to_uniform_f( tmp[k] );
+        }
+    }
+
+    void PhiloxGenerator::fill_uniform( double* out, const size_t& n ) {
+        assert_pointer( out || n == 0 );
+        uint32_t tmp[RANDOM_CHUNK];
+        for( size_t i=0; i<n; i+=RANDOM_CHUNK/2 ) {
+            size_t m = std::min( RANDOM_CHUNK/2, n-i );
+            fill_rv( tmp, 2*m );
+            for( size_t k=0; k<m; k++ )
+                out[i+k] = to_uniform_d( tmp[2*k], tmp[2*k+1] );
+        }
+    }
+
+    void PhiloxGenerator::fill_normal( double* out, const size_t& n ) {
+        assert_pointer( out || n == 0 );
+        size_t i = 0;
+        if( n && m_has_spare ) {
+            out[i++]    = m_spare;
+            m_has_spare = false;
+        }
+        uint32_t tmp[RANDOM_CHUNK];
+        double   u1 [RANDOM_CHUNK/4];
+        double   u2 [RANDOM_CHUNK/4];
+        while( n-i >= 2 ) {
+            size_t n_pairs = std::min( (n-i)/2, RANDOM_CHUNK/4 );
+            fill_rv( tmp, 4*n_pairs );
+            for( size_t k=0; k<n_pairs; k++ ) {
+                u1[k] = to_uniform_d( tmp[4*k  ], tmp[4*k+1] );
+                u2[k] = to_uniform_d( tmp[4*k+2], tmp[4*k+3] );
+            }
+            box_muller_pairs( u1, u2, n_pairs, out+i );
+            i += 2*n_pairs;
+        }
+        if( i < n )
+            out[i] = normal_sample();
+    }
+
+    void PhiloxGenerator::fill_normal( float* out, const size_t& n ) {
+        assert_pointer( out || n == 0 );
+        double tmp[RANDOM_CHUNK/2];
+        for( size_t i=0; i<n; i+=RANDOM_CHUNK/2 ) {
+            size_t m = std::min( RANDOM_CHUNK/2, n-i );
+            fill_normal( tmp, m );
+            for( size_t k=0; k<m; k++ )
+                out[i+k] = float( tmp[k] );
+        }
+    }
+
+    //
+    // per thread generators
+    //
+    /// first stream handed out to the threads that do not get the stream of
+    /// their openmp thread number
+    static const uint64_t RANDOM_UNIQUE_STREAM = uint64_t(1) << 32;
+
+    struct RandomSeed {
+        std::mutex            lock;
+        uint64_t              seed;
+        std::atomic<unsigned> epoch;
+        /// openmp thread streams taken in the current epoch
+        vector<bool>          claimed;
+        uint64_t              next_stream;
+        RandomSeed() {
+            std::random_device randev;
+            seed        = ( uint64_t( randev() ) << 32 ) | uint64_t( randev() );
+            epoch       = 1;
+            next_stream = RANDOM_UNIQUE_STREAM;
+        }
+    };
+
+    static RandomSeed& global_seed() {
+        static RandomSeed rs;
+        return rs;
+    }
+
+    void set_random_seed( const uint64_t& seed ) {
+        RandomSeed& rs = global_seed();
+        std::lock_guard<std::mutex> guard( rs.lock );
+        rs.seed        = seed;
+        rs.next_stream = RANDOM_UNIQUE_STREAM;
+        rs.claimed.clear();
+        rs.epoch++;
+    }
+
+    uint64_t random_seed() {
+        RandomSeed& rs = global_seed();
+        std::lock_guard<std::mutex> guard( rs.lock );
+        return rs.seed;
+    }
+
+    // stream t for openmp thread t outside or in a non-nested team if no
+    // other thread took it in this epoch. the other threads - a second
+    // std::thread outside a team, threads of nested teams - get a stream of
+    // their own. rs.lock has to be held.
+    static uint64_t claim_stream( RandomSeed& rs ) {
+        int level = 0;
+        int tid   = 0;
+#ifdef _OPENMP
+        level = omp_get_level();
+        tid   = omp_get_thread_num();
+#endif
+        if( level <= 1 ) {
+            size_t t = size_t( tid );
+            if( t >= rs.claimed.size() )
+                rs.claimed.resize( t+1, false );
+            if( !rs.claimed[t] ) {
+                rs.claimed[t] = true;
+                return uint64_t( t );
+            }
+        }
+        return rs.next_stream++;
+    }
+
+    PhiloxGenerator* thread_random_generator() {
+        static thread_local PhiloxGenerator gen;
+        static thread_local unsigned        epoch = 0;
+        RandomSeed& rs = global_seed();
+        if( rs.epoch.load() != epoch ) {
+            std::lock_guard<std::mutex> guard( rs.lock );
+            gen.set_seed( rs.seed, claim_stream( rs ) );
+            epoch = rs.epoch.load();
+        }
+        return &gen;
+    }
+
 }
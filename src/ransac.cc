@@ -0,0 +1,263 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/ransac.h>
+#include <kortex/ransac.tcc>
+#include <kortex/geometry.h>
+#include <kortex/random.h>
+#include <kortex/cpu_features.h>
+#include <kortex/check.h>
+
+#include <cmath>
+#include <climits>
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace kortex {
+
+    RansacParams::RansacParams() {
+        threshold          = 1.0f;
+        confidence         = 0.99;
+        min_iterations     = 0;
+        max_iterations     = 10000;
+        batch_size         = 64;
+        prosac             = false;
+        local_optimization = true;
+        lo_iterations      = 4;
+        sprt               = true;
+        sprt_delta         = 0.01;
+        sprt_model_cost    = 200.0;
+        refine             = true;
+        run_parallel       = true;
+        seed               = random_seed();
+    }
+
+    int ransac_iteration_count( const double& eps, const int& m, const double& confidence,
+                                const int& max_iterations ) {
+        if( eps <= 0.0 ) return max_iterations;
+        double p_good = std::pow( eps, m );
+        if( p_good >= 1.0 ) return 1;
+        double n = std::log( 1.0 - confidence ) / std::log( 1.0 - p_good );
+        if( !( n < double(max_iterations) ) ) return max_iterations;
+        return std::max( 1, int( std::ceil(n) ) );
+    }
+
+    double sprt_threshold( const double& epsilon, const double& delta, const double& model_cost ) {
+        assert_statement_g( delta > 0.0 && epsilon > delta && epsilon < 1.0,
+                            "invalid sprt parameters [eps %f] [delta %f]", epsilon, delta );
+        // expected information gain of a point and the fixed point of
+        // A = K + 1 + log(A)
+        double C = ( 1.0 - delta ) * std::log( ( 1.0 - delta ) / ( 1.0 - epsilon ) )
+                 + delta * std::log( delta / epsilon );
+        double K = model_cost * C;
+        double A = K + 1.0;
+        for( int i=0; i<20; i++ ) {
+            double An = K + 1.0 + std::log( A );
+            if( std::fabs( An-A ) < 1e-6 ) { A = An; break; }
+            A = An;
+        }
+        return A;
+    }
+
+    //
+    // ransac_score
+    //
+    static int ransac_score_basic( const float* res, const int& n, const float& threshold, double& loss ) {
+        const float t2 = threshold * threshold;
+        int   n_in = 0;
+        float sum  = 0.0f;
+        for( int i=0; i<n; i++ ) {
+            float r  = res[i];
+            float r2 = r*r;
+            n_in += ( r < threshold );
+            sum  += ( r2 < t2 ) ? r2 : t2;
+        }
+        loss += sum;
+        return n_in;
+    }
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+    KORTEX_TARGET_AVX2
+    static int ransac_score_avx2( const float* res, const int& n, const float& threshold, double& loss ) {
+        const __m256 t  = _mm256_set1_ps( threshold );
+        const __m256 t2 = _mm256_set1_ps( threshold*threshold );
+        __m256 acc  = _mm256_setzero_ps();
+        int    n_in = 0;
+        int    i    = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m256 r = _mm256_loadu_ps( res+i );
+            n_in += __builtin_popcount( _mm256_movemask_ps( _mm256_cmp_ps( r, t, _CMP_LT_OQ ) ) );
+            acc   = _mm256_add_ps( acc, _mm256_min_ps( _mm256_mul_ps( r, r ), t2 ) );
+        }
+        float tmp[8];
+        _mm256_storeu_ps( tmp, acc );
+        loss += tmp[0]+tmp[1]+tmp[2]+tmp[3]+tmp[4]+tmp[5]+tmp[6]+tmp[7];
+        return n_in + ransac_score_basic( res+i, n-i, threshold, loss );
+    }
+
+    KORTEX_TARGET_AVX512
+    static int ransac_score_avx512( const float* res, const int& n, const float& threshold, double& loss ) {
+        const __m512 t  = _mm512_set1_ps( threshold );
+        const __m512 t2 = _mm512_set1_ps( threshold*threshold );
+        __m512 acc  = _mm512_setzero_ps();
+        int    n_in = 0;
+        int    i    = 0;
+        for( ; i+16<=n; i+=16 ) {
+            __m512 r = _mm512_loadu_ps( res+i );
+            n_in += __builtin_popcount( _mm512_cmp_ps_mask( r, t, _CMP_LT_OQ ) );
+            acc   = _mm512_add_ps( acc, _mm512_min_ps( _mm512_mul_ps( r, r ), t2 ) );
+        }
+        loss += _mm512_reduce_add_ps( acc );
+        return n_in + ransac_score_basic( res+i, n-i, threshold, loss );
+    }
+#endif
+
+    int ransac_score( const float* res, const int& n, const float& threshold, double& loss ) {
+        assert_pointer( res );
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: return ransac_score_avx512( res, n, threshold, loss );
+        case SIMD_AVX2  : return ransac_score_avx2  ( res, n, threshold, loss );
+        default         : break;
+        }
+#endif
+        return ransac_score_basic( res, n, threshold, loss );
+    }
+
+    //
+    // PlaneModel
+    //
+    PlaneModel::PlaneModel( const float* pnts, const int& n_pnts ) {
+        passert_pointer( pnts );
+        passert_statement( n_pnts > 0, "no points" );
+        m_pnts = pnts;
+        m_n    = n_pnts;
+        m_x.resize( n_pnts );
+        m_y.resize( n_pnts );
+        m_z.resize( n_pnts );
+        for( int i=0; i<n_pnts; i++ ) {
+            m_x[i] = pnts[3*i  ];
+            m_y[i] = pnts[3*i+1];
+            m_z[i] = pnts[3*i+2];
+        }
+    }
+
+    bool PlaneModel::fit_minimal( const int* samples, Params& p ) const {
+        const float* X0 = m_pnts + 3*samples[0];
+        const float* X1 = m_pnts + 3*samples[1];
+        const float* X2 = m_pnts + 3*samples[2];
+        double e1[3] = { double(X1[0])-X0[0], double(X1[1])-X0[1], double(X1[2])-X0[2] };
+        double e2[3] = { double(X2[0])-X0[0], double(X2[1])-X0[1], double(X2[2])-X0[2] };
+        double nrm[3] = { e1[1]*e2[2] - e1[2]*e2[1],
+                          e1[2]*e2[0] - e1[0]*e2[2],
+                          e1[0]*e2[1] - e1[1]*e2[0] };
+        double n2  = nrm[0]*nrm[0] + nrm[1]*nrm[1] + nrm[2]*nrm[2];
+        double e12 = ( e1[0]*e1[0] + e1[1]*e1[1] + e1[2]*e1[2] );
+        double e22 = ( e2[0]*e2[0] + e2[1]*e2[1] + e2[2]*e2[2] );
+        if( !( n2 > 1e-12 * e12 * e22 ) ) // collinear samples
+            return false;
+        double s = 1.0 / std::sqrt( n2 );
+        p.plane[0] = float( nrm[0]*s );
+        p.plane[1] = float( nrm[1]*s );
+        p.plane[2] = float( nrm[2]*s );
+        p.plane[3] = float( -( nrm[0]*X0[0] + nrm[1]*X0[1] + nrm[2]*X0[2] ) * s );
+        return true;
+    }
+
+    bool PlaneModel::fit( const int* indices, const int& n, Params& p ) const {
+        assert_pointer( indices );
+        if( n <  3 ) return false;
+        if( n == 3 ) return fit_minimal( indices, p );
+        vector<const float*> pnts( n );
+        for( int i=0; i<n; i++ )
+            pnts[i] = m_pnts + 3*indices[i];
+        return compute_plane( pnts, p.plane ) >= 0.0f;
+    }
+
+    static void plane_residuals_basic( const float* x, const float* y, const float* z, const int& n,
+                                       const float plane[4], float* res ) {
+        for( int i=0; i<n; i++ )
+            res[i] = std::fabs( plane[0]*x[i] + plane[1]*y[i] + plane[2]*z[i] + plane[3] );
+    }
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+    KORTEX_TARGET_AVX2
+    static void plane_residuals_avx2( const float* x, const float* y, const float* z, const int& n,
+                                      const float plane[4], float* res ) {
+        const __m256 a    = _mm256_set1_ps( plane[0] );
+        const __m256 b    = _mm256_set1_ps( plane[1] );
+        const __m256 c    = _mm256_set1_ps( plane[2] );
+        const __m256 d    = _mm256_set1_ps( plane[3] );
+        const __m256 sign = _mm256_set1_ps( -0.0f );
+        int i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m256 r = _mm256_fmadd_ps( a, _mm256_loadu_ps( x+i ), d );
+            r = _mm256_fmadd_ps( b, _mm256_loadu_ps( y+i ), r );
+            r = _mm256_fmadd_ps( c, _mm256_loadu_ps( z+i ), r );
+            _mm256_storeu_ps( res+i, _mm256_andnot_ps( sign, r ) );
+        }
+        plane_residuals_basic( x+i, y+i, z+i, n-i, plane, res+i );
+    }
+
+    KORTEX_TARGET_AVX512
+    static void plane_residuals_avx512( const float* x, const float* y, const float* z, const int& n,
+                                        const float plane[4], float* res ) {
+        const __m512 a = _mm512_set1_ps( plane[0] );
+        const __m512 b = _mm512_set1_ps( plane[1] );
+        const __m512 c = _mm512_set1_ps( plane[2] );
+        const __m512 d = _mm512_set1_ps( plane[3] );
+        int i = 0;
+        for( ; i+16<=n; i+=16 ) {
+            __m512 r = _mm512_fmadd_ps( a, _mm512_loadu_ps( x+i ), d );
+            r = _mm512_fmadd_ps( b, _mm512_loadu_ps( y+i ), r );
+            r = _mm512_fmadd_ps( c, _mm512_loadu_ps( z+i ), r );
+            _mm512_storeu_ps( res+i, _mm512_abs_ps( r ) );
+        }
+        plane_residuals_basic( x+i, y+i, z+i, n-i, plane, res+i );
+    }
+#endif
+
+    void PlaneModel::residuals( const Params& p, const int& begin, const int& end, float* res ) const {
+        assert_pointer( res );
+        assert_statement_g( 0 <= begin && begin <= end && end <= m_n, "invalid range [%d %d)", begin, end );
+        const float* x = &m_x[0] + begin;
+        const float* y = &m_y[0] + begin;
+        const float* z = &m_z[0] + begin;
+        int n = end - begin;
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: plane_residuals_avx512( x, y, z, n, p.plane, res ); return;
+        case SIMD_AVX2  : plane_residuals_avx2  ( x, y, z, n, p.plane, res ); return;
+        default         : break;
+        }
+#endif
+        plane_residuals_basic( x, y, z, n, p.plane, res );
+    }
+
+    bool ransac_plane( const float* pnts, const int& n_pnts, const RansacParams& params, float plane[4],
+                       vector<int>& inliers, RansacStats* stats ) {
+        PlaneModel model( pnts, n_pnts );
+        PlaneModel::Params p;
+        if( !ransac( model, params, p, inliers, stats ) )
+            return false;
+        plane[0] = p.plane[0];
+        plane[1] = p.plane[1];
+        plane[2] = p.plane[2];
+        plane[3] = p.plane[3];
+        return true;
+    }
+
+}
@@ -0,0 +1,682 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+#include <kortex/resample.h>
+#include <kortex/filter.h>
+#include <kortex/cpu_features.h>
+#include <kortex/mem_unit.h>
+#include <kortex/color.h>
+#include <kortex/check.h>
+
+#include <cmath>
+#include <climits>
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace kortex {
+
+    /// catmull-rom weights of the samples at -1, 0, 1, 2 for an offset t in
+    /// [0,1) - same kernel as bicubic_interpolation
+    static inline void catmull_rom_weights( const float& t, float* wt ) {
+        float t2 = t*t;
+        float t3 = t2*t;
+        wt[0] = 0.5f*( -t  + 2.0f*t2 -      t3 );
+        wt[1] = 0.5f*( 2.0f - 5.0f*t2 + 3.0f*t3 );
+        wt[2] = 0.5f*(  t  + 4.0f*t2 - 3.0f*t3 );
+        wt[3] = 0.5f*(      -     t2 +      t3 );
+    }
+
+    void compute_resample_taps( const int& n_in, const int& n_out, const int& nc,
+                                const ResampleMethod& method, ResampleTaps& taps ) {
+        passert_statement_g( n_in > 0 && n_out > 0 && nc > 0, "[n_in %d] [n_out %d] [nc %d] invalid sizes", n_in, n_out, nc );
+        double ratio = double(n_in) / double(n_out);
+
+        ResampleMethod m = method;
+        if( m == RS_AREA && ratio <= 1.0 ) m = RS_BILINEAR;
+
+        int n_taps = 0;
+        switch( m ) {
+        case RS_BILINEAR: n_taps = 2; break;
+        case RS_BICUBIC : n_taps = 4; break;
+        case RS_AREA    : n_taps = int( std::ceil(ratio) ) + 1; break;
+        default         : switch_fatality();
+        }
+
+        size_t n = size_t(n_out)*size_t(nc);
+        taps.n_out  = int( n );
+        taps.n_taps = n_taps;
+        taps.index .assign( n*n_taps, 0    );
+        taps.weight.assign( n*n_taps, 0.0f );
+
+        vector<int>   idx( n_taps );
+        vector<float> wgt( n_taps );
+        for( int i=0; i<n_out; i++ ) {
+            double s = ( i+0.5 )*ratio - 0.5;
+            int    f = int( std::floor(s) );
+            float  t = float( s-f );
+            switch( m ) {
+            case RS_BILINEAR:
+                idx[0] = f;   wgt[0] = 1.0f-t;
+                idx[1] = f+1; wgt[1] = t;
+                break;
+            case RS_BICUBIC:
+                for( int k=0; k<4; k++ ) idx[k] = f-1+k;
+                catmull_rom_weights( t, &wgt[0] );
+                break;
+            case RS_AREA: {
+                double x0 = i*ratio;
+                double x1 = ( i+1 )*ratio;
+                int    p0 = int( std::floor(x0) );
+                for( int k=0; k<n_taps; k++ ) {
+                    int    p  = p0+k;
+                    double ov = std::min( double(p+1), x1 ) - std::max( double(p), x0 );
+                    idx[k] = p;
+                    wgt[k] = float( std::max( ov, 0.0 ) / ratio );
+                }
+            } break;
+            default: switch_fatality();
+            }
+            for( int k=0; k<n_taps; k++ ) {
+                int p = std::min( std::max( idx[k], 0 ), n_in-1 );
+                for( int c=0; c<nc; c++ ) {
+                    size_t o = size_t(k)*n + size_t(i)*nc + c;
+                    taps.index [o] = p*nc + c;
+                    taps.weight[o] = wgt[k];
+                }
+            }
+        }
+    }
+
+    void resample_line_basic( const float* in, const ResampleTaps& taps, float* out ) {
+        int          n   = taps.n_out;
+        const int*   idx = &taps.index [0];
+        const float* wgt = &taps.weight[0];
+        for( int i=0; i<n; i++ )
+            out[i] = wgt[i] * in[ idx[i] ];
+        for( int k=1; k<taps.n_taps; k++ ) {
+            const int*   ik = idx + size_t(k)*n;
+            const float* wk = wgt + size_t(k)*n;
+            for( int i=0; i<n; i++ )
+                out[i] += wk[i] * in[ ik[i] ];
+        }
+    }
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+    KORTEX_TARGET_AVX2
+    void resample_line_avx2( const float* in, const ResampleTaps& taps, float* out ) {
+        int          n   = taps.n_out;
+        const int*   idx = &taps.index [0];
+        const float* wgt = &taps.weight[0];
+        int i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m256 acc = _mm256_setzero_ps();
+            for( int k=0; k<taps.n_taps; k++ ) {
+                size_t o  = size_t(k)*n + i;
+                __m256i vi = _mm256_loadu_si256( (const __m256i*)(idx+o) );
+                __m256  v  = _mm256_i32gather_ps( in, vi, 4 );
+                acc = _mm256_fmadd_ps( _mm256_loadu_ps(wgt+o), v, acc );
+            }
+            _mm256_storeu_ps( out+i, acc );
+        }
+        for( ; i<n; i++ ) {
+            float sum = 0.0f;
+            for( int k=0; k<taps.n_taps; k++ ) {
+                size_t o = size_t(k)*n + i;
+                sum += wgt[o] * in[ idx[o] ];
+            }
+            out[i] = sum;
+        }
+    }
+
+    KORTEX_TARGET_AVX512
+    void resample_line_avx512( const float* in, const ResampleTaps& taps, float* out ) {
+        int          n   = taps.n_out;
+        const int*   idx = &taps.index [0];
+        const float* wgt = &taps.weight[0];
+        int i = 0;
+        for( ; i+16<=n; i+=16 ) {
+            __m512 acc = _mm512_setzero_ps();
+            for( int k=0; k<taps.n_taps; k++ ) {
+                size_t o  = size_t(k)*n + i;
+                __m512i vi = _mm512_loadu_si512( (const void*)(idx+o) );
+                __m512  v  = _mm512_i32gather_ps( vi, in, 4 );
+                acc = _mm512_fmadd_ps( _mm512_loadu_ps(wgt+o), v, acc );
+            }
+            _mm512_storeu_ps( out+i, acc );
+        }
+        for( ; i<n; i++ ) {
+            float sum = 0.0f;
+            for( int k=0; k<taps.n_taps; k++ ) {
+                size_t o = size_t(k)*n + i;
+                sum += wgt[o] * in[ idx[o] ];
+            }
+            out[i] = sum;
+        }
+    }
+#endif
+
+    void resample_line( const float* in, const ResampleTaps& taps, float* out ) {
+        assert_pointer( in && out );
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        switch( simd_level() ) {
+        case SIMD_AVX512: resample_line_avx512( in, taps, out ); return;
+        case SIMD_AVX2  : resample_line_avx2  ( in, taps, out ); return;
+        default         : break;
+        }
+#endif
+        resample_line_basic( in, taps, out );
+    }
+
+    static const int RESAMPLE_BLOCK_ROWS = 32;
+
+    /// shared by the float/uchar and serial/parallel versions. exactly one of
+    /// src_f/src_u and of dst_f/dst_u is non-null.
+    ///
+    /// output rows are processed top to bottom in blocks. the horizontally
+    /// resampled source rows are cached in a ring of n_taps rows ( the row
+    /// indices of the vertical taps are consecutive and non-decreasing ) so
+    /// that every source row is resampled once per block run and source rows
+    /// skipped by the vertical taps are never touched.
+    void resample_image( const float* src_f, const uchar* src_u, const int& w, const int& h, const int& nc,
+                         const ResampleMethod& method, const int& nw, const int& nh, const bool& run_parallel,
+                         float* dst_f, uchar* dst_u ) {
+        passert_statement_g( w > 0 && h > 0 && nw > 0 && nh > 0, "[%dx%d] -> [%dx%d] invalid sizes", w, h, nw, nh );
+        ResampleTaps tx, ty;
+        compute_resample_taps( w, nw, nc, method, tx );
+        compute_resample_taps( h, nh, 1,  method, ty );
+
+        size_t in_len   = size_t(w) *size_t(nc);
+        size_t out_len  = size_t(nw)*size_t(nc);
+        int    n_taps   = ty.n_taps;
+        int    n_blocks = ( nh + RESAMPLE_BLOCK_ROWS-1 ) / RESAMPLE_BLOCK_ROWS;
+
+#pragma omp parallel if( run_parallel )
+        {
+            MemUnit mem( ( size_t(n_taps)*out_len + std::max(in_len, out_len) )*sizeof(float) );
+            float*  ring = (float*)mem.get_buffer();
+            float*  line = ring + size_t(n_taps)*out_len;
+            vector<int>          ring_row( n_taps, -1 );
+            vector<const float*> rows    ( n_taps );
+            vector<float>        kernel  ( n_taps );
+
+#pragma omp for schedule(dynamic)
+            for( int b=0; b<n_blocks; b++ ) {
+                int y1 = std::min( nh, (b+1)*RESAMPLE_BLOCK_ROWS );
+                for( int y=b*RESAMPLE_BLOCK_ROWS; y<y1; y++ ) {
+                    for( int k=0; k<n_taps; k++ ) {
+                        int    r    = ty.index[k*nh+y];
+                        int    slot = r % n_taps;
+                        float* rs   = ring + size_t(slot)*out_len;
+                        if( ring_row[slot] != r ) {
+                            const float* in = NULL;
+                            if( src_f ) {
+                                in = src_f + size_t(r)*in_len;
+                            } else {
+                                const uchar* row = src_u + size_t(r)*in_len;
+                                for( size_t x=0; x<in_len; x++ )
+                                    line[x] = float( row[x] );
+                                in = line;
+                            }
+                            resample_line( in, tx, rs );
+                            ring_row[slot] = r;
+                        }
+                        rows  [k] = rs;
+                        kernel[k] = ty.weight[k*nh+y];
+                    }
+                    if( dst_f ) {
+                        filter_rows( &rows[0], &kernel[0], n_taps, int(out_len), dst_f+size_t(y)*out_len );
+                    } else {
+                        filter_rows( &rows[0], &kernel[0], n_taps, int(out_len), line );
+                        uchar* row = dst_u + size_t(y)*out_len;
+                        for( size_t x=0; x<out_len; x++ )
+                            row[x] = cast_to_gray_range( line[x] );
+                    }
+                }
+            }
+        }
+    }
+
+    void resample( const float* src, const int& w, const int& h, const int& nc,
+                   const ResampleMethod& method, const int& nw, const int& nh, float* dst ) {
+        assert_pointer( src && dst );
+        resample_image( src, NULL, w, h, nc, method, nw, nh, false, dst, NULL );
+    }
+
+    void resample_par( const float* src, const int& w, const int& h, const int& nc,
+                       const ResampleMethod& method, const int& nw, const int& nh, float* dst ) {
+        assert_pointer( src && dst );
+        resample_image( src, NULL, w, h, nc, method, nw, nh, true, dst, NULL );
+    }
+
+    void resample( const uchar* src, const int& w, const int& h, const int& nc,
+                   const ResampleMethod& method, const int& nw, const int& nh, uchar* dst ) {
+        assert_pointer( src && dst );
+        resample_image( NULL, src, w, h, nc, method, nw, nh, false, NULL, dst );
+    }
+
+    void resample_par( const uchar* src, const int& w, const int& h, const int& nc,
+                       const ResampleMethod& method, const int& nw, const int& nh, uchar* dst ) {
+        assert_pointer( src && dst );
+        resample_image( NULL, src, w, h, nc, method, nw, nh, true, NULL, dst );
+    }
+
+
+    //
+    // point sampling
+    //
+
+    template<typename T, int NC>
+    void sample_bilinear_basic( const T* img, const int& w, const int& h, const int& stride,
+                                const float* xs, const float* ys, const int& n, float* out ) {
+        float  xmax   = float(w-1);
+        float  ymax   = float(h-1);
+        for( int i=0; i<n; i++ ) {
+            float x  = std::min( xmax, std::max( 0.0f, xs[i] ) );
+            float y  = std::min( ymax, std::max( 0.0f, ys[i] ) );
+            int   x0 = int( x );
+            int   y0 = int( y );
+            int   x1 = std::min( x0+1, w-1 )*NC;
+            int   y1 = std::min( y0+1, h-1 );
+            float a  = x - x0;
+            float b  = y - y0;
+            const T* I = img + size_t(y0)*stride;
+            const T* J = img + size_t(y1)*stride;
+            float*   o = out + size_t(i)*NC;
+            x0 *= NC;
+            for( int c=0; c<NC; c++ )
+                o[c] = (1.0f-b) * ( (1.0f-a) * I[x0+c] + a * I[x1+c] )
+                    +        b  * ( (1.0f-a) * J[x0+c] + a * J[x1+c] );
+        }
+    }
+
+    template<typename T, int NC>
+    void sample_bicubic_basic( const T* img, const int& w, const int& h, const int& stride,
+                               const float* xs, const float* ys, const int& n, float* out ) {
+        float  xmax   = float(w-1);
+        float  ymax   = float(h-1);
+        float  wx[4], wy[4];
+        for( int i=0; i<n; i++ ) {
+            float  x  = std::min( xmax, std::max( 0.0f, xs[i] ) );
+            float  y  = std::min( ymax, std::max( 0.0f, ys[i] ) );
+            int    ix = int( x );
+            int    iy = int( y );
+            float* o  = out + size_t(i)*NC;
+            if( ix < 2 || iy < 2 || ix >= w-3 || iy >= h-3 ) {
+                const T* p = img + size_t(iy)*stride + ix*NC;
+                for( int c=0; c<NC; c++ )
+                    o[c] = float( p[c] );
+                continue;
+            }
+            catmull_rom_weights( x-ix, wx );
+            catmull_rom_weights( y-iy, wy );
+            const T* p = img + size_t(iy-1)*stride + (ix-1)*NC;
+            for( int c=0; c<NC; c++ )
+                o[c] = 0.0f;
+            for( int j=0; j<4; j++ ) {
+                for( int c=0; c<NC; c++ )
+                    o[c] += wy[j] * ( wx[0]*p[c] + wx[1]*p[NC+c] + wx[2]*p[2*NC+c] + wx[3]*p[3*NC+c] );
+                p += stride;
+            }
+        }
+    }
+
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+    /// gathers the NC channels of the pixels starting at element offsets p
+    template<int NC> KORTEX_TARGET_AVX2
+    inline void sample_gather_avx2( const float* img, const __m256i& p, const __m256i& lim, __m256* v ) {
+        for( int c=0; c<NC; c++ )
+            v[c] = _mm256_i32gather_ps( img+c, p, 4 );
+    }
+
+    /// uchar pixels are gathered as dwords holding all channels. offsets past
+    /// lim ( the last dword of the image ) are moved back and the dword is
+    /// shifted into place so that nothing is read past the image.
+    template<int NC> KORTEX_TARGET_AVX2
+    inline void sample_gather_avx2( const uchar* img, const __m256i& p, const __m256i& lim, __m256* v ) {
+        const __m256i mask = _mm256_set1_epi32( 0xff );
+        __m256i o = _mm256_min_epi32( p, lim );
+        __m256i s = _mm256_slli_epi32( _mm256_sub_epi32( p, o ), 3 );
+        __m256i d = _mm256_srlv_epi32( _mm256_i32gather_epi32( (const int*)img, o, 1 ), s );
+        v[0] = _mm256_cvtepi32_ps( _mm256_and_si256( d, mask ) );
+        for( int c=1; c<NC; c++ ) {
+            d    = _mm256_srli_epi32( d, 8 );
+            v[c] = _mm256_cvtepi32_ps( _mm256_and_si256( d, mask ) );
+        }
+    }
+
+    template<int NC> KORTEX_TARGET_AVX2
+    inline void sample_store_avx2( const __m256* v, float* out ) {
+        if( NC == 1 ) {
+            _mm256_storeu_ps( out, v[0] );
+            return;
+        }
+        float r[NC][8];
+        for( int c=0; c<NC; c++ )
+            _mm256_storeu_ps( r[c], v[c] );
+        for( int l=0; l<8; l++ )
+            for( int c=0; c<NC; c++ )
+                out[l*NC+c] = r[c][l];
+    }
+
+    KORTEX_TARGET_AVX2
+    inline void catmull_rom_weights_avx2( const __m256& t, __m256* wt ) {
+        const __m256 half = _mm256_set1_ps( 0.5f );
+        __m256 t2 = _mm256_mul_ps( t,  t );
+        __m256 t3 = _mm256_mul_ps( t2, t );
+        wt[0] = _mm256_mul_ps( half, _mm256_sub_ps( _mm256_fmadd_ps( _mm256_set1_ps( 2.0f), t2, _mm256_sub_ps(_mm256_setzero_ps(), t) ), t3 ) );
+        wt[1] = _mm256_mul_ps( half, _mm256_fmadd_ps( _mm256_set1_ps( 3.0f), t3, _mm256_fmadd_ps( _mm256_set1_ps(-5.0f), t2, _mm256_set1_ps(2.0f) ) ) );
+        wt[2] = _mm256_mul_ps( half, _mm256_fmadd_ps( _mm256_set1_ps(-3.0f), t3, _mm256_fmadd_ps( _mm256_set1_ps( 4.0f), t2, t ) ) );
+        wt[3] = _mm256_mul_ps( half, _mm256_sub_ps( t3, t2 ) );
+    }
+
+    template<typename T, int NC> KORTEX_TARGET_AVX2
+    void sample_bilinear_avx2( const T* img, const int& w, const int& h, const int& stride,
+                               const float* xs, const float* ys, const int& n, float* out ) {
+        const __m256  zero   = _mm256_setzero_ps();
+        const __m256  xmax   = _mm256_set1_ps( float(w-1) );
+        const __m256  ymax   = _mm256_set1_ps( float(h-1) );
+        const __m256i one    = _mm256_set1_epi32( 1 );
+        const __m256i wmax   = _mm256_set1_epi32( w-1 );
+        const __m256i hmax   = _mm256_set1_epi32( h-1 );
+        const __m256i nc     = _mm256_set1_epi32( NC );
+        const __m256i vstride = _mm256_set1_epi32( stride );
+        const __m256i lim     = _mm256_set1_epi32( (h-1)*stride + w*NC-4 );
+        __m256 v00[NC], v01[NC], v10[NC], v11[NC];
+        int i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m256  x  = _mm256_min_ps( _mm256_max_ps( _mm256_loadu_ps(xs+i), zero ), xmax );
+            __m256  y  = _mm256_min_ps( _mm256_max_ps( _mm256_loadu_ps(ys+i), zero ), ymax );
+            __m256i x0 = _mm256_cvttps_epi32( x );
+            __m256i y0 = _mm256_cvttps_epi32( y );
+            __m256  a  = _mm256_sub_ps( x, _mm256_cvtepi32_ps(x0) );
+            __m256  b  = _mm256_sub_ps( y, _mm256_cvtepi32_ps(y0) );
+            __m256i x1 = _mm256_min_epi32( _mm256_add_epi32( x0, one ), wmax );
+            __m256i y1 = _mm256_min_epi32( _mm256_add_epi32( y0, one ), hmax );
+            if( NC > 1 ) {
+                x0 = _mm256_mullo_epi32( x0, nc );
+                x1 = _mm256_mullo_epi32( x1, nc );
+            }
+            y0 = _mm256_mullo_epi32( y0, vstride );
+            y1 = _mm256_mullo_epi32( y1, vstride );
+            sample_gather_avx2<NC>( img, _mm256_add_epi32( y0, x0 ), lim, v00 );
+            sample_gather_avx2<NC>( img, _mm256_add_epi32( y0, x1 ), lim, v01 );
+            sample_gather_avx2<NC>( img, _mm256_add_epi32( y1, x0 ), lim, v10 );
+            sample_gather_avx2<NC>( img, _mm256_add_epi32( y1, x1 ), lim, v11 );
+            for( int c=0; c<NC; c++ ) {
+                __m256 top = _mm256_fmadd_ps( a, _mm256_sub_ps( v01[c], v00[c] ), v00[c] );
+                __m256 bot = _mm256_fmadd_ps( a, _mm256_sub_ps( v11[c], v10[c] ), v10[c] );
+                v00[c] = _mm256_fmadd_ps( b, _mm256_sub_ps( bot, top ), top );
+            }
+            sample_store_avx2<NC>( v00, out+size_t(i)*NC );
+        }
+        if( i < n )
+            sample_bilinear_basic<T,NC>( img, w, h, stride, xs+i, ys+i, n-i, out+size_t(i)*NC );
+    }
+
+    /// needs w >= 4 and h >= 4 - the 4x4 support of the border lanes is
+    /// clamped into the image and replaced by the nearest pixel afterwards.
+    template<typename T, int NC> KORTEX_TARGET_AVX2
+    void sample_bicubic_avx2( const T* img, const int& w, const int& h, const int& stride,
+                              const float* xs, const float* ys, const int& n, float* out ) {
+        const __m256  zero   = _mm256_setzero_ps();
+        const __m256  xmax   = _mm256_set1_ps( float(w-1) );
+        const __m256  ymax   = _mm256_set1_ps( float(h-1) );
+        const __m256i one    = _mm256_set1_epi32( 1 );
+        const __m256i two    = _mm256_set1_epi32( 2 );
+        const __m256i w3     = _mm256_set1_epi32( w-3 );
+        const __m256i h3     = _mm256_set1_epi32( h-3 );
+        const __m256i w4     = _mm256_set1_epi32( w-4 );
+        const __m256i h4     = _mm256_set1_epi32( h-4 );
+        const __m256i nc     = _mm256_set1_epi32( NC );
+        const __m256i vstride = _mm256_set1_epi32( stride );
+        const __m256i lim     = _mm256_set1_epi32( (h-1)*stride + w*NC-4 );
+        __m256 wx[4], wy[4], v[NC], row[NC], acc[NC];
+        int i = 0;
+        for( ; i+8<=n; i+=8 ) {
+            __m256  x  = _mm256_min_ps( _mm256_max_ps( _mm256_loadu_ps(xs+i), zero ), xmax );
+            __m256  y  = _mm256_min_ps( _mm256_max_ps( _mm256_loadu_ps(ys+i), zero ), ymax );
+            __m256i ix = _mm256_cvttps_epi32( x );
+            __m256i iy = _mm256_cvttps_epi32( y );
+            catmull_rom_weights_avx2( _mm256_sub_ps( x, _mm256_cvtepi32_ps(ix) ), wx );
+            catmull_rom_weights_avx2( _mm256_sub_ps( y, _mm256_cvtepi32_ps(iy) ), wy );
+            __m256i border = _mm256_or_si256( _mm256_or_si256( _mm256_cmpgt_epi32( two, ix ), _mm256_cmpgt_epi32( two, iy ) ),
+                                              _mm256_or_si256( _mm256_cmpgt_epi32( ix,  w4 ), _mm256_cmpgt_epi32( iy,  h4 ) ) );
+            __m256i cx = _mm256_min_epi32( _mm256_max_epi32( ix, one ), w3 );
+            __m256i cy = _mm256_min_epi32( _mm256_max_epi32( iy, one ), h3 );
+            __m256i p  = _mm256_add_epi32( _mm256_mullo_epi32( _mm256_sub_epi32( cy, one ), vstride ),
+                                           _mm256_mullo_epi32( _mm256_sub_epi32( cx, one ), nc     ) );
+            for( int c=0; c<NC; c++ )
+                acc[c] = zero;
+            for( int j=0; j<4; j++ ) {
+                for( int c=0; c<NC; c++ )
+                    row[c] = zero;
+                for( int k=0; k<4; k++ ) {
+                    sample_gather_avx2<NC>( img, _mm256_add_epi32( p, _mm256_set1_epi32(k*NC) ), lim, v );
+                    for( int c=0; c<NC; c++ )
+                        row[c] = _mm256_fmadd_ps( wx[k], v[c], row[c] );
+                }
+                for( int c=0; c<NC; c++ )
+                    acc[c] = _mm256_fmadd_ps( wy[j], row[c], acc[c] );
+                p = _mm256_add_epi32( p, vstride );
+            }
+            p = _mm256_add_epi32( _mm256_mullo_epi32( iy, vstride ), _mm256_mullo_epi32( ix, nc ) );
+            sample_gather_avx2<NC>( img, p, lim, v );
+            for( int c=0; c<NC; c++ )
+                acc[c] = _mm256_blendv_ps( acc[c], v[c], _mm256_castsi256_ps(border) );
+            sample_store_avx2<NC>( acc, out+size_t(i)*NC );
+        }
+        if( i < n )
+            sample_bicubic_basic<T,NC>( img, w, h, stride, xs+i, ys+i, n-i, out+size_t(i)*NC );
+    }
+
+    template<int NC> KORTEX_TARGET_AVX512
+    inline void sample_gather_avx512( const float* img, const __m512i& p, const __m512i& lim, __m512* v ) {
+        for( int c=0; c<NC; c++ )
+            v[c] = _mm512_i32gather_ps( p, img+c, 4 );
+    }
+
+    template<int NC> KORTEX_TARGET_AVX512
+    inline void sample_gather_avx512( const uchar* img, const __m512i& p, const __m512i& lim, __m512* v ) {
+        const __m512i mask = _mm512_set1_epi32( 0xff );
+        __m512i o = _mm512_min_epi32( p, lim );
+        __m512i s = _mm512_slli_epi32( _mm512_sub_epi32( p, o ), 3 );
+        __m512i d = _mm512_srlv_epi32( _mm512_i32gather_epi32( o, (const int*)img, 1 ), s );
+        v[0] = _mm512_cvtepi32_ps( _mm512_and_si512( d, mask ) );
+        for( int c=1; c<NC; c++ ) {
+            d    = _mm512_srli_epi32( d, 8 );
+            v[c] = _mm512_cvtepi32_ps( _mm512_and_si512( d, mask ) );
+        }
+    }
+
+    template<int NC> KORTEX_TARGET_AVX512
+    inline void sample_store_avx512( const __m512* v, float* out ) {
+        if( NC == 1 ) {
+            _mm512_storeu_ps( out, v[0] );
+            return;
+        }
+        float r[NC][16];
+        for( int c=0; c<NC; c++ )
+            _mm512_storeu_ps( r[c], v[c] );
+        for( int l=0; l<16; l++ )
+            for( int c=0; c<NC; c++ )
+                out[l*NC+c] = r[c][l];
+    }
+
+    KORTEX_TARGET_AVX512
+    inline void catmull_rom_weights_avx512( const __m512& t, __m512* wt ) {
+        const __m512 half = _mm512_set1_ps( 0.5f );
+        __m512 t2 = _mm512_mul_ps( t,  t );
+        __m512 t3 = _mm512_mul_ps( t2, t );
+        wt[0] = _mm512_mul_ps( half, _mm512_sub_ps( _mm512_fmadd_ps( _mm512_set1_ps( 2.0f), t2, _mm512_sub_ps(_mm512_setzero_ps(), t) ), t3 ) );
+        wt[1] = _mm512_mul_ps( half, _mm512_fmadd_ps( _mm512_set1_ps( 3.0f), t3, _mm512_fmadd_ps( _mm512_set1_ps(-5.0f), t2, _mm512_set1_ps(2.0f) ) ) );
+        wt[2] = _mm512_mul_ps( half, _mm512_fmadd_ps( _mm512_set1_ps(-3.0f), t3, _mm512_fmadd_ps( _mm512_set1_ps( 4.0f), t2, t ) ) );
+        wt[3] = _mm512_mul_ps( half, _mm512_sub_ps( t3, t2 ) );
+    }
+
+    template<typename T, int NC> KORTEX_TARGET_AVX512
+    void sample_bilinear_avx512( const T* img, const int& w, const int& h, const int& stride,
+                                 const float* xs, const float* ys, const int& n, float* out ) {
+        const __m512  zero   = _mm512_setzero_ps();
+        const __m512  xmax   = _mm512_set1_ps( float(w-1) );
+        const __m512  ymax   = _mm512_set1_ps( float(h-1) );
+        const __m512i one    = _mm512_set1_epi32( 1 );
+        const __m512i wmax   = _mm512_set1_epi32( w-1 );
+        const __m512i hmax   = _mm512_set1_epi32( h-1 );
+        const __m512i nc     = _mm512_set1_epi32( NC );
+        const __m512i vstride = _mm512_set1_epi32( stride );
+        const __m512i lim     = _mm512_set1_epi32( (h-1)*stride + w*NC-4 );
+        __m512 v00[NC], v01[NC], v10[NC], v11[NC];
+        int i = 0;
+        for( ; i+16<=n; i+=16 ) {
+            __m512  x  = _mm512_min_ps( _mm512_max_ps( _mm512_loadu_ps(xs+i), zero ), xmax );
+            __m512  y  = _mm512_min_ps( _mm512_max_ps( _mm512_loadu_ps(ys+i), zero ), ymax );
+            __m512i x0 = _mm512_cvttps_epi32( x );
+            __m512i y0 = _mm512_cvttps_epi32( y );
+            __m512  a  = _mm512_sub_ps( x, _mm512_cvtepi32_ps(x0) );
+            __m512  b  = _mm512_sub_ps( y, _mm512_cvtepi32_ps(y0) );
+            __m512i x1 = _mm512_min_epi32( _mm512_add_epi32( x0, one ), wmax );
+            __m512i y1 = _mm512_min_epi32( _mm512_add_epi32( y0, one ), hmax );
+            if( NC > 1 ) {
+                x0 = _mm512_mullo_epi32( x0, nc );
+                x1 = _mm512_mullo_epi32( x1, nc );
+            }
+            y0 = _mm512_mullo_epi32( y0, vstride );
+            y1 = _mm512_mullo_epi32( y1, vstride );
+            sample_gather_avx512<NC>( img, _mm512_add_epi32( y0, x0 ), lim, v00 );
+            sample_gather_avx512<NC>( img, _mm512_add_epi32( y0, x1 ), lim, v01 );
+            sample_gather_avx512<NC>( img, _mm512_add_epi32( y1, x0 ), lim, v10 );
+            sample_gather_avx512<NC>( img, _mm512_add_epi32( y1, x1 ), lim, v11 );
+            for( int c=0; c<NC; c++ ) {
+                __m512 top = _mm512_fmadd_ps( a, _mm512_sub_ps( v01[c], v00[c] ), v00[c] );
+                __m512 bot = _mm512_fmadd_ps( a, _mm512_sub_ps( v11[c], v10[c] ), v10[c] );
+                v00[c] = _mm512_fmadd_ps( b, _mm512_sub_ps( bot, top ), top );
+            }
+            sample_store_avx512<NC>( v00, out+size_t(i)*NC );
+        }
+        if( i < n )
+            sample_bilinear_basic<T,NC>( img, w, h, stride, xs+i, ys+i, n-i, out+size_t(i)*NC );
+    }
+
+    template<typename T, int NC> KORTEX_TARGET_AVX512
+    void sample_bicubic_avx512( const T* img, const int& w, const int& h, const int& stride,
+                                const float* xs, const float* ys, const int& n, float* out ) {
+        const __m512  zero   = _mm512_setzero_ps();
+        const __m512  xmax   = _mm512_set1_ps( float(w-1) );
+        const __m512  ymax   = _mm512_set1_ps( float(h-1) );
+        const __m512i one    = _mm512_set1_epi32( 1 );
+        const __m512i two    = _mm512_set1_epi32( 2 );
+        const __m512i w3     = _mm512_set1_epi32( w-3 );
+        const __m512i h3     = _mm512_set1_epi32( h-3 );
+        const __m512i nc     = _mm512_set1_epi32( NC );
+        const __m512i vstride = _mm512_set1_epi32( stride );
+        const __m512i lim     = _mm512_set1_epi32( (h-1)*stride + w*NC-4 );
+        __m512 wx[4], wy[4], v[NC], row[NC], acc[NC];
+        int i = 0;
+        for( ; i+16<=n; i+=16 ) {
+            __m512  x  = _mm512_min_ps( _mm512_max_ps( _mm512_loadu_ps(xs+i), zero ), xmax );
+            __m512  y  = _mm512_min_ps( _mm512_max_ps( _mm512_loadu_ps(ys+i), zero ), ymax );
+            __m512i ix = _mm512_cvttps_epi32( x );
+            __m512i iy = _mm512_cvttps_epi32( y );
+            catmull_rom_weights_avx512( _mm512_sub_ps( x, _mm512_cvtepi32_ps(ix) ), wx );
+            catmull_rom_weights_avx512( _mm512_sub_ps( y, _mm512_cvtepi32_ps(iy) ), wy );
+            __mmask16 border = _mm512_cmplt_epi32_mask( ix, two ) | _mm512_cmplt_epi32_mask( iy, two )
+                             | _mm512_cmpge_epi32_mask( ix, w3  ) | _mm512_cmpge_epi32_mask( iy, h3  );
+            __m512i cx = _mm512_min_epi32( _mm512_max_epi32( ix, one ), w3 );
+            __m512i cy = _mm512_min_epi32( _mm512_max_epi32( iy, one ), h3 );
+            __m512i p  = _mm512_add_epi32( _mm512_mullo_epi32( _mm512_sub_epi32( cy, one ), vstride ),
+                                           _mm512_mullo_epi32( _mm512_sub_epi32( cx, one ), nc     ) );
+            for( int c=0; c<NC; c++ )
+                acc[c] = zero;
+            for( int j=0; j<4; j++ ) {
+                for( int c=0; c<NC; c++ )
+                    row[c] = zero;
+                for( int k=0; k<4; k++ ) {
+                    sample_gather_avx512<NC>( img, _mm512_add_epi32( p, _mm512_set1_epi32(k*NC) ), lim, v );
+                    for( int c=0; c<NC; c++ )
+                        row[c] = _mm512_fmadd_ps( wx[k], v[c], row[c] );
+                }
+                for( int c=0; c<NC; c++ )
+                    acc[c] = _mm512_fmadd_ps( wy[j], row[c], acc[c] );
+                p = _mm512_add_epi32( p, vstride );
+            }
+            p = _mm512_add_epi32( _mm512_mullo_epi32( iy, vstride ), _mm512_mullo_epi32( ix, nc ) );
+            sample_gather_avx512<NC>( img, p, lim, v );
+            for( int c=0; c<NC; c++ )
+                acc[c] = _mm512_mask_blend_ps( border, acc[c], v[c] );
+            sample_store_avx512<NC>( acc, out+size_t(i)*NC );
+        }
+        if( i < n )
+            sample_bicubic_basic<T,NC>( img, w, h, stride, xs+i, ys+i, n-i, out+size_t(i)*NC );
+    }
+#endif
+
+    template<typename T, int NC>
+    void sample_points( const T* img, const int& w, const int& h, const int& stride, const bool& bicubic,
+                        const float* xs, const float* ys, const int& n, float* out ) {
+#ifdef KORTEX_WITH_SIMD_DISPATCH
+        // the simd bicubic kernels need a full 4x4 support, the uchar gathers
+        // read a dword
+        if( bicubic ? ( w >= 4 && h >= 4 ) : ( (h-1)*stride + w*NC >= 4 ) ) {
+            switch( simd_level() ) {
+            case SIMD_AVX512:
+                if( bicubic ) sample_bicubic_avx512 <T,NC>( img, w, h, stride, xs, ys, n, out );
+                else          sample_bilinear_avx512<T,NC>( img, w, h, stride, xs, ys, n, out );
+                return;
+            case SIMD_AVX2:
+                if( bicubic ) sample_bicubic_avx2 <T,NC>( img, w, h, stride, xs, ys, n, out );
+                else          sample_bilinear_avx2<T,NC>( img, w, h, stride, xs, ys, n, out );
+                return;
+            default: break;
+            }
+        }
+#endif
+        if( bicubic ) sample_bicubic_basic <T,NC>( img, w, h, stride, xs, ys, n, out );
+        else          sample_bilinear_basic<T,NC>( img, w, h, stride, xs, ys, n, out );
+    }
+
+    template<typename T>
+    void sample_points( const T* img, const int& w, const int& h, const int& nc, const size_t& stride, const bool& bicubic,
+                        const float* xs, const float* ys, const int& n, float* out ) {
+        assert_pointer( img && xs && ys && out );
+        passert_statement_g( w > 0 && h > 0 && stride >= size_t(w)*size_t(nc) && size_t(h)*stride < size_t(INT_MAX),
+                             "[%dx%d] invalid image size", w, h );
+        switch( nc ) {
+        case 1 : sample_points<T,1>( img, w, h, int(stride), bicubic, xs, ys, n, out ); break;
+        case 3 : sample_points<T,3>( img, w, h, int(stride), bicubic, xs, ys, n, out ); break;
+        default: logman_fatal_g( "[nc %d] only 1 or 3 channels are supported", nc );
+        }
+    }
+
+    void sample_bilinear( const float* img, const int& w, const int& h, const int& nc, const size_t& stride,
+                          const float* xs, const float* ys, const int& n, float* out ) {
+        sample_points( img, w, h, nc, stride, false, xs, ys, n, out );
+    }
+
+    void sample_bilinear( const uchar* img, const int& w, const int& h, const int& nc, const size_t& stride,
+                          const float* xs, const float* ys, const int& n, float* out ) {
+        sample_points( img, w, h, nc, stride, false, xs, ys, n, out );
+    }
+
+    void sample_bicubic( const float* img, const int& w, const int& h, const int& nc, const size_t& stride,
+                         const float* xs, const float* ys, const int& n, float* out ) {
+        sample_points( img, w, h, nc, stride, true, xs, ys, n, out );
+    }
+
+    void sample_bicubic( const uchar* img, const int& w, const int& h, const int& nc, const size_t& stride,
+                         const float* xs, const float* ys, const int& n, float* out ) {
+        sample_points( img, w, h, nc, stride, true, xs, ys, n, out );
+    }
+
+}
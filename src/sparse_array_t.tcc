@@ -25,6 +25,11 @@ namespace kortex {
         m_data.clear();
     }
 
+    template< typename KeyType, typename DataType >
+    void SparseArrayT<KeyType,DataType>::reserve( const int& n ) {
+        m_data.reserve( n );
+    }
+
     template< typename KeyType, typename DataType >
     bool SparseArrayT<KeyType,DataType>::check( const KeyType& key ) const {
         if( m_data.find(key) == m_data.end() )
@@ -39,26 +44,29 @@ namespace kortex {
 
     template< typename KeyType, typename DataType >
     void SparseArrayT<KeyType,DataType>::add( const KeyType& key, const DataType& val ) {
-        if( check(key) )
-            m_data[key] += val;
+        auto it = m_data.find( key );
+        if( it != m_data.end() )
+            it->second += val;
         else
-            this->set( key, val );
+            m_data.insert( std::make_pair( key, val ) );
     }
 
     template< typename KeyType, typename DataType >
     void SparseArrayT<KeyType,DataType>::inc( const KeyType& key ) {
-        if( !check(key) )
-            this->set( key, DataType(1) );
+        auto it = m_data.find( key );
+        if( it != m_data.end() )
+            it->second = it->second + DataType(1);
         else
-            m_data[key] = m_data[key] + DataType(1);
+            m_data.insert( std::make_pair( key, DataType(1) ) );
     }
 
     template< typename KeyType, typename DataType >
     void SparseArrayT<KeyType,DataType>::dec( const KeyType& key ) {
-        if( !check(key) )
-            this->set( key, DataType(-1) );
+        auto it = m_data.find( key );
+        if( it != m_data.end() )
+            it->second = it->second - DataType(1);
         else
-            m_data[key] = m_data[key] - DataType(1);
+            m_data.insert( std::make_pair( key, DataType(-1) ) );
     }
 
     template< typename KeyType, typename DataType >
@@ -68,8 +76,9 @@ namespace kortex {
 
     template< typename KeyType, typename DataType >
     DataType SparseArrayT<KeyType,DataType>::val( const KeyType& key ) const {
-        passert_statement_g( check(key), "requesting val for non-existing key[%s]", in_str(key).c_str() );
-        return m_data.at(key);
+        auto it = m_data.find( key );
+        passert_statement_g( it != m_data.end(), "requesting val for non-existing key[%s]", in_str(key).c_str() );
+        return it->second;
     }
 
     // template< typename KeyType, typename DataType >
@@ -0,0 +1,582 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/sparse_matrix.h>
+#include <kortex/check.h>
+#include <kortex/log_manager.h>
+
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace kortex {
+
+    using std::pair;
+
+    // transposes the compressed arrays - the output is sorted within each
+    // major index as the input majors are visited in order
+    static void transpose_arrays( int n_major, int n_minor,
+                                  const vector<int>& ptr, const vector<int>& idx, const vector<double>& val,
+                                  vector<int>& optr, vector<int>& oidx, vector<double>& oval ) {
+        optr.assign( n_minor+1, 0 );
+        oidx.resize( idx.size() );
+        oval.resize( val.size() );
+        for( size_t p=0; p<idx.size(); p++ )
+            optr[ idx[p]+1 ]++;
+        for( int i=0; i<n_minor; i++ )
+            optr[i+1] += optr[i];
+        vector<int> pos( optr.begin(), optr.end()-1 );
+        for( int i=0; i<n_major; i++ ) {
+            for( int p=ptr[i]; p<ptr[i+1]; p++ ) {
+                int q   = pos[ idx[p] ]++;
+                oidx[q] = i;
+                oval[q] = val[p];
+            }
+        }
+    }
+
+    SparseMatrix::SparseMatrix() {
+        m_nr      = 0;
+        m_nc      = 0;
+        m_storage = SPARSE_CSR;
+    }
+
+    void SparseMatrix::release() {
+        m_nr = 0;
+        m_nc = 0;
+        vector<int>   ().swap( m_ptr );
+        vector<int>   ().swap( m_idx );
+        vector<double>().swap( m_val );
+    }
+
+    void SparseMatrix::init( int nr, int nc, const vector<SparseTriplet>& triplets,
+                             const SparseStorage& storage ) {
+        passert_statement_g( nr >= 0 && nc >= 0, "invalid matrix size [%d %d]", nr, nc );
+        m_nr      = nr;
+        m_nc      = nc;
+        m_storage = storage;
+        const bool csr    = ( storage == SPARSE_CSR );
+        const int  n_maj  = n_major();
+
+        // bucket by the major index
+        m_ptr.assign( n_maj+1, 0 );
+        for( size_t t=0; t<triplets.size(); t++ ) {
+            const SparseTriplet& e = triplets[t];
+            passert_boundary( e.r, 0, nr );
+            passert_boundary( e.c, 0, nc );
+            m_ptr[ ( csr ? e.r : e.c )+1 ]++;
+        }
+        for( int i=0; i<n_maj; i++ )
+            m_ptr[i+1] += m_ptr[i];
+        vector< pair<int,double> > entries( triplets.size() );
+        vector<int> pos( m_ptr.begin(), m_ptr.end()-1 );
+        for( size_t t=0; t<triplets.size(); t++ ) {
+            const SparseTriplet& e = triplets[t];
+            entries[ pos[ csr ? e.r : e.c ]++ ] = pair<int,double>( csr ? e.c : e.r, e.v );
+        }
+
+        // sort each major and sum the duplicates while compacting
+        m_idx.resize( entries.size() );
+        m_val.resize( entries.size() );
+        int n = 0;
+        for( int i=0; i<n_maj; i++ ) {
+            const int beg = m_ptr[i];
+            const int end = m_ptr[i+1];
+            m_ptr[i] = n;
+            std::sort( entries.begin()+beg, entries.begin()+end );
+            for( int p=beg; p<end; p++ ) {
+                if( n > m_ptr[i] && m_idx[n-1] == entries[p].first ) {
+                    m_val[n-1] += entries[p].second;
+                } else {
+                    m_idx[n] = entries[p].first;
+                    m_val[n] = entries[p].second;
+                    n++;
+                }
+            }
+        }
+        m_ptr[n_maj] = n;
+        m_idx.resize( n );
+        m_val.resize( n );
+    }
+
+    void SparseMatrix::init( int nr, int nc, const SparseStorage& storage,
+                             const int* ptr, const int* idx, const double* val ) {
+        passert_pointer( ptr );
+        passert_statement_g( nr >= 0 && nc >= 0, "invalid matrix size [%d %d]", nr, nc );
+        m_nr      = nr;
+        m_nc      = nc;
+        m_storage = storage;
+        const int n_maj = n_major();
+        const int nz    = ptr[n_maj];
+        passert_pointer( nz == 0 || ( idx && val ) );
+        m_ptr.assign( ptr, ptr+n_maj+1 );
+        m_idx.assign( idx, idx+nz );
+        m_val.assign( val, val+nz );
+    }
+
+    double SparseMatrix::get( int r, int c ) const {
+        assert_boundary( r, 0, m_nr );
+        assert_boundary( c, 0, m_nc );
+        const int maj = ( m_storage == SPARSE_CSR ) ? r : c;
+        const int mnr = ( m_storage == SPARSE_CSR ) ? c : r;
+        if( m_ptr[maj] == m_ptr[maj+1] ) return 0.0;
+        const int* beg = &m_idx[0] + m_ptr[maj];
+        const int* end = &m_idx[0] + m_ptr[maj+1];
+        const int* it  = std::lower_bound( beg, end, mnr );
+        if( it == end || *it != mnr ) return 0.0;
+        return m_val[ it - &m_idx[0] ];
+    }
+
+    void SparseMatrix::diagonal( double* d ) const {
+        passert_pointer( d );
+        const int n = std::min( m_nr, m_nc );
+        for( int i=0; i<n; i++ )
+            d[i] = get( i, i );
+    }
+
+    void SparseMatrix::gather( const double* x, double* y ) const {
+        const int     n   = n_major();
+        const int*    ptr = &m_ptr[0];
+        const int*    idx = this->idx();
+        const double* val = this->val();
+#pragma omp parallel for schedule(static)
+        for( int i=0; i<n; i++ ) {
+            double s = 0.0;
+            for( int p=ptr[i]; p<ptr[i+1]; p++ )
+                s += val[p] * x[ idx[p] ];
+            y[i] = s;
+        }
+    }
+
+    void SparseMatrix::scatter( const double* x, double* y ) const {
+        const int n = n_major();
+        memset( y, 0, sizeof(*y)*n_minor() );
+        for( int i=0; i<n; i++ ) {
+            const double xi = x[i];
+            if( xi == 0.0 ) continue;
+            for( int p=m_ptr[i]; p<m_ptr[i+1]; p++ )
+                y[ m_idx[p] ] += m_val[p] * xi;
+        }
+    }
+
+    void SparseMatrix::mult( const double* x, double* y ) const {
+        passert_pointer( x && y );
+        passert_noalias_p( x, y );
+        if( m_storage == SPARSE_CSR ) gather ( x, y );
+        else                          scatter( x, y );
+    }
+
+    void SparseMatrix::mult_trans( const double* x, double* y ) const {
+        passert_pointer( x && y );
+        passert_noalias_p( x, y );
+        if( m_storage == SPARSE_CSC ) gather ( x, y );
+        else                          scatter( x, y );
+    }
+
+    void SparseMatrix::transpose( SparseMatrix& At ) const {
+        passert_noalias_p( this, &At );
+        At.m_nr      = m_nc;
+        At.m_nc      = m_nr;
+        At.m_storage = m_storage;
+        transpose_arrays( n_major(), n_minor(), m_ptr, m_idx, m_val, At.m_ptr, At.m_idx, At.m_val );
+    }
+
+    void SparseMatrix::convert( const SparseStorage& storage, SparseMatrix& B ) const {
+        passert_noalias_p( this, &B );
+        if( storage == m_storage ) {
+            B = *this;
+            return;
+        }
+        B.m_nr      = m_nr;
+        B.m_nc      = m_nc;
+        B.m_storage = storage;
+        transpose_arrays( n_major(), n_minor(), m_ptr, m_idx, m_val, B.m_ptr, B.m_idx, B.m_val );
+    }
+
+    void SparseMatrix::to_dense( double* A ) const {
+        passert_pointer( A );
+        memset( A, 0, sizeof(*A)*size_t(m_nr)*m_nc );
+        const bool csr = ( m_storage == SPARSE_CSR );
+        for( int i=0; i<n_major(); i++ ) {
+            for( int p=m_ptr[i]; p<m_ptr[i+1]; p++ ) {
+                if( csr ) A[ size_t(i)*m_nc + m_idx[p] ] = m_val[p];
+                else      A[ size_t(m_idx[p])*m_nc + i ] = m_val[p];
+            }
+        }
+    }
+
+    //
+    // iterative solvers
+    //
+
+    IterativeSolverParams::IterativeSolverParams() {
+        max_iterations = 1000;
+        tolerance      = 1e-8;
+        preconditioner = PRECONDITIONER_JACOBI;
+        damp           = 0.0;
+    }
+
+    static double vec_dot( const double* a, const double* b, const int& n ) {
+        double s = 0.0;
+#pragma omp parallel for schedule(static) reduction(+:s)
+        for( int i=0; i<n; i++ )
+            s += a[i]*b[i];
+        return s;
+    }
+
+    static double vec_norm( const double* a, const int& n ) {
+        return std::sqrt( vec_dot( a, a, n ) );
+    }
+
+    // y = a*x + b*y
+    static void vec_axpby( const double& a, const double* x, const double& b, double* y, const int& n ) {
+#pragma omp parallel for schedule(static)
+        for( int i=0; i<n; i++ )
+            y[i] = a*x[i] + b*y[i];
+    }
+
+    static void vec_scale( const double& s, double* x, const int& n ) {
+#pragma omp parallel for schedule(static)
+        for( int i=0; i<n; i++ )
+            x[i] *= s;
+    }
+
+    // y = A x for a symmetric A with whichever product gathers
+    static void sym_mult( const SparseMatrix& A, const double* x, double* y ) {
+        if( A.storage() == SPARSE_CSR ) A.mult      ( x, y );
+        else                            A.mult_trans( x, y );
+    }
+
+    // z = M^-1 r. for a symmetric matrix the major i of both csr and csc holds
+    // row i, so the incomplete factor is built the same way for both.
+    class SparsePreconditionerOp {
+    public:
+        SparsePreconditionerOp( const SparseMatrix& A, const SparsePreconditioner& type );
+        void apply( const double* r, double* z ) const;
+    private:
+        SparsePreconditioner m_type;
+        int                  m_n;
+        vector<double>       m_inv_diag;
+        // lower triangular factor in csr - the diagonal is the last entry of
+        // each row
+        vector<int>          m_lptr;
+        vector<int>          m_lidx;
+        vector<double>       m_lval;
+
+        void init_jacobi ( const SparseMatrix& A );
+        /// shift is added to the diagonal
+        bool factor_ichol( const double* aval, const double& shift );
+    };
+
+    SparsePreconditionerOp::SparsePreconditionerOp( const SparseMatrix& A, const SparsePreconditioner& type ) {
+        m_type = type;
+        m_n    = A.rows();
+        if( m_type == PRECONDITIONER_NONE )
+            return;
+
+        if( m_type == PRECONDITIONER_JACOBI ) {
+            init_jacobi( A );
+            return;
+        }
+
+        // the diagonal shift can not make a non-positive pivot positive
+        vector<double> diag( m_n );
+        A.diagonal( &diag[0] );
+        double max_diag = 0.0;
+        for( int i=0; i<m_n; i++ ) {
+            if( !( diag[i] > 0.0 ) ) {
+                logman_warning_g( "non-positive diagonal entry [%g] at row [%d]. "
+                                  "falling back to jacobi preconditioning", diag[i], i );
+                init_jacobi( A );
+                return;
+            }
+            max_diag = std::max( max_diag, diag[i] );
+        }
+
+        // lower triangle pattern
+        const int*    ptr = A.ptr();
+        const int*    idx = A.idx();
+        const double* val = A.val();
+        m_lptr.assign( m_n+1, 0 );
+        m_lidx.clear();
+        vector<double> aval;
+        for( int i=0; i<m_n; i++ ) {
+            for( int p=ptr[i]; p<ptr[i+1] && idx[p] <= i; p++ ) {
+                m_lidx.push_back( idx[p] );
+                aval.push_back( val[p] );
+            }
+            m_lptr[i+1] = (int)m_lidx.size();
+            passert_statement_g( m_lptr[i+1] > m_lptr[i] && m_lidx.back() == i,
+                                 "missing diagonal entry at row [%d]", i );
+        }
+        m_lval.resize( aval.size() );
+
+        // a shift of a few times the largest diagonal makes the matrix
+        // diagonally dominant unless its off-diagonals are huge - give up
+        // then instead of growing the shift forever
+        const int max_retries = 40;
+        double shift = 0.0;
+        for( int r=0; !factor_ichol( &aval[0], shift * max_diag ); r++ ) {
+            if( r == max_retries ) {
+                logman_warning_g( "incomplete cholesky broke down with diagonal shift [%g]. "
+                                  "falling back to jacobi preconditioning", shift * max_diag );
+                vector<int>   ().swap( m_lptr );
+                vector<int>   ().swap( m_lidx );
+                vector<double>().swap( m_lval );
+                init_jacobi( A );
+                return;
+            }
+            shift = std::max( 2.0*shift, 1e-3 );
+            logman_warning_g( "incomplete cholesky broke down. retrying with diagonal shift [%g]", shift * max_diag );
+        }
+    }
+
+    void SparsePreconditionerOp::init_jacobi( const SparseMatrix& A ) {
+        m_type = PRECONDITIONER_JACOBI;
+        m_inv_diag.resize( m_n );
+        A.diagonal( &m_inv_diag[0] );
+        for( int i=0; i<m_n; i++ )
+            m_inv_diag[i] = ( m_inv_diag[i] != 0.0 ) ? 1.0/m_inv_diag[i] : 1.0;
+    }
+
+    bool SparsePreconditionerOp::factor_ichol( const double* aval, const double& shift ) {
+        const int*    lptr = &m_lptr[0];
+        const int*    lidx = &m_lidx[0];
+        double*       lval = &m_lval[0];
+        for( int i=0; i<m_n; i++ ) {
+            const int di = lptr[i+1]-1;
+            for( int p=lptr[i]; p<di; p++ ) {
+                const int k  = lidx[p];
+                const int dk = lptr[k+1]-1;
+                // sum_{j<k} l_ij l_kj over the common pattern
+                double s = aval[p];
+                int a = lptr[i], b = lptr[k];
+                while( a < p && b < dk ) {
+                    if     ( lidx[a] < lidx[b] ) a++;
+                    else if( lidx[a] > lidx[b] ) b++;
+                    else                         s -= lval[a++] * lval[b++];
+                }
+                lval[p] = s / lval[dk];
+            }
+            double d = aval[di] + shift;
+            for( int p=lptr[i]; p<di; p++ )
+                d -= lval[p]*lval[p];
+            if( !( d > 0.0 ) )
+                return false;
+            lval[di] = std::sqrt( d );
+        }
+        return true;
+    }
+
+    void SparsePreconditionerOp::apply( const double* r, double* z ) const {
+        switch( m_type ) {
+        case PRECONDITIONER_NONE:
+            memcpy( z, r, sizeof(*z)*m_n );
+            break;
+        case PRECONDITIONER_JACOBI: {
+            const double* id = &m_inv_diag[0];
+#pragma omp parallel for schedule(static)
+            for( int i=0; i<m_n; i++ )
+                z[i] = id[i] * r[i];
+        } break;
+        case PRECONDITIONER_ICHOL: {
+            const int*    lptr = &m_lptr[0];
+            const int*    lidx = &m_lidx[0];
+            const double* lval = &m_lval[0];
+            // L y = r
+            for( int i=0; i<m_n; i++ ) {
+                const int di = lptr[i+1]-1;
+                double s = r[i];
+                for( int p=lptr[i]; p<di; p++ )
+                    s -= lval[p] * z[ lidx[p] ];
+                z[i] = s / lval[di];
+            }
+            // L' z = y
+            for( int i=m_n-1; i>=0; i-- ) {
+                const int di = lptr[i+1]-1;
+                const double zi = ( z[i] /= lval[di] );
+                for( int p=lptr[i]; p<di; p++ )
+                    z[ lidx[p] ] -= lval[p] * zi;
+            }
+        } break;
+        }
+    }
+
+    static bool pcg( const SparseMatrix& A, const double* b, double* x,
+                     const IterativeSolverParams& params, const SparsePreconditioner& type,
+                     IterativeSolverStats* stats ) {
+        passert_pointer( b && x );
+        passert_statement_g( A.rows() == A.cols(), "matrix is not square [%d %d]", A.rows(), A.cols() );
+        const int n = A.rows();
+        SparsePreconditionerOp M( A, type );
+
+        vector<double> r( n ), z( n ), p( n ), Ap( n );
+        sym_mult( A, x, &r[0] );
+        vec_axpby( 1.0, b, -1.0, &r[0], n );
+        M.apply( &r[0], &z[0] );
+        p = z;
+
+        const double bnorm = vec_norm( b, n );
+        const double stop  = params.tolerance * ( bnorm > 0.0 ? bnorm : 1.0 );
+        double rz    = vec_dot( &r[0], &z[0], n );
+        double rnorm = vec_norm( &r[0], n );
+        int    it    = 0;
+        for( ; it<params.max_iterations && rnorm > stop; it++ ) {
+            sym_mult( A, &p[0], &Ap[0] );
+            const double pAp = vec_dot( &p[0], &Ap[0], n );
+            if( !( pAp > 0.0 ) ) {
+                logman_warning_g( "matrix is not positive definite [p'Ap %g]", pAp );
+                break;
+            }
+            const double alpha = rz / pAp;
+            vec_axpby(  alpha, &p [0], 1.0, x,     n );
+            vec_axpby( -alpha, &Ap[0], 1.0, &r[0], n );
+            M.apply( &r[0], &z[0] );
+            const double rz_new = vec_dot( &r[0], &z[0], n );
+            vec_axpby( 1.0, &z[0], rz_new/rz, &p[0], n );
+            rz    = rz_new;
+            rnorm = vec_norm( &r[0], n );
+        }
+
+        const bool converged = ( rnorm <= stop );
+        if( stats ) {
+            stats->n_iterations = it;
+            stats->residual     = rnorm;
+            stats->converged    = converged;
+        }
+        return converged;
+    }
+
+    bool sparse_solver_cg( const SparseMatrix& A, const double* b, double* x,
+                           const IterativeSolverParams& params, IterativeSolverStats* stats ) {
+        return pcg( A, b, x, params, PRECONDITIONER_NONE, stats );
+    }
+
+    bool sparse_solver_pcg( const SparseMatrix& A, const double* b, double* x,
+                            const IterativeSolverParams& params, IterativeSolverStats* stats ) {
+        return pcg( A, b, x, params, params.preconditioner, stats );
+    }
+
+    // y = A' x through the csr transpose At if there is one
+    static void lsqr_mult_trans( const SparseMatrix& A, const SparseMatrix* At, const double* x, double* y ) {
+        if( At ) At->mult      ( x, y );
+        else     A  .mult_trans( x, y );
+    }
+
+    bool sparse_solver_lsqr( const SparseMatrix& A, const double* b, double* x,
+                             const IterativeSolverParams& params, IterativeSolverStats* stats ) {
+        passert_pointer( b && x );
+        const int m = A.rows();
+        const int n = A.cols();
+
+        // B = A and Bt = A' in csr so that both products gather. the csc
+        // arrays of A already are the csr arrays of A'.
+        SparseMatrix C, T;
+        const SparseMatrix* B  = &A;
+        const SparseMatrix* Bt = &T;
+        if( A.storage() == SPARSE_CSR ) {
+            A.transpose( T );
+        } else {
+            A.convert( SPARSE_CSR, C );
+            B  = &C;
+            Bt = NULL;
+        }
+
+        const double damp = params.damp;
+        vector<double> u( m ), v( n ), w( n ), tmp( std::max( m, n ) ), dx( n, 0.0 );
+
+        // solves for the update of the initial guess
+        B->mult( x, &u[0] );
+        vec_axpby( 1.0, b, -1.0, &u[0], m );
+        const double bnorm = vec_norm( b, m );
+        double beta = vec_norm( &u[0], m );
+        double alpha = 0.0;
+        if( beta > 0.0 ) {
+            vec_scale( 1.0/beta, &u[0], m );
+            lsqr_mult_trans( A, Bt, &u[0], &v[0] );
+            alpha = vec_norm( &v[0], n );
+        }
+        if( alpha > 0.0 )
+            vec_scale( 1.0/alpha, &v[0], n );
+        w = v;
+
+        double phibar = beta;
+        double rhobar = alpha;
+        double anorm2 = 0.0;
+        double res2   = 0.0;  // accumulated damping part of the residual
+        double rnorm  = beta;
+        double arnorm = alpha*beta;
+        const double stop = params.tolerance * ( bnorm > 0.0 ? bnorm : 1.0 );
+        bool converged = ( rnorm <= stop || arnorm == 0.0 );
+
+        int it = 0;
+        for( ; it<params.max_iterations && !converged; it++ ) {
+            // bidiagonalization
+            B->mult( &v[0], &tmp[0] );
+            vec_axpby( 1.0, &tmp[0], -alpha, &u[0], m );
+            beta = vec_norm( &u[0], m );
+            if( beta > 0.0 ) {
+                vec_scale( 1.0/beta, &u[0], m );
+                anorm2 += alpha*alpha + beta*beta + damp*damp;
+                lsqr_mult_trans( A, Bt, &u[0], &tmp[0] );
+                vec_axpby( 1.0, &tmp[0], -beta, &v[0], n );
+                alpha = vec_norm( &v[0], n );
+                if( alpha > 0.0 )
+                    vec_scale( 1.0/alpha, &v[0], n );
+            }
+
+            // eliminates the damping parameter
+            const double rhobar1 = std::sqrt( rhobar*rhobar + damp*damp );
+            const double cs1     = rhobar / rhobar1;
+            const double sn1     = damp   / rhobar1;
+            const double psi     = sn1 * phibar;
+            phibar = cs1 * phibar;
+
+            // plane rotation
+            const double rho   = std::sqrt( rhobar1*rhobar1 + beta*beta );
+            const double c     = rhobar1 / rho;
+            const double s     = beta    / rho;
+            const double theta = s * alpha;
+            rhobar = -c * alpha;
+            const double phi   = c * phibar;
+            phibar = s * phibar;
+
+            // dx += (phi/rho) w, w = v - (theta/rho) w
+            const double t1 = phi / rho;
+            const double t2 = -theta / rho;
+            vec_axpby( t1, &w[0], 1.0, &dx[0], n );
+            vec_axpby( 1.0, &v[0], t2, &w[0], n );
+
+            res2  += psi*psi;
+            rnorm  = std::sqrt( phibar*phibar + res2 );
+            arnorm = alpha * std::fabs( s*phi );
+            converged = ( rnorm <= stop ) ||
+                        ( arnorm <= params.tolerance * std::sqrt( anorm2 ) * rnorm );
+        }
+
+        vec_axpby( 1.0, &dx[0], 1.0, x, n );
+        if( stats ) {
+            stats->n_iterations = it;
+            stats->residual     = rnorm;
+            stats->converged    = converged;
+        }
+        return converged;
+    }
+
+}
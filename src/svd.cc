@@ -15,6 +15,9 @@
 #include <kortex/kmatrix.h>
 #include <kortex/svd.h>
 
+#include <cstring>
+#include <algorithm>
+
 namespace kortex {
 
     SVD::SVD() {
@@ -33,6 +36,9 @@ namespace kortex {
     }
 
     void SVD::set_params(int nr, int nc, bool compute_U, bool compute_VT) {
+        // buffers of the previous call are reused as is
+        if( m_r == nr && m_c == nc && m_compute_u == compute_U && m_compute_vt == compute_VT )
+            return;
         m_r = nr;
         m_c = nc;
         m_d = (m_r<m_c) ? m_r : m_c;
@@ -118,6 +124,37 @@ namespace kortex {
         return cond;
     }
 
+    static void svd_decompose_batch_( const double* A, const bool& inplace, int n_mats, int nr, int nc,
+                                      double* Sd, double* U, double* Vt ) {
+        passert_pointer( A  );
+        passert_pointer( Sd );
+        passert_statement_g( nr > 0 && nc > 0, "invalid matrix size [%d %d]", nr, nc );
+        const size_t asz = size_t(nr)*nc;
+        const int    d   = std::min( nr, nc );
+#pragma omp parallel
+        {
+            SVD svd;
+#pragma omp for schedule(dynamic,16)
+            for( int i=0; i<n_mats; i++ ) {
+                if( inplace ) svd.decompose_inplace( const_cast<double*>(A) + i*asz, nr, nc, U!=NULL, Vt!=NULL );
+                else          svd.decompose        ( A + i*asz, nr, nc, U!=NULL, Vt!=NULL );
+                memcpy( Sd + size_t(i)*d, svd.Sd(), sizeof(*Sd)*d );
+                if( U  ) memcpy( U  + size_t(i)*nr*nr, svd.U (), sizeof(*U )*nr*nr );
+                if( Vt ) memcpy( Vt + size_t(i)*nc*nc, svd.Vt(), sizeof(*Vt)*nc*nc );
+            }
+        }
+    }
+
+    void svd_decompose_batch( const double* A, int n_mats, int nr, int nc,
+                              double* Sd, double* U, double* Vt ) {
+        svd_decompose_batch_( A, false, n_mats, nr, nc, Sd, U, Vt );
+    }
+
+    void svd_decompose_batch_inplace( double* A, int n_mats, int nr, int nc,
+                                      double* Sd, double* U, double* Vt ) {
+        svd_decompose_batch_( A, true, n_mats, nr, nc, Sd, U, Vt );
+    }
+
     void SVD::print() const {
         if( m_compute_u ) {
             m_U.print( "U" );
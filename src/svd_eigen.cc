@@ -29,6 +29,11 @@ namespace kortex {
             m_Sd.set( i, 0, svd.singularValues()[i] );
     }
 
+    void SVD::decompose_inplace( double* A, int nr, int nc, bool compute_u, bool compute_vt ) {
+        // eigen works on its own copy anyway
+        decompose( A, nr, nc, nc, compute_u, compute_vt );
+    }
+
 }
 
 #endif
@@ -10,7 +10,8 @@ namespace kortex {
         int info;
         int m = nr;
         int n = nc;
-        dgesvd_(&jobvt, &jobu, &m, &n, 0,  &m, 0, 0, &m, 0, &n, &work, &lwork, &info);
+        // same ( transposed ) problem as in decompose
+        dgesvd_(&jobvt, &jobu, &n, &m, 0,  &n, 0, 0, &n, 0, &m, &work, &lwork, &info);
         return int(work)*sizeof(double);
     }
 
@@ -19,6 +20,12 @@ namespace kortex {
         set_params(nr, nc, compute_u, compute_vt);
         for(int y=0; y<nr; y++)
             m_A.set_row( y, A + y*nld, nc );
+        decompose_inplace( m_A.get_pointer(), nr, nc, compute_u, compute_vt );
+    }
+
+    void SVD::decompose_inplace( double* A, int nr, int nc, bool compute_u, bool compute_vt ) {
+        passert_pointer( A );
+        set_params(nr, nc, compute_u, compute_vt);
 
         char jobu  = 'N'; if( m_compute_u  ) jobu  = 'A';
         char jobvt = 'N'; if( m_compute_vt ) jobvt = 'A';
@@ -36,7 +43,7 @@ namespace kortex {
         if( m_compute_u  )  u_ptr = m_U.get_pointer();
 
         // computing the A-transpose svd here -> dgesvd is column-major
-        dgesvd_( &jobvt, &jobu, &n, &m, m_A.get_pointer(), &proxy_ld,
+        dgesvd_( &jobvt, &jobu, &n, &m, A, &proxy_ld,
                  m_Sd.get_pointer(), vt_ptr, &n, u_ptr, &m, work, &work_sz,
                  &info );
     }
@@ -0,0 +1,380 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/ann_index.h>
+#include <kortex/descriptor_matcher.h>
+#include <kortex/random_generator.h>
+#include <kortex/cpu_features.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+using namespace kortex;
+using std::vector;
+using std::pair;
+
+void kd_exact_test();
+void kd_approximate_test();
+void kd_radius_test();
+void hnsw_test();
+void save_load_test();
+void ann_benchmark();
+
+int main(int argc, char **argv) {
+    kd_exact_test();
+    kd_approximate_test();
+    kd_radius_test();
+    hnsw_test();
+    save_load_test();
+    ann_benchmark();
+    release_log_man();
+}
+
+const SimdLevel g_levels[] = { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };
+
+// points near a random d_latent dimensional subspace - descriptors are far
+// from uniformly distributed in their space
+void clustered_points( PhiloxGenerator& gen, const int& n, const int& dim, const int& d_latent,
+                       vector<float>& X ) {
+    vector<float> B( size_t(d_latent)*dim );
+    for( size_t i=0; i<B.size(); i++ )
+        B[i] = float( gen.normal_sample() );
+    X.assign( size_t(n)*dim, 0.0f );
+    vector<float> z( d_latent );
+    for( int i=0; i<n; i++ ) {
+        for( int j=0; j<d_latent; j++ )
+            z[j] = float( gen.normal_sample() );
+        float* x = &X[ size_t(i)*dim ];
+        for( int j=0; j<d_latent; j++ )
+            for( int d=0; d<dim; d++ )
+                x[d] += z[j] * B[ size_t(j)*dim + d ];
+        for( int d=0; d<dim; d++ )
+            x[d] += 0.1f * float( gen.normal_sample() );
+    }
+}
+
+void reference_knn( const vector<float>& Q, const vector<float>& X, const int& dim, const int& k,
+                    vector<int>& idx, vector<float>& dst ) {
+    const int nq = int( Q.size()/dim ), nx = int( X.size()/dim );
+    idx.assign( size_t(nq)*k, -1 );
+    dst.assign( size_t(nq)*k, -1.0f );
+    vector< pair<double,int> > d( nx );
+    for( int q=0; q<nq; q++ ) {
+        for( int i=0; i<nx; i++ ) {
+            double s = 0.0;
+            for( int c=0; c<dim; c++ ) {
+                double e = double( Q[ size_t(q)*dim+c ] ) - X[ size_t(i)*dim+c ];
+                s += e*e;
+            }
+            d[i] = pair<double,int>( s, i );
+        }
+        int kk = std::min( k, nx );
+        std::partial_sort( d.begin(), d.begin()+kk, d.end() );
+        for( int j=0; j<kk; j++ ) {
+            idx[ size_t(q)*k+j ] = d[j].second;
+            dst[ size_t(q)*k+j ] = float( std::sqrt( d[j].first ) );
+        }
+    }
+}
+
+// fraction of the true k nearest neighbors found
+double recall( const vector<int>& ref, const vector<int>& idx, const int& k ) {
+    const int nq = int( ref.size()/k );
+    int found = 0;
+    for( int q=0; q<nq; q++ ) {
+        const int* r = &ref[ size_t(q)*k ];
+        const int* a = &idx[ size_t(q)*k ];
+        for( int j=0; j<k; j++ )
+            if( std::find( a, a+k, r[j] ) != a+k ) found++;
+    }
+    return double( found ) / ( double(nq)*k );
+}
+
+bool same_distances( const vector<float>& ref, const vector<float>& dst, const float& eps ) {
+    if( ref.size() != dst.size() ) return false;
+    for( size_t j=0; j<ref.size(); j++ )
+        if( std::fabs( ref[j] - dst[j] ) > eps * ( 1.0f + std::fabs( ref[j] ) ) ) return false;
+    return true;
+}
+
+bool is_sorted_knn( const vector<int>& idx, const vector<float>& dst, const int& k ) {
+    for( size_t q=0; q<idx.size()/k; q++ )
+        for( int j=1; j<k; j++ ) {
+            if( idx[q*k+j] < 0 ) continue;
+            if( dst[q*k+j] < dst[q*k+j-1] ) return false;
+        }
+    return true;
+}
+
+void kd_exact_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 1 );
+    const int dims[] = { 3, 32 };
+    for( int di=0; di<2; di++ ) {
+        const int dim = dims[di];
+        const int k   = 5;
+        vector<float> X, Q;
+        clustered_points( gen, 5000, dim, std::min( dim, 8 ), X );
+        clustered_points( gen,  200, dim, std::min( dim, 8 ), Q );
+        // duplicates exercise the median split
+        for( int i=0; i<200; i++ )
+            std::copy( X.begin(), X.begin()+dim, X.begin() + size_t(4000+i)*dim );
+
+        vector<int>   ridx;
+        vector<float> rdst;
+        reference_knn( Q, X, dim, k, ridx, rdst );
+
+        KdForestParams params;
+        params.n_trees = 2;
+        KdForest forest;
+        forest.build( &X[0], 5000, dim, params );
+        for( int li=0; li<3; li++ ) {
+            if( g_levels[li] > cpu_simd_level() ) continue;
+            set_simd_level_limit( g_levels[li] );
+            vector<int>   idx( 200*k );
+            vector<float> dst( 200*k );
+            forest.knn( &Q[0], 200, k, 0, true, &idx[0], &dst[0] );
+            if( !same_distances( rdst, dst, 1e-4f ) ) passed = false;
+            if( !is_sorted_knn( idx, dst, k ) ) passed = false;
+        }
+        set_simd_level_limit( SIMD_AVX512 );
+
+        // more neighbors than points
+        KdForest small;
+        small.build( &X[0], 3, dim, params );
+        vector<int>   idx( 200*k );
+        vector<float> dst( 200*k );
+        small.knn( &Q[0], 200, k, 0, false, &idx[0], &dst[0] );
+        for( int q=0; q<200; q++ )
+            if( idx[q*k+2] < 0 || idx[q*k+3] != -1 || dst[q*k+4] != -1.0f ) passed = false;
+    }
+    if( passed ) printf("%50s passed\n", "kd forest exact search" );
+    else         printf("%50s failed\n", "kd forest exact search" );
+}
+
+void kd_approximate_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 2 );
+    const int dim = 8, n = 20000, nq = 500, k = 5;
+    vector<float> X( size_t(n)*dim ), Q( size_t(nq)*dim );
+    for( size_t i=0; i<X.size(); i++ )
+        X[i] = float( gen.uniform_sample() );
+    for( size_t i=0; i<Q.size(); i++ )
+        Q[i] = float( gen.uniform_sample() );
+    vector<int>   ridx;
+    vector<float> rdst;
+    reference_knn( Q, X, dim, k, ridx, rdst );
+
+    KdForest forest;
+    forest.build( &X[0], n, dim, KdForestParams() );
+    double prev = 0.0;
+    const int checks[] = { 32, 256, 2048 };
+    for( int c=0; c<3; c++ ) {
+        vector<int>   idx( nq*k );
+        vector<float> dst( nq*k );
+        forest.knn( &Q[0], nq, k, checks[c], true, &idx[0], &dst[0] );
+        double r = recall( ridx, idx, k );
+        if( r < prev - 0.01 ) passed = false;
+        if( !is_sorted_knn( idx, dst, k ) ) passed = false;
+        prev = r;
+    }
+    if( prev < 0.95 ) passed = false;
+    if( passed ) printf("%50s passed\n", "kd forest approximate search" );
+    else         printf("%50s failed\n", "kd forest approximate search" );
+}
+
+void kd_radius_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 3 );
+    const int n = 10000;
+    vector<float> X( 3*n );
+    for( size_t i=0; i<X.size(); i++ )
+        X[i] = float( gen.uniform_sample() );
+    KdForestParams params;
+    params.n_trees = 1;
+    KdForest forest;
+    forest.build( &X[0], n, 3, params );
+    for( int t=0; t<50; t++ ) {
+        const float* q = &X[ 3*size_t(t*37) ];
+        const float  r = 0.05f;
+        vector<int> ref;
+        for( int i=0; i<n; i++ ) {
+            float dx = X[3*i]-q[0], dy = X[3*i+1]-q[1], dz = X[3*i+2]-q[2];
+            if( dx*dx + dy*dy + dz*dz < r*r ) ref.push_back( i );
+        }
+        vector<int>   idx;
+        vector<float> dst;
+        forest.radius_search( q, r, idx, &dst );
+        if( idx.empty() || idx[0] != t*37 || dst[0] != 0.0f ) passed = false;
+        for( size_t j=1; j<dst.size(); j++ )
+            if( dst[j] < dst[j-1] ) passed = false;
+        std::sort( idx.begin(), idx.end() );
+        if( idx != ref ) passed = false;
+    }
+    if( passed ) printf("%50s passed\n", "kd forest radius search" );
+    else         printf("%50s failed\n", "kd forest radius search" );
+}
+
+void hnsw_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 4 );
+    const int dim = 128, n = 10000, nq = 200, k = 10;
+    vector<float> X, Q;
+    clustered_points( gen, n,  dim, 12, X );
+    clustered_points( gen, nq, dim, 12, Q );
+    vector<int>   ridx;
+    vector<float> rdst;
+    reference_knn( Q, X, dim, k, ridx, rdst );
+
+    for( int par=0; par<2; par++ ) {
+        HnswParams params;
+        params.M               = 12;
+        params.ef_construction = 100;
+        params.run_parallel    = ( par == 1 );
+        HnswIndex index;
+        index.build( &X[0], n, dim, params );
+        double prev = 0.0;
+        const int efs[] = { 10, 50, 200 };
+        for( int e=0; e<3; e++ ) {
+            vector<int>   idx( nq*k );
+            vector<float> dst( nq*k );
+            index.knn( &Q[0], nq, k, efs[e], true, &idx[0], &dst[0] );
+            double r = recall( ridx, idx, k );
+            if( r < prev - 0.01 ) passed = false;
+            if( !is_sorted_knn( idx, dst, k ) ) passed = false;
+            prev = r;
+        }
+        if( prev < 0.95 ) passed = false;
+    }
+
+    // the distance kernels agree
+    HnswIndex index;
+    index.build( &X[0], 2000, dim, HnswParams() );
+    vector<int>   idx0( nq*k ), idx( nq*k );
+    vector<float> dst0( nq*k ), dst( nq*k );
+    set_simd_level_limit( SIMD_NONE );
+    index.knn( &Q[0], nq, k, 400, true, &idx0[0], &dst0[0] );
+    for( int li=1; li<3; li++ ) {
+        if( g_levels[li] > cpu_simd_level() ) continue;
+        set_simd_level_limit( g_levels[li] );
+        index.knn( &Q[0], nq, k, 400, true, &idx[0], &dst[0] );
+        if( !same_distances( dst0, dst, 1e-4f ) ) passed = false;
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+
+    // tiny and empty indices
+    HnswIndex tiny;
+    tiny.build( &X[0], 3, dim, HnswParams() );
+    tiny.knn( &Q[0], nq, k, 10, true, &idx[0], &dst[0] );
+    for( int q=0; q<nq; q++ )
+        if( idx[q*k+2] < 0 || idx[q*k+3] != -1 ) passed = false;
+    tiny.build( &X[0], 0, dim, HnswParams() );
+    tiny.knn( &Q[0], nq, k, 10, true, &idx[0], &dst[0] );
+    if( idx[0] != -1 || dst[0] != -1.0f ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "hnsw search" );
+    else         printf("%50s failed\n", "hnsw search" );
+}
+
+void save_load_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 5 );
+    const int dim = 32, n = 3000, nq = 100, k = 4;
+    vector<float> X, Q;
+    clustered_points( gen, n,  dim, 8, X );
+    clustered_points( gen, nq, dim, 8, Q );
+    vector<int>   idx0( nq*k ), idx1( nq*k );
+    vector<float> dst0( nq*k ), dst1( nq*k );
+
+    KdForest forest, lforest;
+    forest.build( &X[0], n, dim, KdForestParams() );
+    forest.save( "/tmp/kortex_kdforest.bin" );
+    lforest.load( "/tmp/kortex_kdforest.bin", &X[0], n, dim );
+    forest .knn( &Q[0], nq, k, 64, true, &idx0[0], &dst0[0] );
+    lforest.knn( &Q[0], nq, k, 64, true, &idx1[0], &dst1[0] );
+    if( idx0 != idx1 || dst0 != dst1 || lforest.n_trees() != forest.n_trees() ) passed = false;
+
+    HnswIndex index, lindex;
+    index.build( &X[0], n, dim, HnswParams() );
+    index.save( "/tmp/kortex_hnsw.bin" );
+    lindex.load( "/tmp/kortex_hnsw.bin", &X[0], n, dim );
+    index .knn( &Q[0], nq, k, 20, true, &idx0[0], &dst0[0] );
+    lindex.knn( &Q[0], nq, k, 20, true, &idx1[0], &dst1[0] );
+    if( idx0 != idx1 || dst0 != dst1 || lindex.max_level() != index.max_level() ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "ann index save/load" );
+    else         printf("%50s failed\n", "ann index save/load" );
+}
+
+void ann_benchmark() {
+    PhiloxGenerator gen( 6 );
+    const int n_pnts = 1<<18, n_pq = 1<<16, kp = 8;
+    vector<float> P( 3*size_t(n_pnts) ), PQ( 3*size_t(n_pq) );
+    for( size_t i=0; i<P.size(); i++ )
+        P[i] = float( gen.uniform_sample() );
+    for( size_t i=0; i<PQ.size(); i++ )
+        PQ[i] = float( gen.uniform_sample() );
+    Timer timer;
+    timer.reset();
+    KdForestParams kparams;
+    kparams.n_trees = 1;
+    KdForest forest;
+    forest.build( &P[0], n_pnts, 3, kparams );
+    double t_kd_build = timer.elapsed();
+    vector<int>   pidx( size_t(n_pq)*kp );
+    vector<float> pdst( size_t(n_pq)*kp );
+    timer.reset();
+    forest.knn( &PQ[0], n_pq, kp, 0, true, &pidx[0], &pdst[0] );
+    double t_kd_query = timer.elapsed();
+    printf("%d 3d points: kd tree build %8.4f sec exact %d-nn of %d points %8.4f sec\n",
+           n_pnts, t_kd_build, kp, n_pq, t_kd_query );
+
+    const int dim = 128, n = 20000, nq = 2000, k = 10;
+    vector<float> X, Q;
+    clustered_points( gen, n,  dim, 16, X );
+    clustered_points( gen, nq, dim, 16, Q );
+
+    timer.reset();
+    vector<int>   bidx( 2*nq );
+    vector<float> bdst( 2*nq );
+    descriptor_knn2( &Q[0], nq, &X[0], n, dim, DESCRIPTOR_L2, true, &bidx[0], &bdst[0] );
+    double t_brute = timer.elapsed();
+
+    timer.reset();
+    HnswIndex index;
+    index.build( &X[0], n, dim, HnswParams() );
+    double t_build = timer.elapsed();
+
+    vector<int>   idx( nq*k );
+    vector<float> dst( nq*k );
+    timer.reset();
+    index.knn( &Q[0], nq, k, 64, true, &idx[0], &dst[0] );
+    double t_query = timer.elapsed();
+    int found = 0;
+    for( int q=0; q<nq; q++ )
+        if( idx[q*k] == bidx[2*q] ) found++;
+
+    printf("%d x %d points: brute force knn2 %8.4f sec hnsw build %8.4f sec query %8.4f sec recall@1 %.3f\n",
+           n, dim, t_brute, t_build, t_query, double(found)/nq );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
@@ -0,0 +1,268 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/dary_heap.tcc>
+#include <kortex/heap.tcc>
+#include <kortex/random_generator.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+using namespace kortex;
+using std::vector;
+
+void dary_heap_test();
+void indexed_heap_test();
+void shortest_path_test();
+void shortest_path_benchmark();
+
+int main(int argc, char **argv) {
+    dary_heap_test();
+    indexed_heap_test();
+    shortest_path_test();
+    shortest_path_benchmark();
+    release_log_man();
+}
+
+template< typename Compare, int D >
+bool heap_sort_check( const vector<double>& v, const bool& use_assign ) {
+    DaryHeap<double,Compare,D> heap;
+    if( use_assign ) {
+        heap.assign( &v[0], v.size() );
+    } else {
+        for( size_t i=0; i<v.size(); i++ )
+            heap.push( v[i] );
+    }
+    if( !heap.is_heap_healthy() || heap.size() != v.size() ) return false;
+    vector<double> sorted( v );
+    std::sort( sorted.begin(), sorted.end(), Compare() );
+    for( size_t i=0; i<sorted.size(); i++ )
+        if( heap.pop() != sorted[i] ) return false;
+    return heap.is_empty();
+}
+
+void dary_heap_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 1 );
+    const int sizes[] = { 1, 2, 5, 17, 1000 };
+    for( int s=0; s<5; s++ ) {
+        vector<double> v( sizes[s] );
+        for( size_t i=0; i<v.size(); i++ )
+            v[i] = double( int( 50 * gen.uniform_sample() ) ); // with repeats
+        for( int a=0; a<2; a++ ) {
+            if( !heap_sort_check< std::less<double>,    2 >( v, a==1 ) ) passed = false;
+            if( !heap_sort_check< std::less<double>,    4 >( v, a==1 ) ) passed = false;
+            if( !heap_sort_check< std::less<double>,    8 >( v, a==1 ) ) passed = false;
+            if( !heap_sort_check< std::greater<double>, 4 >( v, a==1 ) ) passed = false;
+        }
+    }
+
+    // interleaved pushes and pops
+    DaryHeap<int> heap;
+    vector<int>   ref;
+    for( int t=0; t<10000; t++ ) {
+        if( ref.empty() || gen.uniform_sample() < 0.6 ) {
+            int v = int( gen.uniform_index( 1000 ) );
+            heap.push( v );
+            ref.push_back( v );
+        } else {
+            vector<int>::iterator m = std::min_element( ref.begin(), ref.end() );
+            if( heap.top() != *m || heap.pop() != *m ) passed = false;
+            ref.erase( m );
+        }
+    }
+    if( heap.size() != ref.size() || !heap.is_heap_healthy() ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "d-ary heap" );
+    else         printf("%50s failed\n", "d-ary heap" );
+}
+
+template< int D >
+bool indexed_check( PhiloxGenerator& gen ) {
+    const int n_ids = 500;
+    IndexedDaryHeap<float,std::less<float>,D> heap;
+    heap.init( n_ids );
+    vector<float> key( n_ids );
+    vector<bool>  in ( n_ids, false );
+    bool passed = true;
+    for( int t=0; t<20000; t++ ) {
+        int   id = int( gen.uniform_index( n_ids ) );
+        float k  = float( int( 1000 * gen.uniform_sample() ) );
+        switch( gen.uniform_index( 5 ) ) {
+        case 0:
+            heap.push_or_update( id, k );
+            key[id] = k;
+            in [id] = true;
+            break;
+        case 1:
+            if( heap.decrease( id, k ) != ( !in[id] || k < key[id] ) ) passed = false;
+            if( !in[id] || k < key[id] ) key[id] = k;
+            in[id] = true;
+            break;
+        case 2:
+            heap.remove( id );
+            in[id] = false;
+            break;
+        case 3:
+            if( in[id] ) {
+                heap.update( id, k );
+                key[id] = k;
+            }
+            break;
+        case 4:
+            if( !heap.is_empty() ) {
+                float m = heap.top_key();
+                int   p = heap.pop();
+                if( !in[p] || key[p] != m ) passed = false;
+                for( int i=0; i<n_ids; i++ )
+                    if( in[i] && key[i] < m ) passed = false;
+                in[p] = false;
+            }
+            break;
+        }
+        if( heap.contains( id ) != in[id] ) passed = false;
+        if( in[id] && heap.key( id ) != key[id] ) passed = false;
+        if( t % 1000 == 0 && !heap.is_heap_healthy() ) passed = false;
+    }
+    size_t n_in = 0;
+    for( int i=0; i<n_ids; i++ )
+        if( in[i] ) n_in++;
+    if( heap.size() != n_in ) passed = false;
+
+    heap.clear();
+    for( int i=0; i<n_ids; i++ )
+        if( heap.contains( i ) ) passed = false;
+    return passed && heap.is_empty() && heap.is_heap_healthy();
+}
+
+void indexed_heap_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 2 );
+    if( !indexed_check<2>( gen ) ) passed = false;
+    if( !indexed_check<4>( gen ) ) passed = false;
+    if( !indexed_check<7>( gen ) ) passed = false;
+    if( passed ) printf("%50s passed\n", "indexed d-ary heap" );
+    else         printf("%50s failed\n", "indexed d-ary heap" );
+}
+
+// 4-connected w x h pixel graph - the cost of entering a pixel is its weight
+void random_weights( PhiloxGenerator& gen, const int& w, const int& h, vector<double>& wgt ) {
+    wgt.resize( size_t(w)*h );
+    for( size_t i=0; i<wgt.size(); i++ )
+        wgt[i] = 0.1 + gen.uniform_sample();
+}
+
+template< int D >
+void dijkstra( const vector<double>& wgt, const int& w, const int& h, const int& src, vector<double>& dist ) {
+    const int n = w*h;
+    dist.assign( n, -1.0 );
+    IndexedDaryHeap<double,std::less<double>,D> heap;
+    heap.init( n );
+    heap.push( src, 0.0 );
+    while( !heap.is_empty() ) {
+        const double d = heap.top_key();
+        const int    p = heap.pop();
+        dist[p] = d;
+        const int x = p%w, y = p/w;
+        const int nb[4] = { x > 0 ? p-1 : -1, x < w-1 ? p+1 : -1, y > 0 ? p-w : -1, y < h-1 ? p+w : -1 };
+        for( int j=0; j<4; j++ ) {
+            if( nb[j] < 0 || dist[nb[j]] >= 0.0 ) continue;
+            heap.decrease( nb[j], d + wgt[nb[j]] );
+        }
+    }
+}
+
+void dijkstra_heap( const vector<double>& wgt, const int& w, const int& h, const int& src, vector<double>& dist ) {
+    const int n = w*h;
+    dist.assign( n, -1.0 );
+    vector< HNode<int> > nodes( n );
+    vector< bool >       queued( n, false );
+    for( int i=0; i<n; i++ )
+        nodes[i].data = i;
+    Heap<int> heap;
+    heap.init( n+1, Heap<int>::HT_ASCENDING );
+    nodes[src].heap_val = 0.0;
+    heap.insert( &nodes[src] );
+    queued[src] = true;
+    while( !heap.is_empty() ) {
+        HNode<int>* top = heap.pop();
+        const int    p = top->data;
+        const double d = top->heap_val;
+        dist[p] = d;
+        const int x = p%w, y = p/w;
+        const int nb[4] = { x > 0 ? p-1 : -1, x < w-1 ? p+1 : -1, y > 0 ? p-w : -1, y < h-1 ? p+w : -1 };
+        for( int j=0; j<4; j++ ) {
+            const int q = nb[j];
+            if( q < 0 || dist[q] >= 0.0 ) continue;
+            double nd = d + wgt[q];
+            if( !queued[q] ) {
+                nodes[q].heap_val = nd;
+                heap.insert( &nodes[q] );
+                queued[q] = true;
+            } else if( nd < nodes[q].heap_val ) {
+                nodes[q].heap_val = nd;
+                heap.update( &nodes[q] );
+            }
+        }
+    }
+}
+
+void shortest_path_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 3 );
+    const int w = 97, h = 61;
+    vector<double> wgt, d0, d2, d4;
+    random_weights( gen, w, h, wgt );
+    const int src = 30*w + 40;
+    dijkstra_heap( wgt, w, h, src, d0 );
+    dijkstra<2>  ( wgt, w, h, src, d2 );
+    dijkstra<4>  ( wgt, w, h, src, d4 );
+    for( int i=0; i<w*h; i++ ) {
+        if( d0[i] < 0.0 || std::fabs( d0[i] - d2[i] ) > 1e-9 || std::fabs( d0[i] - d4[i] ) > 1e-9 )
+            passed = false;
+    }
+    if( d4[src] != 0.0 || std::fabs( d4[src+1] - wgt[src+1] ) > 1e-12 ) passed = false;
+    if( passed ) printf("%50s passed\n", "shortest paths" );
+    else         printf("%50s failed\n", "shortest paths" );
+}
+
+void shortest_path_benchmark() {
+    PhiloxGenerator gen( 4 );
+    const int w = 1024, h = 1024;
+    vector<double> wgt, dist;
+    random_weights( gen, w, h, wgt );
+    const int src = h/2*w + w/2;
+    Timer timer;
+    timer.reset();
+    dijkstra_heap( wgt, w, h, src, dist );
+    double t_heap = timer.elapsed();
+    timer.reset();
+    dijkstra<2>( wgt, w, h, src, dist );
+    double t_2 = timer.elapsed();
+    timer.reset();
+    dijkstra<4>( wgt, w, h, src, dist );
+    double t_4 = timer.elapsed();
+    printf("shortest paths on %dx%d pixels: Heap %8.4f sec binary %8.4f sec 4-ary %8.4f sec\n",
+           w, h, t_heap, t_2, t_4 );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
@@ -0,0 +1,392 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/descriptor_matcher.h>
+#include <kortex/bit_operations.h>
+#include <kortex/math.h>
+#include <kortex/random_generator.h>
+#include <kortex/cpu_features.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+using namespace kortex;
+using std::vector;
+using std::pair;
+
+void hamming_knn_test();
+void hamming_match_test();
+void hamming_benchmark();
+void float_knn2_test();
+void uchar_knn2_test();
+void descriptor_match_test();
+void knn2_benchmark();
+
+int main(int argc, char **argv) {
+    hamming_knn_test();
+    hamming_match_test();
+    hamming_benchmark();
+    float_knn2_test();
+    uchar_knn2_test();
+    descriptor_match_test();
+    knn2_benchmark();
+    release_log_man();
+}
+
+const SimdLevel g_levels[] = { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };
+
+void random_descriptors( PhiloxGenerator& gen, const int& n, vector<uchar>& D ) {
+    D.resize( 32*size_t(n) );
+    for( size_t i=0; i<D.size(); i++ )
+        D[i] = uchar( int( 256 * gen.uniform_sample() ) & 255 );
+}
+
+// random train descriptors - train descriptor q is a noisy copy of query q
+// for every 3rd q
+void noisy_copies( PhiloxGenerator& gen, const vector<uchar>& Q, const int& n_train, vector<uchar>& T ) {
+    random_descriptors( gen, n_train, T );
+    const int n_query = int( Q.size()/32 );
+    for( int q=0; q<n_query && q<n_train; q+=3 ) {
+        uchar* t = &T[ 32*size_t(q) ];
+        for( int b=0; b<32; b++ ) {
+            t[b] = Q[32*size_t(q)+b];
+            if( gen.uniform_sample() < 0.3 ) t[b] ^= uchar( 1 << ( b%8 ) );
+        }
+    }
+}
+
+void reference_knn( const vector<uchar>& Q, const vector<uchar>& T, const int& k,
+                    vector<int>& idx, vector<int>& dst ) {
+    const int nq = int( Q.size()/32 ), nt = int( T.size()/32 );
+    idx.assign( size_t(nq)*k, -1 );
+    dst.assign( size_t(nq)*k, -1 );
+    vector< pair<int,int> > d( nt );
+    for( int q=0; q<nq; q++ ) {
+        for( int t=0; t<nt; t++ )
+            d[t] = pair<int,int>( hamming_256( &Q[32*size_t(q)], &T[32*size_t(t)] ), t );
+        std::sort( d.begin(), d.end() );
+        for( int j=0; j<k && j<nt; j++ ) {
+            idx[ size_t(q)*k+j ] = d[j].second;
+            dst[ size_t(q)*k+j ] = d[j].first;
+        }
+    }
+}
+
+void hamming_knn_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 1 );
+    const int sizes[][2] = { {1,1}, {37,3}, {130,1029}, {300,2500} };
+    const int ks[] = { 1, 2, 5 };
+    for( int s=0; s<4; s++ ) {
+        vector<uchar> Q, T;
+        random_descriptors( gen, sizes[s][0], Q );
+        noisy_copies( gen, Q, sizes[s][1], T );
+        for( int ki=0; ki<3; ki++ ) {
+            const int k = ks[ki];
+            vector<int> ridx, rdst;
+            reference_knn( Q, T, k, ridx, rdst );
+            for( int l=0; l<3; l++ ) {
+                if( g_levels[l] > cpu_simd_level() ) continue;
+                set_simd_level_limit( g_levels[l] );
+                vector<int> idx( ridx.size() ), dst( rdst.size() );
+                hamming_256_knn( &Q[0], sizes[s][0], &T[0], sizes[s][1], k, true, &idx[0], &dst[0] );
+                if( idx != ridx || dst != rdst ) passed = false;
+            }
+        }
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+    if( passed ) printf("%50s passed\n", "hamming_256_knn" );
+    else         printf("%50s failed\n", "hamming_256_knn" );
+}
+
+void hamming_match_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 2 );
+    const int nq = 500, nt = 700;
+    vector<uchar> Q, T;
+    random_descriptors( gen, nq, Q );
+    noisy_copies( gen, Q, nt, T );
+    vector<int> fidx, fdst, bidx, bdst;
+    reference_knn( Q, T, 2, fidx, fdst );
+    reference_knn( T, Q, 1, bidx, bdst );
+
+    for( int c=0; c<8; c++ ) {
+        MatcherParams params;
+        params.ratio        = ( c & 1 ) ? 0.8f  : 1.0f;
+        params.cross_check  = ( c & 2 ) != 0;
+        params.max_distance = ( c & 4 ) ? 60.0f : -1.0f;
+        vector<DescriptorMatch> matches;
+        hamming_256_match( &Q[0], nq, &T[0], nt, params, matches );
+
+        vector<DescriptorMatch> ref;
+        for( int q=0; q<nq; q++ ) {
+            int t = fidx[2*q], d = fdst[2*q];
+            if( params.max_distance >= 0.0f && d > params.max_distance ) continue;
+            if( params.ratio < 1.0f && !( d < params.ratio * fdst[2*q+1] ) ) continue;
+            if( params.cross_check && bidx[t] != q ) continue;
+            DescriptorMatch m = { q, t, float(d) };
+            ref.push_back( m );
+        }
+        if( matches.size() != ref.size() ) { passed = false; continue; }
+        for( size_t i=0; i<ref.size(); i++ )
+            if( matches[i].query != ref[i].query || matches[i].train != ref[i].train ||
+                matches[i].distance != ref[i].distance ) passed = false;
+        // the planted matches survive all the filters
+        if( (int)matches.size() < nq/3 - 5 ) passed = false;
+    }
+    if( passed ) printf("%50s passed\n", "hamming_256_match" );
+    else         printf("%50s failed\n", "hamming_256_match" );
+}
+
+void hamming_benchmark() {
+    PhiloxGenerator gen( 3 );
+    const int n = 20000;
+    vector<uchar> Q, T;
+    random_descriptors( gen, n, Q );
+    noisy_copies( gen, Q, n, T );
+    vector<int> idx( 2*size_t(n) ), dst( 2*size_t(n) );
+    Timer timer;
+
+    timer.reset();
+    for( int q=0; q<n; q++ ) {
+        int best = 257, bi = -1;
+        for( int t=0; t<n; t++ ) {
+            int d = hamming_256( &Q[32*size_t(q)], &T[32*size_t(t)] );
+            if( d < best ) { best = d; bi = t; }
+        }
+        idx[q] = bi;
+    }
+    printf("%d x %d hamming_256 [pairwise]: %8.4f sec\n", n, n, timer.elapsed() );
+
+    for( int l=0; l<3; l++ ) {
+        if( g_levels[l] > cpu_simd_level() ) continue;
+        set_simd_level_limit( g_levels[l] );
+        timer.reset();
+        hamming_256_knn( &Q[0], n, &T[0], n, 2, true, &idx[0], &dst[0] );
+        printf("%d x %d hamming_256 [%-6s]: %8.4f sec\n", n, n,
+               simd_level_name( g_levels[l] ).c_str(), timer.elapsed() );
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+}
+
+// sift-like descriptors - train t is a perturbed copy of query t for every
+// 4th t
+template<typename T>
+void random_real_descriptors( PhiloxGenerator& gen, const int& nq, const int& nt, const int& dim,
+                              const float& scale, vector<T>& Q, vector<T>& Tr ) {
+    Q .resize( size_t(nq)*dim );
+    Tr.resize( size_t(nt)*dim );
+    for( size_t i=0; i<Q .size(); i++ ) Q [i] = T( scale * gen.uniform_sample() );
+    for( size_t i=0; i<Tr.size(); i++ ) Tr[i] = T( scale * gen.uniform_sample() );
+    for( int t=0; t<nt && t<nq; t+=4 ) {
+        for( int p=0; p<dim; p++ ) {
+            float v = float( Q[ size_t(t)*dim+p ] ) + 0.05f * scale * float( gen.normal_sample() );
+            Tr[ size_t(t)*dim+p ] = T( std::min( std::max( v, 0.0f ), scale ) );
+        }
+    }
+}
+
+// double precision reference - the two nearest neighbors
+template<typename T>
+void reference_knn2( const vector<T>& Q, const vector<T>& Tr, const int& dim, const DescriptorMetric& metric,
+                     vector<int>& idx, vector<double>& dst ) {
+    const int nq = int( Q.size()/dim ), nt = int( Tr.size()/dim );
+    idx.assign( 2*size_t(nq), -1 );
+    dst.assign( 2*size_t(nq), -1.0 );
+    vector< pair<double,int> > d( nt );
+    for( int q=0; q<nq; q++ ) {
+        const T* a = &Q[ size_t(q)*dim ];
+        for( int t=0; t<nt; t++ ) {
+            const T* b = &Tr[ size_t(t)*dim ];
+            double ab = 0.0, aa = 0.0, bb = 0.0;
+            for( int p=0; p<dim; p++ ) {
+                ab += double(a[p])*double(b[p]);
+                aa += double(a[p])*double(a[p]);
+                bb += double(b[p])*double(b[p]);
+            }
+            if( metric == DESCRIPTOR_L2 ) d[t].first = std::sqrt( std::max( 0.0, aa + bb - 2.0*ab ) );
+            else                          d[t].first = 1.0 - ab / std::sqrt( aa*bb );
+            d[t].second = t;
+        }
+        std::sort( d.begin(), d.end() );
+        for( int j=0; j<2 && j<nt; j++ ) {
+            idx[2*q+j] = d[j].second;
+            dst[2*q+j] = d[j].first;
+        }
+    }
+}
+
+// indices have to agree unless the reference distances are within tol
+bool same_knn2( const vector<int>& ridx, const vector<double>& rdst,
+                const vector<int>& idx, const vector<float>& dst, const double& tol ) {
+    for( size_t i=0; i<ridx.size(); i++ ) {
+        if( std::fabs( dst[i] - rdst[i] ) > tol ) return false;
+        if( idx[i] == ridx[i] ) continue;
+        if( ( i%2 == 0 ) && std::fabs( rdst[i+1] - rdst[i] ) > tol ) return false;
+        if( ( i%2 == 1 ) && std::fabs( rdst[i] - rdst[i-1] ) > tol ) return false;
+    }
+    return true;
+}
+
+void float_knn2_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 4 );
+    const int sizes[][3] = { {1,1,128}, {5,2,16}, {97,333,128}, {250,1500,37} };
+    for( int s=0; s<4; s++ ) {
+        const int nq = sizes[s][0], nt = sizes[s][1], dim = sizes[s][2];
+        vector<float> Q, T;
+        random_real_descriptors( gen, nq, nt, dim, 1.0f, Q, T );
+        for( int m=0; m<2; m++ ) {
+            const DescriptorMetric metric = m ? DESCRIPTOR_COSINE : DESCRIPTOR_L2;
+            vector<int>    ridx;
+            vector<double> rdst;
+            reference_knn2( Q, T, dim, metric, ridx, rdst );
+            for( int l=0; l<3; l++ ) {
+                if( g_levels[l] > cpu_simd_level() ) continue;
+                set_simd_level_limit( g_levels[l] );
+                vector<int>   idx( 2*nq );
+                vector<float> dst( 2*nq );
+                descriptor_knn2( &Q[0], nq, &T[0], nt, dim, metric, true, &idx[0], &dst[0] );
+                if( !same_knn2( ridx, rdst, idx, dst, 1e-3 ) ) passed = false;
+                // matches dot128 / l2norm of the pair
+                if( dim == 128 && idx[0] >= 0 ) {
+                    const float* a = &Q[0];
+                    const float* b = &T[ size_t(idx[0])*dim ];
+                    float d = ( metric == DESCRIPTOR_L2 )
+                        ? l2norm( a, b, dim )
+                        : 1.0f - dot128( a, b ) / ( l2norm_128( a ) * l2norm_128( b ) );
+                    if( std::fabs( d - dst[0] ) > 1e-4f ) passed = false;
+                }
+            }
+        }
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+    if( passed ) printf("%50s passed\n", "descriptor_knn2 [float]" );
+    else         printf("%50s failed\n", "descriptor_knn2 [float]" );
+}
+
+void uchar_knn2_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 5 );
+    const int sizes[][3] = { {3,1,128}, {97,333,128}, {250,1500,37} };
+    for( int s=0; s<3; s++ ) {
+        const int nq = sizes[s][0], nt = sizes[s][1], dim = sizes[s][2];
+        vector<uchar> Q, T;
+        random_real_descriptors( gen, nq, nt, dim, 255.0f, Q, T );
+        vector<int>    ridx, cidx;
+        vector<double> rdst, cdst;
+        reference_knn2( Q, T, dim, DESCRIPTOR_L2,     ridx, rdst );
+        reference_knn2( Q, T, dim, DESCRIPTOR_COSINE, cidx, cdst );
+        for( int l=0; l<3; l++ ) {
+            if( g_levels[l] > cpu_simd_level() ) continue;
+            set_simd_level_limit( g_levels[l] );
+            vector<int>   idx( 2*nq );
+            vector<float> dst( 2*nq );
+            // l2 is exact - same neighbors and ties as the reference
+            descriptor_knn2( &Q[0], nq, &T[0], nt, dim, DESCRIPTOR_L2, true, &idx[0], &dst[0] );
+            if( idx != ridx ) passed = false;
+            for( int i=0; i<2*nq; i++ )
+                if( std::fabs( dst[i] - rdst[i] ) > 1e-5 * std::fabs( rdst[i] ) ) passed = false;
+            if( dim == 128 && idx[0] >= 0 &&
+                dst[0] != std::sqrt( float( l2norm_128_sq( &Q[0], &T[ size_t(idx[0])*dim ] ) ) ) )
+                passed = false;
+            descriptor_knn2( &Q[0], nq, &T[0], nt, dim, DESCRIPTOR_COSINE, true, &idx[0], &dst[0] );
+            if( !same_knn2( cidx, cdst, idx, dst, 1e-5 ) ) passed = false;
+        }
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+    if( passed ) printf("%50s passed\n", "descriptor_knn2 [uchar]" );
+    else         printf("%50s failed\n", "descriptor_knn2 [uchar]" );
+}
+
+void descriptor_match_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 6 );
+    const int nq = 400, nt = 600, dim = 128;
+    vector<uchar> Q, T;
+    random_real_descriptors( gen, nq, nt, dim, 255.0f, Q, T );
+    vector<int>    fidx, bidx;
+    vector<double> fdst, bdst;
+    reference_knn2( Q, T, dim, DESCRIPTOR_L2, fidx, fdst );
+    reference_knn2( T, Q, dim, DESCRIPTOR_L2, bidx, bdst );
+    for( int c=0; c<8; c++ ) {
+        MatcherParams params;
+        params.ratio        = ( c & 1 ) ? 0.8f   : 1.0f;
+        params.cross_check  = ( c & 2 ) != 0;
+        params.max_distance = ( c & 4 ) ? 600.0f : -1.0f;
+        vector<DescriptorMatch> matches;
+        descriptor_match( &Q[0], nq, &T[0], nt, dim, DESCRIPTOR_L2, params, matches );
+        vector<int> ref;
+        for( int q=0; q<nq; q++ ) {
+            float d1 = float( fdst[2*q] ), d2 = float( fdst[2*q+1] );
+            if( params.max_distance >= 0.0f && d1 > params.max_distance ) continue;
+            if( params.ratio < 1.0f && !( d1 < params.ratio * d2 ) ) continue;
+            if( params.cross_check && bidx[ 2*fidx[2*q] ] != q ) continue;
+            ref.push_back( q );
+        }
+        if( matches.size() != ref.size() ) { passed = false; continue; }
+        for( size_t i=0; i<ref.size(); i++ )
+            if( matches[i].query != ref[i] || matches[i].train != fidx[ 2*ref[i] ] ) passed = false;
+        if( (int)matches.size() < nq/4 ) passed = false;
+    }
+    if( passed ) printf("%50s passed\n", "descriptor_match" );
+    else         printf("%50s failed\n", "descriptor_match" );
+}
+
+void knn2_benchmark() {
+    PhiloxGenerator gen( 7 );
+    const int n = 10000, dim = 128;
+    vector<float> Q, T;
+    random_real_descriptors( gen, n, n, dim, 1.0f, Q, T );
+    vector<uchar> uQ( Q.size() ), uT( T.size() );
+    for( size_t i=0; i<Q.size(); i++ ) uQ[i] = uchar( 255.0f * Q[i] );
+    for( size_t i=0; i<T.size(); i++ ) uT[i] = uchar( 255.0f * T[i] );
+    vector<int>   idx( 2*size_t(n) );
+    vector<float> dst( 2*size_t(n) );
+    Timer timer;
+
+    timer.reset();
+    for( int q=0; q<n; q++ ) {
+        float best = 1e30f;
+        for( int t=0; t<n; t++ ) {
+            float d = 2.0f - 2.0f * dot128( &Q[ size_t(q)*dim ], &T[ size_t(t)*dim ] );
+            if( d < best ) { best = d; idx[q] = t; }
+        }
+    }
+    printf("%d x %d x %d [dot128 loop   ]: %8.4f sec\n", n, n, dim, timer.elapsed() );
+
+    for( int l=0; l<3; l++ ) {
+        if( g_levels[l] > cpu_simd_level() ) continue;
+        set_simd_level_limit( g_levels[l] );
+        timer.reset();
+        descriptor_knn2( &Q[0], n, &T[0], n, dim, DESCRIPTOR_L2, true, &idx[0], &dst[0] );
+        double tf = timer.elapsed();
+        timer.reset();
+        descriptor_knn2( &uQ[0], n, &uT[0], n, dim, DESCRIPTOR_L2, true, &idx[0], &dst[0] );
+        double tu = timer.elapsed();
+        printf("%d x %d x %d [%-6s] float %8.4f sec uchar %8.4f sec\n", n, n, dim,
+               simd_level_name( g_levels[l] ).c_str(), tf, tu );
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
@@ -0,0 +1,486 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/filter.h>
+#include <kortex/image.h>
+#include <kortex/image_processing.h>
+#include <kortex/image_pyramid.h>
+#include <kortex/cpu_features.h>
+#include <kortex/math.h>
+#include <kortex/rect2.h>
+#include <kortex/timer.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace kortex;
+
+void filter_test();
+void filter_benchmark();
+
+int main(int argc, char **argv) {
+    filter_test();
+    filter_benchmark();
+    release_log_man();
+}
+
+/// zero padded reference convolution
+void reference_filter_hor( const vector<float>& im, int w, int h, const float* kernel, int ksize, vector<float>& out ) {
+    int hsz = ksize/2;
+    out.assign( im.size(), 0.0f );
+    for( int y=0; y<h; y++ ) {
+        for( int x=0; x<w; x++ ) {
+            double sum = 0.0;
+            for( int j=0; j<ksize; j++ ) {
+                int xx = x+j-hsz;
+                if( xx<0 || xx>=w ) continue;
+                sum += double(im[y*w+xx]) * kernel[j];
+            }
+            out[y*w+x] = float(sum);
+        }
+    }
+}
+
+void reference_filter_ver( const vector<float>& im, int w, int h, const float* kernel, int ksize, vector<float>& out ) {
+    int hsz = ksize/2;
+    out.assign( im.size(), 0.0f );
+    for( int y=0; y<h; y++ ) {
+        for( int x=0; x<w; x++ ) {
+            double sum = 0.0;
+            for( int j=0; j<ksize; j++ ) {
+                int yy = y+j-hsz;
+                if( yy<0 || yy>=h ) continue;
+                sum += double(im[yy*w+x]) * kernel[j];
+            }
+            out[y*w+x] = float(sum);
+        }
+    }
+}
+
+float max_abs_difference( const vector<float>& a, const vector<float>& b ) {
+    float d = 0.0f;
+    for( size_t i=0; i<a.size(); i++ )
+        d = std::max( d, std::fabs(a[i]-b[i]) );
+    return d;
+}
+
+void assert_filter_result( const vector<float>& a, const vector<float>& b, float eps, const string& str ) {
+    float d = max_abs_difference( a, b );
+    if( d < eps ) printf("%50s passed\n", str.c_str() );
+    else          printf("%50s failed [max diff %f]\n", str.c_str(), d );
+}
+
+void random_image( int w, int h, vector<float>& im ) {
+    im.resize( size_t(w)*size_t(h) );
+    unsigned int s = 17;
+    for( size_t i=0; i<im.size(); i++ ) {
+        s = s*1664525u + 1013904223u;
+        im[i] = float( s>>8 ) / float( 1<<24 );
+    }
+}
+
+void filter_level_test( const SimdLevel& level ) {
+    set_simd_level_limit( level );
+    const int sizes[][2] = { {1,1}, {7,3}, {33,17}, {100,61}, {257,129} };
+    const int ksizes[]   = { 3, 5, 7, 9, 11, 13, 15, 17, 25, 41 };
+    bool passed = true;
+    for( int s=0; s<5; s++ ) {
+        int w = sizes[s][0];
+        int h = sizes[s][1];
+        vector<float> im, ref, ref_hv, out;
+        random_image( w, h, im );
+        for( int k=0; k<10; k++ ) {
+            int ksize = ksizes[k];
+            vector<float> kernel( ksize );
+            for( int j=0; j<ksize; j++ ) kernel[j] = 1.0f/float(j+2);
+
+            out.assign( im.size(), 0.0f );
+            reference_filter_hor( im, w, h, &kernel[0], ksize, ref );
+            filter_hor( &im[0], w, h, &kernel[0], ksize, &out[0] );
+            if( max_abs_difference(ref, out) > 1e-4f ) passed = false;
+            filter_hor_par( &im[0], w, h, &kernel[0], ksize, &out[0] );
+            if( max_abs_difference(ref, out) > 1e-4f ) passed = false;
+
+            reference_filter_ver( im, w, h, &kernel[0], ksize, ref );
+            filter_ver( &im[0], w, h, &kernel[0], ksize, &out[0] );
+            if( max_abs_difference(ref, out) > 1e-4f ) passed = false;
+            filter_ver_par( &im[0], w, h, &kernel[0], ksize, &out[0] );
+            if( max_abs_difference(ref, out) > 1e-4f ) passed = false;
+
+            reference_filter_hor( im,  w, h, &kernel[0], ksize, ref    );
+            reference_filter_ver( ref, w, h, &kernel[0], ksize, ref_hv );
+            filter_hv( &im[0], w, h, &kernel[0], ksize, &out[0] );
+            if( max_abs_difference(ref_hv, out) > 1e-3f ) passed = false;
+            filter_hv_par( &im[0], w, h, &kernel[0], ksize, &out[0] );
+            if( max_abs_difference(ref_hv, out) > 1e-3f ) passed = false;
+
+            // in-place
+            out = im;
+            filter_hv( &out[0], w, h, &kernel[0], ksize );
+            if( max_abs_difference(ref_hv, out) > 1e-3f ) passed = false;
+            out = im;
+            filter_hv_par( &out[0], w, h, &kernel[0], ksize );
+            if( max_abs_difference(ref_hv, out) > 1e-3f ) passed = false;
+
+            // different horizontal and vertical kernels
+            float kernel_v[] = { -0.5f, 0.0f, 0.5f };
+            reference_filter_ver( ref, w, h, kernel_v, 3, ref_hv );
+            filter_separable( &im[0], w, h, &kernel[0], ksize, kernel_v, 3, &out[0] );
+            if( max_abs_difference(ref_hv, out) > 1e-3f ) passed = false;
+            out = im;
+            filter_separable_par( &out[0], w, h, &kernel[0], ksize, kernel_v, 3, &out[0] );
+            if( max_abs_difference(ref_hv, out) > 1e-3f ) passed = false;
+        }
+    }
+    string str = "filter [" + simd_level_name(level) + "]";
+    if( passed ) printf("%50s passed\n", str.c_str() );
+    else         printf("%50s failed\n", str.c_str() );
+}
+
+/// images wider/taller than the old 16384 stack buffers
+void filter_large_dimension_test() {
+    const int sizes[][2] = { {20011,5}, {5,20011} };
+    float kernel[] = { 0.1f, 0.2f, 0.4f, 0.2f, 0.1f };
+    for( int s=0; s<2; s++ ) {
+        int w = sizes[s][0];
+        int h = sizes[s][1];
+        vector<float> im, ref, ref_hv, out( size_t(w)*size_t(h) );
+        random_image( w, h, im );
+        reference_filter_hor( im,  w, h, kernel, 5, ref    );
+        reference_filter_ver( ref, w, h, kernel, 5, ref_hv );
+        filter_hv( &im[0], w, h, kernel, 5, &out[0] );
+        assert_filter_result( ref_hv, out, 1e-4f, "filter_hv large dimension" );
+        filter_hv_par( &im[0], w, h, kernel, 5, &out[0] );
+        assert_filter_result( ref_hv, out, 1e-4f, "filter_hv_par large dimension" );
+    }
+}
+
+/// recursive gaussian against the fir output, including in-place and
+/// parallel use and image sizes smaller than the filter support
+void gaussian_iir_test() {
+    const int   sizes[][2] = { {1,1}, {5,300}, {300,5}, {257,129}, {640,480} };
+    const float sigmas[]   = { 0.5f, 1.0f, 2.0f, 5.0f, 8.0f, 20.0f, 40.0f };
+    bool passed = true;
+    for( int s=0; s<5; s++ ) {
+        int w = sizes[s][0];
+        int h = sizes[s][1];
+        vector<float> im, ref, out;
+        random_image( w, h, im );
+        for( int k=0; k<7; k++ ) {
+            float sigma = sigmas[k];
+            int   ksize = filter_size( sigma );
+            vector<float> kernel( ksize );
+            gaussian_1d( &kernel[0], ksize, 0.0f, sigma );
+            ref.assign( im.size(), 0.0f );
+            filter_hv( &im[0], w, h, &kernel[0], ksize, &ref[0] );
+
+            out.assign( im.size(), 0.0f );
+            filter_gaussian_iir( &im[0], w, h, sigma, &out[0] );
+            if( max_abs_difference(ref, out) > 1e-3f ) passed = false;
+            out = im;
+            filter_gaussian_iir_par( &out[0], w, h, sigma, &out[0] );
+            if( max_abs_difference(ref, out) > 1e-3f ) passed = false;
+        }
+    }
+    if( passed ) printf("%50s passed\n", "filter_gaussian_iir" );
+    else         printf("%50s failed\n", "filter_gaussian_iir" );
+}
+
+float max_abs_difference( const Image& a, const Image& b ) {
+    float d = 0.0f;
+    for( size_t i=0; i<a.element_count(); i++ )
+        d = std::max( d, std::fabs(a.get_fptr()[i]-b.get_fptr()[i]) );
+    return d;
+}
+
+/// the overloads without a mode keep the fir output; GM_AUTO switches to
+/// the recursive filter for large sigma and stays within 1e-3 of it
+void gaussian_mode_test() {
+    int w = 211;
+    int h = 97;
+    vector<float> im;
+    random_image( w, h, im );
+    Image img( w, h, IT_F_GRAY );
+    memcpy( img.get_fptr(), &im[0], sizeof(float)*im.size() );
+    bool passed = true;
+    const float sigmas[] = { 1.0f, GAUSSIAN_IIR_MIN_SIGMA, 12.0f };
+    for( int s=0; s<3; s++ ) {
+        Image fir( w, h, IT_F_GRAY ), def( w, h, IT_F_GRAY ), aut( w, h, IT_F_GRAY );
+        filter_gaussian    ( img, sigmas[s], GM_FIR,  fir );
+        filter_gaussian    ( img, sigmas[s],          def );
+        if( max_abs_difference( fir, def ) != 0.0f ) passed = false;
+        filter_gaussian_par( img, sigmas[s],          def );
+        if( max_abs_difference( fir, def ) != 0.0f ) passed = false;
+        filter_gaussian    ( img, sigmas[s], GM_AUTO, aut );
+        if( max_abs_difference( fir, aut ) > 1e-3f ) passed = false;
+    }
+    if( passed ) printf("%50s passed\n", "filter_gaussian modes" );
+    else         printf("%50s failed\n", "filter_gaussian modes" );
+}
+
+/// incremental and parallel builds agree, octaves are decimated copies and
+/// the levels match a direct blur of the octave base
+void image_pyramid_test() {
+    int w = 301;
+    int h = 203;
+    vector<float> im;
+    random_image( w, h, im );
+    Image img( w, h, IT_F_GRAY );
+    memcpy( img.get_fptr(), &im[0], sizeof(float)*im.size() );
+
+    ImagePyramid pyr, pyr_par;
+    pyr    .create( w, h, 0, 3, 6, 1.6f, 0.5f );
+    pyr_par.create( w, h, 0, 3, 6, 1.6f, 0.5f );
+    pyr    .build    ( img );
+    pyr_par.build_par( img );
+
+    bool passed = ( pyr.n_octaves() == 4 );
+    for( int o=0; o<pyr.n_octaves(); o++ ) {
+        if( pyr.get_level(o,0)->w() != (w>>o) || pyr.get_level(o,0)->h() != (h>>o) ) passed = false;
+        for( int l=0; l<pyr.n_levels(); l++ ) {
+            if( max_abs_difference( *pyr.get_level(o,l), *pyr_par.get_level(o,l) ) > 1e-5f ) passed = false;
+        }
+        if( o > 0 ) {
+            Image dec;
+            image_decimate( *pyr.get_level(o-1,pyr.n_scales()), dec );
+            if( max_abs_difference( dec, *pyr.get_level(o,0) ) != 0.0f ) passed = false;
+        }
+        // away from the zero padded borders
+        int   ow = pyr.octave_w(o);
+        int   oh = pyr.octave_h(o);
+        Image direct( ow, oh, IT_F_GRAY );
+        float s0 = pyr.level_sigma(0);
+        float s4 = pyr.level_sigma(4);
+        filter_gaussian( *pyr.get_level(o,0), std::sqrt(s4*s4-s0*s0), direct );
+        int m = int( 4.0f*s4 );
+        for( int y=m; y<oh-m; y++ )
+            for( int x=m; x<ow-m; x++ )
+                if( std::fabs( direct.getf(x,y) - pyr.get_level(o,4)->getf(x,y) ) > 2e-3f ) passed = false;
+    }
+    if( std::fabs( pyr.scale(2,3) - 4.0f*3.2f ) > 1e-4f ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "image_pyramid" );
+    else         printf("%50s failed\n", "image_pyramid" );
+}
+
+/// max difference of the rows of two gray or image-ordered images
+float max_row_difference( const Image& a, const Image& b ) {
+    float d = 0.0f;
+    for( int c=0; c<a.ch(); c++ ) {
+        for( int y=0; y<a.h(); y++ ) {
+            const float* ra = a.get_row_fi(y,c);
+            const float* rb = b.get_row_fi(y,c);
+            for( int x=0; x<a.w(); x++ )
+                d = std::max( d, std::fabs(ra[x]-rb[x]) );
+        }
+    }
+    return d;
+}
+
+void fill_image( Image& img, const float& v ) {
+    for( int c=0; c<img.ch(); c++ )
+        for( int y=0; y<img.h(); y++ )
+            for( int x=0; x<img.w(); x++ )
+                img.get_row_fi(y,c)[x] = v;
+}
+
+/// images with a stride other than their width: out of the packed image
+/// img, a padded copy and a view of a larger image are filled. outputs are
+/// likewise a packed image, a padded image and a view - the views must not
+/// write outside their regions.
+struct StridedImages {
+    Image packed, padded, parent, view;
+    Image packed_out, padded_out, parent_out, view_out;
+
+    StridedImages( const Image& img ) {
+        int w = img.w();
+        int h = img.h();
+        ImageType type = img.type();
+        Rect2i roi( 13, 13+w, 7, 7+h );
+        packed.copy( &img );
+        padded.create_padded( w, h, type );
+        padded.copy_from_region( &img, 0, 0, w, h, 0, 0 );
+        parent.create( w+29, h+17, type );
+        fill_image( parent, -7.0f );
+        view.create_wrapper( parent, roi );
+        view.copy_from_region( &img, 0, 0, w, h, 0, 0 );
+
+        packed_out.create( w, h, type );
+        padded_out.create_padded( w, h, type );
+        parent_out.create( w+29, h+17, type );
+        fill_image( parent_out, -7.0f );
+        view_out.create_wrapper( parent_out, roi );
+    }
+
+    /// outputs agree with the packed one and the view did not leak
+    bool check( const float& eps ) const {
+        if( padded.is_contiguous() || view.is_contiguous() ) return false;
+        if( padded_out.is_contiguous() || view_out.is_contiguous() ) return false;
+        if( max_row_difference( packed_out, padded_out ) > eps ) return false;
+        if( max_row_difference( packed_out, view_out   ) > eps ) return false;
+        Image border;
+        border.copy( &parent_out );
+        Image inner;
+        inner.create_wrapper( border, Rect2i( 13, 13+view_out.w(), 7, 7+view_out.h() ) );
+        fill_image( inner, -7.0f );
+        for( size_t i=0; i<border.element_count(); i++ )
+            if( border.get_fptr()[i] != -7.0f ) return false;
+        return true;
+    }
+};
+
+void strided_filter_test() {
+    int w = 101;
+    int h = 53;
+    vector<float> im;
+    random_image( w, h, im );
+    Image img( w, h, IT_F_GRAY );
+    memcpy( img.get_fptr(), &im[0], sizeof(float)*im.size() );
+    float kernel  [] = { 0.1f, 0.2f, 0.4f, 0.2f, 0.1f };
+    float kernel_v[] = { -0.5f, 0.0f, 0.5f };
+
+    bool passed = true;
+    StridedImages s( img );
+    const Image* in [] = { &s.packed,     &s.padded,     &s.view     };
+    Image      * out[] = { &s.packed_out, &s.padded_out, &s.view_out };
+
+    for( int i=0; i<3; i++ ) filter_gaussian( *in[i], 1.5f, GM_FIR, *out[i] );
+    if( !s.check( 0.0f ) ) passed = false;
+    for( int i=0; i<3; i++ ) filter_gaussian_par( *in[i], 1.5f, GM_FIR, *out[i] );
+    if( !s.check( 0.0f ) ) passed = false;
+    for( int i=0; i<3; i++ ) filter_gaussian( *in[i], 4.0f, GM_IIR, *out[i] );
+    if( !s.check( 0.0f ) ) passed = false;
+    for( int i=0; i<3; i++ ) filter_gaussian_par( *in[i], 4.0f, GM_IIR, *out[i] );
+    if( !s.check( 0.0f ) ) passed = false;
+    for( int i=0; i<3; i++ ) filter_hor( *in[i], kernel, 5, *out[i] );
+    if( !s.check( 0.0f ) ) passed = false;
+    for( int i=0; i<3; i++ ) filter_ver_par( *in[i], kernel, 5, *out[i] );
+    if( !s.check( 0.0f ) ) passed = false;
+    for( int i=0; i<3; i++ ) filter_separable_par( *in[i], kernel, 5, kernel_v, 3, *out[i] );
+    if( !s.check( 0.0f ) ) passed = false;
+    for( int i=0; i<3; i++ ) image_scale( *in[i], -2.0f, true, *out[i] );
+    if( !s.check( 0.0f ) ) passed = false;
+    for( int i=0; i<3; i++ ) image_abs( *out[i], false, *out[i] );
+    if( !s.check( 0.0f ) ) passed = false;
+    for( int i=0; i<3; i++ ) image_add( *in[i], *out[i], false, *out[i] );
+    if( !s.check( 0.0f ) ) passed = false;
+    for( int i=0; i<3; i++ ) image_clip( *in[i], 0.2f, 0.7f, true, *out[i] );
+    if( !s.check( 0.0f ) ) passed = false;
+
+    // in-place on the strided images themselves
+    StridedImages t( img );
+    Image* io[] = { &t.packed, &t.padded, &t.view };
+    for( int i=0; i<3; i++ ) {
+        filter_hv( *io[i], kernel, 5, *io[i] );
+        filter_gaussian( *io[i], 3.0f, GM_IIR, *io[i] );
+    }
+    if( max_row_difference( t.packed, t.padded ) != 0.0f ) passed = false;
+    if( max_row_difference( t.packed, t.view   ) != 0.0f ) passed = false;
+
+    // gradients - the view of a gradient output is created in place
+    Image gx[3], gy[3];
+    Image gx_parent( w+29, h+17, IT_F_GRAY ), gy_parent( w+29, h+17, IT_F_GRAY );
+    gx[2].create_wrapper( gx_parent, Rect2i( 13, 13+w, 7, 7+h ) );
+    gy[2].create_wrapper( gy_parent, Rect2i( 13, 13+w, 7, 7+h ) );
+    for( int i=0; i<3; i++ ) image_gradient( *in[i], "simple", gx[i], gy[i] );
+    for( int i=1; i<3; i++ ) {
+        if( max_row_difference( gx[0], gx[i] ) != 0.0f ) passed = false;
+        if( max_row_difference( gy[0], gy[i] ) != 0.0f ) passed = false;
+    }
+
+    // image ordered channels
+    Image rgb( w, h, IT_F_IRGB );
+    for( int c=0; c<3; c++ )
+        for( int y=0; y<h; y++ )
+            for( int x=0; x<w; x++ )
+                rgb.get_row_fi(y,c)[x] = im[ ( y*w + x*(c+1) ) % im.size() ];
+    StridedImages r( rgb );
+    const Image* rin [] = { &r.packed,     &r.padded,     &r.view     };
+    Image      * rout[] = { &r.packed_out, &r.padded_out, &r.view_out };
+    for( int i=0; i<3; i++ ) filter_gaussian_par( *rin[i], 2.0f, GM_FIR, *rout[i] );
+    if( !r.check( 0.0f ) ) passed = false;
+    for( int i=0; i<3; i++ ) image_add( *rin[i], *rout[i], true, *rout[i] );
+    if( !r.check( 0.0f ) ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "padded images and views" );
+    else         printf("%50s failed\n", "padded images and views" );
+}
+
+/// on im(x,y) = (y+1)*x the simple gradient is dx = 2(y+1), dy = -2x at
+/// every pixel - the one sided border differences are doubled
+void image_gradient_test() {
+    int w = 31;
+    int h = 17;
+    Image img( w, h, IT_F_GRAY );
+    for( int y=0; y<h; y++ )
+        for( int x=0; x<w; x++ )
+            img.get_row_f(y)[x] = float( (y+1)*x );
+    Image gx, gy;
+    image_gradient( img, "simple", gx, gy );
+    bool passed = true;
+    for( int y=0; y<h; y++ ) {
+        for( int x=0; x<w; x++ ) {
+            if( gx.getf(x,y) != float( 2*(y+1) ) ) passed = false;
+            if( gy.getf(x,y) != float( -2*x    ) ) passed = false;
+        }
+    }
+    if( passed ) printf("%50s passed\n", "image_gradient simple" );
+    else         printf("%50s failed\n", "image_gradient simple" );
+}
+
+void filter_test() {
+    printf("cpu simd level: %s\n", simd_level_name(cpu_simd_level()).c_str() );
+    for( int l=SIMD_NONE; l<=cpu_simd_level(); l++ )
+        filter_level_test( (SimdLevel)l );
+    set_simd_level_limit( SIMD_AVX512 );
+    filter_large_dimension_test();
+    gaussian_iir_test();
+    gaussian_mode_test();
+    image_pyramid_test();
+    strided_filter_test();
+    image_gradient_test();
+}
+
+void filter_benchmark() {
+    int w = 2048;
+    int h = 2048;
+    Image img( w, h, IT_F_GRAY );
+    vector<float> im;
+    random_image( w, h, im );
+    memcpy( img.get_fptr(), &im[0], sizeof(float)*im.size() );
+    Image out( w, h, IT_F_GRAY );
+
+    const float sigmas[] = { 1.0f, 2.0f, 4.0f, 8.0f };
+    for( int l=SIMD_NONE; l<=cpu_simd_level(); l++ ) {
+        set_simd_level_limit( (SimdLevel)l );
+        for( int s=0; s<4; s++ ) {
+            Timer timer;
+            filter_gaussian( img, sigmas[s], GM_FIR, out );
+            printf("filter_gaussian [%dx%d] [sigma %4.1f] [%-6s] %8.4f sec\n",
+                   w, h, sigmas[s], simd_level_name((SimdLevel)l).c_str(), timer.elapsed() );
+        }
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+    for( int s=0; s<4; s++ ) {
+        Timer timer;
+        filter_gaussian( img, sigmas[s], GM_IIR, out );
+        printf("filter_gaussian [%dx%d] [sigma %4.1f] [iir   ] %8.4f sec\n",
+               w, h, sigmas[s], timer.elapsed() );
+    }
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
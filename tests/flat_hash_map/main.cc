@@ -0,0 +1,274 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/flat_hash_map.h>
+#include <kortex/pair_indexed_array.h>
+#include <kortex/sparse_array_t.h>
+#include <kortex/random_generator.h>
+#include <kortex/string.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+
+using namespace kortex;
+using std::vector;
+
+void flat_hash_map_test();
+void string_key_test();
+void pair_indexed_array_test();
+void sparse_array_test();
+void pair_map_benchmark();
+
+int main(int argc, char **argv) {
+    flat_hash_map_test();
+    string_key_test();
+    pair_indexed_array_test();
+    sparse_array_test();
+    pair_map_benchmark();
+    release_log_man();
+}
+
+template< typename Key, typename T >
+bool same_contents( const FlatHashMap<Key,T>& m, const std::unordered_map<Key,T>& ref ) {
+    if( m.size() != ref.size() ) return false;
+    size_t n = 0;
+    for( typename FlatHashMap<Key,T>::const_iterator it=m.begin(); it!=m.end(); ++it, ++n ) {
+        typename std::unordered_map<Key,T>::const_iterator r = ref.find( it->first );
+        if( r == ref.end() || r->second != it->second ) return false;
+    }
+    return n == ref.size();
+}
+
+struct OddValue {
+    bool operator()( const std::pair<int,int>& p ) const { return p.second % 2 != 0; }
+};
+
+void flat_hash_map_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 1 );
+    FlatHashMap<int,int>         m;
+    std::unordered_map<int,int>  ref;
+    // keys with equal low bits stress the probing
+    for( int t=0; t<200000; t++ ) {
+        int key = int( gen.uniform_index( 5000 ) ) << 8;
+        int val = int( gen.uniform_index( 100 ) );
+        switch( gen.uniform_index( 4 ) ) {
+        case 0:
+            m[key]   = val;
+            ref[key] = val;
+            break;
+        case 1:
+            if( m.insert( std::make_pair( key, val ) ).second != ref.insert( std::make_pair( key, val ) ).second )
+                passed = false;
+            break;
+        case 2:
+            if( m.erase( key ) != ref.erase( key ) ) passed = false;
+            break;
+        case 3:
+            if( m.count( key ) != ref.count( key ) ) passed = false;
+            if( ref.count( key ) && m.at( key ) != ref[key] ) passed = false;
+            break;
+        }
+        if( t % 20000 == 0 && !same_contents( m, ref ) ) passed = false;
+    }
+    if( !same_contents( m, ref ) ) passed = false;
+    if( m.capacity()*7 < m.size()*8 ) passed = false;
+
+    // erase_if
+    size_t n_odd = 0;
+    for( std::unordered_map<int,int>::iterator it=ref.begin(); it!=ref.end(); ) {
+        if( it->second % 2 ) {
+            it = ref.erase( it );
+            n_odd++;
+        } else {
+            ++it;
+        }
+    }
+    if( m.erase_if( OddValue() ) != n_odd || !same_contents( m, ref ) ) passed = false;
+
+    // reserve keeps the contents and avoids rehashing
+    m.reserve( 100000 );
+    size_t cap = m.capacity();
+    if( !same_contents( m, ref ) ) passed = false;
+    for( int i=0; i<100000-(int)m.size(); i++ )
+        m[ 1 + 2*i ] = i;
+    if( m.capacity() != cap ) passed = false;
+
+    m.clear();
+    if( m.size() != 0 || m.begin() != m.end() || m.count( 0 ) || m.capacity() != cap ) passed = false;
+    m.release();
+    if( m.capacity() != 0 || m.find( 3 ) != m.end() ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "flat hash map" );
+    else         printf("%50s failed\n", "flat hash map" );
+}
+
+void string_key_test() {
+    bool passed = true;
+    FlatHashMap<string,int>         m;
+    std::unordered_map<string,int>  ref;
+    for( int i=0; i<20000; i++ ) {
+        string key = "key_" + num2str( i % 7000 );
+        m  [key] += i;
+        ref[key] += i;
+        if( i % 3 == 0 ) {
+            string e = "key_" + num2str( ( i*7 ) % 7000 );
+            if( m.erase( e ) != ref.erase( e ) ) passed = false;
+        }
+    }
+    if( !same_contents( m, ref ) ) passed = false;
+    if( passed ) printf("%50s passed\n", "flat hash map string keys" );
+    else         printf("%50s failed\n", "flat hash map string keys" );
+}
+
+void pair_indexed_array_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 2 );
+    PairIndexedArray<int,float> arr;
+    std::map< std::pair<int,int>, float > ref;
+    arr.reserve( 1000 );
+    for( int t=0; t<50000; t++ ) {
+        int   x = int( gen.uniform_index( 100 ) );
+        int   y = int( gen.uniform_index( 100 ) );
+        float v = float( gen.uniform_index( 10 ) );
+        switch( gen.uniform_index( 3 ) ) {
+        case 0:
+            arr.set( x, y, v );
+            ref[ std::make_pair( x, y ) ] = v;
+            break;
+        case 1: {
+            float r = ( ref[ std::make_pair( x, y ) ] += v );
+            if( arr.add( x, y, v ) != r ) passed = false;
+            break;
+        }
+        case 2:
+            arr.remove( x, y );
+            ref.erase( std::make_pair( x, y ) );
+            break;
+        }
+    }
+    if( arr.size() != (int)ref.size() ) passed = false;
+    for( std::map< std::pair<int,int>, float >::iterator it=ref.begin(); it!=ref.end(); ++it )
+        if( !arr.is_present( it->first.first, it->first.second ) ||
+            arr.get( it->first.first, it->first.second ) != it->second ) passed = false;
+
+    // exported in the order of the old std::map
+    vector< PairValue<int,float> > pairs;
+    arr.export_pairs( pairs );
+    if( pairs.size() != ref.size() ) passed = false;
+    size_t j = 0;
+    for( std::map< std::pair<int,int>, float >::iterator it=ref.begin(); it!=ref.end() && j<pairs.size(); ++it, ++j )
+        if( pairs[j].id0 != it->first.first || pairs[j].id1 != it->first.second || pairs[j].val != it->second )
+            passed = false;
+
+    // save / load
+    arr.save( "/tmp/kortex_pair_indexed_array.bin" );
+    PairIndexedArray<int,float> larr;
+    larr.load( "/tmp/kortex_pair_indexed_array.bin" );
+    vector< PairValue<int,float> > lpairs;
+    larr.export_pairs( lpairs );
+    if( lpairs.size() != pairs.size() ) passed = false;
+    for( size_t i=0; i<lpairs.size() && i<pairs.size(); i++ )
+        if( lpairs[i].id0 != pairs[i].id0 || lpairs[i].id1 != pairs[i].id1 || lpairs[i].val != pairs[i].val )
+            passed = false;
+
+    // filter
+    int n_below = 0;
+    for( std::map< std::pair<int,int>, float >::iterator it=ref.begin(); it!=ref.end(); ++it )
+        if( it->second < 5.0f ) n_below++;
+    if( arr.filter_array( 5.0f ) != n_below || arr.size() != (int)ref.size() - n_below ) passed = false;
+    for( PairIndexedArray<int,float>::map_type::const_iterator it=arr.begin(); it!=arr.end(); ++it )
+        if( it->second < 5.0f || ref[ it->first ] != it->second ) passed = false;
+
+    // 64 bit indices
+    PairIndexedArray<uint64_t,int> arr64;
+    const uint64_t big = uint64_t(1) << 40;
+    arr64.add( big,   1, 3 );
+    arr64.add( big,   1, 4 );
+    arr64.add( 1,   big, 5 );
+    if( arr64.size() != 2 || arr64.get( big, 1 ) != 7 || arr64.get( 1, big ) != 5 ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "pair indexed array" );
+    else         printf("%50s failed\n", "pair indexed array" );
+}
+
+void sparse_array_test() {
+    bool passed = true;
+    SparseArrayII arr;
+    arr.reserve( 100 );
+    for( int i=0; i<1000; i++ ) {
+        arr.inc( i % 37 );
+        if( i % 5 == 0 ) arr.dec( 100 + i % 3 );
+        arr.add( 200, i );
+    }
+    if( arr.size() != 37+3+1 ) passed = false;
+    if( arr.val( 0 ) != 28 || arr.val( 36 ) != 27 ) passed = false;
+    if( arr.val( 100 ) != -67 || arr.val( 101 ) != -66 || arr.val( 102 ) != -67 ) passed = false;
+    if( arr.val( 200 ) != 999*1000/2 ) passed = false;
+    int key, val;
+    if( !arr.min_item( key, val ) || ( key != 100 && key != 102 ) || val != -67 ) passed = false;
+    if( !arr.max_item( key, val ) || key != 200 ) passed = false;
+    arr.zero( 200 );
+    arr.set( 300, 5 );
+    if( arr.val( 200 ) != 0 || arr.val( 300 ) != 5 || !arr.check( 300 ) || arr.check( 301 ) ) passed = false;
+    arr.clear();
+    if( arr.size() != 0 || arr.check( 0 ) ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "sparse array" );
+    else         printf("%50s failed\n", "sparse array" );
+}
+
+// image pair match counts - the access pattern of a match graph
+void pair_map_benchmark() {
+    PhiloxGenerator gen( 3 );
+    const int n_ops = 4000000, n_images = 20000;
+    vector<int> xs( n_ops ), ys( n_ops );
+    for( int i=0; i<n_ops; i++ ) {
+        xs[i] = int( gen.uniform_index( n_images ) );
+        ys[i] = int( gen.uniform_index( n_images ) );
+    }
+    Timer timer;
+
+    timer.reset();
+    std::map< std::pair<int,int>, int > tree;
+    for( int i=0; i<n_ops; i++ )
+        tree[ std::make_pair( xs[i], ys[i] ) ] += 1;
+    long s0 = 0;
+    for( int i=0; i<n_ops; i++ )
+        s0 += tree.find( std::make_pair( ys[i], xs[i] ) ) != tree.end();
+    double t_map = timer.elapsed();
+    tree.clear();
+
+    timer.reset();
+    PairIndexedArray<int,int> arr;
+    for( int i=0; i<n_ops; i++ )
+        arr.add( xs[i], ys[i], 1 );
+    long s1 = 0;
+    for( int i=0; i<n_ops; i++ )
+        s1 += arr.is_present( ys[i], xs[i] );
+    double t_flat = timer.elapsed();
+
+    printf("%d pair increments and lookups: std::map %8.4f sec PairIndexedArray %8.4f sec [%s]\n",
+           n_ops, t_map, t_flat, s0 == s1 ? "same" : "differ" );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
@@ -0,0 +1,174 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/gemm.h>
+#include <kortex/matrix.h>
+#include <kortex/random_generator.h>
+#include <kortex/cpu_features.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using namespace kortex;
+using std::vector;
+
+void packed_test();
+void matrix_ops_test();
+void gemm_benchmark();
+
+int main(int argc, char **argv) {
+    packed_test();
+    matrix_ops_test();
+    gemm_benchmark();
+    release_log_man();
+}
+
+void random_fill( PhiloxGenerator& gen, vector<double>& v ) {
+    for( size_t i=0; i<v.size(); i++ )
+        v[i] = 2.0*gen.uniform_sample() - 1.0;
+}
+
+void naive_gemm( const bool& ta, const bool& tb, const int& m, const int& n, const int& k,
+                 const double* A, const int& lda, const double* B, const int& ldb,
+                 double* C, const int& ldc ) {
+    for( int i=0; i<m; i++ ) {
+        for( int j=0; j<n; j++ ) {
+            double res = 0.0;
+            for( int p=0; p<k; p++ ) {
+                double a = ta ? A[p*lda+i] : A[i*lda+p];
+                double b = tb ? B[j*ldb+p] : B[p*ldb+j];
+                res += a*b;
+            }
+            C[i*ldc+j] = res;
+        }
+    }
+}
+
+double max_diff( const vector<double>& a, const vector<double>& b ) {
+    double d = 0.0;
+    for( size_t i=0; i<a.size(); i++ )
+        d = std::max( d, std::fabs( a[i]-b[i] ) );
+    return d;
+}
+
+void packed_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 7 );
+    // odd sizes hit the edge tiles, k > 256 and m > 96 cross the cache blocks
+    const int shapes[][3] = { {1,1,1}, {5,7,3}, {17,33,9}, {96,16,256}, {97,17,257},
+                              {130,70,300}, {31,301,45}, {200,129,513} };
+    const int n_shapes = sizeof(shapes)/sizeof(shapes[0]);
+    const SimdLevel levels[] = { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };
+    for( int l=0; l<3; l++ ) {
+        if( levels[l] > cpu_simd_level() ) continue;
+        set_simd_level_limit( levels[l] );
+        for( int s=0; s<n_shapes; s++ ) {
+            const int m = shapes[s][0], n = shapes[s][1], k = shapes[s][2];
+            for( int t=0; t<4; t++ ) {
+                bool ta = ( t & 1 ), tb = ( t & 2 );
+                int lda = ta ? m : k;
+                int ldb = tb ? k : n;
+                vector<double> A( size_t(m)*k ), B( size_t(k)*n );
+                random_fill( gen, A );
+                random_fill( gen, B );
+                // C has a padded row stride and the padding is left untouched
+                int ldc = n+3;
+                vector<double> C( size_t(m)*ldc, 7.0 ), R( size_t(m)*ldc, 7.0 );
+                naive_gemm     ( ta, tb, m, n, k, &A[0], lda, &B[0], ldb, &R[0], ldc );
+                mat_gemm_packed( ta, tb, m, n, k, &A[0], lda, &B[0], ldb, &C[0], ldc );
+                if( max_diff( C, R ) > 1e-12 * k ) passed = false;
+                mat_gemm       ( ta, tb, m, n, k, &A[0], lda, &B[0], ldb, &C[0], ldc );
+                if( max_diff( C, R ) > 1e-12 * k ) passed = false;
+            }
+        }
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+    if( passed ) printf("%50s passed\n", "packed gemm" );
+    else         printf("%50s failed\n", "packed gemm" );
+}
+
+void matrix_ops_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 8 );
+    const int nr = 150, nc = 90, nc2 = 110;
+    vector<double> A( nr*nc ), B( nc*nc2 ), D( nr*nc2 ), E( nr*nc );
+    random_fill( gen, A );
+    random_fill( gen, B );
+    random_fill( gen, D );
+    random_fill( gen, E );
+
+    vector<double> C( nr*nc2 ), R( nr*nc2 );
+    mat_mat( &A[0], nr, nc, &B[0], nc, nc2, &C[0], nr*nc2 );
+    naive_gemm( false, false, nr, nc2, nc, &A[0], nc, &B[0], nc2, &R[0], nc2 );
+    if( max_diff( C, R ) > 1e-10 ) passed = false;
+
+    vector<double> Ct( nr*nr ), Rt( nr*nr );
+    mat_mat_trans( &A[0], nr, nc, &E[0], nr, nc, &Ct[0], nr*nr );
+    naive_gemm( false, true, nr, nr, nc, &A[0], nc, &E[0], nc, &Rt[0], nr );
+    if( max_diff( Ct, Rt ) > 1e-10 ) passed = false;
+
+    vector<double> Tc( nc*nc2 ), Tr( nc*nc2 );
+    mat_trans_mat( &A[0], nr, nc, &D[0], nr, nc2, &Tc[0], nc*nc2 );
+    naive_gemm( true, false, nc, nc2, nr, &A[0], nc, &D[0], nc2, &Tr[0], nc2 );
+    if( max_diff( Tc, Tr ) > 1e-10 ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "mat_mat/mat_mat_trans/mat_trans_mat" );
+    else         printf("%50s failed\n", "mat_mat/mat_mat_trans/mat_trans_mat" );
+}
+
+void gemm_benchmark() {
+    PhiloxGenerator gen( 9 );
+    Timer timer;
+    const int sizes[] = { 256, 512, 1024 };
+    for( int s=0; s<3; s++ ) {
+        const int n = sizes[s];
+        const double gflop = 2.0 * double(n) * n * n * 1e-9;
+        vector<double> A( size_t(n)*n ), B( size_t(n)*n ), C( size_t(n)*n );
+        random_fill( gen, A );
+        random_fill( gen, B );
+
+        if( n <= 512 ) {
+            timer.reset();
+            naive_gemm( false, false, n, n, n, &A[0], n, &B[0], n, &C[0], n );
+            double t = timer.elapsed();
+            printf("gemm %4d [naive ]: %8.4f sec %6.2f gflops\n", n, t, gflop/t );
+        }
+
+        const SimdLevel levels[] = { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };
+        for( int l=0; l<3; l++ ) {
+            if( levels[l] > cpu_simd_level() ) continue;
+            set_simd_level_limit( levels[l] );
+            timer.reset();
+            mat_gemm_packed( false, false, n, n, n, &A[0], n, &B[0], n, &C[0], n );
+            double t = timer.elapsed();
+            printf("gemm %4d [%-6s]: %8.4f sec %6.2f gflops\n", n, simd_level_name(levels[l]).c_str(), t, gflop/t );
+        }
+        set_simd_level_limit( SIMD_AVX512 );
+
+#ifdef WITH_BLAS
+        timer.reset();
+        mat_gemm_blas( false, false, n, n, n, &A[0], n, &B[0], n, &C[0], n );
+        double t = timer.elapsed();
+        printf("gemm %4d [blas  ]: %8.4f sec %6.2f gflops\n", n, t, gflop/t );
+#endif
+    }
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
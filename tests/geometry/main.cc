@@ -0,0 +1,272 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/geometry.h>
+#include <kortex/matrix.h>
+#include <kortex/svd.h>
+#include <kortex/rotation.h>
+#include <kortex/random_generator.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using namespace kortex;
+using std::vector;
+
+void eigen_sym_test();
+void plane_test();
+void batch_plane_test();
+void plane_benchmark();
+
+int main(int argc, char **argv) {
+    eigen_sym_test();
+    plane_test();
+    batch_plane_test();
+    plane_benchmark();
+    release_log_man();
+}
+
+// A = R' diag(l) R for a random rotation R
+void random_symmetric( PhiloxGenerator& gen, const double l[3], double A[9] ) {
+    double aa[4] = { gen.normal_sample(), gen.normal_sample(), gen.normal_sample(), 0.0 };
+    double s = 1.0 / std::sqrt( aa[0]*aa[0] + aa[1]*aa[1] + aa[2]*aa[2] );
+    aa[0] *= s;
+    aa[1] *= s;
+    aa[2] *= s;
+    aa[3] = 6.0 * gen.uniform_sample();
+    double R[9], D[9] = { l[0], 0.0, 0.0, 0.0, l[1], 0.0, 0.0, 0.0, l[2] }, DR[9];
+    axisangle_to_rotation( aa, R );
+    mat_mat( D, 3, 3, R, 3, 3, DR, 9 );
+    mat_trans_mat( R, 3, 3, DR, 3, 3, A, 9 );
+}
+
+bool check_eigen( const double A[9], const double evals[3], const double evecs[9], const double& eps ) {
+    if( evals[0] < evals[1] || evals[1] < evals[2] ) return false;
+    double scale = std::max( std::fabs( evals[0] ), std::fabs( evals[2] ) ) + 1e-300;
+    for( int i=0; i<3; i++ ) {
+        const double* v = evecs + 3*i;
+        double Av[3];
+        mat_mat( A, 3, 3, v, 3, 1, Av, 3 );
+        for( int k=0; k<3; k++ )
+            if( std::fabs( Av[k] - evals[i]*v[k] ) > eps*scale ) return false;
+        for( int j=0; j<3; j++ ) {
+            double d = dot3( v, evecs+3*j );
+            if( std::fabs( d - ( i==j ? 1.0 : 0.0 ) ) > 1e-12 ) return false;
+        }
+    }
+    return true;
+}
+
+void eigen_sym_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 1 );
+    for( int t=0; t<1000; t++ ) {
+        double l[3], A[9], evals[3], evecs[9];
+        l[0] = 10.0 * gen.normal_sample();
+        l[1] = 10.0 * gen.normal_sample();
+        l[2] = 10.0 * gen.normal_sample();
+        if( t%4 == 1 ) l[1] = l[0];             // repeated
+        if( t%4 == 2 ) l[2] = l[0] * 1e-9;      // nearly rank deficient
+        if( t%4 == 3 ) l[1] = l[2] = 0.0;       // rank one
+        random_symmetric( gen, l, A );
+        mat_eigen_sym_3( A, evals, evecs );
+        if( !check_eigen( A, evals, evecs, 1e-12 ) ) passed = false;
+        std::sort( l, l+3 );
+        for( int i=0; i<3; i++ )
+            if( std::fabs( evals[i] - l[2-i] ) > 1e-12 * ( std::fabs(l[0]) + std::fabs(l[2]) ) ) passed = false;
+    }
+
+    // diagonal and zero matrices
+    double D[9] = { 1.0, 0.0, 0.0, 0.0, 3.0, 0.0, 0.0, 0.0, 2.0 }, Z[9] = { 0.0 };
+    double evals[3], evecs[9];
+    mat_eigen_sym_3( D, evals, evecs );
+    if( evals[0] != 3.0 || evals[1] != 2.0 || evals[2] != 1.0 ) passed = false;
+    if( evecs[1] != 1.0 || evecs[5] != 1.0 || evecs[6] != 1.0 ) passed = false;
+    mat_eigen_sym_3( Z, evals, evecs );
+    if( evals[0] != 0.0 || evals[2] != 0.0 || !check_eigen( Z, evals, evecs, 0.0 ) ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "symmetric 3x3 eigen decomposition" );
+    else         printf("%50s failed\n", "symmetric 3x3 eigen decomposition" );
+}
+
+// n points around the plane nrm.x + d = 0
+void plane_points( PhiloxGenerator& gen, const int& n, const double nrm[3], const double& d,
+                   const double& noise, float* X ) {
+    for( int i=0; i<n; i++ ) {
+        double p[3];
+        for( int k=0; k<3; k++ )
+            p[k] = 4.0 * gen.uniform_sample() - 2.0;
+        double e = dot3( nrm, p ) + d - noise * gen.normal_sample();
+        for( int k=0; k<3; k++ )
+            X[3*i+k] = float( p[k] - e*nrm[k] );
+    }
+}
+
+void random_normal( PhiloxGenerator& gen, double n[3] ) {
+    n[0] = gen.normal_sample();
+    n[1] = gen.normal_sample();
+    n[2] = gen.normal_sample();
+    double s = 1.0 / std::sqrt( dot3( n, n ) );
+    n[0] *= s;
+    n[1] *= s;
+    n[2] *= s;
+}
+
+// the plane fit through the svd of the covariance
+float svd_plane( const float* pnts, const int* idx, const int& n, float plane[4] ) {
+    double mu[3] = { 0.0, 0.0, 0.0 }, Cov[9] = { 0.0 };
+    for( int i=0; i<n; i++ )
+        for( int k=0; k<3; k++ )
+            mu[k] += pnts[ 3*idx[i]+k ] / n;
+    for( int i=0; i<n; i++ ) {
+        double d[3];
+        for( int k=0; k<3; k++ )
+            d[k] = pnts[ 3*idx[i]+k ] - mu[k];
+        for( int r=0; r<3; r++ )
+            for( int c=0; c<3; c++ )
+                Cov[3*r+c] += d[r]*d[c];
+    }
+    SVD svd;
+    svd.decompose( Cov, 3, 3, true, true );
+    const double* v  = svd.Vt() + 6;
+    const double* sd = svd.Sd();
+    for( int k=0; k<3; k++ )
+        plane[k] = float( v[k] );
+    plane[3] = float( -dot3( v, mu ) );
+    return float( sd[2] / ( sd[0] + sd[1] + sd[2] ) );
+}
+
+bool is_same_plane( const float a[4], const float b[4], const float& tol ) {
+    float sgn = ( a[0]*b[0] + a[1]*b[1] + a[2]*b[2] ) < 0.0f ? -1.0f : 1.0f;
+    for( int k=0; k<4; k++ )
+        if( std::fabs( a[k] - sgn*b[k] ) > tol ) return false;
+    return true;
+}
+
+void plane_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 2 );
+    for( int t=0; t<200; t++ ) {
+        const int n = 50;
+        double nrm[3];
+        random_normal( gen, nrm );
+        vector<float> X( 3*n );
+        plane_points( gen, n, nrm, 0.5, 0.01, &X[0] );
+
+        vector<const float*> pnts( n );
+        vector<Vec3f>        vpnts( n );
+        vector<int>          idx( n );
+        for( int i=0; i<n; i++ ) {
+            pnts[i]  = &X[3*i];
+            vpnts[i] = Vec3f( X[3*i], X[3*i+1], X[3*i+2] );
+            idx[i]   = i;
+        }
+        float p0[4], p1[4], ps[4];
+        float c0 = compute_plane( pnts,  p0 );
+        float c1 = compute_plane( vpnts, p1 );
+        float cs = svd_plane( &X[0], &idx[0], n, ps );
+        if( !is_same_plane( p0, ps, 1e-5f ) || !is_same_plane( p1, ps, 1e-5f ) ) passed = false;
+        if( std::fabs( c0 - cs ) > 1e-6f || std::fabs( c1 - cs ) > 1e-6f ) passed = false;
+        float gt[4] = { float(nrm[0]), float(nrm[1]), float(nrm[2]), 0.5f };
+        if( !is_same_plane( p0, gt, 0.02f ) ) passed = false;
+    }
+    if( passed ) printf("%50s passed\n", "compute_plane" );
+    else         printf("%50s failed\n", "compute_plane" );
+}
+
+void batch_plane_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 3 );
+    // neighborhoods of varying size on different planes
+    const int n_nbh = 1000;
+    vector<int>   offsets( n_nbh+1 ), nbh;
+    vector<float> X;
+    offsets[0] = 0;
+    for( int i=0; i<n_nbh; i++ ) {
+        int k = ( i%100 == 0 ) ? 3 : 4 + int( 30 * gen.uniform_sample() );
+        double nrm[3];
+        random_normal( gen, nrm );
+        int b = (int)X.size()/3;
+        X.resize( X.size() + 3*k );
+        plane_points( gen, k, nrm, gen.normal_sample(), 0.02, &X[3*b] );
+        for( int j=0; j<k; j++ )
+            nbh.push_back( b + k-1-j );
+        offsets[i+1] = (int)nbh.size();
+    }
+    const int n_pnts = (int)X.size()/3;
+
+    vector<float> planes( 4*n_nbh ), curv( n_nbh );
+    compute_planes( &X[0], n_pnts, &nbh[0], &offsets[0], n_nbh, &planes[0], &curv[0] );
+    for( int i=0; i<n_nbh; i++ ) {
+        int k = offsets[i+1] - offsets[i];
+        if( k < 4 ) {
+            if( curv[i] != -1.0f || planes[4*i] != 0.0f ) passed = false;
+            continue;
+        }
+        float ps[4];
+        float cs = svd_plane( &X[0], &nbh[offsets[i]], k, ps );
+        if( !is_same_plane( &planes[4*i], ps, 1e-4f ) ) passed = false;
+        if( std::fabs( curv[i] - cs ) > 1e-5f ) passed = false;
+    }
+
+    // fixed size neighborhoods
+    const int k = 8;
+    vector<int> knn( k*(n_pnts/k) );
+    for( size_t i=0; i<knn.size(); i++ )
+        knn[i] = (int)i;
+    vector<float> kplanes( 4*(n_pnts/k) );
+    compute_knn_planes( &X[0], n_pnts, &knn[0], k, n_pnts/k, &kplanes[0], NULL );
+    for( int i=0; i<n_pnts/k; i++ ) {
+        float ps[4];
+        svd_plane( &X[0], &knn[k*i], k, ps );
+        if( !is_same_plane( &kplanes[4*i], ps, 1e-3f ) ) passed = false;
+    }
+
+    if( passed ) printf("%50s passed\n", "compute_planes" );
+    else         printf("%50s failed\n", "compute_planes" );
+}
+
+void plane_benchmark() {
+    PhiloxGenerator gen( 4 );
+    const int n_pnts = 1<<18;
+    const int k      = 16;
+    double nrm[3] = { 0.0, 0.0, 1.0 };
+    vector<float> X( 3*n_pnts );
+    plane_points( gen, n_pnts, nrm, 0.0, 0.01, &X[0] );
+    vector<int> knn( size_t(k)*n_pnts );
+    for( int i=0; i<n_pnts; i++ )
+        for( int j=0; j<k; j++ )
+            knn[ size_t(i)*k+j ] = ( i + j*37 ) % n_pnts;
+
+    vector<float> planes( 4*size_t(n_pnts) ), curv( n_pnts );
+    Timer timer;
+    timer.reset();
+    for( int i=0; i<n_pnts; i++ )
+        curv[i] = svd_plane( &X[0], &knn[ size_t(i)*k ], k, &planes[ 4*size_t(i) ] );
+    double t_svd = timer.elapsed();
+
+    timer.reset();
+    compute_knn_planes( &X[0], n_pnts, &knn[0], k, n_pnts, &planes[0], &curv[0] );
+    double t_jacobi = timer.elapsed();
+    printf("%d planes of %d points: svd %8.4f sec compute_knn_planes %8.4f sec\n",
+           n_pnts, k, t_svd, t_jacobi );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
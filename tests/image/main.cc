@@ -0,0 +1,290 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/image.h>
+#include <kortex/image_processing.h>
+#include <kortex/mem_manager.h>
+#include <kortex/rect2.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+using namespace kortex;
+
+void padded_image_test();
+void region_view_test();
+void move_test();
+
+int main(int argc, char **argv) {
+    srand(19);
+    padded_image_test();
+    region_view_test();
+    move_test();
+    release_log_man();
+}
+
+void fill_random( Image& img ) {
+    for( int y=0; y<img.h(); y++ ) {
+        for( int x=0; x<img.w(); x++ ) {
+            switch( img.type() ) {
+            case IT_U_GRAY: img.set( x, y, uchar(rand()%256) ); break;
+            case IT_F_GRAY: img.set( x, y, float(rand()%1000)/10.0f ); break;
+            case IT_U_PRGB:
+            case IT_U_IRGB: img.set( x, y, uchar(rand()%256), uchar(rand()%256), uchar(rand()%256) ); break;
+            case IT_F_PRGB:
+            case IT_F_IRGB: img.set( x, y, float(rand()%1000), float(rand()%1000), float(rand()%1000) ); break;
+            default: break;
+            }
+        }
+    }
+}
+
+void get_pixel( const Image& img, int x, int y, float* v ) {
+    if( img.ch() == 1 ) {
+        v[0] = v[1] = v[2] = img.get(x,y);
+    } else if( img.precision() == TYPE_UCHAR ) {
+        uchar r, g, b;
+        img.get( x, y, r, g, b );
+        v[0] = r; v[1] = g; v[2] = b;
+    } else {
+        img.get( x, y, v[0], v[1], v[2] );
+    }
+}
+
+bool is_equal( const Image& a, const Image& b ) {
+    if( a.w() != b.w() || a.h() != b.h() || a.type() != b.type() ) return false;
+    for( int y=0; y<a.h(); y++ ) {
+        for( int x=0; x<a.w(); x++ ) {
+            float va[3], vb[3];
+            get_pixel( a, x, y, va );
+            get_pixel( b, x, y, vb );
+            if( va[0] != vb[0] || va[1] != vb[1] || va[2] != vb[2] ) return false;
+        }
+    }
+    return true;
+}
+
+bool is_aligned( const void* ptr ) {
+    return ( uintptr_t(ptr) % MEMORY_ALIGNMENT ) == 0;
+}
+
+void padded_image_test() {
+    bool passed = true;
+    const ImageType types[] = { IT_U_GRAY, IT_F_GRAY, IT_U_PRGB, IT_F_PRGB, IT_U_IRGB, IT_F_IRGB };
+    for( int t=0; t<6; t++ ) {
+        for( int w=1; w<80; w+=13 ) {
+            Image img;
+            img.create_padded( w, 7, types[t] );
+            for( int y=0; y<img.h(); y++ ) {
+                const void* row = NULL;
+                switch( types[t] ) {
+                case IT_U_GRAY:
+                case IT_U_PRGB: row = img.get_row_u (y  ); break;
+                case IT_F_GRAY:
+                case IT_F_PRGB: row = img.get_row_f (y  ); break;
+                case IT_U_IRGB: row = img.get_row_ui(y,2); break;
+                case IT_F_IRGB: row = img.get_row_fi(y,2); break;
+                default: break;
+                }
+                if( !is_aligned(row) ) passed = false;
+            }
+            fill_random( img );
+
+            // copies are packed and hold the same content
+            Image packed( img );
+            if( !packed.is_contiguous() || !is_equal( img, packed ) ) passed = false;
+
+            Image back;
+            back.create_padded( w, 7, types[t] );
+            back.copy( &packed );
+            if( !is_equal( back, packed ) ) passed = false;
+
+            img.zero();
+            for( int y=0; y<img.h(); y++ ) {
+                for( int x=0; x<img.w(); x++ ) {
+                    float v[3];
+                    get_pixel( img, x, y, v );
+                    if( v[0] != 0.0f || v[1] != 0.0f || v[2] != 0.0f ) passed = false;
+                }
+            }
+        }
+    }
+
+    // channel wrappers of padded image-ordered images keep the stride
+    Image irgb;
+    irgb.create_padded( 37, 11, IT_F_IRGB );
+    fill_random( irgb );
+    const Image* gch = irgb.get_channel_wrapper( 1 );
+    for( int y=0; y<irgb.h(); y++ ) {
+        for( int x=0; x<irgb.w(); x++ ) {
+            float r, g, b;
+            irgb.get( x, y, r, g, b );
+            if( gch->getf(x,y) != g ) passed = false;
+        }
+    }
+    delete gch;
+
+    // stride aware resampling and filtering
+    Image fimg;
+    fimg.create_padded( 53, 41, IT_F_GRAY );
+    fill_random( fimg );
+    Image fpacked( fimg );
+    float xs[] = { 0.0f, 3.5f, 17.25f, 51.9f, -2.0f, 30.0f };
+    float ys[] = { 0.0f, 9.5f, 40.00f, 12.1f, 60.0f, 20.7f };
+    float a[6], b[6];
+    fimg   .get_bicubic( xs, ys, 6, a );
+    fpacked.get_bicubic( xs, ys, 6, b );
+    for( int i=0; i<6; i++ ) {
+        if( a[i] != b[i] ) passed = false;
+        if( !fimg.is_inside( int(xs[i]), int(ys[i]) ) ) continue;
+        if( fimg.get_bilinear( xs[i], ys[i] ) != fpacked.get_bilinear( xs[i], ys[i] ) ) passed = false;
+        if( !fimg.is_inside_margin( xs[i], ys[i], 2 ) ) continue;
+        if( fimg.get_bicubic ( xs[i], ys[i] ) != fpacked.get_bicubic ( xs[i], ys[i] ) ) passed = false;
+    }
+
+    Image r0, r1;
+    image_resize( fimg,    20, 17, RS_BICUBIC, false, r0 );
+    image_resize( fpacked, 20, 17, RS_BICUBIC, false, r1 );
+    if( !is_equal( r0, r1 ) ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "padded image" );
+    else         printf("%50s failed\n", "padded image" );
+}
+
+void region_view_test() {
+    bool passed = true;
+    const ImageType types[] = { IT_U_GRAY, IT_F_GRAY, IT_U_PRGB, IT_F_PRGB, IT_U_IRGB, IT_F_IRGB };
+    for( int t=0; t<6; t++ ) {
+        Image img( 61, 43, types[t] );
+        fill_random( img );
+
+        Image view, patch;
+        extract_region_view ( img, 7, 5, 40, 31, view  );
+        extract_region_patch( img, 7, 5, 40, 31, patch );
+        if( !view.is_wrapper() || view.is_contiguous() ) passed = false;
+        if( !is_equal( view, patch ) ) passed = false;
+
+        // the view shares the rows of the image
+        switch( types[t] ) {
+        case IT_U_GRAY:
+        case IT_U_PRGB: if( view.get_row_u(3) != img.get_row_u(8) + 7*img.ch() ) passed = false; break;
+        case IT_F_GRAY:
+        case IT_F_PRGB: if( view.get_row_f(3) != img.get_row_f(8) + 7*img.ch() ) passed = false; break;
+        case IT_U_IRGB: if( view.get_row_ui(3,1) != img.get_row_ui(8,1) + 7 ) passed = false; break;
+        case IT_F_IRGB: if( view.get_row_fi(3,1) != img.get_row_fi(8,1) + 7 ) passed = false; break;
+        default: break;
+        }
+
+        // writes go to the image and stay inside the region
+        view.zero();
+        for( int y=0; y<img.h(); y++ ) {
+            for( int x=0; x<img.w(); x++ ) {
+                bool inside = ( x >= 7 && x < 40 && y >= 5 && y < 31 );
+                float v[3];
+                get_pixel( img, x, y, v );
+                if( inside && ( v[0] != 0.0f || v[1] != 0.0f || v[2] != 0.0f ) ) passed = false;
+            }
+        }
+        view.copy( &patch );
+        Image restored;
+        extract_region_patch( img, 7, 5, 40, 31, restored );
+        if( !is_equal( restored, patch ) ) passed = false;
+
+        // views of views
+        Image inner;
+        inner.create_wrapper( view, Rect2i( 2, 10, 3, 9 ) );
+        Image inner_patch;
+        extract_region_patch( img, 9, 8, 17, 14, inner_patch );
+        if( !is_equal( inner, inner_patch ) ) passed = false;
+
+        // regions crossing the border are copied and zero padded
+        Image border;
+        extract_region_view( img, -3, -2, 10, 12, border );
+        if( border.is_wrapper() || !border.is_contiguous() ) passed = false;
+        float v[3];
+        get_pixel( border, 0, 0, v );
+        if( v[0] != 0.0f || v[1] != 0.0f || v[2] != 0.0f ) passed = false;
+
+        // a copy-extracted patch does not write through an old view
+        extract_region_view ( img, 0, 0, 33, 26, view );
+        extract_region_patch( img, 1, 1, 34, 27, view );
+        if( view.is_wrapper() ) passed = false;
+    }
+
+    // sampling a view matches sampling the copied patch
+    Image img( 64, 48, IT_U_PRGB );
+    fill_random( img );
+    Image view, patch;
+    extract_region_view ( img, 11, 9, 50, 40, view  );
+    extract_region_patch( img, 11, 9, 50, 40, patch );
+    const int n = 100;
+    float xs[n], ys[n], a[3*n], b[3*n];
+    for( int i=0; i<n; i++ ) {
+        xs[i] = float(rand()%4500)/100.0f - 3.0f;
+        ys[i] = float(rand()%3600)/100.0f - 3.0f;
+    }
+    view .get_bilinear( xs, ys, n, a );
+    patch.get_bilinear( xs, ys, n, b );
+    for( int i=0; i<3*n; i++ )
+        if( a[i] != b[i] ) passed = false;
+    view .get_bicubic( xs, ys, n, a );
+    patch.get_bicubic( xs, ys, n, b );
+    for( int i=0; i<3*n; i++ )
+        if( a[i] != b[i] ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "region view" );
+    else         printf("%50s failed\n", "region view" );
+}
+
+void move_test() {
+    bool passed = true;
+    Image img( 37, 21, IT_F_PRGB );
+    fill_random( img );
+    Image ref( img );
+
+    // owned buffers are handed over
+    const float* ptr = img.get_fptr();
+    Image moved( std::move( img ) );
+    if( moved.get_fptr() != ptr || !img.is_empty() || !is_equal( moved, ref ) ) passed = false;
+    Image assigned( 5, 5, IT_U_GRAY );
+    assigned = std::move( moved );
+    if( assigned.get_fptr() != ptr || !moved.is_empty() || !is_equal( assigned, ref ) ) passed = false;
+
+    // views are copied - the source image keeps its rows
+    Image view;
+    extract_region_view( assigned, 3, 2, 20, 15, view );
+    Image vpatch;
+    extract_region_patch( assigned, 3, 2, 20, 15, vpatch );
+    Image vcopy( std::move( view ) );
+    if( vcopy.is_wrapper() || !view.is_wrapper() || !is_equal( vcopy, vpatch ) ) passed = false;
+
+    // a view destination is written in place
+    Image src( 17, 13, IT_F_PRGB );
+    fill_random( src );
+    Image src_ref( src );
+    view = std::move( src );
+    if( !view.is_wrapper() || !is_equal( view, src_ref ) ) passed = false;
+    Image written;
+    extract_region_patch( assigned, 3, 2, 20, 15, written );
+    if( !is_equal( written, src_ref ) ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "image move" );
+    else         printf("%50s failed\n", "image move" );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
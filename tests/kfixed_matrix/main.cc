@@ -0,0 +1,250 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/kfixed_matrix.h>
+#include <kortex/kmatrix.h>
+#include <kortex/random_generator.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using namespace kortex;
+using std::vector;
+
+void product_test();
+void inverse_test();
+void interop_test();
+void fixed_matrix_benchmark();
+
+int main(int argc, char **argv) {
+    product_test();
+    inverse_test();
+    interop_test();
+    fixed_matrix_benchmark();
+    release_log_man();
+}
+
+template<typename T, int R, int C>
+void random_matrix( PhiloxGenerator& gen, KFixedMatrix<T,R,C>& A ) {
+    for( int i=0; i<R*C; i++ )
+        A[i] = T( 2.0*gen.uniform_sample() - 1.0 );
+}
+
+template<typename T, int R, int C>
+bool is_equal_raw( const KFixedMatrix<T,R,C>& A, const double* B, const double& eps ) {
+    for( int i=0; i<R*C; i++ )
+        if( std::fabs( double(A[i]) - B[i] ) > eps ) return false;
+    return true;
+}
+
+void product_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 3 );
+    for( int t=0; t<100; t++ ) {
+        Mat34d P;
+        Mat4d  T4;
+        Mat3d  K, R;
+        random_matrix( gen, P  );
+        random_matrix( gen, T4 );
+        random_matrix( gen, K  );
+        random_matrix( gen, R  );
+
+        double ref[16];
+        mat_mat( P(), 3, 4, T4(), 4, 4, ref, 12 );
+        if( !is_equal_raw( P*T4, ref, 1e-14 ) ) passed = false;
+
+        mat_mat( K(), 3, 3, R(), 3, 3, ref, 9 );
+        if( !is_equal_raw( K*R, ref, 1e-14 ) ) passed = false;
+
+        Mat4d PtP;
+        mat_trans_mat( P(), 3, 4, P(), 3, 4, ref, 16 );
+        mat_trans_mat( P, P, PtP );
+        if( !is_equal_raw( PtP, ref, 1e-14 ) ) passed = false;
+
+        Mat3d PPt;
+        mat_mat_trans( P(), 3, 4, P(), 3, 4, ref, 9 );
+        mat_mat_trans( P, P, PPt );
+        if( !is_equal_raw( PPt, ref, 1e-14 ) ) passed = false;
+
+        Vec4d X( 1.0, -2.0, 0.5, 1.0 );
+        Vec3d x = P * X;
+        mat_mat( P(), 3, 4, X(), 4, 1, ref, 3 );
+        for( int i=0; i<3; i++ )
+            if( std::fabs( x[i] - ref[i] ) > 1e-14 ) passed = false;
+
+        Mat34f Pf;
+        Vec4f  Xf( 1.0f, -2.0f, 0.5f, 1.0f );
+        for( int i=0; i<12; i++ ) Pf[i] = float( P[i] );
+        Vec3f xf = Pf * Xf;
+        for( int i=0; i<3; i++ )
+            if( std::fabs( xf[i] - ref[i] ) > 1e-5 ) passed = false;
+
+        Mat3d Rt = R.transposed();
+        Mat3d S  = R;
+        S.transpose();
+        if( !is_equal( Rt, S, 0.0 ) ) passed = false;
+        if( std::fabs( ( K+R-R )(1,2) - K(1,2) ) > 1e-15 ) passed = false;
+        if( std::fabs( K.trace() - ( K(0,0)+K(1,1)+K(2,2) ) ) > 1e-15 ) passed = false;
+    }
+    if( passed ) printf("%50s passed\n", "fixed matrix products" );
+    else         printf("%50s failed\n", "fixed matrix products" );
+}
+
+// cofactor expansion along the first row
+double laplace_det_4( const Mat4d& A ) {
+    double d = 0.0;
+    for( int c=0; c<4; c++ ) {
+        double minor[9];
+        for( int r=1, k=0; r<4; r++ )
+            for( int j=0; j<4; j++ )
+                if( j != c ) minor[k++] = A(r,j);
+        d += ( c%2 ? -1.0 : 1.0 ) * A(0,c) * mat_det_3( minor, 3 );
+    }
+    return d;
+}
+
+void inverse_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 4 );
+    for( int t=0; t<100; t++ ) {
+        Mat2d A2, iA2;
+        Mat3d A3, iA3;
+        Mat4d A4, iA4;
+        random_matrix( gen, A2 );
+        random_matrix( gen, A3 );
+        random_matrix( gen, A4 );
+
+        KMatrix K2( A2(), 2, 2 ), K3( A3(), 3, 3 ), K4( A4(), 4, 4 );
+        if( std::fabs( A2.det() - mat_det_2( A2(), 2 ) ) > 1e-12 ) passed = false;
+        if( std::fabs( A3.det() - K3.det() ) > 1e-12 ) passed = false;
+        if( std::fabs( A4.det() - laplace_det_4( A4 ) ) > 1e-12 ) passed = false;
+
+        KMatrix iK;
+        if( !mat_inv( A2, iA2 ) ) passed = false;
+        mat_inv( K2, iK );
+        if( !is_equal_raw( iA2, iK(), 1e-9 ) ) passed = false;
+        if( !mat_inv( A3, iA3 ) ) passed = false;
+        mat_inv( K3, iK );
+        if( !is_equal_raw( iA3, iK(), 1e-9 ) ) passed = false;
+        if( !mat_inv( A4, iA4 ) ) passed = false;
+        mat_inv( K4, iK );
+        if( !is_equal_raw( iA4, iK(), 1e-9 ) ) passed = false;
+
+        Mat4d I4, E4 = A4 * A4.inv();
+        I4.identity();
+        if( !is_equal( E4, I4, 1e-9 ) ) passed = false;
+
+        Mat3f A3f, iA3f, E3f, I3f;
+        for( int i=0; i<9; i++ ) A3f[i] = float( A3[i] );
+        if( !mat_inv( A3f, iA3f ) ) passed = false;
+        mat_mat( A3f, iA3f, E3f );
+        I3f.identity();
+        if( std::fabs( A3.det() ) > 0.05 && !is_equal( E3f, I3f, 1e-3f ) ) passed = false;
+    }
+
+    // singular matrices are reported and zeroed
+    double s_data[] = { 1.0, 2.0, 3.0, 2.0, 4.0, 6.0, 1.0, 0.0, 1.0 };
+    Mat3d S( s_data ), iS;
+    if( mat_inv( S, iS ) ) passed = false;
+    if( iS.norm() != 0.0 ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "fixed matrix det/inverse" );
+    else         printf("%50s failed\n", "fixed matrix det/inverse" );
+}
+
+void interop_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 5 );
+    Mat34d P;
+    random_matrix( gen, P );
+
+    KMatrix KP;
+    initialize( P, KP );
+    if( KP.h() != 3 || KP.w() != 4 || !is_equal_raw( P, KP(), 0.0 ) ) passed = false;
+
+    Mat34d Q( KP );
+    if( !is_equal( P, Q, 0.0 ) ) passed = false;
+    Mat34f Qf;
+    initialize( KP, Qf );
+    if( !is_equal_raw( Qf, KP(), 1e-6 ) ) passed = false;
+
+    // the wrapper shares memory
+    KMatrix W = P.wrapper();
+    W.scale( 2.0 );
+    for( int i=0; i<12; i++ )
+        if( P[i] != 2.0*KP[i] ) passed = false;
+    if( !W.is_wrapper() ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "fixed matrix kmatrix interop" );
+    else         printf("%50s failed\n", "fixed matrix kmatrix interop" );
+}
+
+void fixed_matrix_benchmark() {
+    const int n = 1000000;
+    PhiloxGenerator gen( 6 );
+    Mat34d P;
+    Mat4d  T4;
+    random_matrix( gen, P  );
+    random_matrix( gen, T4 );
+    T4.scale( 0.5 );
+    Timer timer;
+    double chk[3] = { 0.0, 0.0, 0.0 };
+
+    timer.reset();
+    KMatrix KP( P(), 3, 4 ), KT( T4(), 4, 4 ), KC;
+    for( int i=0; i<n; i++ ) {
+        KC = KP * KT;
+        chk[0] += KC[i%12];
+    }
+    double t_kmatrix = timer.elapsed();
+
+    timer.reset();
+    double C[12];
+    for( int i=0; i<n; i++ ) {
+        mat_mat( P(), 3, 4, T4(), 4, 4, C, 12 );
+        chk[1] += C[i%12];
+        P[i%12] += 1e-9;
+    }
+    double t_raw = timer.elapsed();
+
+    timer.reset();
+    for( int i=0; i<n; i++ ) {
+        Mat34d PT = P * T4;
+        chk[2] += PT[i%12];
+        P[i%12] += 1e-9;
+    }
+    double t_fixed = timer.elapsed();
+
+    timer.reset();
+    Mat4d iT;
+    double s = 0.0;
+    for( int i=0; i<n; i++ ) {
+        T4[i%16] += 1e-9;
+        mat_inv( T4, iT );
+        s += iT[i%16];
+    }
+    double t_inv = timer.elapsed();
+
+    printf("3x4 * 4x4 x %d: KMatrix %8.4f sec raw mat_mat %8.4f sec fixed %8.4f sec [%g %g %g]\n",
+           n, t_kmatrix, t_raw, t_fixed, chk[0], chk[1], chk[2] );
+    printf("4x4 inverse x %d: fixed %8.4f sec [%g]\n", n, t_inv, s );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
@@ -18,9 +18,13 @@
 using namespace kortex;
 
 void matrix_test();
+void move_test();
+void expression_test();
 
 int main(int argc, char **argv) {
     matrix_test();
+    move_test();
+    expression_test();
     release_log_man();
 }
 
@@ -583,6 +587,112 @@ void matrix_test() {
 
 }
 
+void move_test() {
+    double a_data[] = { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0 };
+    KMatrix gA( (const double*)a_data, 2, 3 );
+
+    // owned memory is handed over
+    KMatrix A; A.copy( gA );
+    const double* ptr = A();
+    KMatrix B( std::move(A) );
+    bool passed = ( B() == ptr ) && !A.is_initialized() && mat_is_equal( B, gA, 0.0 );
+    KMatrix C(4,4);
+    C = std::move( B );
+    passed = passed && ( C() == ptr ) && !B.is_initialized() && C.h() == 2 && C.w() == 3;
+    if( passed ) printf("%50s passed\n", "move owned" );
+    else         printf("%50s failed\n", "move owned" );
+
+    // wrappers keep their semantics - a wrapped source is copied and a
+    // wrapper destination is written in place
+    double w_data[6];
+    KMatrix W( w_data, 2, 3 );
+    W = std::move( C );
+    passed = W.is_wrapper() && W() == w_data && mat_is_equal( W, gA, 0.0 );
+    KMatrix D( std::move( gA ) );
+    passed = passed && !D.is_wrapper() && D() != a_data && gA.is_initialized() && mat_is_equal( D, gA, 0.0 );
+    if( passed ) printf("%50s passed\n", "move wrapped" );
+    else         printf("%50s failed\n", "move wrapped" );
+
+    vector<KMatrix> mats;
+    for( int i=0; i<100; i++ ) {
+        mats.push_back( KMatrix( 3, 3 ) );
+        mats.back().identity();
+        mats.back().scale( i );
+    }
+    passed = true;
+    for( int i=0; i<100; i++ )
+        if( mats[i](1,1) != i ) passed = false;
+    if( passed ) printf("%50s passed\n", "move into vector" );
+    else         printf("%50s failed\n", "move into vector" );
+}
+
+void expression_test() {
+    double eps = 1e-10;
+    double a_data[] = {
+        0.3436688804605960,  0.0863212285183167,  0.5030670008016513,
+        0.8514830781674081,  0.7407569272991721,  0.1272223460018265,
+        0.6738894813341811,  0.1784195904359802,  0.6167043970549876 };
+    double b_data[] = {
+        0.73118301679178210, 0.71978909927724144, 0.51242594768108685,
+        0.45431376547891594, 0.53069669311093304, 0.24546935082099669,
+        0.00502015374098324, 0.38104151340781584, 0.22613368480313550 };
+    double c_data[] = {
+        0.6824365555016827, 0.4859748704863389, 0.6129127879432523,
+        0.8080734763838867, 0.0711821018793324, 0.6113789514527007,
+        0.9308892831375858, 0.4703196994250146, 0.8703888508569482 };
+    double x_data[] = { 0.724106275974106,  0.213387624220311, 0.504472749633369 };
+    KMatrix A( (const double*)a_data, 3, 3 );
+    KMatrix B( (const double*)b_data, 3, 3 );
+    KMatrix C( (const double*)c_data, 3, 3 );
+    KMatrix x( (const double*)x_data, 3, 1 );
+
+    KMatrix AB, ref, tmp;
+    mat_mat( A, B, AB );
+
+    mat_minus_mat( AB, C, ref );
+    KMatrix E = A*B - C;
+    assert_matrix_equality( E, ref, eps, "expr A*B-C" );
+
+    mat_minus_mat( C, AB, ref );
+    E = C - A*B;
+    assert_matrix_equality( E, ref, eps, "expr C-A*B" );
+
+    mat_plus_mat( AB, C, tmp );
+    ref.copy( tmp );
+    ref.scale( 2.0 );
+    E = 2.0 * ( A*B + C );
+    assert_matrix_equality( E, ref, eps, "expr 2*(A*B+C)" );
+
+    mat_mat( AB, C, ref );
+    E = A*B*C;
+    assert_matrix_equality( E, ref, eps, "expr A*B*C" );
+
+    mat_inv_mat( A, x, ref );
+    E = A.inv() * x;
+    assert_matrix_equality( E, ref, eps, "expr A.inv()*x" );
+
+    mat_inv( A, ref );
+    E = A.inv();
+    assert_matrix_equality( E, ref, eps, "expr A.inv()" );
+
+    // the destination appears in the expression
+    E.copy( A );
+    E = E*B - C;
+    mat_minus_mat( AB, C, ref );
+    assert_matrix_equality( E, ref, eps, "expr aliased E=E*B-C" );
+
+    E.copy( B );
+    E = A*E;
+    assert_matrix_equality( E, AB, eps, "expr aliased E=A*E" );
+
+    // wrapped destinations are written in place
+    double w_data[9];
+    KMatrix W( w_data, 3, 3 );
+    W = A*B;
+    KMatrix Ww( (const double*)w_data, 3, 3 );
+    assert_matrix_equality( Ww, AB, eps, "expr into wrapper" );
+}
+
 
 
 
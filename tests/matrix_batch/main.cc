@@ -0,0 +1,257 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/matrix_batch.h>
+#include <kortex/kfixed_matrix.h>
+#include <kortex/matrix.h>
+#include <kortex/rotation.h>
+#include <kortex/random_generator.h>
+#include <kortex/cpu_features.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+using namespace kortex;
+using std::vector;
+
+void inverse_test();
+void mat_vec_test();
+void rotation_test();
+void batch_benchmark();
+
+int main(int argc, char **argv) {
+    inverse_test();
+    mat_vec_test();
+    rotation_test();
+    batch_benchmark();
+    release_log_man();
+}
+
+// n random matrices ( aos ) and their soa copy
+void random_batch( PhiloxGenerator& gen, const int& n, const int& esz, vector<double>& A, vector<double>& S ) {
+    A.resize( size_t(n)*esz );
+    S.resize( size_t(n)*esz );
+    for( size_t i=0; i<A.size(); i++ )
+        A[i] = 2.0*gen.uniform_sample() - 1.0;
+    batch_aos_to_soa( &A[0], n, esz, &S[0] );
+}
+
+// n random rotations as [axis angle] in aos and soa layouts. some of the
+// angles are close to pi so that every branch of rotation_to_quaternion is hit
+void random_axisangles( PhiloxGenerator& gen, const int& n, vector<double>& A, vector<double>& S ) {
+    A.resize( 4*size_t(n) );
+    S.resize( 4*size_t(n) );
+    for( int i=0; i<n; i++ ) {
+        double* a = &A[4*size_t(i)];
+        a[0] = gen.normal_sample();
+        a[1] = gen.normal_sample();
+        a[2] = gen.normal_sample();
+        double s = 1.0 / std::sqrt( a[0]*a[0] + a[1]*a[1] + a[2]*a[2] );
+        a[0] *= s;
+        a[1] *= s;
+        a[2] *= s;
+        a[3] = ( i%3 == 0 ) ? 3.1 + 0.04*gen.uniform_sample() : 6.0*gen.uniform_sample() - 3.0;
+    }
+    batch_aos_to_soa( &A[0], n, 4, &S[0] );
+}
+
+const SimdLevel g_levels[] = { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };
+
+void inverse_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 1 );
+    const int n = 1003; // not a multiple of the simd width
+    vector<double> A3, S3, A4, S4;
+    random_batch( gen, n, 9,  A3, S3 );
+    random_batch( gen, n, 16, A4, S4 );
+    // a few singular ones
+    for( int e=0; e<3; e++ ) {
+        S3[ size_t(6+e)*n + 5 ] = 2.0 * S3[ size_t(3+e)*n + 5 ];
+        A3[ 5*9 + 6+e ] = 2.0 * A3[ 5*9 + 3+e ];
+    }
+    for( int e=0; e<16; e++ ) {
+        S4[ size_t(e)*n + n-1 ] = 0.0;
+        A4[ size_t(n-1)*16 + e ] = 0.0;
+    }
+
+    vector<double> d3(n), d4(n), iS3( 9*n ), iS4( 16*n );
+    vector<uchar> v3(n), v4(n);
+    for( int l=0; l<3; l++ ) {
+        if( g_levels[l] > cpu_simd_level() ) continue;
+        set_simd_level_limit( g_levels[l] );
+        batch_det_3( &S3[0], n, &d3[0] );
+        batch_det_4( &S4[0], n, &d4[0] );
+        int n3 = batch_inv_3( &S3[0], n, 1e-12, &iS3[0], &v3[0] );
+        int n4 = batch_inv_4( &S4[0], n, 1e-12, &iS4[0], &v4[0] );
+        if( n3 != n-1 || n4 != n-1 ) passed = false;
+        if( v3[5] || v4[n-1] || !v3[n-1] || !v4[5] ) passed = false;
+
+        for( int i=0; i<n; i++ ) {
+            Mat3d M3( &A3[9*size_t(i)] ), iM3;
+            Mat4d M4( &A4[16*size_t(i)] ), iM4;
+            if( std::fabs( d3[i] - mat_det( M3 ) ) > 1e-12 ) passed = false;
+            if( std::fabs( d4[i] - mat_det( M4 ) ) > 1e-12 ) passed = false;
+            bool ok3 = mat_inv( M3, iM3, 1e-12 );
+            bool ok4 = mat_inv( M4, iM4, 1e-12 );
+            if( ok3 != bool(v3[i]) || ok4 != bool(v4[i]) ) passed = false;
+            // relative to the size of the inverse - some are ill-conditioned
+            double s3 = 1e-12 * ( 1.0 + iM3.norm() * iM3.norm() );
+            double s4 = 1e-12 * ( 1.0 + iM4.norm() * iM4.norm() );
+            for( int e=0; e<9; e++ )
+                if( std::fabs( iS3[ size_t(e)*n+i ] - iM3[e] ) > s3 ) passed = false;
+            for( int e=0; e<16; e++ )
+                if( std::fabs( iS4[ size_t(e)*n+i ] - iM4[e] ) > s4 ) passed = false;
+        }
+        // singular matrices are zeroed
+        for( int e=0; e<9; e++ )
+            if( iS3[ size_t(e)*n+5 ] != 0.0 ) passed = false;
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+
+    // soa <-> aos round trip
+    vector<double> B3( 9*n );
+    batch_soa_to_aos( &S3[0], n, 9, &B3[0] );
+    if( B3 != A3 ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "batch det/inverse" );
+    else         printf("%50s failed\n", "batch det/inverse" );
+}
+
+void mat_vec_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 2 );
+    const int n = 517;
+    vector<double> A3, S3, A4, S4, X3, Y3, X4, Y4;
+    random_batch( gen, n, 9,  A3, S3 );
+    random_batch( gen, n, 16, A4, S4 );
+    random_batch( gen, n, 3,  X3, Y3 );
+    random_batch( gen, n, 4,  X4, Y4 );
+    vector<double> r3( 3*n ), t3( 3*n ), r4( 4*n );
+    for( int l=0; l<3; l++ ) {
+        if( g_levels[l] > cpu_simd_level() ) continue;
+        set_simd_level_limit( g_levels[l] );
+        batch_mat_vec_3      ( &S3[0], &Y3[0], n, &r3[0] );
+        batch_mat_trans_vec_3( &S3[0], &Y3[0], n, &t3[0] );
+        batch_mat_vec_4      ( &S4[0], &Y4[0], n, &r4[0] );
+        for( int i=0; i<n; i++ ) {
+            double y3[3], yt[3], y4[4];
+            mat_mat      ( &A3[9*size_t(i)],  3, 3, &X3[3*size_t(i)], 3, 1, y3, 3 );
+            mat_trans_mat( &A3[9*size_t(i)],  3, 3, &X3[3*size_t(i)], 3, 1, yt, 3 );
+            mat_mat      ( &A4[16*size_t(i)], 4, 4, &X4[4*size_t(i)], 4, 1, y4, 4 );
+            for( int k=0; k<3; k++ ) {
+                if( std::fabs( r3[ size_t(k)*n+i ] - y3[k] ) > 1e-13 ) passed = false;
+                if( std::fabs( t3[ size_t(k)*n+i ] - yt[k] ) > 1e-13 ) passed = false;
+            }
+            for( int k=0; k<4; k++ )
+                if( std::fabs( r4[ size_t(k)*n+i ] - y4[k] ) > 1e-13 ) passed = false;
+        }
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+    if( passed ) printf("%50s passed\n", "batch mat-vec" );
+    else         printf("%50s failed\n", "batch mat-vec" );
+}
+
+void rotation_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 3 );
+    const int n = 2001;
+    vector<double> AA, SA;
+    random_axisangles( gen, n, AA, SA );
+
+    vector<double> q( 4*n ), R( 9*n ), R2( 9*n ), q2( 4*n );
+    for( int l=0; l<3; l++ ) {
+        if( g_levels[l] > cpu_simd_level() ) continue;
+        set_simd_level_limit( g_levels[l] );
+        batch_axisangle_to_quaternion( &SA[0], n, &q[0] );
+        batch_axisangle_to_rotation  ( &SA[0], n, &R[0] );
+        batch_quaternion_to_rotation ( &q[0],  n, &R2[0] );
+        batch_rotation_to_quaternion ( &R[0],  n, &q2[0] );
+        for( int i=0; i<n; i++ ) {
+            double qr[4], Rr[9], q2r[4];
+            axisangle_to_quaternion( &AA[4*size_t(i)], qr );
+            axisangle_to_rotation  ( &AA[4*size_t(i)], Rr );
+            rotation_to_quaternion ( Rr, q2r );
+            for( int k=0; k<4; k++ ) {
+                if( std::fabs( q [ size_t(k)*n+i ] - qr [k] ) > 1e-14 ) passed = false;
+                if( std::fabs( q2[ size_t(k)*n+i ] - q2r[k] ) > 1e-12 ) passed = false;
+            }
+            for( int k=0; k<9; k++ ) {
+                if( std::fabs( R [ size_t(k)*n+i ] - Rr[k] ) > 1e-14 ) passed = false;
+                if( std::fabs( R2[ size_t(k)*n+i ] - Rr[k] ) > 1e-14 ) passed = false;
+            }
+        }
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+    if( passed ) printf("%50s passed\n", "batch rotation conversions" );
+    else         printf("%50s failed\n", "batch rotation conversions" );
+}
+
+void batch_benchmark() {
+    PhiloxGenerator gen( 4 );
+    const int n = 1000000;
+    vector<double> A3, S3, A4, S4, AA, SA;
+    random_batch( gen, n, 9,  A3, S3 );
+    random_batch( gen, n, 16, A4, S4 );
+    random_axisangles( gen, n, AA, SA );
+    vector<double> out( 16*size_t(n) );
+    Timer timer;
+
+    timer.reset();
+    for( int i=0; i<n; i++ )
+        mat_inv_3( &A3[9*size_t(i)], 3, &out[9*size_t(i)], 3, 0.0 );
+    double t_inv3 = timer.elapsed();
+    timer.reset();
+    for( int i=0; i<n; i++ ) {
+        Mat4d M( &A4[16*size_t(i)] ), iM;
+        mat_inv( M, iM );
+        memcpy( &out[16*size_t(i)], iM(), sizeof(double)*16 );
+    }
+    double t_inv4 = timer.elapsed();
+    timer.reset();
+    for( int i=0; i<n; i++ ) {
+        double R[9];
+        axisangle_to_rotation( &AA[4*size_t(i)], R );
+        rotation_to_quaternion( R, &out[4*size_t(i)] );
+    }
+    double t_rot = timer.elapsed();
+    printf("x %d [scalar]: inv3 %8.4f inv4 %8.4f aa->R->q %8.4f sec\n", n, t_inv3, t_inv4, t_rot );
+
+    vector<double> R( 9*size_t(n) );
+    for( int l=0; l<3; l++ ) {
+        if( g_levels[l] > cpu_simd_level() ) continue;
+        set_simd_level_limit( g_levels[l] );
+        timer.reset();
+        batch_inv_3( &S3[0], n, 0.0, &out[0] );
+        t_inv3 = timer.elapsed();
+        timer.reset();
+        batch_inv_4( &S4[0], n, 0.0, &out[0] );
+        t_inv4 = timer.elapsed();
+        timer.reset();
+        batch_axisangle_to_rotation( &SA[0], n, &R[0] );
+        batch_rotation_to_quaternion( &R[0], n, &out[0] );
+        t_rot = timer.elapsed();
+        printf("x %d [%-6s]: inv3 %8.4f inv4 %8.4f aa->R->q %8.4f sec\n", n,
+               simd_level_name(g_levels[l]).c_str(), t_inv3, t_inv4, t_rot );
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
@@ -0,0 +1,155 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/mem_manager.h>
+#include <kortex/mem_unit.h>
+#include <kortex/image.h>
+#include <kortex/timer.h>
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+using namespace kortex;
+
+void alignment_test();
+void memory_pool_test();
+void memory_pool_concurrency_test();
+void memory_pool_benchmark();
+
+int main(int argc, char **argv) {
+    alignment_test();
+    memory_pool_test();
+    memory_pool_concurrency_test();
+    memory_pool_benchmark();
+    release_log_man();
+}
+
+bool is_aligned( const void* ptr ) {
+    return ( uintptr_t(ptr) % MEMORY_ALIGNMENT ) == 0;
+}
+
+void alignment_test() {
+    bool passed = true;
+    const size_t sizes[] = { 1, 3, 17, 64, 100, 4099, 1<<20, 3000017 };
+    for( int i=0; i<8; i++ ) {
+        MemUnit m( sizes[i] );
+        if( !is_aligned( m.get_buffer() ) ) passed = false;
+        m.expand( 2*sizes[i]+5 );
+        if( !is_aligned( m.get_buffer() ) ) passed = false;
+        float* f = NULL;
+        allocate( f, sizes[i] );
+        if( !is_aligned( f ) ) passed = false;
+        deallocate( f );
+    }
+    for( int w=1; w<40; w+=7 ) {
+        Image img( w, 5, IT_U_GRAY );
+        if( !is_aligned( img.get_uptr() ) ) passed = false;
+    }
+    if( passed ) printf("%50s passed\n", "memory alignment" );
+    else         printf("%50s failed\n", "memory alignment" );
+}
+
+void memory_pool_test() {
+    bool passed = true;
+    enable_memory_pool( 64*1024*1024 );
+
+    // same sized frames reuse the released buffer
+    Image img( 640, 480, IT_U_PRGB );
+    const uchar* buf = img.get_uptr();
+    img.release();
+    if( memory_pool_cached_bytes() == 0 ) passed = false;
+    img.create( 640, 480, IT_U_PRGB );
+    if( img.get_uptr() != buf ) passed = false;
+    if( memory_pool_cached_bytes() != 0 ) passed = false;
+
+    // a slightly smaller request falls in the same size class
+    img.release();
+    img.create( 639, 480, IT_U_PRGB );
+    if( img.get_uptr() != buf ) passed = false;
+    memset( img.get_uptr(), 1, img.element_count() );
+    img.release();
+
+    // blocks beyond the cache limit are freed
+    MemUnit big( 128*1024*1024 );
+    big.deallocate();
+    if( memory_pool_cached_bytes() > 64*1024*1024 ) passed = false;
+
+    release_memory_pool();
+    if( memory_pool_cached_bytes() != 0 ) passed = false;
+
+    // blocks allocated with the pool enabled can be released after disabling
+    MemUnit m( 1000 );
+    disable_memory_pool();
+    m.deallocate();
+    if( memory_pool_cached_bytes() != 0 ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "memory pool" );
+    else         printf("%50s failed\n", "memory pool" );
+}
+
+/// allocations from several threads while the pool is switched on and off -
+/// once disable_memory_pool() returns the pool holds no blocks
+void memory_pool_concurrency_test() {
+    bool passed = true;
+    std::atomic<bool> done( false );
+    std::vector<std::thread> workers;
+    for( int t=0; t<4; t++ ) {
+        workers.push_back( std::thread( [&done]() {
+            while( !done ) {
+                MemUnit m( 4096 );
+                m.deallocate();
+            }
+        } ) );
+    }
+    for( int i=0; i<2000; i++ ) {
+        enable_memory_pool( 64*1024*1024 );
+        disable_memory_pool();
+        if( memory_pool_cached_bytes() != 0 ) passed = false;
+    }
+    done = true;
+    for( size_t t=0; t<workers.size(); t++ )
+        workers[t].join();
+    if( memory_pool_cached_bytes() != 0 ) passed = false;
+    if( passed ) printf("%50s passed\n", "memory pool disable under load" );
+    else         printf("%50s failed\n", "memory pool disable under load" );
+}
+
+double create_release_frames( int n ) {
+    Timer timer;
+    for( int i=0; i<n; i++ ) {
+        Image img( 4000, 3000, IT_U_PRGB );
+        img.zero();
+        Image tmp( 4000, 3000, IT_F_GRAY );
+        tmp.zero();
+    }
+    return timer.elapsed();
+}
+
+void memory_pool_benchmark() {
+    int n = 50;
+    double t_system = create_release_frames( n );
+    enable_memory_pool();
+    double t_pool   = create_release_frames( n );
+    disable_memory_pool();
+    printf("create/release 4000x3000 frames x %d: system %8.4f sec pool %8.4f sec\n", n, t_system, t_pool );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
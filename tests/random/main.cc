@@ -0,0 +1,339 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/random.h>
+#include <kortex/random_generator.h>
+#include <kortex/cpu_features.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <omp.h>
+
+using namespace kortex;
+using std::vector;
+
+void philox_known_answer_test();
+void bulk_fill_test();
+void thread_generator_test();
+void distribution_test();
+void sampling_test();
+void random_benchmark();
+
+int main(int argc, char **argv) {
+    philox_known_answer_test();
+    bulk_fill_test();
+    thread_generator_test();
+    distribution_test();
+    sampling_test();
+    random_benchmark();
+    release_log_man();
+}
+
+void philox_known_answer_test() {
+    // known answer vectors of the random123 distribution
+    bool passed = true;
+    const uint32_t c0[4] = { 0, 0, 0, 0 };
+    const uint32_t k0[2] = { 0, 0 };
+    const uint32_t r0[4] = { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 };
+    const uint32_t c1[4] = { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 };
+    const uint32_t k1[2] = { 0xa4093822, 0x299f31d0 };
+    const uint32_t r1[4] = { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 };
+    uint32_t out[4];
+    philox4x32( c0, k0, out );
+    for( int i=0; i<4; i++ ) if( out[i] != r0[i] ) passed = false;
+    philox4x32( c1, k1, out );
+    for( int i=0; i<4; i++ ) if( out[i] != r1[i] ) passed = false;
+    if( passed ) printf("%50s passed\n", "philox4x32 known answer" );
+    else         printf("%50s failed\n", "philox4x32 known answer" );
+}
+
+void bulk_fill_test() {
+    const SimdLevel levels[] = { SIMD_NONE, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 };
+    const size_t n = 5000;
+    // the low counter word wraps inside the run for the second start block
+    const uint64_t starts[] = { 0, uint64_t(UINT32_MAX) - 37 };
+    for( int l=0; l<4; l++ ) {
+        if( levels[l] > cpu_simd_level() ) continue;
+        set_simd_level_limit( levels[l] );
+        bool passed = true;
+        for( int s=0; s<2; s++ ) {
+            PhiloxGenerator single( 0x1234567890ULL, 77 );
+            PhiloxGenerator bulk  ( 0x1234567890ULL, 77 );
+            single.skip( starts[s] );
+            bulk  .skip( starts[s] );
+
+            // unaligned starts exercise the buffered words
+            vector<uint32_t> rv( n );
+            bulk.rv();
+            single.rv();
+            bulk.fill_rv( &rv[0], n );
+            for( size_t i=0; i<n; i++ )
+                if( rv[i] != single.rv() ) passed = false;
+
+            vector<double> ud( n ), nd( n+1 );
+            bulk.fill_uniform( &ud[0], n );
+            for( size_t i=0; i<n; i++ )
+                if( ud[i] != single.uniform_sample() ) passed = false;
+
+            single.normal_sample();
+            bulk  .normal_sample();
+            bulk.fill_normal( &nd[0], n+1 );
+            for( size_t i=0; i<n+1; i++ )
+                if( nd[i] != single.normal_sample() ) passed = false;
+
+            vector<float> uf( n ), nf( n );
+            bulk.fill_uniform( &uf[0], n );
+            for( size_t i=0; i<n; i++ )
+                if( uf[i] != single.uniform_sample_f() ) passed = false;
+            bulk.fill_normal( &nf[0], n );
+            for( size_t i=0; i<n; i++ )
+                if( nf[i] != float( single.normal_sample() ) ) passed = false;
+        }
+        char name[64];
+        sprintf( name, "bulk fill [%s]", simd_level_name(levels[l]).c_str() );
+        if( passed ) printf("%50s passed\n", name );
+        else         printf("%50s failed\n", name );
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+}
+
+void thread_generator_test() {
+    bool passed = true;
+    const int n = 4096;
+    vector<double> a( n ), b( n );
+
+    set_random_seed( 42 );
+#pragma omp parallel for schedule(static)
+    for( int i=0; i<n; i++ )
+        a[i] = uniform_sample();
+
+    set_random_seed( 42 );
+#pragma omp parallel for schedule(static)
+    for( int i=0; i<n; i++ )
+        b[i] = uniform_sample();
+
+    for( int i=0; i<n; i++ )
+        if( a[i] != b[i] ) passed = false;
+
+    // thread t draws stream t of the seed
+    set_random_seed( 42 );
+    PhiloxGenerator stream0( 42, 0 );
+    for( int i=0; i<16; i++ )
+        if( random_sample() != stream0.rv() ) passed = false;
+
+    // streams of the same seed differ
+    PhiloxGenerator g0( 42, 0 ), g1( 42, 1 );
+    int n_same = 0;
+    for( int i=0; i<1000; i++ )
+        if( g0.rv() == g1.rv() ) n_same++;
+    if( n_same > 2 ) passed = false;
+
+    // reseeding with a different seed changes the sequence
+    set_random_seed( 43 );
+    PhiloxGenerator seed43( 43, 0 );
+    if( random_sample() != seed43.rv() ) passed = false;
+
+    // threads outside openmp teams draw different sequences
+    vector<double> s0( 64 ), s1( 64 );
+    std::thread t0( [&s0]() { for( size_t i=0; i<s0.size(); i++ ) s0[i] = uniform_sample(); } );
+    std::thread t1( [&s1]() { for( size_t i=0; i<s1.size(); i++ ) s1[i] = uniform_sample(); } );
+    t0.join();
+    t1.join();
+    n_same = 0;
+    for( size_t i=0; i<s0.size(); i++ )
+        if( s0[i] == s1[i] ) n_same++;
+    if( n_same > 0 ) passed = false;
+
+    // so do the threads of nested teams
+    omp_set_max_active_levels( 2 );
+    vector<double> nested( 4 );
+#pragma omp parallel num_threads(2)
+    {
+#pragma omp parallel num_threads(2)
+        nested[ 2*omp_get_ancestor_thread_num(1) + omp_get_thread_num() ] = uniform_sample();
+    }
+    omp_set_max_active_levels( 1 );
+    for( int i=0; i<4; i++ )
+        for( int j=i+1; j<4; j++ )
+            if( nested[i] == nested[j] ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "thread generators" );
+    else         printf("%50s failed\n", "thread generators" );
+}
+
+void distribution_test() {
+    bool passed = true;
+    const size_t n = 1<<20;
+    vector<double> u( n ), z( n );
+    PhiloxGenerator gen( 7 );
+    gen.fill_uniform( &u[0], n );
+    gen.fill_normal ( &z[0], n );
+    double um = 0.0, uv = 0.0, zm = 0.0, zv = 0.0;
+    for( size_t i=0; i<n; i++ ) {
+        if( u[i] < 0.0 || u[i] >= 1.0 ) passed = false;
+        um += u[i];
+        zm += z[i];
+    }
+    um /= n;
+    zm /= n;
+    for( size_t i=0; i<n; i++ ) {
+        uv += ( u[i]-um ) * ( u[i]-um );
+        zv += ( z[i]-zm ) * ( z[i]-zm );
+    }
+    uv /= n;
+    zv /= n;
+    if( std::fabs( um - 0.5      ) > 2e-3 ) passed = false;
+    if( std::fabs( uv - 1.0/12.0 ) > 2e-3 ) passed = false;
+    if( std::fabs( zm            ) > 5e-3 ) passed = false;
+    if( std::fabs( zv - 1.0      ) > 5e-3 ) passed = false;
+
+    // box-muller against the libm functions
+    PhiloxGenerator ug( 8 ), ng( 8 );
+    double max_err = 0.0;
+    for( int i=0; i<100000; i++ ) {
+        double u1 = ug.uniform_sample();
+        double u2 = ug.uniform_sample();
+        double r  = std::sqrt( -2.0 * std::log( 1.0 - u1 ) );
+        double z0 = ng.normal_sample();
+        double z1 = ng.normal_sample();
+        max_err = std::max( max_err, std::fabs( z0 - r * std::cos( 6.283185307179586 * u2 ) ) );
+        max_err = std::max( max_err, std::fabs( z1 - r * std::sin( 6.283185307179586 * u2 ) ) );
+    }
+    if( max_err > 1e-13 ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "uniform/normal moments" );
+    else         printf("%50s failed\n", "uniform/normal moments" );
+}
+
+bool is_valid_selection( const int* sel, const int& n, const int& minval, const int& maxval ) {
+    vector<bool> seen( maxval-minval, false );
+    for( int i=0; i<n; i++ ) {
+        if( sel[i] < minval || sel[i] >= maxval ) return false;
+        if( seen[ sel[i]-minval ] ) return false;
+        seen[ sel[i]-minval ] = true;
+    }
+    return true;
+}
+
+void sampling_test() {
+    bool passed = true;
+    RandomSampler sampler;
+    set_random_seed( 5 );
+
+    // minimal samples - every value is selected equally often
+    const int n_draws = 200000;
+    vector<int> counts( 10, 0 );
+    int sel[4096];
+    for( int i=0; i<n_draws; i++ ) {
+        if( !sampler.select( 100, 110, 3, sel ) ) passed = false;
+        if( !is_valid_selection( sel, 3, 100, 110 ) ) passed = false;
+        for( int k=0; k<3; k++ ) counts[ sel[k]-100 ]++;
+    }
+    for( int v=0; v<10; v++ )
+        if( std::fabs( counts[v] / double(n_draws) - 0.3 ) > 0.005 ) passed = false;
+
+    // large samples through the scratch table, dense and sparse ranges
+    const int ks[]     = { 17, 500, 2048, 4096 };
+    const int ranges[] = { 17, 100000, 2049, 4096 };
+    for( int t=0; t<4; t++ ) {
+        for( int r=0; r<20; r++ ) {
+            if( !sampler.select( -7, ranges[t]-7, ks[t], sel ) ) passed = false;
+            if( !is_valid_selection( sel, ks[t], -7, ranges[t]-7 ) ) passed = false;
+        }
+    }
+    if( sampler.select( 0, 10, 11, sel ) ) passed = false;
+    if( !select_random_samples( 1<<30, (1<<30)+(1<<29), 8, sel ) ) passed = false;
+    for( int i=0; i<8; i++ ) {
+        if( sel[i] < (1<<30) ) passed = false;
+        for( int j=0; j<i; j++ )
+            if( sel[i] == sel[j] ) passed = false;
+    }
+
+    for( int i=0; i<100; i++ ) {
+        select_prosac_like_random_samples( i, 200, 4, sampler, sel );
+        if( !is_valid_selection( sel, 4, 0, std::min( 200, 32+i/2 ) ) ) passed = false;
+    }
+
+    // permutations
+    vector<int> perm;
+    random_permutation( 1000, perm );
+    if( perm.size() != 1000 || !is_valid_selection( &perm[0], 1000, 0, 1000 ) ) passed = false;
+    vector<int> first( 5, 0 );
+    for( int i=0; i<50000; i++ ) {
+        random_permutation( 5, perm );
+        first[ perm[0] ]++;
+    }
+    for( int v=0; v<5; v++ )
+        if( std::fabs( first[v] / 50000.0 - 0.2 ) > 0.01 ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "random sampling" );
+    else         printf("%50s failed\n", "random sampling" );
+}
+
+void random_benchmark() {
+    const size_t n = 1<<24;
+    vector<float> out( n );
+    Timer timer;
+
+    timer.reset();
+    RandomGenerator mt;
+    for( size_t i=0; i<n; i++ )
+        out[i] = float( mt.uniform_sample() );
+    double t_mt = timer.elapsed();
+
+    timer.reset();
+    PhiloxGenerator gen( 1 );
+    for( size_t i=0; i<n; i++ )
+        out[i] = gen.uniform_sample_f();
+    double t_single = timer.elapsed();
+
+    printf("uniform %zu floats: mt19937 %8.4f sec philox single %8.4f sec\n", n, t_mt, t_single );
+
+    const SimdLevel levels[] = { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };
+    for( int l=0; l<3; l++ ) {
+        if( levels[l] > cpu_simd_level() ) continue;
+        set_simd_level_limit( levels[l] );
+        timer.reset();
+        gen.fill_uniform( &out[0], n );
+        double t_u = timer.elapsed();
+        timer.reset();
+        gen.fill_normal( &out[0], n );
+        double t_n = timer.elapsed();
+        printf("philox fill [%-6s]: uniform %8.4f sec normal %8.4f sec\n",
+               simd_level_name(levels[l]).c_str(), t_u, t_n );
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+
+    RandomSampler sampler;
+    int sel[1000];
+    timer.reset();
+    for( int i=0; i<1000000; i++ )
+        sampler.select( 0, 5000, 4, sel );
+    double t_minimal = timer.elapsed();
+    timer.reset();
+    for( int i=0; i<10000; i++ )
+        sampler.select( 0, 1200, 1000, sel );
+    double t_dense = timer.elapsed();
+    printf("select 4 of 5000 x 1e6 %8.4f sec select 1000 of 1200 x 1e4 %8.4f sec\n", t_minimal, t_dense );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
@@ -0,0 +1,246 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/ransac.h>
+#include <kortex/ransac.tcc>
+#include <kortex/random_generator.h>
+#include <kortex/cpu_features.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using namespace kortex;
+using std::vector;
+
+void plane_test();
+void determinism_test();
+void sprt_test();
+void prosac_test();
+void ransac_benchmark();
+
+int main(int argc, char **argv) {
+    plane_test();
+    determinism_test();
+    sprt_test();
+    prosac_test();
+    ransac_benchmark();
+    release_log_man();
+}
+
+// points on the plane n.x = d with gaussian noise and uniform outliers in
+// the [-10,10]^3 cube. inliers are the first n_in points.
+void generate_plane_data( const int& n, const int& n_in, const float& noise, const uint64_t& seed,
+                          float plane[4], vector<float>& pnts ) {
+    PhiloxGenerator gen( seed );
+    float nrm[3] = { 0.3f, -0.5f, 0.8f };
+    float s = 1.0f / std::sqrt( nrm[0]*nrm[0] + nrm[1]*nrm[1] + nrm[2]*nrm[2] );
+    plane[0] = nrm[0]*s;
+    plane[1] = nrm[1]*s;
+    plane[2] = nrm[2]*s;
+    plane[3] = -2.0f;
+    pnts.resize( 3*size_t(n) );
+    for( int i=0; i<n; i++ ) {
+        float* X = &pnts[3*size_t(i)];
+        for( int k=0; k<3; k++ )
+            X[k] = float( 20.0 * gen.uniform_sample() - 10.0 );
+        if( i >= n_in ) continue;
+        float dist = plane[0]*X[0] + plane[1]*X[1] + plane[2]*X[2] + plane[3];
+        float e    = noise * float( gen.normal_sample() );
+        for( int k=0; k<3; k++ )
+            X[k] += ( e - dist ) * plane[k];
+    }
+}
+
+bool is_same_plane( const float a[4], const float b[4], const float& tol ) {
+    float sgn = ( a[0]*b[0] + a[1]*b[1] + a[2]*b[2] ) < 0.0f ? -1.0f : 1.0f;
+    for( int k=0; k<4; k++ )
+        if( std::fabs( a[k] - sgn*b[k] ) > tol ) return false;
+    return true;
+}
+
+void plane_test() {
+    bool passed = true;
+    const int n    = 20000;
+    const int n_in = 6000;
+    float gt[4];
+    vector<float> pnts;
+    generate_plane_data( n, n_in, 0.02f, 11, gt, pnts );
+
+    RansacParams params;
+    params.threshold = 0.1f;
+    params.seed      = 3;
+    float plane[4];
+    vector<int> inliers;
+    RansacStats stats;
+    if( !ransac_plane( &pnts[0], n, params, plane, inliers, &stats ) ) passed = false;
+    if( !is_same_plane( gt, plane, 5e-3f ) ) passed = false;
+    if( std::fabs( plane[0]*plane[0] + plane[1]*plane[1] + plane[2]*plane[2] - 1.0f ) > 1e-4f ) passed = false;
+    if( (int)inliers.size() != stats.n_inliers ) passed = false;
+    if( stats.n_inliers < n_in ) passed = false;
+    int n_true = 0;
+    for( size_t i=0; i<inliers.size(); i++ )
+        if( inliers[i] < n_in ) n_true++;
+    if( n_true < int( 0.99 * n_in ) ) passed = false;
+    if( stats.n_iterations >= params.max_iterations ) passed = false;
+
+    // all the points on a line are degenerate
+    vector<float> line( 3*100 );
+    for( int i=0; i<100; i++ ) {
+        line[3*i  ] = float(i);
+        line[3*i+1] = 2.0f*i;
+        line[3*i+2] = -1.0f*i;
+    }
+    params.max_iterations = 200;
+    if( ransac_plane( &line[0], 100, params, plane, inliers, &stats ) ) passed = false;
+    if( !inliers.empty() || stats.n_iterations != 200 ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "ransac plane" );
+    else         printf("%50s failed\n", "ransac plane" );
+}
+
+void determinism_test() {
+    bool passed = true;
+    const int n = 10000;
+    float gt[4];
+    vector<float> pnts;
+    generate_plane_data( n, 4000, 0.02f, 12, gt, pnts );
+
+    RansacParams params;
+    params.threshold  = 0.1f;
+    params.seed       = 9;
+    params.batch_size = 16;
+
+    float ref[4];
+    vector<int> ref_inliers;
+    RansacStats ref_stats;
+    params.run_parallel = false;
+    ransac_plane( &pnts[0], n, params, ref, ref_inliers, &ref_stats );
+
+    // the hypotheses do not depend on the thread count or the simd kernels
+    const SimdLevel levels[] = { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };
+    for( int l=0; l<3; l++ ) {
+        if( levels[l] > cpu_simd_level() ) continue;
+        set_simd_level_limit( levels[l] );
+        for( int par=0; par<2; par++ ) {
+            params.run_parallel = ( par == 1 );
+            float plane[4];
+            vector<int> inliers;
+            RansacStats stats;
+            ransac_plane( &pnts[0], n, params, plane, inliers, &stats );
+            if( !is_same_plane( ref, plane, 1e-4f ) ) passed = false;
+            if( stats.n_iterations != ref_stats.n_iterations ) passed = false;
+            if( std::abs( stats.n_inliers - ref_stats.n_inliers ) > 2 ) passed = false;
+        }
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+
+    if( passed ) printf("%50s passed\n", "ransac determinism" );
+    else         printf("%50s failed\n", "ransac determinism" );
+}
+
+void sprt_test() {
+    bool passed = true;
+    const int n = 50000;
+    float gt[4];
+    vector<float> pnts;
+    generate_plane_data( n, 10000, 0.02f, 13, gt, pnts );
+
+    RansacParams params;
+    params.threshold = 0.1f;
+    params.seed      = 21;
+
+    float p0[4], p1[4];
+    vector<int> in0, in1;
+    RansacStats s0, s1;
+    params.sprt = false;
+    ransac_plane( &pnts[0], n, params, p0, in0, &s0 );
+    params.sprt = true;
+    ransac_plane( &pnts[0], n, params, p1, in1, &s1 );
+
+    if( s0.n_rejected != 0 ) passed = false;
+    if( s1.n_rejected == 0 ) passed = false;
+    if( !is_same_plane( gt, p0, 5e-3f ) ) passed = false;
+    if( !is_same_plane( gt, p1, 5e-3f ) ) passed = false;
+    if( std::abs( s0.n_inliers - s1.n_inliers ) > n/1000 ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "ransac sprt" );
+    else         printf("%50s failed\n", "ransac sprt" );
+}
+
+void prosac_test() {
+    bool passed = true;
+    const int n = 20000;
+    float gt[4];
+    vector<float> pnts;
+    // only 10% inliers but they are ranked first
+    generate_plane_data( n, 2000, 0.02f, 14, gt, pnts );
+
+    RansacParams params;
+    params.threshold = 0.1f;
+    params.seed      = 5;
+    params.prosac    = true;
+
+    float plane[4];
+    vector<int> inliers;
+    RansacStats stats;
+    if( !ransac_plane( &pnts[0], n, params, plane, inliers, &stats ) ) passed = false;
+    if( !is_same_plane( gt, plane, 5e-3f ) ) passed = false;
+
+    RansacStats plain;
+    params.prosac = false;
+    ransac_plane( &pnts[0], n, params, plane, inliers, &plain );
+    if( stats.n_iterations > plain.n_iterations ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "ransac prosac" );
+    else         printf("%50s failed\n", "ransac prosac" );
+}
+
+void ransac_benchmark() {
+    const int n = 1<<20;
+    float gt[4];
+    vector<float> pnts;
+    generate_plane_data( n, n/4, 0.02f, 15, gt, pnts );
+
+    RansacParams params;
+    params.threshold = 0.1f;
+    params.seed      = 1;
+
+    Timer timer;
+    const SimdLevel levels[] = { SIMD_NONE, SIMD_AVX2, SIMD_AVX512 };
+    for( int l=0; l<3; l++ ) {
+        if( levels[l] > cpu_simd_level() ) continue;
+        set_simd_level_limit( levels[l] );
+        for( int s=0; s<2; s++ ) {
+            params.sprt = ( s == 1 );
+            float plane[4];
+            vector<int> inliers;
+            RansacStats stats;
+            timer.reset();
+            ransac_plane( &pnts[0], n, params, plane, inliers, &stats );
+            double t = timer.elapsed();
+            printf("ransac plane %d pnts [%-6s] sprt %d: %8.4f sec [iter %d] [rejected %d] [inliers %d]\n",
+                   n, simd_level_name(levels[l]).c_str(), s, t, stats.n_iterations, stats.n_rejected,
+                   stats.n_inliers );
+        }
+    }
+    set_simd_level_limit( SIMD_AVX512 );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
@@ -0,0 +1,337 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/resample.h>
+#include <kortex/image.h>
+#include <kortex/image_processing.h>
+#include <kortex/cpu_features.h>
+#include <kortex/timer.h>
+
+#include <cstdio>
+#include <cmath>
+
+using namespace kortex;
+
+void resample_test();
+void resample_benchmark();
+void sample_test();
+void sample_benchmark();
+
+int main(int argc, char **argv) {
+    resample_test();
+    sample_test();
+    resample_benchmark();
+    sample_benchmark();
+    release_log_man();
+}
+
+void random_image( int w, int h, int nc, vector<float>& im ) {
+    im.resize( size_t(w)*size_t(h)*size_t(nc) );
+    unsigned int s = 17;
+    for( size_t i=0; i<im.size(); i++ ) {
+        s = s*1664525u + 1013904223u;
+        im[i] = float( s>>8 ) / float( 1<<24 );
+    }
+}
+
+/// 1d weights of a sample at s, written for the clamped source indices
+void reference_weights( int n, double s, bool bicubic, vector<double>& wt ) {
+    wt.assign( n, 0.0 );
+    int    f = int( std::floor(s) );
+    double t = s-f;
+    if( !bicubic ) {
+        wt[ std::min(std::max(f,  0),n-1) ] += 1.0-t;
+        wt[ std::min(std::max(f+1,0),n-1) ] += t;
+        return;
+    }
+    double w[4] = { 0.5*(-t+2*t*t-t*t*t), 0.5*(2-5*t*t+3*t*t*t), 0.5*(t+4*t*t-3*t*t*t), 0.5*(-t*t+t*t*t) };
+    for( int k=0; k<4; k++ )
+        wt[ std::min(std::max(f-1+k,0),n-1) ] += w[k];
+}
+
+void reference_resample( const vector<float>& im, int w, int h, int nc, bool bicubic, int nw, int nh, vector<float>& out ) {
+    out.assign( size_t(nw)*nh*nc, 0.0f );
+    vector<double> wx, wy;
+    for( int y=0; y<nh; y++ ) {
+        reference_weights( h, (y+0.5)*double(h)/nh-0.5, bicubic, wy );
+        for( int x=0; x<nw; x++ ) {
+            reference_weights( w, (x+0.5)*double(w)/nw-0.5, bicubic, wx );
+            for( int c=0; c<nc; c++ ) {
+                double sum = 0.0;
+                for( int yy=0; yy<h; yy++ ) {
+                    if( wy[yy] == 0.0 ) continue;
+                    for( int xx=0; xx<w; xx++ )
+                        sum += wy[yy]*wx[xx]*im[ (size_t(yy)*w+xx)*nc+c ];
+                }
+                out[ (size_t(y)*nw+x)*nc+c ] = float(sum);
+            }
+        }
+    }
+}
+
+float max_abs_difference( const vector<float>& a, const vector<float>& b ) {
+    float d = 0.0f;
+    for( size_t i=0; i<a.size(); i++ )
+        d = std::max( d, std::fabs(a[i]-b[i]) );
+    return d;
+}
+
+void resample_level_test( const SimdLevel& level ) {
+    set_simd_level_limit( level );
+    const int sizes[][4] = { {1,1,3,2}, {17,13,40,29}, {64,48,31,17}, {50,40,50,40}, {37,23,9,5} };
+    bool passed = true;
+    for( int s=0; s<5; s++ ) {
+        int w  = sizes[s][0], h  = sizes[s][1];
+        int nw = sizes[s][2], nh = sizes[s][3];
+        for( int nc=1; nc<=3; nc+=2 ) {
+            vector<float> im, ref, out( size_t(nw)*nh*nc );
+            random_image( w, h, nc, im );
+            for( int b=0; b<2; b++ ) {
+                reference_resample( im, w, h, nc, b==1, nw, nh, ref );
+                resample( &im[0], w, h, nc, b==1 ? RS_BICUBIC : RS_BILINEAR, nw, nh, &out[0] );
+                if( max_abs_difference(ref, out) > 1e-4f ) passed = false;
+                resample_par( &im[0], w, h, nc, b==1 ? RS_BICUBIC : RS_BILINEAR, nw, nh, &out[0] );
+                if( max_abs_difference(ref, out) > 1e-4f ) passed = false;
+            }
+        }
+    }
+    string str = "resample [" + simd_level_name(level) + "]";
+    if( passed ) printf("%50s passed\n", str.c_str() );
+    else         printf("%50s failed\n", str.c_str() );
+}
+
+/// integer factor area downscaling is the block mean - fractional factors
+/// preserve the mean of a constant image
+void resample_area_test() {
+    bool passed = true;
+    int w = 64, h = 36;
+    vector<float> im, out( 16*9 );
+    random_image( w, h, 1, im );
+    resample( &im[0], w, h, 1, RS_AREA, 16, 9, &out[0] );
+    for( int y=0; y<9; y++ ) {
+        for( int x=0; x<16; x++ ) {
+            double sum = 0.0;
+            for( int yy=0; yy<4; yy++ )
+                for( int xx=0; xx<4; xx++ )
+                    sum += im[ (4*y+yy)*w + 4*x+xx ];
+            if( std::fabs( sum/16.0 - out[y*16+x] ) > 1e-5 ) passed = false;
+        }
+    }
+    vector<float> cim( 101*77, 0.3f ), cout( 13*10 );
+    resample( &cim[0], 101, 77, 1, RS_AREA, 13, 10, &cout[0] );
+    for( size_t i=0; i<cout.size(); i++ )
+        if( std::fabs( cout[i]-0.3f ) > 1e-5f ) passed = false;
+
+    if( passed ) printf("%50s passed\n", "resample area" );
+    else         printf("%50s failed\n", "resample area" );
+}
+
+/// uchar and channel layouts through image_resize
+void image_resize_test() {
+    bool passed = true;
+    int w = 83, h = 61, nw = 40, nh = 100;
+    vector<float> im;
+    random_image( w, h, 3, im );
+    Image fp( w, h, IT_F_PRGB ), up( w, h, IT_U_PRGB ), fi( w, h, IT_F_IRGB );
+    for( int y=0; y<h; y++ ) {
+        for( int x=0; x<w; x++ ) {
+            const float* p = &im[ (size_t(y)*w+x)*3 ];
+            fp.set( x, y, p[0], p[1], p[2] );
+            up.set( x, y, uchar(255*p[0]), uchar(255*p[1]), uchar(255*p[2]) );
+            fi.set( x, y, p[0], p[1], p[2] );
+        }
+    }
+    Image fpo, upo, fio;
+    image_resize( fp, nw, nh, RS_BICUBIC, false, fpo );
+    image_resize( up, nw, nh, RS_BICUBIC, true,  upo );
+    image_resize( fi, nw, nh, RS_BICUBIC, false, fio );
+    for( int y=0; y<nh; y++ ) {
+        for( int x=0; x<nw; x++ ) {
+            float r0, g0, b0, r1, g1, b1;
+            uchar ur, ug, ub;
+            fpo.get( x, y, r0, g0, b0 );
+            fio.get( x, y, r1, g1, b1 );
+            upo.get( x, y, ur, ug, ub );
+            if( std::fabs(r0-r1) > 1e-6f || std::fabs(g0-g1) > 1e-6f || std::fabs(b0-b1) > 1e-6f ) passed = false;
+            float rc = std::min( std::max( 255.0f*r0, 0.0f ), 255.0f );
+            if( std::fabs( rc - ur ) > 2.0f ) passed = false;
+        }
+    }
+    if( passed ) printf("%50s passed\n", "image_resize" );
+    else         printf("%50s failed\n", "image_resize" );
+}
+
+void resample_test() {
+    for( int l=SIMD_NONE; l<=cpu_simd_level(); l++ )
+        resample_level_test( (SimdLevel)l );
+    set_simd_level_limit( SIMD_AVX512 );
+    resample_area_test();
+    image_resize_test();
+}
+
+void resample_benchmark() {
+    int w = 4000;
+    int h = 3000;
+    Image img( w, h, IT_U_PRGB );
+    uchar* data = img.get_uptr();
+    for( size_t i=0; i<img.element_count(); i++ )
+        data[i] = uchar( (i*7919) % 251 );
+    Image out;
+    const ResampleMethod methods[] = { RS_BILINEAR, RS_BICUBIC, RS_AREA };
+    const char*          names  [] = { "bilinear", "bicubic", "area" };
+    for( int m=0; m<3; m++ ) {
+        Timer timer;
+        image_resize( img, 320, 240, methods[m], false, out );
+        printf("image_resize [%dx%d prgb] -> [320x240] [%-8s] %8.4f sec\n", w, h, names[m], timer.elapsed() );
+    }
+    Timer timer;
+    image_resize( img, 2*w/3, 2*h/3, RS_BICUBIC, false, out );
+    printf("image_resize [%dx%d prgb] -> [%dx%d] [%-8s] %8.4f sec\n", w, h, 2*w/3, 2*h/3, "bicubic", timer.elapsed() );
+}
+
+void random_points( int n, float xmin, float xmax, float ymin, float ymax, vector<float>& xs, vector<float>& ys ) {
+    vector<float> u;
+    random_image( n, 2, 1, u );
+    xs.resize( n );
+    ys.resize( n );
+    for( int i=0; i<n; i++ ) {
+        xs[i] = xmin + u[i  ]*( xmax-xmin );
+        ys[i] = ymin + u[n+i]*( ymax-ymin );
+    }
+    // integer and last valid coordinates
+    xs[0] = xmin; ys[0] = ymin;
+    xs[1] = xmax; ys[1] = ymax;
+    xs[2] = float( int(xs[2]) );
+}
+
+void fill_image( Image& img ) {
+    vector<float> v;
+    random_image( img.w(), img.h(), img.ch(), v );
+    for( int y=0; y<img.h(); y++ ) {
+        for( int x=0; x<img.w(); x++ ) {
+            const float* p = &v[ (size_t(y)*img.w()+x)*img.ch() ];
+            if( img.ch() == 1 ) {
+                if( img.precision() == TYPE_UCHAR ) img.set( x, y, uchar(255*p[0]) );
+                else                                img.set( x, y, p[0] );
+            } else {
+                if( img.precision() == TYPE_UCHAR ) img.set( x, y, uchar(255*p[0]), uchar(255*p[1]), uchar(255*p[2]) );
+                else                                img.set( x, y, p[0], p[1], p[2] );
+            }
+        }
+    }
+}
+
+/// batched sampling against the per-point get_bilinear / get_bicubic
+bool sample_image_test( const Image& img, bool bicubic, int n ) {
+    int   nc  = img.ch();
+    float tol = img.precision() == TYPE_UCHAR ? 1e-3f : 1e-5f;
+    float mg  = bicubic ? 2.0f : 0.0f;
+    vector<float> xs, ys, out( size_t(n)*nc );
+    random_points( n, mg, img.w()-1-mg-1e-3f, mg, img.h()-1-mg-1e-3f, xs, ys );
+    if( bicubic ) img.get_bicubic ( &xs[0], &ys[0], n, &out[0] );
+    else          img.get_bilinear( &xs[0], &ys[0], n, &out[0] );
+    for( int i=0; i<n; i++ ) {
+        float v[3];
+        if( nc == 1 ) {
+            v[0] = bicubic ? img.get_bicubic( xs[i], ys[i] ) : img.get_bilinear( xs[i], ys[i] );
+        } else {
+            if( bicubic ) img.get_bicubic ( xs[i], ys[i], v[0], v[1], v[2] );
+            else          img.get_bilinear( xs[i], ys[i], v[0], v[1], v[2] );
+        }
+        for( int c=0; c<nc; c++ )
+            if( std::fabs( v[c]-out[i*nc+c] ) > tol ) return false;
+    }
+    return true;
+}
+
+/// out of range coordinates are clamped to the image
+bool sample_clamp_test( const Image& img, bool bicubic ) {
+    const float xs[] = { -5.0f, 1e6f, -1.0f, 3.5f, 1e6f, 0.5f, -0.1f, 2.5f, 1.5f };
+    const float ys[] = { -5.0f, 1e6f,  2.5f, -3.0f, 0.5f, 1e6f, 1.5f, -0.1f, 1.5f };
+    int n  = 9;
+    int nc = img.ch();
+    vector<float> cx( n ), cy( n ), out( n*nc ), ref( n*nc );
+    for( int i=0; i<n; i++ ) {
+        cx[i] = std::min( std::max( xs[i], 0.0f ), float(img.w()-1) );
+        cy[i] = std::min( std::max( ys[i], 0.0f ), float(img.h()-1) );
+    }
+    if( bicubic ) { img.get_bicubic ( xs, ys, n, &out[0] ); img.get_bicubic ( &cx[0], &cy[0], n, &ref[0] ); }
+    else          { img.get_bilinear( xs, ys, n, &out[0] ); img.get_bilinear( &cx[0], &cy[0], n, &ref[0] ); }
+    return max_abs_difference( out, ref ) == 0.0f;
+}
+
+void sample_level_test( const SimdLevel& level ) {
+    set_simd_level_limit( level );
+    const ImageType types[] = { IT_U_GRAY, IT_F_GRAY, IT_U_PRGB, IT_F_PRGB, IT_U_IRGB, IT_F_IRGB };
+    const int       sizes[][2] = { {61,47}, {8,7}, {3,2} };
+    bool passed = true;
+    for( int t=0; t<6; t++ ) {
+        for( int s=0; s<3; s++ ) {
+            Image img( sizes[s][0], sizes[s][1], types[t] );
+            fill_image( img );
+            for( int b=0; b<2; b++ ) {
+                if( b == 1 && img.w() > 5 && !sample_image_test( img, true, 1001 ) ) passed = false;
+                if( b == 0 && !sample_image_test( img, false, 1001 ) ) passed = false;
+                if( !sample_clamp_test( img, b==1 ) ) passed = false;
+            }
+        }
+    }
+    string str = "image sample [" + simd_level_name(level) + "]";
+    if( passed ) printf("%50s passed\n", str.c_str() );
+    else         printf("%50s failed\n", str.c_str() );
+}
+
+void sample_test() {
+    for( int l=SIMD_NONE; l<=cpu_simd_level(); l++ )
+        sample_level_test( (SimdLevel)l );
+    set_simd_level_limit( SIMD_AVX512 );
+}
+
+void sample_benchmark() {
+    int n = 1<<20;
+    const ImageType types[] = { IT_U_GRAY, IT_F_GRAY, IT_U_PRGB };
+    for( int t=0; t<3; t++ ) {
+        Image img( 1024, 768, types[t] );
+        fill_image( img );
+        vector<float> xs, ys, out( size_t(n)*img.ch() );
+        random_points( n, 2.0f, img.w()-3.0f, 2.0f, img.h()-3.0f, xs, ys );
+        for( int b=0; b<2; b++ ) {
+            const char* name = b ? "bicubic" : "bilinear";
+            float sum = 0.0f;
+            Timer timer;
+            for( int i=0; i<n; i++ ) {
+                if( img.ch() == 1 ) {
+                    sum += b ? img.get_bicubic( xs[i], ys[i] ) : img.get_bilinear( xs[i], ys[i] );
+                } else {
+                    float r, g, bl;
+                    if( b ) img.get_bicubic ( xs[i], ys[i], r, g, bl );
+                    else    img.get_bilinear( xs[i], ys[i], r, g, bl );
+                    sum += r+g+bl;
+                }
+            }
+            double t_point = timer.elapsed();
+            timer.reset();
+            if( b ) img.get_bicubic ( &xs[0], &ys[0], n, &out[0] );
+            else    img.get_bilinear( &xs[0], &ys[0], n, &out[0] );
+            double t_batch = timer.elapsed();
+            printf("sample [%-10s] [%-8s] %d points: per point %8.4f sec batch %8.4f sec %s\n",
+                   image_type_name(types[t]).c_str(), name, n, t_point, t_batch, sum == 0.0f ? "*" : "" );
+        }
+    }
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
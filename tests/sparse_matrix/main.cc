@@ -0,0 +1,335 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/sparse_matrix.h>
+#include <kortex/random_generator.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using namespace kortex;
+using std::vector;
+
+void construction_test();
+void cg_test();
+void lsqr_test();
+void solver_benchmark();
+
+int main(int argc, char **argv) {
+    construction_test();
+    cg_test();
+    lsqr_test();
+    solver_benchmark();
+    release_log_man();
+}
+
+double max_diff( const double* a, const double* b, const size_t& n ) {
+    double d = 0.0;
+    for( size_t i=0; i<n; i++ )
+        d = std::max( d, std::fabs( a[i]-b[i] ) );
+    return d;
+}
+
+double norm( const vector<double>& a ) {
+    double s = 0.0;
+    for( size_t i=0; i<a.size(); i++ )
+        s += a[i]*a[i];
+    return std::sqrt( s );
+}
+
+void dense_mult( const vector<double>& D, const int& nr, const int& nc, const bool& trans,
+                 const double* x, double* y ) {
+    for( int i=0; i<( trans ? nc : nr ); i++ ) {
+        double s = 0.0;
+        for( int j=0; j<( trans ? nr : nc ); j++ )
+            s += ( trans ? D[ size_t(j)*nc+i ] : D[ size_t(i)*nc+j ] ) * x[j];
+        y[i] = s;
+    }
+}
+
+void construction_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 1 );
+    const int nr = 37, nc = 23;
+    vector<SparseTriplet> triplets;
+    vector<double> D( nr*nc, 0.0 );
+    for( int t=0; t<300; t++ ) {
+        // repeated entries are summed
+        int r = int( nr * gen.uniform_sample() ) % nr;
+        int c = int( nc * gen.uniform_sample() ) % nc;
+        double v = gen.normal_sample();
+        triplets.push_back( SparseTriplet( r, c, v ) );
+        D[ r*nc+c ] += v;
+    }
+    vector<double> x( nr ), y( nr ), yd( nr ), xt( nc ), yt( nc ), ytd( nc ), B( nr*nc );
+    for( int i=0; i<nr; i++ ) x [i] = gen.normal_sample();
+    for( int i=0; i<nc; i++ ) xt[i] = gen.normal_sample();
+    dense_mult( D, nr, nc, false, &xt[0], &yd [0] );
+    dense_mult( D, nr, nc, true,  &x [0], &ytd[0] );
+
+    const SparseStorage storages[] = { SPARSE_CSR, SPARSE_CSC };
+    for( int s=0; s<2; s++ ) {
+        SparseMatrix A, C, At;
+        A.init( nr, nc, triplets, storages[s] );
+        A.to_dense( &B[0] );
+        if( max_diff( &B[0], &D[0], B.size() ) > 1e-14 ) passed = false;
+        for( int r=0; r<nr; r++ )
+            for( int c=0; c<nc; c++ )
+                if( A.get( r, c ) != B[ r*nc+c ] ) passed = false;
+        for( int i=0; i<( s ? nc : nr ); i++ )
+            for( int p=A.ptr()[i]+1; p<A.ptr()[i+1]; p++ )
+                if( A.idx()[p-1] >= A.idx()[p] ) passed = false;
+
+        A.mult      ( &xt[0], &y [0] );
+        A.mult_trans( &x [0], &yt[0] );
+        if( max_diff( &y [0], &yd [0], nr ) > 1e-12 ) passed = false;
+        if( max_diff( &yt[0], &ytd[0], nc ) > 1e-12 ) passed = false;
+
+        // the other format and the transpose
+        A.convert( storages[1-s], C );
+        C.mult( &xt[0], &y[0] );
+        if( C.storage() != storages[1-s] || C.nnz() != A.nnz() ) passed = false;
+        if( max_diff( &y[0], &yd[0], nr ) > 1e-12 ) passed = false;
+        A.transpose( At );
+        At.mult( &x[0], &yt[0] );
+        if( At.rows() != nc || At.cols() != nr ) passed = false;
+        if( max_diff( &yt[0], &ytd[0], nc ) > 1e-12 ) passed = false;
+
+        // round trip through the raw arrays
+        SparseMatrix R;
+        R.init( nr, nc, A.storage(), A.ptr(), A.idx(), A.val() );
+        R.to_dense( &B[0] );
+        if( max_diff( &B[0], &D[0], B.size() ) > 1e-14 ) passed = false;
+    }
+    if( passed ) printf("%50s passed\n", "sparse matrix construction/products" );
+    else         printf("%50s failed\n", "sparse matrix construction/products" );
+}
+
+// 5-point laplacian on a w x h grid with a small diagonal term - the poisson
+// blending system
+void laplacian( const int& w, const int& h, const double& eps, const SparseStorage& storage,
+                SparseMatrix& A ) {
+    vector<SparseTriplet> t;
+    t.reserve( size_t(5)*w*h );
+    for( int y=0; y<h; y++ ) {
+        for( int x=0; x<w; x++ ) {
+            int i = y*w+x;
+            double d = eps;
+            const int nx[4] = { x-1, x+1, x,   x   };
+            const int ny[4] = { y,   y,   y-1, y+1 };
+            for( int k=0; k<4; k++ ) {
+                if( nx[k] < 0 || nx[k] >= w || ny[k] < 0 || ny[k] >= h ) continue;
+                t.push_back( SparseTriplet( i, ny[k]*w+nx[k], -1.0 ) );
+                d += 1.0;
+            }
+            t.push_back( SparseTriplet( i, i, d ) );
+        }
+    }
+    A.init( w*h, w*h, t, storage );
+}
+
+void cg_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 2 );
+    const int w = 60, h = 50, n = w*h;
+    vector<double> xt( n ), b( n ), x( n ), r( n );
+    for( int i=0; i<n; i++ )
+        xt[i] = gen.normal_sample();
+
+    const SparseStorage storages[] = { SPARSE_CSR, SPARSE_CSC };
+    const SparsePreconditioner pcs[] = { PRECONDITIONER_NONE, PRECONDITIONER_JACOBI, PRECONDITIONER_ICHOL };
+    for( int s=0; s<2; s++ ) {
+        SparseMatrix A;
+        laplacian( w, h, 1e-2, storages[s], A );
+        A.mult( &xt[0], &b[0] );
+        int prev_iterations = 1<<30;
+        for( int p=0; p<3; p++ ) {
+            IterativeSolverParams params;
+            params.tolerance      = 1e-10;
+            params.max_iterations = 5000;
+            params.preconditioner = pcs[p];
+            IterativeSolverStats stats;
+            x.assign( n, 0.0 );
+            bool ok = ( p == 0 ) ? sparse_solver_cg ( A, &b[0], &x[0], params, &stats )
+                                 : sparse_solver_pcg( A, &b[0], &x[0], params, &stats );
+            if( !ok || !stats.converged ) passed = false;
+            A.mult( &x[0], &r[0] );
+            for( int i=0; i<n; i++ ) r[i] -= b[i];
+            if( norm( r ) > 1e-9 * norm( b ) ) passed = false;
+            if( max_diff( &x[0], &xt[0], n ) > 1e-6 ) passed = false;
+            // incomplete cholesky needs fewer iterations than plain cg
+            if( p == 2 && stats.n_iterations >= prev_iterations ) passed = false;
+            if( p == 0 ) prev_iterations = stats.n_iterations;
+        }
+    }
+
+    // the initial guess is used
+    SparseMatrix A;
+    laplacian( w, h, 1e-2, SPARSE_CSR, A );
+    A.mult( &xt[0], &b[0] );
+    IterativeSolverParams params;
+    IterativeSolverStats  stats;
+    x = xt;
+    sparse_solver_pcg( A, &b[0], &x[0], params, &stats );
+    if( stats.n_iterations != 0 || !stats.converged ) passed = false;
+
+    // incomplete cholesky of matrices it can not factor returns - a negative
+    // diagonal falls back to jacobi, an indefinite matrix is shifted
+    vector<SparseTriplet> t;
+    t.push_back( SparseTriplet( 0, 0, -1.0 ) );
+    t.push_back( SparseTriplet( 1, 1,  2.0 ) );
+    SparseMatrix N;
+    N.init( 2, 2, t, SPARSE_CSR );
+    t.clear();
+    t.push_back( SparseTriplet( 0, 0, 1.0 ) );
+    t.push_back( SparseTriplet( 0, 1, 2.0 ) );
+    t.push_back( SparseTriplet( 1, 0, 2.0 ) );
+    t.push_back( SparseTriplet( 1, 1, 1.0 ) );
+    SparseMatrix I;
+    I.init( 2, 2, t, SPARSE_CSR );
+    const double b2[2] = { 1.0, 1.0 };
+    double       x2[2];
+    params.preconditioner = PRECONDITIONER_ICHOL;
+    x2[0] = x2[1] = 0.0;
+    sparse_solver_pcg( N, b2, x2, params, &stats );
+    x2[0] = x2[1] = 0.0;
+    sparse_solver_pcg( I, b2, x2, params, &stats );
+
+    if( passed ) printf("%50s passed\n", "cg/pcg" );
+    else         printf("%50s failed\n", "cg/pcg" );
+}
+
+void random_sparse( PhiloxGenerator& gen, const int& nr, const int& nc, const int& per_row,
+                    const SparseStorage& storage, SparseMatrix& A ) {
+    vector<SparseTriplet> t;
+    for( int r=0; r<nr; r++ ) {
+        t.push_back( SparseTriplet( r, r%nc, 1.0 + gen.uniform_sample() ) );
+        for( int k=1; k<per_row; k++ )
+            t.push_back( SparseTriplet( r, int( nc*gen.uniform_sample() ) % nc, gen.normal_sample() ) );
+    }
+    A.init( nr, nc, t, storage );
+}
+
+void lsqr_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 3 );
+    const int m = 400, n = 150;
+    const SparseStorage storages[] = { SPARSE_CSR, SPARSE_CSC };
+    for( int s=0; s<2; s++ ) {
+        SparseMatrix A;
+        random_sparse( gen, m, n, 5, storages[s], A );
+        vector<double> xt( n ), b( m ), x( n ), r( m ), g( n );
+        for( int i=0; i<n; i++ )
+            xt[i] = gen.normal_sample();
+
+        // consistent system
+        A.mult( &xt[0], &b[0] );
+        IterativeSolverParams params;
+        params.tolerance = 1e-12;
+        IterativeSolverStats stats;
+        x.assign( n, 0.0 );
+        if( !sparse_solver_lsqr( A, &b[0], &x[0], params, &stats ) ) passed = false;
+        if( max_diff( &x[0], &xt[0], n ) > 1e-8 ) passed = false;
+
+        // inconsistent and damped - the normal equations
+        // A'(b-Ax) = damp^2 x hold at the solution
+        for( int i=0; i<m; i++ )
+            b[i] += gen.normal_sample();
+        for( int d=0; d<2; d++ ) {
+            params.damp = d ? 0.5 : 0.0;
+            x.assign( n, 0.0 );
+            if( !sparse_solver_lsqr( A, &b[0], &x[0], params, &stats ) ) passed = false;
+            A.mult( &x[0], &r[0] );
+            for( int i=0; i<m; i++ ) r[i] = b[i] - r[i];
+            A.mult_trans( &r[0], &g[0] );
+            for( int i=0; i<n; i++ ) g[i] -= params.damp*params.damp*x[i];
+            if( norm( g ) > 1e-9 * norm( b ) ) passed = false;
+            double rn = norm( r ), xn = norm( x );
+            if( std::fabs( stats.residual - std::sqrt( rn*rn + params.damp*params.damp*xn*xn ) ) > 1e-8 * rn )
+                passed = false;
+        }
+    }
+    if( passed ) printf("%50s passed\n", "lsqr" );
+    else         printf("%50s failed\n", "lsqr" );
+}
+
+void solver_benchmark() {
+    PhiloxGenerator gen( 4 );
+    Timer timer;
+    // poisson blending sized system
+    const int w = 1000, h = 1000, n = w*h;
+    SparseMatrix A;
+    laplacian( w, h, 1e-3, SPARSE_CSR, A );
+    vector<double> xt( n ), b( n ), x( n ), y( n );
+    for( int i=0; i<n; i++ )
+        xt[i] = gen.normal_sample();
+    A.mult( &xt[0], &b[0] );
+
+    timer.reset();
+    for( int t=0; t<100; t++ )
+        A.mult( &xt[0], &y[0] );
+    printf("%d x %d laplacian ( %zu nnz ): 100 spmv %8.4f sec\n", n, n, A.nnz(), timer.elapsed() );
+
+    const SparsePreconditioner pcs[] = { PRECONDITIONER_NONE, PRECONDITIONER_JACOBI, PRECONDITIONER_ICHOL };
+    const char* names[] = { "cg", "pcg jacobi", "pcg ichol" };
+    for( int p=0; p<3; p++ ) {
+        IterativeSolverParams params;
+        params.tolerance      = 1e-6;
+        params.max_iterations = 10000;
+        params.preconditioner = pcs[p];
+        IterativeSolverStats stats;
+        x.assign( n, 0.0 );
+        timer.reset();
+        sparse_solver_pcg( A, &b[0], &x[0], params, &stats );
+        printf("%-12s: %5d iterations %8.4f sec residual %g\n", names[p], stats.n_iterations,
+               timer.elapsed(), stats.residual );
+    }
+
+    // smoothness regularized depth - sparse depth samples and gradient terms
+    vector<SparseTriplet> t;
+    vector<double> d;
+    const int dw = 512, dh = 512;
+    for( int i=0; i<dw*dh; i++ ) {
+        if( gen.uniform_sample() < 0.05 ) {
+            t.push_back( SparseTriplet( (int)d.size(), i, 1.0 ) );
+            d.push_back( 1.0 + 0.1*gen.normal_sample() );
+        }
+    }
+    for( int yy=0; yy<dh; yy++ ) {
+        for( int xx=0; xx<dw; xx++ ) {
+            int i = yy*dw+xx;
+            if( xx+1 < dw ) { int r = (int)d.size(); t.push_back( SparseTriplet( r, i, -1.0 ) ); t.push_back( SparseTriplet( r, i+1,  1.0 ) ); d.push_back( 0.0 ); }
+            if( yy+1 < dh ) { int r = (int)d.size(); t.push_back( SparseTriplet( r, i, -1.0 ) ); t.push_back( SparseTriplet( r, i+dw, 1.0 ) ); d.push_back( 0.0 ); }
+        }
+    }
+    SparseMatrix L;
+    L.init( (int)d.size(), dw*dh, t, SPARSE_CSR );
+    IterativeSolverParams params;
+    params.tolerance      = 1e-6;
+    params.max_iterations = 20000;
+    IterativeSolverStats stats;
+    vector<double> z( dw*dh, 0.0 );
+    timer.reset();
+    sparse_solver_lsqr( L, &d[0], &z[0], params, &stats );
+    printf("%-12s: %5d iterations %8.4f sec ( %d x %d depth )\n", "lsqr", stats.n_iterations,
+           timer.elapsed(), L.rows(), L.cols() );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End:
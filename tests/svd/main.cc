@@ -0,0 +1,155 @@
+// ---------------------------------------------------------------------------
+//
+// This file is part of the <kortex> library suite
+//
+// Copyright (C) 2013 Engin Tola
+//
+// See LICENSE file for license information.
+//
+// author: Engin Tola
+// e-mail: engintola@gmail.com
+// web   : http://www.engintola.com
+//
+// ---------------------------------------------------------------------------
+
+#include <kortex/svd.h>
+#include <kortex/random_generator.h>
+#include <kortex/timer.h>
+#include <kortex/log_manager.h>
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using namespace kortex;
+using std::vector;
+
+void decompose_test();
+void batch_test();
+void svd_benchmark();
+
+int main(int argc, char **argv) {
+    decompose_test();
+    batch_test();
+    svd_benchmark();
+    release_log_man();
+}
+
+void random_fill( PhiloxGenerator& gen, vector<double>& v ) {
+    for( size_t i=0; i<v.size(); i++ )
+        v[i] = 2.0*gen.uniform_sample() - 1.0;
+}
+
+double max_diff( const double* a, const double* b, const int& n ) {
+    double d = 0.0;
+    for( int i=0; i<n; i++ )
+        d = std::max( d, std::fabs( a[i]-b[i] ) );
+    return d;
+}
+
+// |A - U S Vt|
+double reconstruction_error( const double* A, const int& nr, const int& nc, const SVD& svd ) {
+    vector<double> B( nr*nc );
+    svd.combine( &B[0], nc );
+    return max_diff( A, &B[0], nr*nc );
+}
+
+void decompose_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 1 );
+    // one svd object reused over mixed shapes - the cached workspaces have to
+    // match the shape of the call
+    const int shapes[][2] = { {9,9}, {3,3}, {12,5}, {5,12}, {9,9}, {40,7}, {7,40}, {3,3} };
+    const int n_shapes = sizeof(shapes)/sizeof(shapes[0]);
+    SVD svd;
+    for( int t=0; t<3; t++ ) {
+        for( int s=0; s<n_shapes; s++ ) {
+            const int nr = shapes[s][0], nc = shapes[s][1], d = std::min(nr,nc);
+            vector<double> A( nr*nc );
+            random_fill( gen, A );
+
+            SVD fresh;
+            fresh.decompose( &A[0], nr, nc, true, true );
+            svd.decompose( &A[0], nr, nc, true, true );
+            if( max_diff( svd.Sd(), fresh.Sd(), d ) > 1e-12 ) passed = false;
+            if( reconstruction_error( &A[0], nr, nc, svd ) > 1e-12 ) passed = false;
+
+            // singular values only
+            svd.decompose( &A[0], nr, nc, false, false );
+            if( max_diff( svd.Sd(), fresh.Sd(), d ) > 1e-12 ) passed = false;
+
+            vector<double> B = A;
+            svd.decompose_inplace( &B[0], nr, nc, true, true );
+            if( max_diff( svd.Sd(), fresh.Sd(), d ) > 1e-12 ) passed = false;
+            if( reconstruction_error( &A[0], nr, nc, svd ) > 1e-12 ) passed = false;
+        }
+    }
+    if( passed ) printf("%50s passed\n", "svd decompose/decompose_inplace" );
+    else         printf("%50s failed\n", "svd decompose/decompose_inplace" );
+}
+
+void batch_test() {
+    bool passed = true;
+    PhiloxGenerator gen( 2 );
+    const int shapes[][2] = { {9,9}, {8,6}, {6,8} };
+    for( int s=0; s<3; s++ ) {
+        const int nr = shapes[s][0], nc = shapes[s][1], d = std::min(nr,nc);
+        const int n_mats = 1001;
+        const int asz    = nr*nc;
+        vector<double> A( size_t(n_mats)*asz );
+        random_fill( gen, A );
+        vector<double> Sd( n_mats*d ), U( n_mats*nr*nr ), Vt( n_mats*nc*nc ), Sd2( n_mats*d );
+        svd_decompose_batch( &A[0], n_mats, nr, nc, &Sd[0], &U[0], &Vt[0] );
+        vector<double> B = A;
+        svd_decompose_batch_inplace( &B[0], n_mats, nr, nc, &Sd2[0], NULL, NULL );
+        if( max_diff( &Sd[0], &Sd2[0], n_mats*d ) > 1e-12 ) passed = false;
+
+        SVD svd;
+        for( int i=0; i<n_mats; i++ ) {
+            svd.decompose( &A[i*asz], nr, nc, true, true );
+            if( max_diff( svd.Sd(), &Sd[i*d],        d       ) > 1e-12 ) passed = false;
+            if( max_diff( svd.U (), &U [i*nr*nr],    nr*nr   ) > 1e-12 ) passed = false;
+            if( max_diff( svd.Vt(), &Vt[i*nc*nc],    nc*nc   ) > 1e-12 ) passed = false;
+        }
+    }
+    if( passed ) printf("%50s passed\n", "svd_decompose_batch" );
+    else         printf("%50s failed\n", "svd_decompose_batch" );
+}
+
+void svd_benchmark() {
+    PhiloxGenerator gen( 3 );
+    const int n_mats = 100000;
+    const int nr = 9, nc = 9, asz = nr*nc;
+    vector<double> A( size_t(n_mats)*asz ), Sd( n_mats*nc ), Vt( n_mats*nc*nc );
+    random_fill( gen, A );
+    Timer timer;
+
+    timer.reset();
+    for( int i=0; i<n_mats; i++ ) {
+        SVD svd;
+        svd.decompose( &A[i*asz], nr, nc, false, true );
+    }
+    double t_fresh = timer.elapsed();
+
+    timer.reset();
+    SVD svd;
+    for( int i=0; i<n_mats; i++ )
+        svd.decompose( &A[i*asz], nr, nc, false, true );
+    double t_reuse = timer.elapsed();
+
+    timer.reset();
+    svd_decompose_batch( &A[0], n_mats, nr, nc, &Sd[0], NULL, &Vt[0] );
+    double t_batch = timer.elapsed();
+
+    timer.reset();
+    svd_decompose_batch_inplace( &A[0], n_mats, nr, nc, &Sd[0], NULL, &Vt[0] );
+    double t_inplace = timer.elapsed();
+
+    printf("%d 9x9 svds: per-call object %8.4f reused object %8.4f batch %8.4f batch inplace %8.4f sec\n",
+           n_mats, t_fresh, t_reuse, t_batch, t_inplace );
+}
+
+// Local Variables:
+// mode: c++
+// compile-command: "make -C ."
+// End: